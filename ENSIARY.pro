@@ -1,4 +1,4 @@
-QT += core widgets
+QT += core widgets concurrent sql
 
 CONFIG += c++20
 
@@ -27,8 +27,24 @@ SOURCES += \
     src/models/user.cpp \
     src/models/loan.cpp \
     src/models/reservation.cpp \
+    src/models/epoch_time.cpp \
+    src/models/string_pool.cpp \
+    src/models/cbor_record.cpp \
     src/services/library_manager.cpp \
     src/services/persistence_service.cpp \
+    src/services/clock.cpp \
+    src/services/resource_store.cpp \
+    src/services/change_tracker.cpp \
+    src/services/circulation_journal.cpp \
+    src/services/cbor_snapshot.cpp \
+    src/services/json_stream_writer.cpp \
+    src/services/json_pull_reader.cpp \
+    src/services/background_saver.cpp \
+    src/services/backup_store.cpp \
+    src/services/history_archive.cpp \
+    src/services/sqlite_storage_backend.cpp \
+    src/services/resource_index.cpp \
+    src/services/json_schema.cpp \
     src/dialogs/resource_dialog.cpp \
     src/dialogs/user_dialog.cpp \
     src/dialogs/user_loans_dialog.cpp \
@@ -44,8 +60,26 @@ HEADERS += \
     src/models/user.h \
     src/models/loan.h \
     src/models/reservation.h \
+    src/models/epoch_time.h \
+    src/models/string_pool.h \
+    src/models/cbor_record.h \
     src/services/library_manager.h \
     src/services/persistence_service.h \
+    src/services/clock.h \
+    src/services/resource_store.h \
+    src/services/change_tracker.h \
+    src/services/circulation_journal.h \
+    src/services/cbor_snapshot.h \
+    src/services/json_stream_writer.h \
+    src/services/json_pull_reader.h \
+    src/services/load_conflict.h \
+    src/services/background_saver.h \
+    src/services/backup_store.h \
+    src/services/history_archive.h \
+    src/services/storage_backend.h \
+    src/services/sqlite_storage_backend.h \
+    src/services/resource_index.h \
+    src/services/json_schema.h \
     src/dialogs/resource_dialog.h \
     src/dialogs/user_dialog.h \
     src/dialogs/user_loans_dialog.h \
@@ -27,7 +27,9 @@ ReservationManagementDialog::ReservationManagementDialog(LibraryManager* library
     , m_activeCountLabel(nullptr)
     , m_historyTable(nullptr)
     , m_refreshHistoryButton(nullptr)
+    , m_olderHistoryButton(nullptr)
     , m_historyCountLabel(nullptr)
+    , m_historyLimit(HistoryPageSize)
 {
     setWindowTitle("Reservation Management - Admin Panel");
     setModal(true);
@@ -195,6 +197,10 @@ void ReservationManagementDialog::setupReservationHistoryTab()
     headerLayout->addWidget(m_historyCountLabel);
     headerLayout->addStretch();
     
+    m_olderHistoryButton = new QPushButton("Show Older");
+    connect(m_olderHistoryButton, &QPushButton::clicked, this, &ReservationManagementDialog::onShowOlderHistory);
+    headerLayout->addWidget(m_olderHistoryButton);
+    
     m_refreshHistoryButton = new QPushButton("Refresh");
     connect(m_refreshHistoryButton, &QPushButton::clicked, this, &ReservationManagementDialog::onRefreshData);
     headerLayout->addWidget(m_refreshHistoryButton);
@@ -294,12 +300,18 @@ void ReservationManagementDialog::populateActiveReservations()
 
 void ReservationManagementDialog::populateReservationHistory()
 {
-    auto history = m_libraryManager->getReservationHistory();
+    // Only the latest page is read; archived history can be far larger than the table should hold
+    std::vector<HistoryRecord<Reservation>> history;
+    try {
+        history = m_libraryManager->getRecentReservationHistory(m_historyLimit);
+    } catch (const std::exception& e) {
+        QMessageBox::warning(this, "Error", QString("Error loading reservation history: %1").arg(e.what()));
+    }
     
     m_historyTable->setRowCount(history.size());
     
     for (int i = 0; i < history.size(); ++i) {
-        const Reservation* reservation = history[i];
+        const Reservation* reservation = history[i].get();
         
         // Get user and resource details
         User* user = m_libraryManager->findUserById(reservation->getUserId());
@@ -329,7 +341,17 @@ void ReservationManagementDialog::populateReservationHistory()
         m_historyTable->item(i, 0)->setData(Qt::UserRole, reservation->getId());
     }
     
-    m_historyCountLabel->setText(QString("%1 completed reservations").arg(history.size()));
+    // A full page means there may be older reservations
+    const bool more = static_cast<qsizetype>(history.size()) >= m_historyLimit;
+    m_olderHistoryButton->setEnabled(more);
+    m_historyCountLabel->setText(QString(more ? "Latest %1 completed reservations" : "%1 completed reservations")
+                                     .arg(history.size()));
+}
+
+void ReservationManagementDialog::onShowOlderHistory()
+{
+    m_historyLimit += HistoryPageSize;
+    populateReservationHistory();
 }
 
 void ReservationManagementDialog::onCreateReservation()
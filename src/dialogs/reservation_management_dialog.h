@@ -27,6 +27,8 @@ class ReservationManagementDialog : public QDialog
 
 public:
     explicit ReservationManagementDialog(LibraryManager* libraryManager, QWidget *parent = nullptr);
+    
+    static constexpr qsizetype HistoryPageSize = 200;
 
 private slots:
     void onCreateReservation();
@@ -35,6 +37,7 @@ private slots:
     void onRefreshData();
     void onActiveReservationSelectionChanged();
     void onHistoryReservationSelectionChanged();
+    void onShowOlderHistory();
     void onUserSelectionChanged();
     void onResourceSelectionChanged();
 
@@ -77,7 +80,9 @@ private:
     QWidget* m_historyTab;
     QTableWidget* m_historyTable;
     QPushButton* m_refreshHistoryButton;
+    QPushButton* m_olderHistoryButton;
     QLabel* m_historyCountLabel;
+    qsizetype m_historyLimit; // Rows of history shown, grown a page at a time
     
     // Current selections
     QString m_selectedActiveReservationId;
@@ -243,13 +243,15 @@ void UserLoansDialog::loadLoanData() {
         m_currentLoans.push_back(std::make_unique<Loan>(*loan));
     }
     
-    // Get loan history from library manager
+    // Get loan history from library manager (only this user's archive pages are read)
     m_loanHistory.clear();
-    auto allLoans = m_libraryManager->getCompletedLoans();
-    for (const auto& loan : allLoans) {
-        if (loan->getUserId() == m_user->getId()) {
+    try {
+        for (const auto& loan : m_libraryManager->getUserLoanHistory(m_user->getId())) {
             m_loanHistory.push_back(std::make_unique<Loan>(*loan));
         }
+    } catch (const std::exception& e) {
+        m_loanHistory.clear();
+        QMessageBox::warning(this, "Error", QString("Error loading loan history: %1").arg(e.what()));
     }
     
     populateCurrentLoans();
@@ -262,6 +264,7 @@ void UserLoansDialog::loadLoanData() {
  */
 void UserLoansDialog::populateCurrentLoans() {
     m_currentLoansTable->setRowCount(m_currentLoans.size());
+    const qint64 now = m_libraryManager->currentTimeMSecs();
     
     for (size_t i = 0; i < m_currentLoans.size(); ++i) {
         const Loan* loan = m_currentLoans[i].get();
@@ -278,7 +281,7 @@ void UserLoansDialog::populateCurrentLoans() {
         m_currentLoansTable->setItem(i, 4, new QTableWidgetItem(formatLoanStatus(*loan)));
         
         // Color code overdue loans
-        if (loan->isOverdue()) {
+        if (loan->isOverdue(now)) {
             for (int col = 0; col < m_currentLoansTable->columnCount(); ++col) {
                 QTableWidgetItem* item = m_currentLoansTable->item(i, col);
                 if (item) {
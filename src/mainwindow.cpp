@@ -1,6 +1,7 @@
 #include "mainwindow.h"
 #include "services/library_manager.h"
 #include "services/persistence_service.h"
+#include "services/background_saver.h"
 #include "models/resource.h"
 #include "models/book.h"
 #include "models/article.h"
@@ -31,6 +32,8 @@
 #include <QCloseEvent>
 #include <QDateTime>
 #include <QDebug>
+#include <QFutureWatcher>
+#include <algorithm>
 
 /**
  * @brief Constructor for MainWindow
@@ -41,6 +44,9 @@ MainWindow::MainWindow(QWidget* parent)
     // Initialize business logic components
     m_libraryManager = std::make_unique<LibraryManager>(this);
     m_persistenceService = std::make_unique<PersistenceService>();
+    m_backgroundSaver = std::make_unique<BackgroundSaver>(*m_persistenceService, *m_libraryManager);
+    connect(m_backgroundSaver.get(), &BackgroundSaver::saveFinished,
+            this, &MainWindow::onBackgroundSaveFinished);
     
     // Setup UI
     setupUI();
@@ -868,7 +874,7 @@ void MainWindow::onRemoveResourceClicked() {
     if (confirmAction("Are you sure you want to remove this resource?")) {
         try {
             if (m_libraryManager->removeResource(m_selectedResourceId)) {
-                showSuccess("Resource removed successfully!");
+                whenDurable([this]() { showSuccess("Resource removed successfully!"); });
                 updateResourceTable();
             } else {
                 showError("Failed to remove resource.");
@@ -894,7 +900,9 @@ void MainWindow::onBorrowResourceClicked() {
     if (ok && !userId.isEmpty()) {
         try {
             QString loanId = m_libraryManager->borrowResource(userId, m_selectedResourceId);
-            showSuccess(QString("Resource borrowed successfully! Loan ID: %1").arg(loanId));
+            whenDurable([this, loanId]() {
+                showSuccess(QString("Resource borrowed successfully! Loan ID: %1").arg(loanId));
+            });
             updateResourceTable();
             updateLoanTables();
         } catch (const std::exception& e) {
@@ -939,7 +947,9 @@ void MainWindow::onReserveResourceClicked() {
       try {
         QString reservationId = m_libraryManager->reserveResource(userId, resourceId);
         if (!reservationId.isEmpty()) {
-            showMessage(QString("Resource reserved successfully! Reservation ID: %1").arg(reservationId));
+            whenDurable([this, reservationId]() {
+                showMessage(QString("Resource reserved successfully! Reservation ID: %1").arg(reservationId));
+            });
             updateResourceTable(); // Refresh the table
         } else {
             QMessageBox::warning(this, "Reservation Failed", "Failed to create reservation.");
@@ -972,15 +982,23 @@ void MainWindow::loadData() {
         
         // Refresh UI after loading data
         refreshAllData();
+        showLoadConflicts();
     } else {
         showMessage("Using default data - " + m_persistenceService->getLastError());
     }
+    
+    // Record every circulation operation from here on, so a crash between saves loses nothing
+    if (!m_persistenceService->enableJournal(*m_libraryManager)) {
+        showMessage("Journal unavailable - " + m_persistenceService->getLastError());
+    }
 }
 
 /**
  * @brief Save all data
  */
 void MainWindow::saveData() {
+    // Let a background save finish first so the two never write the same files
+    m_backgroundSaver->waitForIdle();
     if (m_persistenceService->saveLibraryData(*m_libraryManager)) {
         showMessage("Data saved successfully.");
     } else {
@@ -988,6 +1006,13 @@ void MainWindow::saveData() {
     }
 }
 
+/**
+ * @brief Save all data on a worker thread after an edit
+ */
+void MainWindow::autoSaveData() {
+    m_backgroundSaver->requestSave();
+}
+
 /**
  * @brief Refresh all data displays
  */
@@ -1003,14 +1028,32 @@ void MainWindow::refreshAllData() {
  * @brief Load and display resource data
  */
 void MainWindow::loadResourceData() {
-    auto resources = m_libraryManager->getAllResources();
+    std::span<std::byte> buffer = scratchBuffer(m_libraryManager->getTotalResourceCount());
+    std::pmr::monotonic_buffer_resource scratch(buffer.data(), buffer.size());
+    
+    auto resources = m_libraryManager->getAllResources(&scratch);
     populateResourceTable(resources);
 }
 
+/**
+ * @brief Get the scratch buffer for one refresh, sized for pointerCount results
+ * 
+ * The buffer only grows, so after the first few refreshes building the
+ * result lists never touches the general heap.
+ */
+std::span<std::byte> MainWindow::scratchBuffer(std::size_t pointerCount) {
+    // Room for the results plus alignment padding between lists
+    const std::size_t required = pointerCount * sizeof(void*) + 4 * alignof(std::max_align_t);
+    if (m_scratchBuffer.size() < required) {
+        m_scratchBuffer.resize(std::max(required, m_scratchBuffer.size() * 2));
+    }
+    return m_scratchBuffer;
+}
+
 /**
  * @brief Populate resource table
  */
-void MainWindow::populateResourceTable(const std::vector<Resource*>& resources) {
+void MainWindow::populateResourceTable(std::span<Resource* const> resources) {
     m_resourceTable->setRowCount(resources.size());
     
     for (size_t i = 0; i < resources.size(); ++i) {
@@ -1030,8 +1073,14 @@ void MainWindow::populateResourceTable(const std::vector<Resource*>& resources)
  */
 void MainWindow::updateResourceTable() {
     QString searchText = m_resourceSearchEdit->text();
-    auto allResources = m_libraryManager->getAllResources();
-    std::vector<Resource*> filteredResources;
+    
+    // All resources plus the filtered subset
+    std::span<std::byte> buffer = scratchBuffer(2 * m_libraryManager->getTotalResourceCount());
+    std::pmr::monotonic_buffer_resource scratch(buffer.data(), buffer.size());
+    
+    auto allResources = m_libraryManager->getAllResources(&scratch);
+    std::pmr::vector<Resource*> filteredResources(&scratch);
+    filteredResources.reserve(allResources.size());
     
     for (Resource* resource : allResources) {
         bool matchesSearch = searchText.isEmpty() || 
@@ -1056,8 +1105,12 @@ void MainWindow::updateResourceTable() {
  * @brief Load and display user data
  */
 void MainWindow::loadUserData() {
-    auto allUsers = m_libraryManager->getAllUsers();
-    std::vector<User*> filteredUsers;
+    std::span<std::byte> buffer = scratchBuffer(2 * m_libraryManager->getTotalUserCount());
+    std::pmr::monotonic_buffer_resource scratch(buffer.data(), buffer.size());
+    
+    auto allUsers = m_libraryManager->getAllUsers(&scratch);
+    std::pmr::vector<User*> filteredUsers(&scratch);
+    filteredUsers.reserve(allUsers.size());
     
     // Get search and filter criteria
     QString searchText = m_userSearchEdit->text().toLower();
@@ -1103,7 +1156,7 @@ void MainWindow::loadUserData() {
 /**
  * @brief Populate user table
  */
-void MainWindow::populateUserTable(const std::vector<User*>& users) {
+void MainWindow::populateUserTable(std::span<User* const> users) {
     m_userTable->setRowCount(users.size());
     
     for (size_t i = 0; i < users.size(); ++i) {
@@ -1121,8 +1174,12 @@ void MainWindow::populateUserTable(const std::vector<User*>& users) {
  * @brief Load and display loan data
  */
 void MainWindow::loadLoanData() {
-    auto activeLoans = m_libraryManager->getActiveLoans();
-    auto overdueLoans = m_libraryManager->getOverdueLoans();
+    // Active loans plus the overdue subset
+    std::span<std::byte> buffer = scratchBuffer(2 * m_libraryManager->getTotalActiveLoans());
+    std::pmr::monotonic_buffer_resource scratch(buffer.data(), buffer.size());
+    
+    auto activeLoans = m_libraryManager->getActiveLoans(&scratch);
+    auto overdueLoans = m_libraryManager->getOverdueLoans(&scratch);
     
     populateActiveLoanTable(activeLoans);
     populateOverdueLoanTable(overdueLoans);
@@ -1131,7 +1188,7 @@ void MainWindow::loadLoanData() {
 /**
  * @brief Populate active loan table
  */
-void MainWindow::populateActiveLoanTable(const std::vector<Loan*>& loans) {
+void MainWindow::populateActiveLoanTable(std::span<Loan* const> loans) {
     m_activeLoanTable->setRowCount(loans.size());
     
     for (size_t i = 0; i < loans.size(); ++i) {
@@ -1149,8 +1206,9 @@ void MainWindow::populateActiveLoanTable(const std::vector<Loan*>& loans) {
 /**
  * @brief Populate overdue loan table
  */
-void MainWindow::populateOverdueLoanTable(const std::vector<Loan*>& loans) {
+void MainWindow::populateOverdueLoanTable(std::span<Loan* const> loans) {
     m_overdueLoanTable->setRowCount(loans.size());
+    const qint64 now = m_libraryManager->currentTimeMSecs();
     
     for (size_t i = 0; i < loans.size(); ++i) {
         const Loan* loan = loans[i];
@@ -1159,7 +1217,7 @@ void MainWindow::populateOverdueLoanTable(const std::vector<Loan*>& loans) {
         m_overdueLoanTable->setItem(i, 1, new QTableWidgetItem(loan->getUserId()));
         m_overdueLoanTable->setItem(i, 2, new QTableWidgetItem(loan->getResourceTitle()));
         m_overdueLoanTable->setItem(i, 3, new QTableWidgetItem(loan->getDueDate().toString("yyyy-MM-dd")));
-        m_overdueLoanTable->setItem(i, 4, new QTableWidgetItem(QString::number(loan->getDaysOverdue())));
+        m_overdueLoanTable->setItem(i, 4, new QTableWidgetItem(QString::number(loan->getDaysOverdue(now))));
         m_overdueLoanTable->setItem(i, 5, new QTableWidgetItem(loan->getStatusString()));
     }
 }
@@ -1184,6 +1242,13 @@ void MainWindow::updateStatistics() {
     QString stats;
     stats += QString("Total Resources: %1\n").arg(m_libraryManager->getTotalResourceCount());
     stats += QString("Available Resources: %1\n").arg(m_libraryManager->getAvailableResourceCount());
+    for (int i = 0; i < Resource::KindCount; ++i) {
+        const auto kind = static_cast<Resource::Kind>(i);
+        stats += QString("  %1: %2 (%3 available)\n")
+                     .arg(Resource::kindToTypeString(kind))
+                     .arg(m_libraryManager->getResourceCountByKind(kind))
+                     .arg(m_libraryManager->getAvailableResourceCountByKind(kind));
+    }
     stats += QString("Total Users: %1\n").arg(m_libraryManager->getTotalUserCount());
     stats += QString("Active Users: %1\n").arg(m_libraryManager->getActiveUserCount());
     stats += QString("Active Loans: %1\n").arg(m_libraryManager->getTotalActiveLoans());
@@ -1222,8 +1287,8 @@ void MainWindow::onAddUserClicked() {
         auto user = dialog.getUser();        if (user) {
             m_libraryManager->addUser(std::move(user));
             updateUserTable();
-            saveData(); // Save data after adding user
-            showMessage("User added successfully!");
+            autoSaveData(); // Save data after adding user
+            whenDurable([this]() { showMessage("User added successfully!"); });
         }
     }
 }
@@ -1266,7 +1331,7 @@ void MainWindow::onRemoveUserClicked() {
     if (ret == QMessageBox::Yes) {
         if (m_libraryManager->removeUser(userId)) {
             updateUserTable();
-            showMessage("User removed successfully!");
+            whenDurable([this]() { showMessage("User removed successfully!"); });
         } else {
             showError("Failed to remove user. User may have active loans.");
         }
@@ -1347,7 +1412,7 @@ void MainWindow::onReturnBookClicked() {
             updateLoanTables();
             updateResourceTable();
             updateUserTable();
-            showMessage("Resource returned successfully!");
+            whenDurable([this]() { showMessage("Resource returned successfully!"); });
         } else {
             showError("Failed to return resource.");
         }
@@ -1373,7 +1438,9 @@ void MainWindow::onRenewLoanClicked() {
         QDateTime newDueDate = m_libraryManager->renewLoan(loanId, days);
         if (!newDueDate.isNull()) {
             updateLoanTables();
-            showMessage(QString("Loan renewed until %1").arg(newDueDate.toString("yyyy-MM-dd")));
+            whenDurable([this, newDueDate]() {
+                showMessage(QString("Loan renewed until %1").arg(newDueDate.toString("yyyy-MM-dd")));
+            });
         } else {
             showError("Failed to renew loan. Maximum renewals may have been reached.");
         }
@@ -1425,6 +1492,12 @@ void MainWindow::onAutoRefresh() {
     // Perform daily maintenance and refresh overdue items
     m_libraryManager->performDailyMaintenance();
     updateLoanTables();
+    
+    // Fold a long journal into the snapshot so recovery stays quick; the save goes
+    // through the background saver, so it never overlaps one already writing
+    if (m_persistenceService->shouldCompactJournal()) {
+        m_backgroundSaver->requestSave();
+    }
 }
 
 // Notification slots
@@ -1502,6 +1575,17 @@ void MainWindow::onDataSaved() {
     showMessage("Data saved successfully!");
 }
 
+/**
+ * @brief Handle completion of a background save
+ */
+void MainWindow::onBackgroundSaveFinished(bool success, const QString& error) {
+    if (success) {
+        onDataSaved();
+    } else {
+        showError("Failed to save data: " + error);
+    }
+}
+
 /**
  * @brief Handle data loaded notification
  */
@@ -1517,9 +1601,9 @@ void MainWindow::showAddResourceDialog() {
         try {
             auto resource = dialog.getResource();            if (resource) {
                 m_libraryManager->addResource(std::move(resource));
-                showSuccess("Resource added successfully!");
+                whenDurable([this]() { showSuccess("Resource added successfully!"); });
                 updateResourceTable();
-                saveData(); // Save data after adding resource
+                autoSaveData(); // Save data after adding resource
             }
         } catch (const std::exception& e) {
             showError(QString("Error adding resource: %1").arg(e.what()));
@@ -1538,9 +1622,9 @@ void MainWindow::showEditResourceDialog(Resource* resource) {
                 // Remove old resource and add updated one
                 QString resourceId = resource->getId();
                 m_libraryManager->removeResource(resourceId);                m_libraryManager->addResource(std::move(updatedResource));
-                showSuccess("Resource updated successfully!");
+                whenDurable([this]() { showSuccess("Resource updated successfully!"); });
                 updateResourceTable();
-                saveData(); // Save data after updating resource
+                autoSaveData(); // Save data after updating resource
             }
         } catch (const std::exception& e) {
             showError(QString("Error updating resource: %1").arg(e.what()));
@@ -1554,9 +1638,9 @@ void MainWindow::showAddUserDialog() {
         try {
             auto user = dialog.getUser();            if (user) {
                 m_libraryManager->addUser(std::move(user));
-                showSuccess("User added successfully!");
+                whenDurable([this]() { showSuccess("User added successfully!"); });
                 updateUserTable();
-                saveData(); // Save data after adding user
+                autoSaveData(); // Save data after adding user
             }
         } catch (const std::exception& e) {
             showError(QString("Error adding user: %1").arg(e.what()));
@@ -1575,9 +1659,9 @@ void MainWindow::showEditUserDialog(User* user) {
                 // Remove old user and add updated one
                 QString userId = user->getId();
                 m_libraryManager->removeUser(userId);                m_libraryManager->addUser(std::move(updatedUser));
-                showSuccess("User updated successfully!");
+                whenDurable([this]() { showSuccess("User updated successfully!"); });
                 updateUserTable();
-                saveData(); // Save data after updating user
+                autoSaveData(); // Save data after updating user
             }
         } catch (const std::exception& e) {
             showError(QString("Error updating user: %1").arg(e.what()));
@@ -1617,11 +1701,55 @@ void MainWindow::showError(const QString& error) {
     m_statusBar->showMessage("Error: " + error, 5000);
 }
 
+/**
+ * @brief Show the stored records the last load skipped, with the reason for each
+ */
+void MainWindow::showLoadConflicts() {
+    const std::vector<LoadConflict>& conflicts = m_persistenceService->getLoadConflicts();
+    if (conflicts.empty()) {
+        return;
+    }
+    
+    QStringList details;
+    for (const LoadConflict& conflict : conflicts) {
+        details << conflict.message;
+    }
+    
+    QMessageBox box(QMessageBox::Warning, "Records Skipped",
+                    QString("%1 stored record(s) could not be loaded and were left out. "
+                            "They will be dropped from the data files the next time those are saved.")
+                        .arg(conflicts.size()),
+                    QMessageBox::Ok, this);
+    box.setDetailedText(details.join('\n'));
+    box.exec();
+    m_statusBar->showMessage(QString("%1 record(s) skipped while loading").arg(conflicts.size()), 5000);
+}
+
 void MainWindow::showSuccess(const QString& message) {
     QMessageBox::information(this, "Success", message);
     m_statusBar->showMessage(message, 3000);
 }
 
+/**
+ * @brief Report an operation once the journal has made its changes durable
+ * 
+ * The tables show the change right away; only the confirmation waits for
+ * the group commit, and the GUI never blocks on it.
+ */
+void MainWindow::whenDurable(const std::function<void()>& report) {
+    auto* watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, report]() {
+        watcher->deleteLater();
+        if (watcher->result()) {
+            report();
+        } else {
+            showError("The change was made but could not be written to the journal. "
+                      "Save the data to keep it.");
+        }
+    });
+    watcher->setFuture(m_persistenceService->mutationsDurable());
+}
+
 bool MainWindow::confirmAction(const QString& message) {
     return QMessageBox::question(this, "Confirm", message, 
                                 QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
@@ -15,10 +15,16 @@
 #include <QMenuBar>
 #include <QToolBar>
 #include <memory>
+#include <memory_resource>
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <functional>
 
 // Forward declarations
 class LibraryManager;
 class PersistenceService;
+class BackgroundSaver;
 class Resource;
 class User;
 class Loan;
@@ -36,6 +42,7 @@ private:
     // Core business logic
     std::unique_ptr<LibraryManager> m_libraryManager;
     std::unique_ptr<PersistenceService> m_persistenceService;
+    std::unique_ptr<BackgroundSaver> m_backgroundSaver; // Destroyed before the services it writes
     
     // Main UI components
     QTabWidget* m_tabWidget;
@@ -94,6 +101,9 @@ private:
     QString m_selectedResourceId;
     QString m_selectedUserId;
     QString m_selectedLoanId;
+    
+    // Backing store for the per-refresh monotonic arena used by table refreshes
+    std::vector<std::byte> m_scratchBuffer;
 
 public:
     explicit MainWindow(QWidget* parent = nullptr);
@@ -139,6 +149,7 @@ private slots:
     // System slots
     void onAutoRefresh();
     void onDataSaved();
+    void onBackgroundSaveFinished(bool success, const QString& error);
     void onDataLoaded();
     
     // Library manager notification slots
@@ -176,20 +187,21 @@ private:
     void loadLoanData();
     void loadLibraryInfo();
     void refreshAllData();
+    std::span<std::byte> scratchBuffer(std::size_t pointerCount);
     
     // Resource table methods
-    void populateResourceTable(const std::vector<Resource*>& resources);
+    void populateResourceTable(std::span<Resource* const> resources);
     void updateResourceTable();
     void clearResourceSelection();
     
     // User table methods
-    void populateUserTable(const std::vector<User*>& users);
+    void populateUserTable(std::span<User* const> users);
     void updateUserTable();
     void clearUserSelection();
     
     // Loan table methods
-    void populateActiveLoanTable(const std::vector<Loan*>& loans);
-    void populateOverdueLoanTable(const std::vector<Loan*>& loans);
+    void populateActiveLoanTable(std::span<Loan* const> loans);
+    void populateOverdueLoanTable(std::span<Loan* const> loans);
     void updateLoanTables();
     void clearLoanSelection();
     
@@ -204,7 +216,9 @@ private:
     // Utility methods
     void showMessage(const QString& message, int timeout = 3000);
     void showError(const QString& error);
+    void showLoadConflicts();
     void showSuccess(const QString& message);
+    void whenDurable(const std::function<void()>& report);
     bool confirmAction(const QString& message);
     void updateStatistics();
     QString formatResourceInfo(const Resource& resource);
@@ -1,4 +1,6 @@
 #include "article.h"
+#include "string_pool.h"
+#include "cbor_record.h"
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QRegularExpression>
@@ -10,9 +12,9 @@ Article::Article(const QString& id, const QString& title, const QString& author,
                  int publicationYear, const QString& journal, int volume,
                  int issue, const QString& pageRange, const QString& doi,
                  const QString& researchField)
-    : Resource(id, title, author, publicationYear, Category::Article),
-      m_journal(journal), m_volume(volume), m_issue(issue),
-      m_pageRange(pageRange), m_doi(doi), m_researchField(researchField) {
+    : Resource(id, title, author, publicationYear, Category::Article, Kind::Article),
+      m_journal(StringPool::intern(journal)), m_volume(volume), m_issue(issue),
+      m_pageRange(pageRange), m_doi(doi), m_researchField(StringPool::intern(researchField)) {
     
     validateArticleData();
 }
@@ -58,13 +60,6 @@ QString Article::getDetails() const {
     return details;
 }
 
-/**
- * @brief Get the resource type
- */
-QString Article::getResourceType() const {
-    return "Article";
-}
-
 /**
  * @brief Convert article to JSON object
  */
@@ -112,13 +107,13 @@ void Article::fromJson(const QJsonObject& json) {
     setDescription(json["description"].toString());
     
     // Load Article-specific fields
-    m_journal = json["journal"].toString();
+    m_journal = StringPool::intern(json["journal"].toString());
     m_volume = json["volume"].toInt();
     m_issue = json["issue"].toInt();
     m_pageRange = json["pageRange"].toString();
     m_doi = json["doi"].toString();
     m_abstract = json["abstract"].toString();
-    m_researchField = json["researchField"].toString();
+    m_researchField = StringPool::intern(json["researchField"].toString());
     
     // Load keywords array
     m_keywords.clear();
@@ -128,6 +123,36 @@ void Article::fromJson(const QJsonObject& json) {
     }
 }
 
+/**
+ * @brief Write the Article-specific CBOR fields
+ */
+void Article::writeCborFields(QCborStreamWriter& writer) const {
+    CborRecord::writeText(writer, CborJournal, m_journal);
+    CborRecord::writeInteger(writer, CborVolume, m_volume);
+    CborRecord::writeInteger(writer, CborIssue, m_issue);
+    CborRecord::writeText(writer, CborPageRange, m_pageRange);
+    CborRecord::writeText(writer, CborDoi, m_doi);
+    CborRecord::writeText(writer, CborAbstract, m_abstract);
+    CborRecord::writeTextList(writer, CborKeywords, m_keywords);
+    CborRecord::writeText(writer, CborResearchField, m_researchField);
+}
+
+/**
+ * @brief Load article from a decoded CBOR record
+ */
+void Article::readCbor(const CborRecord& record) {
+    readCborBaseFields(record);
+    
+    m_journal = StringPool::intern(record.text(CborJournal));
+    m_volume = static_cast<int>(record.integer(CborVolume));
+    m_issue = static_cast<int>(record.integer(CborIssue));
+    m_pageRange = record.text(CborPageRange);
+    m_doi = record.text(CborDoi);
+    m_abstract = record.text(CborAbstract);
+    m_keywords = record.textList(CborKeywords);
+    m_researchField = StringPool::intern(record.text(CborResearchField));
+}
+
 /**
  * @brief Set journal with validation
  */
@@ -135,7 +160,7 @@ void Article::setJournal(const QString& journal) {
     if (journal.isEmpty()) {
         throw ResourceException("Journal name cannot be empty");
     }
-    m_journal = journal;
+    m_journal = StringPool::intern(journal);
 }
 
 /**
@@ -209,7 +234,7 @@ void Article::removeKeyword(const QString& keyword) {
  * @brief Set research field
  */
 void Article::setResearchField(const QString& researchField) {
-    m_researchField = researchField;
+    m_researchField = StringPool::intern(researchField);
 }
 
 /**
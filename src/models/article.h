@@ -10,7 +10,7 @@
  * This class represents an article in the library system and demonstrates
  * inheritance from the abstract Resource base class.
  */
-class Article : public Resource {
+class Article final : public Resource {
 private:
     QString m_journal;
     int m_volume;
@@ -22,6 +22,18 @@ private:
     QString m_researchField;
 
 public:
+    // CBOR field keys (after the shared Resource keys)
+    enum CborKey : int {
+        CborJournal = CborSubclassKeys,
+        CborVolume,
+        CborIssue,
+        CborPageRange,
+        CborDoi,
+        CborAbstract,
+        CborKeywords,
+        CborResearchField
+    };
+
     // Constructor
     Article(const QString& id, const QString& title, const QString& author,
             int publicationYear, const QString& journal, int volume = 0,
@@ -30,9 +42,10 @@ public:
 
     // Override virtual functions from Resource
     QString getDetails() const override;
-    QString getResourceType() const override;
     QJsonObject toJson() const override;
-    void fromJson(const QJsonObject& json) override;    // Article-specific getters
+    void fromJson(const QJsonObject& json) override;
+    void readCbor(const CborRecord& record) override;
+    // Article-specific getters
     QString getJournal() const { return m_journal; }
     QString getVolume() const { return QString::number(m_volume); }
     QString getIssue() const { return QString::number(m_issue); }
@@ -59,6 +72,9 @@ public:
     QString getCitation() const;
     bool isValidDoi(const QString& doi) const;
 
+protected:
+    void writeCborFields(QCborStreamWriter& writer) const override;
+
 private:
     void validateArticleData() const;
 };
@@ -1,4 +1,6 @@
 #include "book.h"
+#include "string_pool.h"
+#include "cbor_record.h"
 #include <QJsonObject>
 #include <QRegularExpression>
 
@@ -8,9 +10,10 @@
 Book::Book(const QString& id, const QString& title, const QString& author,
            int publicationYear, const QString& isbn, const QString& publisher,
            int pageCount, const QString& language, const QString& genre, bool isHardcover)
-    : Resource(id, title, author, publicationYear, Category::Book),
-      m_isbn(isbn), m_publisher(publisher), m_pageCount(pageCount),
-      m_language(language), m_genre(genre), m_isHardcover(isHardcover) {
+    : Resource(id, title, author, publicationYear, Category::Book, Kind::Book),
+      m_isbn(isbn), m_publisher(StringPool::intern(publisher)), m_pageCount(pageCount),
+      m_language(StringPool::intern(language)), m_genre(StringPool::intern(genre)),
+      m_isHardcover(isHardcover) {
     
     validateBookData();
 }
@@ -38,13 +41,6 @@ QString Book::getDetails() const {
     return details;
 }
 
-/**
- * @brief Get the resource type
- */
-QString Book::getResourceType() const {
-    return "Book";
-}
-
 /**
  * @brief Convert book to JSON object
  */
@@ -85,13 +81,39 @@ void Book::fromJson(const QJsonObject& json) {
     
     // Load Book-specific fields
     m_isbn = json["isbn"].toString();
-    m_publisher = json["publisher"].toString();
+    m_publisher = StringPool::intern(json["publisher"].toString());
     m_pageCount = json["pageCount"].toInt();
-    m_language = json["language"].toString();
-    m_genre = json["genre"].toString();
+    m_language = StringPool::intern(json["language"].toString());
+    m_genre = StringPool::intern(json["genre"].toString());
     m_isHardcover = json["isHardcover"].toBool();
 }
 
+/**
+ * @brief Write the Book-specific CBOR fields
+ */
+void Book::writeCborFields(QCborStreamWriter& writer) const {
+    CborRecord::writeText(writer, CborIsbn, m_isbn);
+    CborRecord::writeText(writer, CborPublisher, m_publisher);
+    CborRecord::writeInteger(writer, CborPageCount, m_pageCount);
+    CborRecord::writeText(writer, CborLanguage, m_language);
+    CborRecord::writeText(writer, CborGenre, m_genre);
+    CborRecord::writeBoolean(writer, CborHardcover, m_isHardcover);
+}
+
+/**
+ * @brief Load book from a decoded CBOR record
+ */
+void Book::readCbor(const CborRecord& record) {
+    readCborBaseFields(record);
+    
+    m_isbn = record.text(CborIsbn);
+    m_publisher = StringPool::intern(record.text(CborPublisher));
+    m_pageCount = static_cast<int>(record.integer(CborPageCount));
+    m_language = StringPool::intern(record.text(CborLanguage));
+    m_genre = StringPool::intern(record.text(CborGenre));
+    m_isHardcover = record.boolean(CborHardcover);
+}
+
 /**
  * @brief Set ISBN with validation
  */
@@ -109,7 +131,7 @@ void Book::setPublisher(const QString& publisher) {
     if (publisher.isEmpty()) {
         throw ResourceException("Publisher cannot be empty");
     }
-    m_publisher = publisher;
+    m_publisher = StringPool::intern(publisher);
 }
 
 /**
@@ -126,14 +148,14 @@ void Book::setPageCount(int pageCount) {
  * @brief Set language
  */
 void Book::setLanguage(const QString& language) {
-    m_language = language;
+    m_language = StringPool::intern(language);
 }
 
 /**
  * @brief Set genre
  */
 void Book::setGenre(const QString& genre) {
-    m_genre = genre;
+    m_genre = StringPool::intern(genre);
 }
 
 /**
@@ -10,7 +10,7 @@
  * This class represents a book in the library system and demonstrates
  * inheritance from the abstract Resource base class.
  */
-class Book : public Resource {
+class Book final : public Resource {
 private:
     QString m_isbn;
     QString m_publisher;
@@ -20,6 +20,16 @@ private:
     bool m_isHardcover;
 
 public:
+    // CBOR field keys (after the shared Resource keys)
+    enum CborKey : int {
+        CborIsbn = CborSubclassKeys,
+        CborPublisher,
+        CborPageCount,
+        CborLanguage,
+        CborGenre,
+        CborHardcover
+    };
+
     // Constructor
     Book(const QString& id, const QString& title, const QString& author,
          int publicationYear, const QString& isbn, const QString& publisher,
@@ -28,9 +38,10 @@ public:
 
     // Override virtual functions from Resource
     QString getDetails() const override;
-    QString getResourceType() const override;
     QJsonObject toJson() const override;
-    void fromJson(const QJsonObject& json) override;    // Book-specific getters
+    void fromJson(const QJsonObject& json) override;
+    void readCbor(const CborRecord& record) override;
+    // Book-specific getters
     QString getIsbn() const { return m_isbn; }
     QString getPublisher() const { return m_publisher; }
     int getPageCount() const { return m_pageCount; }
@@ -51,6 +62,9 @@ public:
     QString getFormattedDetails() const;
     bool isValidIsbn(const QString& isbn) const;
 
+protected:
+    void writeCborFields(QCborStreamWriter& writer) const override;
+
 private:
     void validateBookData() const;
 };
@@ -0,0 +1,229 @@
+#include "cbor_record.h"
+
+/**
+ * @brief Decode one CBOR map into the record's slots
+ *
+ * The reader must be positioned on the map; on success it is left on the
+ * element that follows it.
+ */
+bool CborRecord::read(QCborStreamReader& reader, const NestedReader& nested) {
+    clear();
+
+    if (!reader.isMap() || !reader.enterContainer()) {
+        return false;
+    }
+
+    while (reader.hasNext()) {
+        if (!reader.isInteger()) {
+            return false;
+        }
+        qint64 key = reader.toInteger();
+        if (!reader.next()) {
+            return false;
+        }
+
+        if (key < 0 || key >= MaxKeys) {
+            // Field from a newer encoding
+            if (!reader.next()) {
+                return false;
+            }
+            continue;
+        }
+
+        Slot& target = m_slots[static_cast<std::size_t>(key)];
+        bool ok = true;
+        if (reader.isString()) {
+            target.type = SlotType::Text;
+            ok = readText(reader, target.text);
+        } else if (reader.isInteger()) {
+            target.type = SlotType::Integer;
+            target.integer = reader.toInteger();
+            ok = reader.next();
+        } else if (reader.isBool()) {
+            target.type = SlotType::Integer;
+            target.integer = reader.toBool() ? 1 : 0;
+            ok = reader.next();
+        } else if (reader.isDouble()) {
+            target.type = SlotType::Real;
+            target.real = reader.toDouble();
+            ok = reader.next();
+        } else if (reader.isFloat()) {
+            target.type = SlotType::Real;
+            target.real = reader.toFloat();
+            ok = reader.next();
+        } else if (reader.isArray() && nested) {
+            ok = nested(static_cast<int>(key), reader);
+        } else if (reader.isArray()) {
+            target.type = SlotType::TextList;
+            ok = readTextList(reader, target.list);
+        } else {
+            ok = reader.next();
+        }
+
+        if (!ok) {
+            return false;
+        }
+    }
+
+    return reader.leaveContainer();
+}
+
+/**
+ * @brief Mark every slot empty, keeping string capacity for the next record
+ */
+void CborRecord::clear() {
+    for (Slot& target : m_slots) {
+        target.type = SlotType::Empty;
+    }
+}
+
+/**
+ * @brief Check whether the last record contained a key
+ */
+bool CborRecord::has(int key) const {
+    return slot(key) != nullptr;
+}
+
+/**
+ * @brief Get a text field
+ */
+QString CborRecord::text(int key, const QString& defaultValue) const {
+    const Slot* target = slot(key);
+    return (target && target->type == SlotType::Text) ? target->text : defaultValue;
+}
+
+/**
+ * @brief Get an integer field (booleans read as 0 or 1)
+ */
+qint64 CborRecord::integer(int key, qint64 defaultValue) const {
+    const Slot* target = slot(key);
+    return (target && target->type == SlotType::Integer) ? target->integer : defaultValue;
+}
+
+/**
+ * @brief Get a floating-point field, accepting integers as well
+ */
+double CborRecord::real(int key, double defaultValue) const {
+    const Slot* target = slot(key);
+    if (!target) {
+        return defaultValue;
+    }
+    if (target->type == SlotType::Real) {
+        return target->real;
+    }
+    if (target->type == SlotType::Integer) {
+        return static_cast<double>(target->integer);
+    }
+    return defaultValue;
+}
+
+/**
+ * @brief Get a boolean field
+ */
+bool CborRecord::boolean(int key, bool defaultValue) const {
+    const Slot* target = slot(key);
+    return (target && target->type == SlotType::Integer) ? target->integer != 0 : defaultValue;
+}
+
+/**
+ * @brief Get a list-of-strings field
+ */
+QStringList CborRecord::textList(int key) const {
+    const Slot* target = slot(key);
+    return (target && target->type == SlotType::TextList) ? target->list : QStringList();
+}
+
+/**
+ * @brief Read a (possibly chunked) text string and advance past it
+ */
+bool CborRecord::readText(QCborStreamReader& reader, QString& value) {
+    value.clear();
+    if (!reader.isString()) {
+        return false;
+    }
+
+    auto chunk = reader.readString();
+    while (chunk.status == QCborStreamReader::Ok) {
+        value += chunk.data;
+        chunk = reader.readString();
+    }
+    return chunk.status == QCborStreamReader::EndOfString;
+}
+
+/**
+ * @brief Write a key and text value
+ */
+void CborRecord::writeText(QCborStreamWriter& writer, int key, const QString& value) {
+    writer.append(key);
+    writer.append(QStringView(value));
+}
+
+/**
+ * @brief Write a key and integer value
+ */
+void CborRecord::writeInteger(QCborStreamWriter& writer, int key, qint64 value) {
+    writer.append(key);
+    writer.append(value);
+}
+
+/**
+ * @brief Write a key and floating-point value
+ */
+void CborRecord::writeReal(QCborStreamWriter& writer, int key, double value) {
+    writer.append(key);
+    writer.append(value);
+}
+
+/**
+ * @brief Write a key and boolean value
+ */
+void CborRecord::writeBoolean(QCborStreamWriter& writer, int key, bool value) {
+    writer.append(key);
+    writer.append(value);
+}
+
+/**
+ * @brief Write a key and an array of strings
+ */
+void CborRecord::writeTextList(QCborStreamWriter& writer, int key, const QStringList& values) {
+    writer.append(key);
+    writer.startArray(static_cast<quint64>(values.size()));
+    for (const QString& value : values) {
+        writer.append(QStringView(value));
+    }
+    writer.endArray();
+}
+
+/**
+ * @brief Get the slot for a key, or nullptr if the key was absent
+ */
+const CborRecord::Slot* CborRecord::slot(int key) const {
+    if (key < 0 || key >= MaxKeys) {
+        return nullptr;
+    }
+    const Slot& target = m_slots[static_cast<std::size_t>(key)];
+    return target.type == SlotType::Empty ? nullptr : &target;
+}
+
+/**
+ * @brief Read an array of strings, skipping elements of any other type
+ */
+bool CborRecord::readTextList(QCborStreamReader& reader, QStringList& values) {
+    values.clear();
+    if (!reader.enterContainer()) {
+        return false;
+    }
+
+    while (reader.hasNext()) {
+        if (reader.isString()) {
+            QString value;
+            if (!readText(reader, value)) {
+                return false;
+            }
+            values.append(value);
+        } else if (!reader.next()) {
+            return false;
+        }
+    }
+    return reader.leaveContainer();
+}
@@ -0,0 +1,82 @@
+#ifndef CBOR_RECORD_H
+#define CBOR_RECORD_H
+
+#include <QString>
+#include <QStringList>
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <array>
+#include <functional>
+
+/**
+ * @brief Fields of one entity read from a CBOR stream, indexed by integer key
+ *
+ * Models encode themselves as CBOR maps keyed by small integers. Reading
+ * decodes each value straight from QCborStreamReader into a fixed slot, so no
+ * QCborValue or QJsonObject tree is built. Arrays of strings are collected
+ * into a list; any other array is handed to a callback while the reader is
+ * positioned on it. Unknown keys are skipped, so newer files stay readable.
+ */
+class CborRecord {
+public:
+    static constexpr int MaxKeys = 32;
+
+    // Consumes the array value for the given key; returns false on malformed input
+    using NestedReader = std::function<bool(int key, QCborStreamReader& reader)>;
+
+    CborRecord() = default;
+
+    // Decoding
+    bool read(QCborStreamReader& reader, const NestedReader& nested = {});
+    void clear();
+
+    // Field access
+    bool has(int key) const;
+    QString text(int key, const QString& defaultValue = QString()) const;
+    qint64 integer(int key, qint64 defaultValue = 0) const;
+    double real(int key, double defaultValue = 0.0) const;
+    bool boolean(int key, bool defaultValue = false) const;
+    QStringList textList(int key) const;
+
+    /**
+     * @brief Read an enum stored as its underlying index
+     * @param count Number of enumerators; out-of-range values give the default
+     */
+    template <typename Enum>
+    Enum enumValue(int key, Enum defaultValue, int count) const {
+        qint64 value = integer(key, -1);
+        return (value >= 0 && value < count) ? static_cast<Enum>(value) : defaultValue;
+    }
+
+    // Stream helpers shared by the model encoders and the snapshot reader
+    static bool readText(QCborStreamReader& reader, QString& value);
+    static void writeText(QCborStreamWriter& writer, int key, const QString& value);
+    static void writeInteger(QCborStreamWriter& writer, int key, qint64 value);
+    static void writeReal(QCborStreamWriter& writer, int key, double value);
+    static void writeBoolean(QCborStreamWriter& writer, int key, bool value);
+    static void writeTextList(QCborStreamWriter& writer, int key, const QStringList& values);
+
+private:
+    enum class SlotType : quint8 {
+        Empty,
+        Text,
+        Integer,
+        Real,
+        TextList
+    };
+
+    struct Slot {
+        SlotType type = SlotType::Empty;
+        qint64 integer = 0;
+        double real = 0.0;
+        QString text;
+        QStringList list;
+    };
+
+    std::array<Slot, MaxKeys> m_slots;
+
+    const Slot* slot(int key) const;
+    static bool readTextList(QCborStreamReader& reader, QStringList& values);
+};
+
+#endif // CBOR_RECORD_H
@@ -1,4 +1,6 @@
 #include "digitalcontent.h"
+#include "string_pool.h"
+#include "cbor_record.h"
 #include <QJsonObject>
 #include <QJsonArray>
 #include <algorithm>
@@ -7,7 +9,7 @@
  * @brief Constructor for DigitalContent class
  */
 DigitalContent::DigitalContent(const QString& id, const QString& title, const QString& author, int publicationYear)
-    : Resource(id, title, author, publicationYear, Resource::Category::DigitalContent), 
+    : Resource(id, title, author, publicationYear, Resource::Category::DigitalContent, Resource::Kind::DigitalContent), 
       m_contentType(ContentType::EBook), m_accessType(AccessType::Online), 
       m_requiresAuthentication(false), m_simultaneousUsers(1) {
     
@@ -65,7 +67,7 @@ void DigitalContent::setFileFormat(const QString& format) {
     if (format.trimmed().isEmpty()) {
         throw DigitalContentException("File format cannot be empty");
     }
-    m_fileFormat = format.trimmed().toUpper();
+    m_fileFormat = StringPool::intern(format.trimmed().toUpper());
 }
 
 /**
@@ -89,7 +91,7 @@ void DigitalContent::setUrl(const QUrl& url) {
  * @brief Set platform
  */
 void DigitalContent::setPlatform(const QString& platform) {
-    m_platform = platform.trimmed();
+    m_platform = StringPool::intern(platform.trimmed());
 }
 
 /**
@@ -219,15 +221,47 @@ void DigitalContent::fromJson(const QJsonObject& json) {
     // Load digital content-specific fields
     m_contentType = stringToContentType(json["contentType"].toString());
     m_accessType = stringToAccessType(json["accessType"].toString());
-    m_fileFormat = json["fileFormat"].toString();
+    m_fileFormat = StringPool::intern(json["fileFormat"].toString());
     m_fileSize = json["fileSize"].toString();
     m_url = QUrl(json["url"].toString());
-    m_platform = json["platform"].toString();
+    m_platform = StringPool::intern(json["platform"].toString());
     m_requiresAuthentication = json["requiresAuthentication"].toBool();
     m_simultaneousUsers = json["simultaneousUsers"].toInt(1);
     m_systemRequirements = json["systemRequirements"].toString();
 }
 
+/**
+ * @brief Write the digital content-specific CBOR fields
+ */
+void DigitalContent::writeCborFields(QCborStreamWriter& writer) const {
+    CborRecord::writeInteger(writer, CborContentType, static_cast<int>(m_contentType));
+    CborRecord::writeInteger(writer, CborAccessType, static_cast<int>(m_accessType));
+    CborRecord::writeText(writer, CborFileFormat, m_fileFormat);
+    CborRecord::writeText(writer, CborFileSize, m_fileSize);
+    CborRecord::writeText(writer, CborUrl, m_url.toString());
+    CborRecord::writeText(writer, CborPlatform, m_platform);
+    CborRecord::writeBoolean(writer, CborRequiresAuthentication, m_requiresAuthentication);
+    CborRecord::writeInteger(writer, CborSimultaneousUsers, m_simultaneousUsers);
+    CborRecord::writeText(writer, CborSystemRequirements, m_systemRequirements);
+}
+
+/**
+ * @brief Load digital content from a decoded CBOR record
+ */
+void DigitalContent::readCbor(const CborRecord& record) {
+    readCborBaseFields(record);
+    
+    m_contentType = record.enumValue(CborContentType, ContentType::EBook, 7);
+    m_accessType = record.enumValue(CborAccessType, AccessType::Online, 3);
+    m_fileFormat = StringPool::intern(record.text(CborFileFormat));
+    m_fileSize = record.text(CborFileSize);
+    m_url = QUrl(record.text(CborUrl));
+    m_platform = StringPool::intern(record.text(CborPlatform));
+    m_requiresAuthentication = record.boolean(CborRequiresAuthentication);
+    m_simultaneousUsers = static_cast<int>(record.integer(CborSimultaneousUsers, 1));
+    m_systemRequirements = record.text(CborSystemRequirements);
+}
+
 /**
  * @brief Convert content type to string
  */
@@ -12,7 +12,7 @@
  * This class extends Resource to handle digital content such as 
  * e-books, audio files, videos, and other digital materials.
  */
-class DigitalContent : public Resource {
+class DigitalContent final : public Resource {
 public:
     enum class ContentType {
         EBook,
@@ -30,6 +30,19 @@ public:
         Streaming    // Streamed content
     };
 
+    // CBOR field keys (after the shared Resource keys)
+    enum CborKey : int {
+        CborContentType = CborSubclassKeys,
+        CborAccessType,
+        CborFileFormat,
+        CborFileSize,
+        CborUrl,
+        CborPlatform,
+        CborRequiresAuthentication,
+        CborSimultaneousUsers,
+        CborSystemRequirements
+    };
+
 private:
     ContentType m_contentType;
     AccessType m_accessType;
@@ -78,7 +91,6 @@ public:    // Constructor
     void setSimultaneousUsers(int users);
     void setSystemRequirements(const QString& requirements);    // Override base class methods
     QString getDetails() const override;
-    QString getResourceType() const override { return "Digital Content"; }
 
     // Digital content specific methods
     bool canAccommodateSimultaneousLoans() const;
@@ -87,6 +99,7 @@ public:    // Constructor
     // JSON serialization
     QJsonObject toJson() const override;
     void fromJson(const QJsonObject& json) override;
+    void readCbor(const CborRecord& record) override;
 
     // Static utility functions
     static QString contentTypeToString(ContentType type);
@@ -97,6 +110,9 @@ public:    // Constructor
     // Validation
     bool isValidDigitalContent() const;
 
+protected:
+    void writeCborFields(QCborStreamWriter& writer) const override;
+
 private:
     void initializeDigitalContent();
     void validateDigitalContentData() const;
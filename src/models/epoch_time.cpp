@@ -0,0 +1,52 @@
+#include "epoch_time.h"
+
+/**
+ * @brief Convert a QDateTime to epoch milliseconds
+ */
+qint64 EpochTime::fromDateTime(const QDateTime& dateTime) {
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : Invalid;
+}
+
+/**
+ * @brief Convert epoch milliseconds to a local QDateTime
+ */
+QDateTime EpochTime::toDateTime(qint64 msecs) {
+    return isValid(msecs) ? QDateTime::fromMSecsSinceEpoch(msecs) : QDateTime();
+}
+
+/**
+ * @brief Parse an ISO 8601 date string into epoch milliseconds
+ */
+qint64 EpochTime::fromIsoString(const QString& isoString) {
+    if (isoString.isEmpty()) {
+        return Invalid;
+    }
+    return fromDateTime(QDateTime::fromString(isoString, Qt::ISODate));
+}
+
+/**
+ * @brief Format epoch milliseconds as an ISO 8601 string
+ */
+QString EpochTime::toIsoString(qint64 msecs) {
+    return isValid(msecs) ? toDateTime(msecs).toString(Qt::ISODate) : QString();
+}
+
+/**
+ * @brief Calendar days between two instants, counted on local dates
+ *
+ * Matches QDateTime::daysTo(): passing local midnight counts as a day,
+ * however few hours have elapsed.
+ */
+int EpochTime::daysBetween(qint64 from, qint64 to) {
+    if (!isValid(from) || !isValid(to)) {
+        return 0;
+    }
+    return static_cast<int>(toDateTime(from).date().daysTo(toDateTime(to).date()));
+}
+
+/**
+ * @brief Shift an instant by a number of calendar days, keeping the local time of day
+ */
+qint64 EpochTime::addDays(qint64 msecs, int days) {
+    return isValid(msecs) ? toDateTime(msecs).addDays(days).toMSecsSinceEpoch() : Invalid;
+}
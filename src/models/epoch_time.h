@@ -0,0 +1,34 @@
+#ifndef EPOCH_TIME_H
+#define EPOCH_TIME_H
+
+#include <QDateTime>
+#include <QString>
+#include <limits>
+
+/**
+ * @brief Helpers for the compact date representation used by the models
+ * 
+ * Hot model fields store instants as 64-bit UTC milliseconds since the Unix
+ * epoch. QDateTime objects are only built at the UI and JSON boundary, so
+ * date comparisons inside the models are single integer operations.
+ */
+class EpochTime {
+public:
+    // Marker for "no date" (the equivalent of a default-constructed QDateTime)
+    static constexpr qint64 Invalid = std::numeric_limits<qint64>::min();
+
+    static bool isValid(qint64 msecs) { return msecs != Invalid; }
+    static qint64 now() { return QDateTime::currentMSecsSinceEpoch(); }
+
+    // Boundary conversions
+    static qint64 fromDateTime(const QDateTime& dateTime);
+    static QDateTime toDateTime(qint64 msecs);
+    static qint64 fromIsoString(const QString& isoString);
+    static QString toIsoString(qint64 msecs);
+
+    // Calendar days from one instant to another in the local time zone (negative if "to" is earlier)
+    static int daysBetween(qint64 from, qint64 to);
+    static qint64 addDays(qint64 msecs, int days);
+};
+
+#endif // EPOCH_TIME_H
@@ -1,4 +1,5 @@
 #include "loan.h"
+#include "cbor_record.h"
 #include <QUuid>
 #include <QJsonObject>
 
@@ -9,7 +10,8 @@ Loan::Loan(const QString& loanId, const QString& userId, const QString& resource
            const QString& resourceTitle, const QDateTime& borrowDate,
            const QDateTime& dueDate, int maxRenewals)
     : m_loanId(loanId), m_userId(userId), m_resourceId(resourceId),
-      m_resourceTitle(resourceTitle), m_borrowDate(borrowDate), m_dueDate(dueDate),
+      m_resourceTitle(resourceTitle), m_borrowDate(EpochTime::fromDateTime(borrowDate)),
+      m_dueDate(EpochTime::fromDateTime(dueDate)), m_returnDate(EpochTime::Invalid),
       m_status(Status::Active), m_renewalCount(0), m_maxRenewals(maxRenewals),
       m_fineAmount(0.0) {
     
@@ -21,10 +23,11 @@ Loan::Loan(const QString& loanId, const QString& userId, const QString& resource
  * @brief Set due date with validation
  */
 void Loan::setDueDate(const QDateTime& dueDate) {
-    if (dueDate <= m_borrowDate) {
+    qint64 dueDateMSecs = EpochTime::fromDateTime(dueDate);
+    if (dueDateMSecs <= m_borrowDate) {
         throw LoanException("Due date must be after borrow date");
     }
-    m_dueDate = dueDate;
+    m_dueDate = dueDateMSecs;
     updateStatus();
 }
 
@@ -32,10 +35,11 @@ void Loan::setDueDate(const QDateTime& dueDate) {
  * @brief Set return date
  */
 void Loan::setReturnDate(const QDateTime& returnDate) {
-    if (returnDate < m_borrowDate) {
+    qint64 returnDateMSecs = EpochTime::fromDateTime(returnDate);
+    if (returnDateMSecs < m_borrowDate) {
         throw LoanException("Return date cannot be before borrow date");
     }
-    m_returnDate = returnDate;
+    m_returnDate = returnDateMSecs;
     updateStatus();
 }
 
@@ -67,11 +71,18 @@ void Loan::setNotes(const QString& notes) {
  * @brief Renew the loan
  */
 bool Loan::renewLoan(int daysToExtend) {
-    if (!canBeRenewed()) {
+    return renewLoan(daysToExtend, EpochTime::now());
+}
+
+/**
+ * @brief Renew the loan, checking eligibility against the given time
+ */
+bool Loan::renewLoan(int daysToExtend, qint64 nowMSecs) {
+    if (!canBeRenewed(nowMSecs)) {
         return false;
     }
     
-    m_dueDate = m_dueDate.addDays(daysToExtend);
+    m_dueDate = EpochTime::addDays(m_dueDate, daysToExtend);
     m_renewalCount++;
     m_status = Status::Renewed;
     
@@ -82,13 +93,25 @@ bool Loan::renewLoan(int daysToExtend) {
  * @brief Return the item
  */
 void Loan::returnItem() {
-    m_returnDate = QDateTime::currentDateTime();
-    m_status = Status::Returned;
+    returnItem(EpochTime::now());
+}
+
+/**
+ * @brief Return the item at the given time
+ */
+void Loan::returnItem(qint64 returnDateMSecs) {
+    // Fine is assessed first: once returned, the loan no longer counts as overdue
+    calculateFine(DefaultDailyFineRate, returnDateMSecs);
     
-    // Calculate fine if returned late
-    if (isOverdue()) {
-        calculateFine();
-    }
+    m_returnDate = returnDateMSecs;
+    m_status = Status::Returned;
+}
+
+/**
+ * @brief Get when the loan left circulation: its return date, or its due date if never returned
+ */
+qint64 Loan::getCompletionDateMSecs() const {
+    return EpochTime::isValid(m_returnDate) ? m_returnDate : m_dueDate;
 }
 
 /**
@@ -104,7 +127,14 @@ void Loan::markAsLost() {
  * @brief Calculate fine for overdue item
  */
 void Loan::calculateFine(double dailyFineRate) {
-    int daysOverdue = getDaysOverdue();
+    calculateFine(dailyFineRate, EpochTime::now());
+}
+
+/**
+ * @brief Calculate fine for overdue item as of the given time
+ */
+void Loan::calculateFine(double dailyFineRate, qint64 nowMSecs) {
+    int daysOverdue = getDaysOverdue(nowMSecs);
     if (daysOverdue > 0) {
         m_fineAmount = daysOverdue * dailyFineRate;
     }
@@ -114,42 +144,70 @@ void Loan::calculateFine(double dailyFineRate) {
  * @brief Check if loan is overdue
  */
 bool Loan::isOverdue() const {
+    return isOverdue(EpochTime::now());
+}
+
+/**
+ * @brief Check if loan is overdue at the given time
+ */
+bool Loan::isOverdue(qint64 nowMSecs) const {
     if (m_status == Status::Returned || m_status == Status::Lost) {
         return false; // No longer overdue once returned or lost
     }
     
-    return QDateTime::currentDateTime() > m_dueDate;
+    return nowMSecs > m_dueDate;
 }
 
 /**
  * @brief Check if loan can be renewed
  */
 bool Loan::canBeRenewed() const {
+    return canBeRenewed(EpochTime::now());
+}
+
+/**
+ * @brief Check if loan can be renewed at the given time
+ */
+bool Loan::canBeRenewed(qint64 nowMSecs) const {
     return (m_status == Status::Active || m_status == Status::Renewed) &&
            m_renewalCount < m_maxRenewals &&
-           !isOverdue();
+           !isOverdue(nowMSecs);
 }
 
 /**
  * @brief Get days overdue
  */
 int Loan::getDaysOverdue() const {
-    if (!isOverdue()) {
+    return getDaysOverdue(EpochTime::now());
+}
+
+/**
+ * @brief Get days overdue at the given time
+ */
+int Loan::getDaysOverdue(qint64 nowMSecs) const {
+    if (!isOverdue(nowMSecs)) {
         return 0;
     }
     
-    return m_dueDate.daysTo(QDateTime::currentDateTime());
+    return EpochTime::daysBetween(m_dueDate, nowMSecs);
 }
 
 /**
  * @brief Get days until due
  */
 int Loan::getDaysUntilDue() const {
+    return getDaysUntilDue(EpochTime::now());
+}
+
+/**
+ * @brief Get days until due at the given time
+ */
+int Loan::getDaysUntilDue(qint64 nowMSecs) const {
     if (m_status == Status::Returned || m_status == Status::Lost) {
         return 0;
     }
     
-    int daysUntil = QDateTime::currentDateTime().daysTo(m_dueDate);
+    int daysUntil = EpochTime::daysBetween(nowMSecs, m_dueDate);
     return qMax(0, daysUntil);
 }
 
@@ -162,9 +220,9 @@ QJsonObject Loan::toJson() const {
     json["userId"] = m_userId;
     json["resourceId"] = m_resourceId;
     json["resourceTitle"] = m_resourceTitle;
-    json["borrowDate"] = m_borrowDate.toString(Qt::ISODate);
-    json["dueDate"] = m_dueDate.toString(Qt::ISODate);
-    json["returnDate"] = m_returnDate.toString(Qt::ISODate);
+    json["borrowDate"] = EpochTime::toIsoString(m_borrowDate);
+    json["dueDate"] = EpochTime::toIsoString(m_dueDate);
+    json["returnDate"] = EpochTime::toIsoString(m_returnDate);
     json["status"] = statusToString(m_status);
     json["renewalCount"] = m_renewalCount;
     json["maxRenewals"] = m_maxRenewals;
@@ -182,9 +240,9 @@ void Loan::fromJson(const QJsonObject& json) {
     m_userId = json["userId"].toString();
     m_resourceId = json["resourceId"].toString();
     m_resourceTitle = json["resourceTitle"].toString();
-    m_borrowDate = QDateTime::fromString(json["borrowDate"].toString(), Qt::ISODate);
-    m_dueDate = QDateTime::fromString(json["dueDate"].toString(), Qt::ISODate);
-    m_returnDate = QDateTime::fromString(json["returnDate"].toString(), Qt::ISODate);
+    m_borrowDate = EpochTime::fromIsoString(json["borrowDate"].toString());
+    m_dueDate = EpochTime::fromIsoString(json["dueDate"].toString());
+    m_returnDate = EpochTime::fromIsoString(json["returnDate"].toString());
     m_status = stringToStatus(json["status"].toString());
     m_renewalCount = json["renewalCount"].toInt();
     m_maxRenewals = json["maxRenewals"].toInt();
@@ -192,6 +250,44 @@ void Loan::fromJson(const QJsonObject& json) {
     m_notes = json["notes"].toString();
 }
 
+/**
+ * @brief Write loan as a CBOR map keyed by CborKey
+ */
+void Loan::writeCbor(QCborStreamWriter& writer) const {
+    writer.startMap();
+    CborRecord::writeText(writer, CborLoanId, m_loanId);
+    CborRecord::writeText(writer, CborUserId, m_userId);
+    CborRecord::writeText(writer, CborResourceId, m_resourceId);
+    CborRecord::writeText(writer, CborResourceTitle, m_resourceTitle);
+    CborRecord::writeInteger(writer, CborBorrowDate, m_borrowDate);
+    CborRecord::writeInteger(writer, CborDueDate, m_dueDate);
+    CborRecord::writeInteger(writer, CborReturnDate, m_returnDate);
+    CborRecord::writeInteger(writer, CborStatus, static_cast<int>(m_status));
+    CborRecord::writeInteger(writer, CborRenewalCount, m_renewalCount);
+    CborRecord::writeInteger(writer, CborMaxRenewals, m_maxRenewals);
+    CborRecord::writeReal(writer, CborFineAmount, m_fineAmount);
+    CborRecord::writeText(writer, CborNotes, m_notes);
+    writer.endMap();
+}
+
+/**
+ * @brief Load loan from a decoded CBOR record
+ */
+void Loan::readCbor(const CborRecord& record) {
+    m_loanId = record.text(CborLoanId);
+    m_userId = record.text(CborUserId);
+    m_resourceId = record.text(CborResourceId);
+    m_resourceTitle = record.text(CborResourceTitle);
+    m_borrowDate = record.integer(CborBorrowDate, EpochTime::Invalid);
+    m_dueDate = record.integer(CborDueDate, EpochTime::Invalid);
+    m_returnDate = record.integer(CborReturnDate, EpochTime::Invalid);
+    m_status = record.enumValue(CborStatus, Status::Active, 5);
+    m_renewalCount = static_cast<int>(record.integer(CborRenewalCount));
+    m_maxRenewals = static_cast<int>(record.integer(CborMaxRenewals));
+    m_fineAmount = record.real(CborFineAmount);
+    m_notes = record.text(CborNotes);
+}
+
 /**
  * @brief Get formatted information for display
  */
@@ -201,13 +297,13 @@ QString Loan::getFormattedInfo() const {
                    .arg(getStatusString());
     
     if (m_status == Status::Active || m_status == Status::Renewed) {
-        info += QString(" (Due: %1)").arg(m_dueDate.toString("yyyy-MM-dd"));
+        info += QString(" (Due: %1)").arg(getDueDate().toString("yyyy-MM-dd"));
         
         if (isOverdue()) {
             info += QString(" - OVERDUE by %1 days").arg(getDaysOverdue());
         }
     } else if (m_status == Status::Returned) {
-        info += QString(" (Returned: %1)").arg(m_returnDate.toString("yyyy-MM-dd"));
+        info += QString(" (Returned: %1)").arg(getReturnDate().toString("yyyy-MM-dd"));
     }
     
     if (m_fineAmount > 0.0) {
@@ -229,10 +325,10 @@ QString Loan::getStatusString() const {
  */
 QString Loan::getDurationString() const {
     if (m_status == Status::Returned) {
-        int days = m_borrowDate.daysTo(m_returnDate);
+        int days = EpochTime::daysBetween(m_borrowDate, m_returnDate);
         return QString("%1 days").arg(days);
     } else {
-        int days = m_borrowDate.daysTo(QDateTime::currentDateTime());
+        int days = EpochTime::daysBetween(m_borrowDate, EpochTime::now());
         return QString("%1 days (ongoing)").arg(days);
     }
 }
@@ -4,6 +4,11 @@
 #include <QString>
 #include <QDateTime>
 #include <QJsonObject>
+#include <QCborStreamWriter>
+
+#include "epoch_time.h"
+
+class CborRecord;
 
 /**
  * @brief Represents a loan transaction in the library system
@@ -21,14 +26,33 @@ public:
         Lost
     };
 
+    // Integer field keys of the CBOR encoding
+    enum CborKey : int {
+        CborLoanId = 0,
+        CborUserId,
+        CborResourceId,
+        CborResourceTitle,
+        CborBorrowDate,
+        CborDueDate,
+        CborReturnDate,
+        CborStatus,
+        CborRenewalCount,
+        CborMaxRenewals,
+        CborFineAmount,
+        CborNotes
+    };
+
+    static constexpr double DefaultDailyFineRate = 0.50;
+
 private:
     QString m_loanId;
     QString m_userId;
     QString m_resourceId;
     QString m_resourceTitle; // Cached for display purposes
-    QDateTime m_borrowDate;
-    QDateTime m_dueDate;
-    QDateTime m_returnDate;
+    // Dates are UTC epoch milliseconds (EpochTime::Invalid when unset)
+    qint64 m_borrowDate;
+    qint64 m_dueDate;
+    qint64 m_returnDate;
     Status m_status;
     int m_renewalCount;
     int m_maxRenewals;
@@ -56,9 +80,13 @@ public:
     QString getUserId() const { return m_userId; }
     QString getResourceId() const { return m_resourceId; }
     QString getResourceTitle() const { return m_resourceTitle; }
-    QDateTime getBorrowDate() const { return m_borrowDate; }
-    QDateTime getDueDate() const { return m_dueDate; }
-    QDateTime getReturnDate() const { return m_returnDate; }
+    QDateTime getBorrowDate() const { return EpochTime::toDateTime(m_borrowDate); }
+    QDateTime getDueDate() const { return EpochTime::toDateTime(m_dueDate); }
+    QDateTime getReturnDate() const { return EpochTime::toDateTime(m_returnDate); }
+    qint64 getBorrowDateMSecs() const { return m_borrowDate; }
+    qint64 getDueDateMSecs() const { return m_dueDate; }
+    qint64 getReturnDateMSecs() const { return m_returnDate; }
+    qint64 getCompletionDateMSecs() const; // Return date, or due date for loans closed without one
     Status getStatus() const { return m_status; }
     int getRenewalCount() const { return m_renewalCount; }
     int getMaxRenewals() const { return m_maxRenewals; }
@@ -75,21 +103,32 @@ public:
 
     // Loan operations
     bool renewLoan(int daysToExtend = 14);
+    bool renewLoan(int daysToExtend, qint64 nowMSecs);
     void returnItem();
+    void returnItem(qint64 returnDateMSecs);
     void markAsLost();
-    void calculateFine(double dailyFineRate = 0.50);
+    void calculateFine(double dailyFineRate = DefaultDailyFineRate);
+    void calculateFine(double dailyFineRate, qint64 nowMSecs);
 
-    // Status checks
+    // Status checks (the overloads taking "now" let callers sample the clock once per batch)
     bool isOverdue() const;
+    bool isOverdue(qint64 nowMSecs) const;
     bool isActive() const { return m_status == Status::Active; }
     bool isReturned() const { return m_status == Status::Returned; }
     bool canBeRenewed() const;
+    bool canBeRenewed(qint64 nowMSecs) const;
     int getDaysOverdue() const;
+    int getDaysOverdue(qint64 nowMSecs) const;
     int getDaysUntilDue() const;
+    int getDaysUntilDue(qint64 nowMSecs) const;
 
     // JSON serialization
     QJsonObject toJson() const;
     void fromJson(const QJsonObject& json);
+    
+    // CBOR serialization (binary snapshots)
+    void writeCbor(QCborStreamWriter& writer) const;
+    void readCbor(const CborRecord& record);
 
     // Utility functions
     QString getFormattedInfo() const;
@@ -1,4 +1,5 @@
 #include "reservation.h"
+#include "cbor_record.h"
 #include <QUuid>
 
 /**
@@ -6,11 +7,20 @@
  */
 Reservation::Reservation(const QString& userId, const QString& resourceId, 
                         const QString& resourceTitle, int expirationDays)
+    : Reservation(userId, resourceId, resourceTitle, expirationDays, EpochTime::now()) {
+}
+
+/**
+ * @brief Constructor for Reservation class with an explicit reservation time
+ */
+Reservation::Reservation(const QString& userId, const QString& resourceId,
+                        const QString& resourceTitle, int expirationDays,
+                        qint64 reservationDateMSecs)
     : m_userId(userId), m_resourceId(resourceId), m_resourceTitle(resourceTitle),
-      m_status(Status::Active), m_reservationDate(QDateTime::currentDateTime()) {
+      m_reservationDate(reservationDateMSecs), m_status(Status::Active) {
     
     m_reservationId = generateReservationId();
-    m_expirationDate = m_reservationDate.addDays(expirationDays);
+    m_expirationDate = EpochTime::addDays(m_reservationDate, expirationDays);
 }
 
 /**
@@ -31,21 +41,35 @@ void Reservation::setNotes(const QString& notes) {
  * @brief Set expiration date
  */
 void Reservation::setExpirationDate(const QDateTime& expirationDate) {
-    m_expirationDate = expirationDate;
+    m_expirationDate = EpochTime::fromDateTime(expirationDate);
 }
 
 /**
  * @brief Check if reservation is expired
  */
 bool Reservation::isExpired() const {
-    return QDateTime::currentDateTime() > m_expirationDate && m_status == Status::Active;
+    return isExpired(EpochTime::now());
+}
+
+/**
+ * @brief Check if reservation is expired at the given time
+ */
+bool Reservation::isExpired(qint64 nowMSecs) const {
+    return nowMSecs > m_expirationDate && m_status == Status::Active;
 }
 
 /**
  * @brief Check if reservation can be fulfilled
  */
 bool Reservation::canBeFulfilled() const {
-    return m_status == Status::Active && !isExpired();
+    return canBeFulfilled(EpochTime::now());
+}
+
+/**
+ * @brief Check if reservation can be fulfilled at the given time
+ */
+bool Reservation::canBeFulfilled(qint64 nowMSecs) const {
+    return m_status == Status::Active && !isExpired(nowMSecs);
 }
 
 /**
@@ -75,15 +99,21 @@ void Reservation::extendReservation(int additionalDays) {
     if (m_status != Status::Active) {
         throw ReservationException("Can only extend active reservations");
     }
-    m_expirationDate = m_expirationDate.addDays(additionalDays);
+    m_expirationDate = EpochTime::addDays(m_expirationDate, additionalDays);
 }
 
 /**
  * @brief Get days until expiration
  */
 int Reservation::getDaysUntilExpiration() const {
-    QDateTime now = QDateTime::currentDateTime();
-    return now.daysTo(m_expirationDate);
+    return getDaysUntilExpiration(EpochTime::now());
+}
+
+/**
+ * @brief Get days until expiration at the given time
+ */
+int Reservation::getDaysUntilExpiration(qint64 nowMSecs) const {
+    return EpochTime::daysBetween(nowMSecs, m_expirationDate);
 }
 
 /**
@@ -93,8 +123,8 @@ QString Reservation::getFormattedInfo() const {
     QString info;
     info += QString("Reservation ID: %1\n").arg(m_reservationId);
     info += QString("Resource: %1\n").arg(m_resourceTitle);
-    info += QString("Reserved Date: %1\n").arg(m_reservationDate.toString("yyyy-MM-dd hh:mm"));
-    info += QString("Expires: %1\n").arg(m_expirationDate.toString("yyyy-MM-dd hh:mm"));
+    info += QString("Reserved Date: %1\n").arg(getReservationDate().toString("yyyy-MM-dd hh:mm"));
+    info += QString("Expires: %1\n").arg(getExpirationDate().toString("yyyy-MM-dd hh:mm"));
     info += QString("Status: %1\n").arg(statusToString(m_status));
     
     if (m_status == Status::Active) {
@@ -122,8 +152,8 @@ QJsonObject Reservation::toJson() const {
     json["userId"] = m_userId;
     json["resourceId"] = m_resourceId;
     json["resourceTitle"] = m_resourceTitle;
-    json["reservationDate"] = m_reservationDate.toString(Qt::ISODate);
-    json["expirationDate"] = m_expirationDate.toString(Qt::ISODate);
+    json["reservationDate"] = EpochTime::toIsoString(m_reservationDate);
+    json["expirationDate"] = EpochTime::toIsoString(m_expirationDate);
     json["status"] = statusToString(m_status);
     json["notes"] = m_notes;
     
@@ -138,12 +168,42 @@ void Reservation::fromJson(const QJsonObject& json) {
     m_userId = json["userId"].toString();
     m_resourceId = json["resourceId"].toString();
     m_resourceTitle = json["resourceTitle"].toString();
-    m_reservationDate = QDateTime::fromString(json["reservationDate"].toString(), Qt::ISODate);
-    m_expirationDate = QDateTime::fromString(json["expirationDate"].toString(), Qt::ISODate);
+    m_reservationDate = EpochTime::fromIsoString(json["reservationDate"].toString());
+    m_expirationDate = EpochTime::fromIsoString(json["expirationDate"].toString());
     m_status = stringToStatus(json["status"].toString());
     m_notes = json["notes"].toString();
 }
 
+/**
+ * @brief Write reservation as a CBOR map keyed by CborKey
+ */
+void Reservation::writeCbor(QCborStreamWriter& writer) const {
+    writer.startMap();
+    CborRecord::writeText(writer, CborReservationId, m_reservationId);
+    CborRecord::writeText(writer, CborUserId, m_userId);
+    CborRecord::writeText(writer, CborResourceId, m_resourceId);
+    CborRecord::writeText(writer, CborResourceTitle, m_resourceTitle);
+    CborRecord::writeInteger(writer, CborReservationDate, m_reservationDate);
+    CborRecord::writeInteger(writer, CborExpirationDate, m_expirationDate);
+    CborRecord::writeInteger(writer, CborStatus, static_cast<int>(m_status));
+    CborRecord::writeText(writer, CborNotes, m_notes);
+    writer.endMap();
+}
+
+/**
+ * @brief Load reservation from a decoded CBOR record
+ */
+void Reservation::readCbor(const CborRecord& record) {
+    m_reservationId = record.text(CborReservationId);
+    m_userId = record.text(CborUserId);
+    m_resourceId = record.text(CborResourceId);
+    m_resourceTitle = record.text(CborResourceTitle);
+    m_reservationDate = record.integer(CborReservationDate, EpochTime::Invalid);
+    m_expirationDate = record.integer(CborExpirationDate, EpochTime::Invalid);
+    m_status = record.enumValue(CborStatus, Status::Active, 4);
+    m_notes = record.text(CborNotes);
+}
+
 /**
  * @brief Generate unique reservation ID
  */
@@ -4,8 +4,13 @@
 #include <QString>
 #include <QDateTime>
 #include <QJsonObject>
+#include <QCborStreamWriter>
 #include <QUuid>
 
+#include "epoch_time.h"
+
+class CborRecord;
+
 /**
  * @brief Represents a reservation in the library system
  * 
@@ -21,13 +26,26 @@ public:
         Cancelled   // Reservation was cancelled
     };
 
+    // Integer field keys of the CBOR encoding
+    enum CborKey : int {
+        CborReservationId = 0,
+        CborUserId,
+        CborResourceId,
+        CborResourceTitle,
+        CborReservationDate,
+        CborExpirationDate,
+        CborStatus,
+        CborNotes
+    };
+
 private:
     QString m_reservationId;
     QString m_userId;
     QString m_resourceId;
     QString m_resourceTitle;
-    QDateTime m_reservationDate;
-    QDateTime m_expirationDate;
+    // Dates are UTC epoch milliseconds
+    qint64 m_reservationDate;
+    qint64 m_expirationDate;
     Status m_status;
     QString m_notes;
 
@@ -35,6 +53,9 @@ public:
     // Constructors
     Reservation(const QString& userId, const QString& resourceId, 
                 const QString& resourceTitle, int expirationDays = 7);
+    Reservation(const QString& userId, const QString& resourceId,
+                const QString& resourceTitle, int expirationDays,
+                qint64 reservationDateMSecs);
     
     // Getters
     QString getReservationId() const { return m_reservationId; }
@@ -42,8 +63,10 @@ public:
     QString getUserId() const { return m_userId; }
     QString getResourceId() const { return m_resourceId; }
     QString getResourceTitle() const { return m_resourceTitle; }
-    QDateTime getReservationDate() const { return m_reservationDate; }
-    QDateTime getExpirationDate() const { return m_expirationDate; }
+    QDateTime getReservationDate() const { return EpochTime::toDateTime(m_reservationDate); }
+    QDateTime getExpirationDate() const { return EpochTime::toDateTime(m_expirationDate); }
+    qint64 getReservationDateMSecs() const { return m_reservationDate; }
+    qint64 getExpirationDateMSecs() const { return m_expirationDate; }
     Status getStatus() const { return m_status; }
     QString getNotes() const { return m_notes; }
     
@@ -55,7 +78,9 @@ public:
     // Status checks
     bool isActive() const { return m_status == Status::Active; }
     bool isExpired() const;
+    bool isExpired(qint64 nowMSecs) const;
     bool canBeFulfilled() const;
+    bool canBeFulfilled(qint64 nowMSecs) const;
     
     // Operations
     void fulfillReservation();
@@ -64,12 +89,17 @@ public:
     
     // Utility functions
     int getDaysUntilExpiration() const;
+    int getDaysUntilExpiration(qint64 nowMSecs) const;
     QString getFormattedInfo() const;
     
     // JSON serialization
     QJsonObject toJson() const;
     void fromJson(const QJsonObject& json);
     
+    // CBOR serialization (binary snapshots)
+    void writeCbor(QCborStreamWriter& writer) const;
+    void readCbor(const CborRecord& record);
+    
     // Static utility functions
     static QString generateReservationId();
     static QString statusToString(Status status);
@@ -1,4 +1,6 @@
 #include "resource.h"
+#include "string_pool.h"
+#include "cbor_record.h"
 #include <stdexcept>
 #include <QJsonDocument>
 
@@ -6,9 +8,9 @@
  * @brief Constructor for Resource base class
  */
 Resource::Resource(const QString& id, const QString& title, const QString& author, 
-                   int publicationYear, Category category)
-    : m_id(id), m_title(title), m_author(author), m_publicationYear(publicationYear),
-      m_category(category), m_status(Status::Available), m_dateAdded(QDateTime::currentDateTime()) {
+                   int publicationYear, Category category, Kind kind)
+    : m_id(id), m_title(title), m_author(StringPool::intern(author)), m_publicationYear(publicationYear),
+      m_category(category), m_status(Status::Available), m_kind(kind), m_dateAdded(EpochTime::now()) {
     
     // Validate input parameters
     if (id.isEmpty()) {
@@ -42,7 +44,7 @@ void Resource::setAuthor(const QString& author) {
     if (author.isEmpty()) {
         throw ResourceException("Author cannot be empty");
     }
-    m_author = author;
+    m_author = StringPool::intern(author);
 }
 
 /**
@@ -129,6 +131,63 @@ Resource::Status Resource::stringToStatus(const QString& statusStr) {
     return Status::Available; // Default fallback
 }
 
+/**
+ * @brief Convert Kind tag to the type string used in JSON
+ */
+QString Resource::kindToTypeString(Kind kind) {
+    // Literals are static data, so this never allocates
+    switch (kind) {
+        case Kind::Book: return QStringLiteral("Book");
+        case Kind::Article: return QStringLiteral("Article");
+        case Kind::Thesis: return QStringLiteral("Thesis");
+        case Kind::DigitalContent: return QStringLiteral("Digital Content");
+        default: return QStringLiteral("Unknown");
+    }
+}
+
+/**
+ * @brief Convert JSON type string to Kind tag
+ * @return false if the type string is not recognised
+ */
+bool Resource::typeStringToKind(const QString& typeStr, Kind& kind) {
+    if (typeStr == QLatin1String("Book")) { kind = Kind::Book; return true; }
+    if (typeStr == QLatin1String("Article")) { kind = Kind::Article; return true; }
+    if (typeStr == QLatin1String("Thesis")) { kind = Kind::Thesis; return true; }
+    if (typeStr == QLatin1String("Digital Content")) { kind = Kind::DigitalContent; return true; }
+    return false;
+}
+
+/**
+ * @brief Write the resource as a CBOR map keyed by CborKey
+ */
+void Resource::writeCbor(QCborStreamWriter& writer) const {
+    writer.startMap();
+    CborRecord::writeInteger(writer, CborKind, static_cast<int>(m_kind));
+    CborRecord::writeText(writer, CborId, m_id);
+    CborRecord::writeText(writer, CborTitle, m_title);
+    CborRecord::writeText(writer, CborAuthor, m_author);
+    CborRecord::writeInteger(writer, CborPublicationYear, m_publicationYear);
+    CborRecord::writeInteger(writer, CborCategory, static_cast<int>(m_category));
+    CborRecord::writeInteger(writer, CborStatus, static_cast<int>(m_status));
+    CborRecord::writeInteger(writer, CborDateAdded, m_dateAdded);
+    CborRecord::writeText(writer, CborDescription, m_description);
+    writeCborFields(writer);
+    writer.endMap();
+}
+
+/**
+ * @brief Restore the base Resource fields from a decoded CBOR record
+ */
+void Resource::readCborBaseFields(const CborRecord& record) {
+    setTitle(record.text(CborTitle));
+    setAuthor(record.text(CborAuthor));
+    setPublicationYear(static_cast<int>(record.integer(CborPublicationYear)));
+    setCategory(record.enumValue(CborCategory, Category::Other, 5));
+    setStatus(record.enumValue(CborStatus, Status::Available, 5));
+    setDescription(record.text(CborDescription));
+    m_dateAdded = record.integer(CborDateAdded, m_dateAdded);
+}
+
 /**
  * @brief Equality comparison operator
  */
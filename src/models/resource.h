@@ -4,8 +4,13 @@
 #include <QString>
 #include <QDateTime>
 #include <QJsonObject>
+#include <QCborStreamWriter>
 #include <memory>
 
+#include "epoch_time.h"
+
+class CborRecord;
+
 /**
  * @brief Abstract base class for all library resources
  * 
@@ -30,6 +35,29 @@ public:
         Lost
     };
 
+    // Compact tag identifying the concrete subclass (unlike Category, never changes)
+    enum class Kind : quint8 {
+        Book,
+        Article,
+        Thesis,
+        DigitalContent
+    };
+    static constexpr int KindCount = 4;
+
+    // Integer field keys of the CBOR encoding; subclass keys start at CborSubclassKeys
+    enum CborKey : int {
+        CborKind = 0,
+        CborId,
+        CborTitle,
+        CborAuthor,
+        CborPublicationYear,
+        CborCategory,
+        CborStatus,
+        CborDateAdded,
+        CborDescription,
+        CborSubclassKeys = 16
+    };
+
 protected:
     QString m_id;
     QString m_title;
@@ -37,23 +65,27 @@ protected:
     int m_publicationYear;
     Category m_category;
     Status m_status;
-    QDateTime m_dateAdded;
+    Kind m_kind;
+    qint64 m_dateAdded; // UTC epoch milliseconds
     QString m_description;
 
 public:
     // Constructor
     Resource(const QString& id, const QString& title, const QString& author, 
-             int publicationYear, Category category);
+             int publicationYear, Category category, Kind kind);
     
     // Virtual destructor for proper polymorphism
     virtual ~Resource() = default;
 
     // Pure virtual functions that must be implemented by derived classes
     virtual QString getDetails() const = 0;
-    virtual QString getResourceType() const = 0;
     virtual QJsonObject toJson() const = 0;
     virtual void fromJson(const QJsonObject& json) = 0;
 
+    // CBOR serialization (binary snapshots)
+    void writeCbor(QCborStreamWriter& writer) const;
+    virtual void readCbor(const CborRecord& record) = 0;
+
     // Getters
     QString getId() const { return m_id; }
     QString getTitle() const { return m_title; }
@@ -61,8 +93,11 @@ public:
     int getPublicationYear() const { return m_publicationYear; }
     Category getCategory() const { return m_category; }
     Status getStatus() const { return m_status; }
-    QDateTime getDateAdded() const { return m_dateAdded; }
+    QDateTime getDateAdded() const { return EpochTime::toDateTime(m_dateAdded); }
+    qint64 getDateAddedMSecs() const { return m_dateAdded; }
     QString getDescription() const { return m_description; }
+    Kind getKind() const { return m_kind; }
+    QString getResourceType() const { return kindToTypeString(m_kind); }
 
     // Setters with validation
     void setTitle(const QString& title);
@@ -82,10 +117,17 @@ public:
     static Category stringToCategory(const QString& categoryStr);
     static QString statusToString(Status status);
     static Status stringToStatus(const QString& statusStr);
+    static QString kindToTypeString(Kind kind);
+    static bool typeStringToKind(const QString& typeStr, Kind& kind);
 
     // Comparison operators for searching and sorting
     bool operator==(const Resource& other) const;
     bool operator<(const Resource& other) const;
+
+protected:
+    // CBOR helpers: subclasses write their own keys and restore the shared ones
+    virtual void writeCborFields(QCborStreamWriter& writer) const = 0;
+    void readCborBaseFields(const CborRecord& record);
 };
 
 // Custom exception class for Resource-related errors
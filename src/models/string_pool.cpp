@@ -0,0 +1,75 @@
+#include "string_pool.h"
+#include <QSet>
+#include <algorithm>
+
+namespace {
+    // Pool size below which the pool is never pruned
+    constexpr qsizetype MinPruneSize = 4096;
+
+    struct LocalPool {
+        QSet<QString> strings;
+        qsizetype pruneAt = MinPruneSize; // Size at which the next insertion prunes first
+    };
+
+    LocalPool& localPool() {
+        thread_local LocalPool pool;
+        return pool;
+    }
+
+    qsizetype pruneUnused(LocalPool& pool) {
+        qsizetype removed = 0;
+        for (auto it = pool.strings.begin(); it != pool.strings.end();) {
+            // Detached: the pool holds the only reference to the buffer
+            if (it->isDetached()) {
+                it = pool.strings.erase(it);
+                ++removed;
+            } else {
+                ++it;
+            }
+        }
+        pool.pruneAt = std::max(MinPruneSize, pool.strings.size() * 2);
+        return removed;
+    }
+}
+
+/**
+ * @brief Intern a string value
+ */
+QString StringPool::intern(const QString& value) {
+    if (value.isEmpty()) {
+        return QString();
+    }
+    
+    LocalPool& pool = localPool();
+    auto it = pool.strings.constFind(value);
+    if (it != pool.strings.constEnd()) {
+        return *it;
+    }
+    if (pool.strings.size() >= pool.pruneAt) {
+        pruneUnused(pool);
+    }
+    return *pool.strings.insert(value);
+}
+
+/**
+ * @brief Get the number of distinct strings in the calling thread's pool
+ */
+qsizetype StringPool::size() {
+    return localPool().strings.size();
+}
+
+/**
+ * @brief Drop the calling thread's pooled strings that only the pool still holds
+ */
+qsizetype StringPool::prune() {
+    return pruneUnused(localPool());
+}
+
+/**
+ * @brief Drop every string of the calling thread's pool (existing copies stay valid)
+ */
+void StringPool::clear() {
+    LocalPool& pool = localPool();
+    pool.strings.clear();
+    pool.pruneAt = MinPruneSize;
+}
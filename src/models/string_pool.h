@@ -0,0 +1,30 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <QString>
+
+/**
+ * @brief Per-thread interning pool for repeated catalog metadata
+ * 
+ * Authors, publishers, journals, universities and similar values repeat
+ * across a large catalog. Interning them makes every occurrence share one
+ * implicitly shared QString buffer.
+ * 
+ * Each thread interns into a pool of its own, so the parallel decoders of a
+ * load never wait on each other; a value decoded on several threads is kept
+ * once per thread. A pool drops the strings only it still holds whenever it
+ * has doubled in size since it last did, so values no resource uses any more
+ * do not pile up over a long session.
+ */
+class StringPool {
+public:
+    // Return the calling thread's pooled instance equal to value (inserting it if needed)
+    static QString intern(const QString& value);
+
+    // The calling thread's pool
+    static qsizetype size();
+    static qsizetype prune(); // Drops strings nothing outside the pool uses; returns how many
+    static void clear();
+};
+
+#endif // STRING_POOL_H
@@ -1,4 +1,6 @@
 #include "thesis.h"
+#include "string_pool.h"
+#include "cbor_record.h"
 #include <QJsonObject>
 #include <QJsonArray>
 #include <algorithm>
@@ -7,7 +9,7 @@
  * @brief Constructor for Thesis class
  */
 Thesis::Thesis(const QString& id, const QString& title, const QString& author, int publicationYear)
-    : Resource(id, title, author, publicationYear, Resource::Category::Thesis), 
+    : Resource(id, title, author, publicationYear, Resource::Category::Thesis, Resource::Kind::Thesis), 
       m_degreeLevel(DegreeLevel::Bachelors) {
     
     initializeThesis();
@@ -45,7 +47,7 @@ void Thesis::setSupervisor(const QString& supervisor) {
     if (supervisor.trimmed().isEmpty()) {
         throw ThesisException("Supervisor name cannot be empty");
     }
-    m_supervisor = supervisor.trimmed();
+    m_supervisor = StringPool::intern(supervisor.trimmed());
 }
 
 /**
@@ -55,7 +57,7 @@ void Thesis::setUniversity(const QString& university) {
     if (university.trimmed().isEmpty()) {
         throw ThesisException("University name cannot be empty");
     }
-    m_university = university.trimmed();
+    m_university = StringPool::intern(university.trimmed());
 }
 
 /**
@@ -65,7 +67,7 @@ void Thesis::setDepartment(const QString& department) {
     if (department.trimmed().isEmpty()) {
         throw ThesisException("Department name cannot be empty");
     }
-    m_department = department.trimmed();
+    m_department = StringPool::intern(department.trimmed());
 }
 
 /**
@@ -144,13 +146,37 @@ void Thesis::fromJson(const QJsonObject& json) {
     setDescription(json["description"].toString());
     
     // Load thesis-specific fields
-    m_supervisor = json["supervisor"].toString();
-    m_university = json["university"].toString();
-    m_department = json["department"].toString();
+    m_supervisor = StringPool::intern(json["supervisor"].toString());
+    m_university = StringPool::intern(json["university"].toString());
+    m_department = StringPool::intern(json["department"].toString());
     m_degreeLevel = stringToDegreeLevel(json["degreeLevel"].toString());
     m_keywords = json["keywords"].toString();
 }
 
+/**
+ * @brief Write the thesis-specific CBOR fields
+ */
+void Thesis::writeCborFields(QCborStreamWriter& writer) const {
+    CborRecord::writeText(writer, CborSupervisor, m_supervisor);
+    CborRecord::writeText(writer, CborUniversity, m_university);
+    CborRecord::writeText(writer, CborDepartment, m_department);
+    CborRecord::writeInteger(writer, CborDegreeLevel, static_cast<int>(m_degreeLevel));
+    CborRecord::writeText(writer, CborKeywords, m_keywords);
+}
+
+/**
+ * @brief Load thesis from a decoded CBOR record
+ */
+void Thesis::readCbor(const CborRecord& record) {
+    readCborBaseFields(record);
+    
+    m_supervisor = StringPool::intern(record.text(CborSupervisor));
+    m_university = StringPool::intern(record.text(CborUniversity));
+    m_department = StringPool::intern(record.text(CborDepartment));
+    m_degreeLevel = record.enumValue(CborDegreeLevel, DegreeLevel::Bachelors, 4);
+    m_keywords = record.text(CborKeywords);
+}
+
 /**
  * @brief Convert degree level to string
  */
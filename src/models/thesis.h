@@ -11,7 +11,7 @@
  * This class extends Resource to handle thesis-specific information
  * such as supervisor, university, and degree level.
  */
-class Thesis : public Resource {
+class Thesis final : public Resource {
 public:
     enum class DegreeLevel {
         Bachelors,
@@ -20,6 +20,15 @@ public:
         Postdoc
     };
 
+    // CBOR field keys (after the shared Resource keys)
+    enum CborKey : int {
+        CborSupervisor = CborSubclassKeys,
+        CborUniversity,
+        CborDepartment,
+        CborDegreeLevel,
+        CborKeywords
+    };
+
 private:
     QString m_supervisor;
     QString m_university;
@@ -56,11 +65,11 @@ public:    // Constructor
     void setDegreeLevel(DegreeLevel level);
     void setKeywords(const QString& keywords);    // Override base class methods
     QString getDetails() const override;
-    QString getResourceType() const override { return "Thesis"; }
 
     // JSON serialization
     QJsonObject toJson() const override;
     void fromJson(const QJsonObject& json) override;
+    void readCbor(const CborRecord& record) override;
 
     // Static utility functions
     static QString degreeLevelToString(DegreeLevel level);
@@ -69,6 +78,9 @@ public:    // Constructor
     // Validation
     bool isValidThesis() const;
 
+protected:
+    void writeCborFields(QCborStreamWriter& writer) const override;
+
 private:
     void initializeThesis();
     void validateThesisData() const;
@@ -1,5 +1,6 @@
 #include "user.h"
 #include "loan.h"
+#include "cbor_record.h"
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QRegularExpression>
@@ -11,8 +12,8 @@
 User::User(const QString& userId, const QString& firstName, const QString& lastName,
            const QString& email, UserType userType)    : m_userId(userId), m_firstName(firstName), m_lastName(lastName),
       m_email(email), m_userType(userType), m_status(Status::Active),
-      m_registrationDate(QDateTime::currentDateTime()),
-      m_lastActivity(QDateTime::currentDateTime()), 
+      m_registrationDate(EpochTime::now()),
+      m_lastActivity(m_registrationDate), 
       m_year(userType == UserType::Student ? 1 : -1) { // Default to 1st year for students, -1 for others
     
     validateUserData();
@@ -85,13 +86,10 @@ void User::setFirstName(const QString& firstName) {
 }
 
 /**
- * @brief Set last name with validation
+ * @brief Set last name
  */
 void User::setLastName(const QString& lastName) {
-    if (lastName.isEmpty()) {
-        throw UserException("Last name cannot be empty");
-    }
-    m_lastName = lastName;
+    m_lastName = lastName; // Empty for single-word names
 }
 
 /**
@@ -168,7 +166,7 @@ void User::setYear(int year) {
  * @brief Update last activity to current time
  */
 void User::updateLastActivity() {
-    m_lastActivity = QDateTime::currentDateTime();
+    m_lastActivity = EpochTime::now();
 }
 
 /**
@@ -261,9 +259,16 @@ bool User::canBorrow() const {
  * @brief Check if user has overdue items
  */
 bool User::hasOverdueItems() const {
+    return hasOverdueItems(EpochTime::now());
+}
+
+/**
+ * @brief Check if user has overdue items at the given time
+ */
+bool User::hasOverdueItems(qint64 nowMSecs) const {
     return std::any_of(m_currentLoans.begin(), m_currentLoans.end(),
-                      [](const std::unique_ptr<Loan>& loan) {
-                          return loan->isOverdue();
+                      [nowMSecs](const std::unique_ptr<Loan>& loan) {
+                          return loan->isOverdue(nowMSecs);
                       });
 }
 
@@ -294,7 +299,7 @@ QJsonObject User::toJson() const {
     json["address"] = m_address;
     json["userType"] = userTypeToString(m_userType);
     json["status"] = statusToString(m_status);
-    json["registrationDate"] = m_registrationDate.toString(Qt::ISODate);    json["lastActivity"] = m_lastActivity.toString(Qt::ISODate);    json["maxBorrowLimit"] = m_maxBorrowLimit;
+    json["registrationDate"] = EpochTime::toIsoString(m_registrationDate);    json["lastActivity"] = EpochTime::toIsoString(m_lastActivity);    json["maxBorrowLimit"] = m_maxBorrowLimit;
     json["notes"] = m_notes;
     json["year"] = m_year;
     
@@ -326,8 +331,8 @@ void User::fromJson(const QJsonObject& json) {
     m_phoneNumber = json["phoneNumber"].toString();
     m_address = json["address"].toString();
     m_userType = stringToUserType(json["userType"].toString());    m_status = stringToStatus(json["status"].toString());
-    m_registrationDate = QDateTime::fromString(json["registrationDate"].toString(), Qt::ISODate);
-    m_lastActivity = QDateTime::fromString(json["lastActivity"].toString(), Qt::ISODate);    m_maxBorrowLimit = json["maxBorrowLimit"].toInt();
+    m_registrationDate = EpochTime::fromIsoString(json["registrationDate"].toString());
+    m_lastActivity = EpochTime::fromIsoString(json["lastActivity"].toString());    m_maxBorrowLimit = json["maxBorrowLimit"].toInt();
     m_notes = json["notes"].toString();
     m_year = json["year"].toInt(-1); // Default to -1 if not specified
     
@@ -350,6 +355,70 @@ void User::fromJson(const QJsonObject& json) {
     }
 }
 
+/**
+ * @brief Write user as a CBOR map keyed by CborKey, loans included
+ */
+void User::writeCbor(QCborStreamWriter& writer) const {
+    writer.startMap();
+    CborRecord::writeText(writer, CborUserId, m_userId);
+    CborRecord::writeText(writer, CborFirstName, m_firstName);
+    CborRecord::writeText(writer, CborLastName, m_lastName);
+    CborRecord::writeText(writer, CborEmail, m_email);
+    CborRecord::writeText(writer, CborPhoneNumber, m_phoneNumber);
+    CborRecord::writeText(writer, CborAddress, m_address);
+    CborRecord::writeInteger(writer, CborUserType, static_cast<int>(m_userType));
+    CborRecord::writeInteger(writer, CborStatus, static_cast<int>(m_status));
+    CborRecord::writeInteger(writer, CborRegistrationDate, m_registrationDate);
+    CborRecord::writeInteger(writer, CborLastActivity, m_lastActivity);
+    CborRecord::writeInteger(writer, CborMaxBorrowLimit, m_maxBorrowLimit);
+    CborRecord::writeText(writer, CborNotes, m_notes);
+    CborRecord::writeInteger(writer, CborYear, m_year);
+    
+    writer.append(static_cast<int>(CborCurrentLoans));
+    writer.startArray(static_cast<quint64>(m_currentLoans.size()));
+    for (const auto& loan : m_currentLoans) {
+        loan->writeCbor(writer);
+    }
+    writer.endArray();
+    
+    writer.append(static_cast<int>(CborLoanHistory));
+    writer.startArray(static_cast<quint64>(m_loanHistory.size()));
+    for (const auto& loan : m_loanHistory) {
+        loan->writeCbor(writer);
+    }
+    writer.endArray();
+    
+    writer.endMap();
+}
+
+/**
+ * @brief Load user scalar fields from a decoded CBOR record
+ */
+void User::readCbor(const CborRecord& record) {
+    m_userId = record.text(CborUserId);
+    m_firstName = record.text(CborFirstName);
+    m_lastName = record.text(CborLastName);
+    m_email = record.text(CborEmail);
+    m_phoneNumber = record.text(CborPhoneNumber);
+    m_address = record.text(CborAddress);
+    m_userType = record.enumValue(CborUserType, UserType::Student, 5);
+    m_status = record.enumValue(CborStatus, Status::Active, 4);
+    m_registrationDate = record.integer(CborRegistrationDate, m_registrationDate);
+    m_lastActivity = record.integer(CborLastActivity, m_lastActivity);
+    m_maxBorrowLimit = static_cast<int>(record.integer(CborMaxBorrowLimit, m_maxBorrowLimit));
+    m_notes = record.text(CborNotes);
+    m_year = static_cast<int>(record.integer(CborYear, -1));
+}
+
+/**
+ * @brief Install decoded loans without re-applying borrowing limits
+ */
+void User::restoreLoans(std::vector<std::unique_ptr<Loan>> currentLoans,
+                        std::vector<std::unique_ptr<Loan>> loanHistory) {
+    m_currentLoans = std::move(currentLoans);
+    m_loanHistory = std::move(loanHistory);
+}
+
 /**
  * @brief Get formatted user information
  */
@@ -468,9 +537,6 @@ void User::validateUserData() const {
     if (m_firstName.isEmpty()) {
         throw UserException("First name cannot be empty");
     }
-    if (m_lastName.isEmpty()) {
-        throw UserException("Last name cannot be empty");
-    }
     if (!isValidEmail(m_email)) {
         throw UserException("Invalid email format");
     }
@@ -6,10 +6,14 @@
 #include <QDate>
 #include <QTime>
 #include <QJsonObject>
+#include <QCborStreamWriter>
 #include <vector>
 #include <memory>
 
 #include "loan.h"
+#include "epoch_time.h"
+
+class CborRecord;
 
 /**
  * @brief Represents a library user
@@ -36,6 +40,25 @@ public:    enum class UserType {
         Expired
     };
 
+    // Integer field keys of the CBOR encoding
+    enum CborKey : int {
+        CborUserId = 0,
+        CborFirstName,
+        CborLastName,
+        CborEmail,
+        CborPhoneNumber,
+        CborAddress,
+        CborUserType,
+        CborStatus,
+        CborRegistrationDate,
+        CborLastActivity,
+        CborMaxBorrowLimit,
+        CborNotes,
+        CborYear,
+        CborCurrentLoans,
+        CborLoanHistory
+    };
+
 private:
     QString m_userId;    QString m_firstName;
     QString m_lastName;
@@ -44,8 +67,8 @@ private:
     QString m_address;
     UserType m_userType;
     Status m_status;
-    QDateTime m_registrationDate;
-    QDateTime m_lastActivity;    int m_maxBorrowLimit;
+    qint64 m_registrationDate; // UTC epoch milliseconds
+    qint64 m_lastActivity;     // UTC epoch milliseconds    int m_maxBorrowLimit;
     QString m_notes;
     int m_year; // For students: 1st-5th year, -1 for non-students
     
@@ -77,8 +100,10 @@ public:    // Constructor
     QString getPhoneNumber() const { return m_phoneNumber; }
     QString getAddress() const { return m_address; }
     UserType getUserType() const { return m_userType; }
-    Status getStatus() const { return m_status; }    QDateTime getRegistrationDate() const { return m_registrationDate; }
-    QDateTime getLastActivity() const { return m_lastActivity; }    int getMaxBorrowLimit() const { return m_maxBorrowLimit; }
+    Status getStatus() const { return m_status; }    QDateTime getRegistrationDate() const { return EpochTime::toDateTime(m_registrationDate); }
+    QDateTime getLastActivity() const { return EpochTime::toDateTime(m_lastActivity); }
+    qint64 getRegistrationDateMSecs() const { return m_registrationDate; }
+    qint64 getLastActivityMSecs() const { return m_lastActivity; }    int getMaxBorrowLimit() const { return m_maxBorrowLimit; }
     QString getNotes() const { return m_notes; }
     int getYear() const { return m_year; }
       // Additional getters for dialog compatibility
@@ -113,12 +138,20 @@ public:    // Constructor
       // User status checks
     bool canBorrow() const;
     bool hasOverdueItems() const;
+    bool hasOverdueItems(qint64 nowMSecs) const;
     bool hasMaxLoansReached() const;
     int getCurrentLoanCount() const;
 
     // JSON serialization
     QJsonObject toJson() const;
     void fromJson(const QJsonObject& json);
+    
+    // CBOR serialization (binary snapshots); loans are decoded by the caller
+    // from the CborCurrentLoans/CborLoanHistory arrays and handed to restoreLoans
+    void writeCbor(QCborStreamWriter& writer) const;
+    void readCbor(const CborRecord& record);
+    void restoreLoans(std::vector<std::unique_ptr<Loan>> currentLoans,
+                      std::vector<std::unique_ptr<Loan>> loanHistory);
 
     // Utility functions
     QString getFormattedInfo() const;
@@ -0,0 +1,98 @@
+#include "background_saver.h"
+#include "library_manager.h"
+#include <QtConcurrent/QtConcurrentRun>
+
+/**
+ * @brief Constructor for BackgroundSaver
+ */
+BackgroundSaver::BackgroundSaver(PersistenceService& persistenceService, const LibraryManager& libraryManager,
+                                 QObject* parent)
+    : QObject(parent), m_persistenceService(persistenceService), m_libraryManager(libraryManager),
+      m_saving(false), m_savePending(false) {
+    connect(&m_watcher, &QFutureWatcher<bool>::finished, this, &BackgroundSaver::onWriteFinished);
+}
+
+/**
+ * @brief Destructor for BackgroundSaver; never leaves a write running
+ */
+BackgroundSaver::~BackgroundSaver() {
+    waitForIdle();
+}
+
+/**
+ * @brief Save now, or once the running save is done
+ */
+void BackgroundSaver::requestSave() {
+    if (m_saving) {
+        m_savePending = true;
+        return;
+    }
+    startSave();
+}
+
+/**
+ * @brief Block until the running save is written and committed
+ */
+void BackgroundSaver::waitForIdle() {
+    m_savePending = false;
+    if (m_saving) {
+        m_watcher.waitForFinished();
+        finishSave();
+    }
+}
+
+/**
+ * @brief Delivered on the GUI thread once the worker has written the files
+ */
+void BackgroundSaver::onWriteFinished() {
+    // waitForIdle() may already have committed this save
+    if (m_saving) {
+        finishSave();
+    }
+}
+
+// Private helper methods
+
+/**
+ * @brief Capture a snapshot here and hand its writing to the thread pool
+ */
+void BackgroundSaver::startSave() {
+    m_savePending = false;
+    if (!m_persistenceService.captureSnapshot(m_libraryManager, m_snapshot)) {
+        emit saveFinished(false, m_persistenceService.getLastError());
+        return;
+    }
+
+    // Nothing changed: committing only clears the journal
+    if (m_snapshot.isEmpty()) {
+        bool committed = m_persistenceService.commitSnapshot(m_snapshot);
+        emit saveFinished(committed, committed ? QString() : m_persistenceService.getLastError());
+        return;
+    }
+
+    m_saving = true;
+    PersistenceService* service = &m_persistenceService;
+    PersistenceService::SaveSnapshot* snapshot = &m_snapshot;
+    m_watcher.setFuture(QtConcurrent::run([service, snapshot]() {
+        return service->writeSnapshot(*snapshot);
+    }));
+}
+
+/**
+ * @brief Commit the written snapshot and start the coalesced follow-up, if any
+ */
+void BackgroundSaver::finishSave() {
+    m_saving = false;
+
+    bool written = m_watcher.future().result();
+    bool committed = m_persistenceService.commitSnapshot(m_snapshot);
+    bool success = written && committed;
+    QString error = success ? QString() : m_persistenceService.getLastError();
+    m_snapshot = PersistenceService::SaveSnapshot(); // Release the shared buffers
+
+    emit saveFinished(success, error);
+
+    if (m_savePending) {
+        startSave();
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef BACKGROUND_SAVER_H
+#define BACKGROUND_SAVER_H
+
+#include <QObject>
+#include <QString>
+#include <QFutureWatcher>
+
+#include "persistence_service.h"
+
+class LibraryManager;
+
+/**
+ * @brief Saves library data on a worker thread so the GUI never waits on disk
+ *
+ * A save captures a PersistenceService::SaveSnapshot on the calling (GUI)
+ * thread - dirty entities are copied, unchanged ones share their cached
+ * encoding - then encodes and writes the files on the global thread pool
+ * and commits the saved revisions back on the GUI thread. Requests made while a save is
+ * running coalesce into a single follow-up save.
+ */
+class BackgroundSaver : public QObject {
+    Q_OBJECT
+
+public:
+    BackgroundSaver(PersistenceService& persistenceService, const LibraryManager& libraryManager,
+                    QObject* parent = nullptr);
+    ~BackgroundSaver() override;
+
+    // Save now, or after the running save if one is in progress
+    void requestSave();
+    bool isSaving() const { return m_saving; }
+
+    // Finish the running save and drop any queued one (a synchronous save follows)
+    void waitForIdle();
+
+signals:
+    void saveFinished(bool success, const QString& error);
+
+private slots:
+    void onWriteFinished();
+
+private:
+    PersistenceService& m_persistenceService;
+    const LibraryManager& m_libraryManager;
+    QFutureWatcher<bool> m_watcher;
+    PersistenceService::SaveSnapshot m_snapshot; // Owned by the worker while m_saving
+    bool m_saving;
+    bool m_savePending;
+
+    void startSave();
+    void finishSave();
+};
+
+#endif // BACKGROUND_SAVER_H
@@ -0,0 +1,461 @@
+#include "backup_store.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QSet>
+#include <QDebug>
+#include <algorithm>
+#include <array>
+
+namespace {
+
+/**
+ * @brief Fixed pseudo-random values per byte for the gear hash
+ * 
+ * Generated with splitmix64 so chunk boundaries, and with them the
+ * deduplication, stay stable across builds and platforms.
+ */
+constexpr std::array<quint64, 256> makeGearTable() {
+    std::array<quint64, 256> table{};
+    quint64 state = 0x454E5349415259ULL;
+    for (quint64& value : table) {
+        state += 0x9E3779B97F4A7C15ULL;
+        quint64 z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        value = z ^ (z >> 31);
+    }
+    return table;
+}
+
+constexpr std::array<quint64, 256> GearTable = makeGearTable();
+
+// 13 bits: a boundary every 8 KiB on average. The top bits are used because
+// they depend on the most bytes of the window.
+constexpr quint64 BoundaryMask = ((quint64(1) << 13) - 1) << (64 - 13);
+
+} // namespace
+
+/**
+ * @brief Constructor for BackupStore
+ */
+BackupStore::BackupStore(const QString& directory)
+    : m_directory(directory) {
+}
+
+/**
+ * @brief Back up files of a directory under the given id
+ * @param fileNames Names relative to sourceDirectory, restored in this order
+ *
+ * Only chunks not already in the store are written, and files unchanged
+ * since the newest backup are not even read.
+ */
+bool BackupStore::create(const QString& id, const QString& sourceDirectory, const QStringList& fileNames) {
+    m_lastError.clear();
+    if (!isPlainName(id)) {
+        setError("Invalid backup id: " + id);
+        return false;
+    }
+
+    Backup backup;
+    backup.id = id;
+    backup.timestamp = QDateTime::currentDateTimeUtc();
+
+    // Entries of the newest backup, reused for files that have not been touched since
+    std::vector<Backup> previous = list();
+    auto previousEntry = [&previous](const QString& name) -> const FileEntry* {
+        if (previous.empty()) {
+            return nullptr;
+        }
+        for (const FileEntry& entry : previous.front().files) {
+            if (entry.name == name) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    };
+
+    for (const QString& name : fileNames) {
+        if (!isPlainName(name)) {
+            setError("Invalid backup file name: " + name);
+            return false;
+        }
+        QFileInfo info(sourceDirectory + "/" + name);
+        const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+        const FileEntry* earlier = previousEntry(name);
+        if (earlier && earlier->size == info.size() && earlier->modified == modified) {
+            backup.files.push_back(*earlier);
+            continue;
+        }
+
+        FileEntry entry;
+        if (!storeFile(info.filePath(), name, modified, entry)) {
+            return false;
+        }
+        backup.files.push_back(std::move(entry));
+    }
+
+    return writeCatalog(backup);
+}
+
+/**
+ * @brief Store files kept elsewhere (e.g. old-style backup copies) as a backup
+ * @param timestamp When the files were backed up originally
+ *
+ * Unlike create(), every file is read, since none of them has to match
+ * what an earlier backup recorded under the same name.
+ */
+bool BackupStore::importFiles(const QString& id, const QDateTime& timestamp,
+                              const std::vector<ImportFile>& files) {
+    m_lastError.clear();
+    if (!isPlainName(id)) {
+        setError("Invalid backup id: " + id);
+        return false;
+    }
+
+    Backup backup;
+    backup.id = id;
+    backup.timestamp = timestamp.toUTC();
+    for (const ImportFile& file : files) {
+        if (!isPlainName(file.name)) {
+            setError("Invalid backup file name: " + file.name);
+            return false;
+        }
+        FileEntry entry;
+        if (!storeFile(file.sourcePath, file.name,
+                       QFileInfo(file.sourcePath).lastModified().toMSecsSinceEpoch(), entry)) {
+            return false;
+        }
+        backup.files.push_back(std::move(entry));
+    }
+
+    return writeCatalog(backup);
+}
+
+/**
+ * @brief Whether a name can be used as a single path component
+ */
+bool BackupStore::isPlainName(const QString& name) {
+    return !name.isEmpty() && name != "." && name != ".." && !name.contains('/') && !name.contains('\\');
+}
+
+/**
+ * @brief Delete backups outside the retention policy, then chunks no backup refers to
+ */
+bool BackupStore::prune(const RetentionPolicy& policy) {
+    m_lastError.clear();
+
+    const QDateTime cutoff = QDateTime::currentDateTimeUtc().addDays(-policy.keepDays);
+    QSet<QDate> keptDays;
+    QSet<QByteArray> referenced;
+    bool success = true;
+
+    std::vector<Backup> backups = list();
+    for (std::size_t i = 0; i < backups.size(); ++i) {
+        const Backup& backup = backups[i];
+        const QDate day = backup.timestamp.toLocalTime().date();
+
+        bool keep = static_cast<int>(i) < policy.keepLast ||
+                    (backup.timestamp >= cutoff && !keptDays.contains(day));
+        if (keep) {
+            keptDays.insert(day);
+        } else if (QFile::remove(catalogPath(backup.id))) {
+            continue;
+        } else {
+            // Still listed, so its chunks must survive the sweep below
+            setError("Failed to remove backup: " + backup.id);
+            success = false;
+        }
+
+        for (const FileEntry& entry : backup.files) {
+            for (const QByteArray& chunk : entry.chunks) {
+                referenced.insert(chunk);
+            }
+        }
+    }
+
+    QDir objectDir(m_directory + "/objects");
+    for (const QString& fileName : objectDir.entryList({"*.z"}, QDir::Files)) {
+        if (!referenced.contains(fileName.chopped(2).toLatin1())) {
+            objectDir.remove(fileName);
+        }
+    }
+
+    return success;
+}
+
+/**
+ * @brief List every readable backup, newest first
+ */
+std::vector<BackupStore::Backup> BackupStore::list() const {
+    std::vector<Backup> backups;
+    QDir dir(m_directory);
+    for (const QString& fileName : dir.entryList({"*.backup.json"}, QDir::Files)) {
+        Backup backup;
+        if (readCatalog(dir.filePath(fileName), backup)) {
+            backups.push_back(std::move(backup));
+        }
+    }
+
+    std::sort(backups.begin(), backups.end(), [](const Backup& a, const Backup& b) {
+        return a.timestamp > b.timestamp;
+    });
+    return backups;
+}
+
+/**
+ * @brief Find a backup by id
+ */
+bool BackupStore::find(const QString& id, Backup& backup) const {
+    return isPlainName(id) && readCatalog(catalogPath(id), backup) && backup.id == id;
+}
+
+/**
+ * @brief Check that every file of a backup can be read back intact
+ */
+bool BackupStore::verify(const Backup& backup) {
+    QByteArray contents;
+    for (const FileEntry& entry : backup.files) {
+        if (!readFile(entry, contents)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reassemble one backed-up file, checking every chunk and the whole file
+ */
+bool BackupStore::readFile(const FileEntry& entry, QByteArray& contents) {
+    contents.clear();
+    contents.reserve(entry.size);
+
+    for (const QByteArray& checksum : entry.chunks) {
+        QFile file(objectPath(checksum));
+        if (!file.open(QIODevice::ReadOnly)) {
+            setError("Missing backup chunk for " + entry.name);
+            return false;
+        }
+
+        QByteArray chunk = qUncompress(file.readAll());
+        if (QCryptographicHash::hash(chunk, QCryptographicHash::Sha256).toHex() != checksum) {
+            setError("Backup chunk failed its checksum: " + entry.name);
+            return false;
+        }
+        contents.append(chunk);
+    }
+
+    if (contents.size() != entry.size ||
+        QCryptographicHash::hash(contents, QCryptographicHash::Sha256).toHex() != entry.checksum) {
+        setError("Backup file failed its checksum: " + entry.name);
+        return false;
+    }
+    return true;
+}
+
+// Private helper methods
+
+/**
+ * @brief Find content-defined chunk boundaries
+ * @return End offset of each chunk; the last one is contents.size()
+ */
+std::vector<qsizetype> BackupStore::chunkBoundaries(const QByteArray& contents) {
+    std::vector<qsizetype> boundaries;
+    const auto* bytes = reinterpret_cast<const uchar*>(contents.constData());
+    const qsizetype size = contents.size();
+
+    qsizetype start = 0;
+    while (start < size) {
+        const qsizetype limit = std::min(size, start + MaxChunkSize);
+        qsizetype end = limit;
+        quint64 hash = 0;
+
+        // Bytes before the minimum size only warm up the hash
+        for (qsizetype i = start; i < limit; ++i) {
+            hash = (hash << 1) + GearTable[bytes[i]];
+            if (i + 1 - start >= MinChunkSize && (hash & BoundaryMask) == 0) {
+                end = i + 1;
+                break;
+            }
+        }
+
+        boundaries.push_back(end);
+        start = end;
+    }
+    return boundaries;
+}
+
+/**
+ * @brief Whether a catalog value is a hex SHA-256, and so safe to build an object path from
+ */
+bool BackupStore::isChecksum(const QByteArray& checksum) {
+    return checksum.size() == 64 && std::all_of(checksum.begin(), checksum.end(), [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+    });
+}
+
+/**
+ * @brief Read one file and write the chunks the store does not hold yet
+ */
+bool BackupStore::storeFile(const QString& sourcePath, const QString& name, qint64 modified, FileEntry& entry) {
+    QFile file(sourcePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError("Cannot open file for backup: " + file.fileName());
+        return false;
+    }
+    QByteArray contents = file.readAll();
+
+    entry.name = name;
+    entry.checksum = QCryptographicHash::hash(contents, QCryptographicHash::Sha256).toHex();
+    entry.size = contents.size();
+    entry.modified = modified;
+    entry.chunks.clear();
+
+    // Only chunks no earlier backup holds are compressed and written
+    qsizetype start = 0;
+    for (qsizetype end : chunkBoundaries(contents)) {
+        QByteArray chunk = contents.sliced(start, end - start);
+        QByteArray checksum = QCryptographicHash::hash(chunk, QCryptographicHash::Sha256).toHex();
+        if (!QFile::exists(objectPath(checksum)) && !writeObject(checksum, chunk)) {
+            return false;
+        }
+        entry.chunks.push_back(checksum);
+        start = end;
+    }
+    return true;
+}
+
+/**
+ * @brief Path of the object holding the chunk with the given checksum
+ */
+QString BackupStore::objectPath(const QByteArray& checksum) const {
+    return m_directory + "/objects/" + QString::fromLatin1(checksum) + ".z";
+}
+
+/**
+ * @brief Path of a backup's catalog
+ */
+QString BackupStore::catalogPath(const QString& id) const {
+    return m_directory + "/" + id + ".backup.json";
+}
+
+/**
+ * @brief Compress and store one chunk
+ */
+bool BackupStore::writeObject(const QByteArray& checksum, const QByteArray& contents) {
+    if (!QDir().mkpath(m_directory + "/objects")) {
+        setError("Failed to create backup directory: " + m_directory);
+        return false;
+    }
+
+    QSaveFile file(objectPath(checksum));
+    if (!file.open(QIODevice::WriteOnly)) {
+        setError("Cannot open file for writing: " + file.fileName());
+        return false;
+    }
+
+    QByteArray compressed = qCompress(contents);
+    if (file.write(compressed) != compressed.size() || !file.commit()) {
+        setError(QString("Failed to write backup object: %1 (%2)").arg(file.fileName(), file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse a backup catalog
+ */
+bool BackupStore::readCatalog(const QString& filePath, Backup& backup) const {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonObject root = QJsonDocument::fromJson(file.readAll(), &error).object();
+    if (error.error != QJsonParseError::NoError || root["type"].toString() != "backup") {
+        qDebug() << "Ignoring unreadable backup catalog:" << filePath;
+        return false;
+    }
+
+    backup.id = root["id"].toString();
+    backup.timestamp = QDateTime::fromString(root["timestamp"].toString(), Qt::ISODate);
+    backup.files.clear();
+    for (const QJsonValue& value : root["files"].toArray()) {
+        QJsonObject fileJson = value.toObject();
+        FileEntry entry;
+        entry.name = fileJson["name"].toString();
+        entry.checksum = fileJson["sha256"].toString().toLatin1();
+        entry.size = fileJson["size"].toInteger();
+        entry.modified = fileJson["modified"].toInteger();
+        for (const QJsonValue& chunk : fileJson["chunks"].toArray()) {
+            entry.chunks.push_back(chunk.toString().toLatin1());
+        }
+        // Catalogs from before chunking stored each file as one object
+        if (!fileJson.contains("chunks") && entry.size > 0) {
+            entry.chunks.push_back(entry.checksum);
+        }
+        // Names and checksums become paths when restoring, so nothing may point outside the store
+        if (!isPlainName(entry.name) || !isChecksum(entry.checksum) ||
+            !std::all_of(entry.chunks.begin(), entry.chunks.end(), &BackupStore::isChecksum)) {
+            qDebug() << "Ignoring backup catalog with an invalid file entry:" << filePath;
+            return false;
+        }
+        backup.files.push_back(std::move(entry));
+    }
+
+    return isPlainName(backup.id) && backup.timestamp.isValid();
+}
+
+/**
+ * @brief Write a backup's catalog, which makes the backup visible
+ */
+bool BackupStore::writeCatalog(const Backup& backup) {
+    if (!QDir().mkpath(m_directory)) {
+        setError("Failed to create backup directory: " + m_directory);
+        return false;
+    }
+
+    QJsonArray files;
+    for (const FileEntry& entry : backup.files) {
+        QJsonObject fileJson;
+        fileJson["name"] = entry.name;
+        fileJson["sha256"] = QString::fromLatin1(entry.checksum);
+        fileJson["size"] = entry.size;
+        fileJson["modified"] = entry.modified;
+        QJsonArray chunks;
+        for (const QByteArray& chunk : entry.chunks) {
+            chunks.append(QString::fromLatin1(chunk));
+        }
+        fileJson["chunks"] = chunks;
+        files.append(fileJson);
+    }
+
+    QJsonObject root;
+    root["version"] = "1.0";
+    root["type"] = "backup";
+    root["id"] = backup.id;
+    root["timestamp"] = backup.timestamp.toString(Qt::ISODate);
+    root["files"] = files;
+
+    QSaveFile file(catalogPath(backup.id));
+    QByteArray json = QJsonDocument(root).toJson();
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        setError(QString("Failed to write backup catalog: %1 (%2)").arg(file.fileName(), file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Set error message
+ */
+void BackupStore::setError(const QString& error) {
+    m_lastError = error;
+    qDebug() << "BackupStore Error:" << error;
+}
@@ -0,0 +1,98 @@
+#ifndef BACKUP_STORE_H
+#define BACKUP_STORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QDateTime>
+#include <vector>
+
+/**
+ * @brief Compressed, deduplicated backups of a data directory
+ *
+ * Files are cut into content-defined chunks: boundaries are placed where a
+ * rolling (gear) hash of the last bytes matches a bit pattern, so inserting
+ * or appending data only changes the chunks around the edit. Each distinct
+ * chunk is stored once, zlib-compressed and named after the SHA-256 of its
+ * bytes. A backup is a catalog listing every file as its chunk sequence, so
+ * appending to loan history costs the changed tail chunk plus the catalog.
+ * Files whose size and modification time match the previous backup are not
+ * read at all.
+ *
+ * Layout below the store directory:
+ *   objects/<sha256>.z     qCompress'ed chunk
+ *   <id>.backup.json       catalog of one backup
+ *
+ * Catalogs are written after their chunks, and both through QSaveFile, so
+ * an interrupted backup leaves at most unreferenced chunks behind.
+ *
+ * Backup ids and file names become path components, so both must be plain
+ * names; catalogs naming anything else are treated as unreadable.
+ */
+class BackupStore {
+public:
+    struct FileEntry {
+        QString name; // Relative to the backed-up directory
+        QByteArray checksum; // Hex SHA-256 of the whole file
+        qint64 size = 0;
+        qint64 modified = 0; // Modification time (ms since epoch) when backed up
+        std::vector<QByteArray> chunks; // Hex SHA-256 of each chunk, in file order
+    };
+
+    // Chunk size bounds; the boundary mask gives roughly 8 KiB on average
+    static constexpr qsizetype MinChunkSize = 2 * 1024;
+    static constexpr qsizetype MaxChunkSize = 64 * 1024;
+
+    struct Backup {
+        QString id;
+        QDateTime timestamp; // UTC
+        std::vector<FileEntry> files; // In the order they were backed up
+    };
+
+    // The newest keepLast backups are always kept; older ones are thinned to
+    // the newest per day for keepDays days, and dropped after that
+    struct RetentionPolicy {
+        int keepLast = 5;
+        int keepDays = 30;
+    };
+
+    explicit BackupStore(const QString& directory);
+
+    // A file to import: where it is now, and the name it is restored under
+    struct ImportFile {
+        QString sourcePath;
+        QString name;
+    };
+
+    // Writing
+    bool create(const QString& id, const QString& sourceDirectory, const QStringList& fileNames);
+    bool importFiles(const QString& id, const QDateTime& timestamp, const std::vector<ImportFile>& files);
+    bool prune(const RetentionPolicy& policy);
+
+    // Reading
+    std::vector<Backup> list() const; // Readable catalogs, newest first
+    bool find(const QString& id, Backup& backup) const;
+    bool verify(const Backup& backup);
+    bool readFile(const FileEntry& entry, QByteArray& contents);
+
+    // Information
+    QString getDirectory() const { return m_directory; }
+    QString getLastError() const { return m_lastError; }
+    static bool isPlainName(const QString& name); // Usable as one path component
+
+private:
+    QString m_directory;
+    QString m_lastError;
+
+    static std::vector<qsizetype> chunkBoundaries(const QByteArray& contents);
+    static bool isChecksum(const QByteArray& checksum);
+    bool storeFile(const QString& sourcePath, const QString& name, qint64 modified, FileEntry& entry);
+    QString objectPath(const QByteArray& checksum) const;
+    QString catalogPath(const QString& id) const;
+    bool writeObject(const QByteArray& checksum, const QByteArray& contents);
+    bool readCatalog(const QString& filePath, Backup& backup) const;
+    bool writeCatalog(const Backup& backup);
+    void setError(const QString& error);
+};
+
+#endif // BACKUP_STORE_H
@@ -0,0 +1,392 @@
+#include "cbor_snapshot.h"
+#include "resource_store.h"
+#include "../models/cbor_record.h"
+#include "../models/resource.h"
+#include "../models/book.h"
+#include "../models/article.h"
+#include "../models/thesis.h"
+#include "../models/digitalcontent.h"
+#include "../models/user.h"
+#include "../models/loan.h"
+#include "../models/reservation.h"
+#include "../models/epoch_time.h"
+#include <QFileDevice>
+
+/**
+ * @brief Write resources straight from the manager's typed segments
+ */
+bool CborSnapshot::writeResources(QIODevice& device, const ResourceStore& store) {
+    QCborStreamWriter writer(&device);
+    writeHeader(writer, Type::Resources);
+
+    writer.append(static_cast<int>(RootData));
+    writer.startArray(static_cast<quint64>(store.size()));
+    store.forEach([&writer](const Resource& resource) {
+        resource.writeCbor(writer);
+    });
+    writer.endArray();
+
+    writer.endMap();
+    return finishWrite(device, "resources");
+}
+
+/**
+ * @brief Write resources from a list
+ */
+bool CborSnapshot::writeResources(QIODevice& device, std::span<const std::unique_ptr<Resource>> resources) {
+    QCborStreamWriter writer(&device);
+    writeHeader(writer, Type::Resources);
+
+    writer.append(static_cast<int>(RootData));
+    writer.startArray(static_cast<quint64>(resources.size()));
+    for (const auto& resource : resources) {
+        resource->writeCbor(writer);
+    }
+    writer.endArray();
+
+    writer.endMap();
+    return finishWrite(device, "resources");
+}
+
+/**
+ * @brief Write users, each with its nested loans
+ */
+bool CborSnapshot::writeUsers(QIODevice& device, std::span<const std::unique_ptr<User>> users) {
+    QCborStreamWriter writer(&device);
+    writeHeader(writer, Type::Users);
+
+    writer.append(static_cast<int>(RootData));
+    writer.startArray(static_cast<quint64>(users.size()));
+    for (const auto& user : users) {
+        user->writeCbor(writer);
+    }
+    writer.endArray();
+
+    writer.endMap();
+    return finishWrite(device, "users");
+}
+
+/**
+ * @brief Write active loans and loan history
+ */
+bool CborSnapshot::writeLoans(QIODevice& device, std::span<const std::unique_ptr<Loan>> activeLoans,
+                              std::span<const std::unique_ptr<Loan>> loanHistory) {
+    QCborStreamWriter writer(&device);
+    writeHeader(writer, Type::Loans);
+
+    writer.append(static_cast<int>(RootData));
+    writer.startArray(static_cast<quint64>(activeLoans.size()));
+    for (const auto& loan : activeLoans) {
+        loan->writeCbor(writer);
+    }
+    writer.endArray();
+
+    writer.append(static_cast<int>(RootHistory));
+    writer.startArray(static_cast<quint64>(loanHistory.size()));
+    for (const auto& loan : loanHistory) {
+        loan->writeCbor(writer);
+    }
+    writer.endArray();
+
+    writer.endMap();
+    return finishWrite(device, "loans");
+}
+
+/**
+ * @brief Write active reservations and reservation history
+ */
+bool CborSnapshot::writeReservations(QIODevice& device,
+                                     std::span<const std::unique_ptr<Reservation>> activeReservations,
+                                     std::span<const std::unique_ptr<Reservation>> reservationHistory) {
+    QCborStreamWriter writer(&device);
+    writeHeader(writer, Type::Reservations);
+
+    writer.append(static_cast<int>(RootData));
+    writer.startArray(static_cast<quint64>(activeReservations.size()));
+    for (const auto& reservation : activeReservations) {
+        reservation->writeCbor(writer);
+    }
+    writer.endArray();
+
+    writer.append(static_cast<int>(RootHistory));
+    writer.startArray(static_cast<quint64>(reservationHistory.size()));
+    for (const auto& reservation : reservationHistory) {
+        reservation->writeCbor(writer);
+    }
+    writer.endArray();
+
+    writer.endMap();
+    return finishWrite(device, "reservations");
+}
+
+/**
+ * @brief Read a resources snapshot
+ */
+bool CborSnapshot::readResources(QIODevice& device, std::vector<std::unique_ptr<Resource>>& resources) {
+    resources.clear();
+    CborRecord record;
+
+    return readSnapshot(device, Type::Resources, [&](int, QCborStreamReader& reader) {
+        if (!record.read(reader)) {
+            setError("Malformed resource record");
+            return false;
+        }
+        auto resource = createResource(record);
+        if (!resource) {
+            setError("Unknown resource kind in record: " + record.text(Resource::CborId));
+            return false;
+        }
+        resources.push_back(std::move(resource));
+        return true;
+    });
+}
+
+/**
+ * @brief Read a users snapshot, decoding nested loans as they stream past
+ */
+bool CborSnapshot::readUsers(QIODevice& device, std::vector<std::unique_ptr<User>>& users) {
+    users.clear();
+    CborRecord record;
+    std::vector<std::unique_ptr<Loan>> currentLoans;
+    std::vector<std::unique_ptr<Loan>> loanHistory;
+
+    CborRecord::NestedReader readNested = [&](int key, QCborStreamReader& reader) {
+        if (key == User::CborCurrentLoans) {
+            return readLoanArray(reader, currentLoans);
+        }
+        if (key == User::CborLoanHistory) {
+            return readLoanArray(reader, loanHistory);
+        }
+        return reader.next();
+    };
+
+    return readSnapshot(device, Type::Users, [&](int, QCborStreamReader& reader) {
+        currentLoans.clear();
+        loanHistory.clear();
+        if (!record.read(reader, readNested)) {
+            if (m_lastError.isEmpty()) {
+                setError("Malformed user record");
+            }
+            return false;
+        }
+
+        auto user = std::make_unique<User>(record.text(User::CborUserId), record.text(User::CborFirstName),
+                                           record.text(User::CborLastName), record.text(User::CborEmail));
+        user->readCbor(record);
+        user->restoreLoans(std::move(currentLoans), std::move(loanHistory));
+        users.push_back(std::move(user));
+        return true;
+    });
+}
+
+/**
+ * @brief Read a loans snapshot
+ */
+bool CborSnapshot::readLoans(QIODevice& device, std::vector<std::unique_ptr<Loan>>& activeLoans,
+                             std::vector<std::unique_ptr<Loan>>& loanHistory) {
+    activeLoans.clear();
+    loanHistory.clear();
+    CborRecord record;
+
+    return readSnapshot(device, Type::Loans, [&](int rootKey, QCborStreamReader& reader) {
+        if (!record.read(reader)) {
+            setError("Malformed loan record");
+            return false;
+        }
+        auto& target = rootKey == RootHistory ? loanHistory : activeLoans;
+        target.push_back(createLoan(record));
+        return true;
+    });
+}
+
+/**
+ * @brief Read a reservations snapshot
+ */
+bool CborSnapshot::readReservations(QIODevice& device,
+                                    std::vector<std::unique_ptr<Reservation>>& activeReservations,
+                                    std::vector<std::unique_ptr<Reservation>>& reservationHistory) {
+    activeReservations.clear();
+    reservationHistory.clear();
+    CborRecord record;
+
+    return readSnapshot(device, Type::Reservations, [&](int rootKey, QCborStreamReader& reader) {
+        if (!record.read(reader)) {
+            setError("Malformed reservation record");
+            return false;
+        }
+        auto& target = rootKey == RootHistory ? reservationHistory : activeReservations;
+        target.push_back(createReservation(record));
+        return true;
+    });
+}
+
+/**
+ * @brief Create the concrete resource a record describes
+ * @return nullptr if the record's kind is unknown
+ */
+std::unique_ptr<Resource> CborSnapshot::createResource(const CborRecord& record) {
+    qint64 kindValue = record.integer(Resource::CborKind, -1);
+    if (kindValue < 0 || kindValue >= Resource::KindCount) {
+        return nullptr;
+    }
+
+    QString id = record.text(Resource::CborId);
+    QString title = record.text(Resource::CborTitle);
+    QString author = record.text(Resource::CborAuthor);
+    int year = static_cast<int>(record.integer(Resource::CborPublicationYear));
+
+    // Constructor arguments come from the record so validation passes
+    std::unique_ptr<Resource> resource;
+    switch (static_cast<Resource::Kind>(kindValue)) {
+        case Resource::Kind::Book:
+            resource = std::make_unique<Book>(id, title, author, year,
+                                              record.text(Book::CborIsbn), record.text(Book::CborPublisher));
+            break;
+        case Resource::Kind::Article:
+            resource = std::make_unique<Article>(id, title, author, year, record.text(Article::CborJournal));
+            break;
+        case Resource::Kind::Thesis:
+            resource = std::make_unique<Thesis>(id, title, author, year);
+            break;
+        case Resource::Kind::DigitalContent:
+            resource = std::make_unique<DigitalContent>(id, title, author, year);
+            break;
+    }
+
+    if (resource) {
+        resource->readCbor(record);
+    }
+    return resource;
+}
+
+/**
+ * @brief Create a loan from a record
+ */
+std::unique_ptr<Loan> CborSnapshot::createLoan(const CborRecord& record) {
+    auto loan = std::make_unique<Loan>(record.text(Loan::CborLoanId), record.text(Loan::CborUserId),
+                                       record.text(Loan::CborResourceId), record.text(Loan::CborResourceTitle),
+                                       EpochTime::toDateTime(record.integer(Loan::CborBorrowDate, EpochTime::Invalid)),
+                                       EpochTime::toDateTime(record.integer(Loan::CborDueDate, EpochTime::Invalid)));
+    loan->readCbor(record);
+    return loan;
+}
+
+/**
+ * @brief Create a reservation from a record
+ */
+std::unique_ptr<Reservation> CborSnapshot::createReservation(const CborRecord& record) {
+    auto reservation = std::make_unique<Reservation>(record.text(Reservation::CborUserId),
+                                                     record.text(Reservation::CborResourceId),
+                                                     record.text(Reservation::CborResourceTitle), 7);
+    reservation->readCbor(record);
+    return reservation;
+}
+
+// Private helper methods
+
+/**
+ * @brief Open the root map and write the version, type and timestamp entries
+ */
+void CborSnapshot::writeHeader(QCborStreamWriter& writer, Type type) {
+    writer.startMap();
+    CborRecord::writeInteger(writer, RootVersion, FormatVersion);
+    CborRecord::writeInteger(writer, RootType, static_cast<int>(type));
+    CborRecord::writeInteger(writer, RootTimestamp, EpochTime::now());
+}
+
+/**
+ * @brief Check the device accepted everything the writer produced
+ */
+bool CborSnapshot::finishWrite(QIODevice& device, const QString& what) {
+    auto* file = qobject_cast<QFileDevice*>(&device);
+    if (file && (!file->flush() || file->error() != QFileDevice::NoError)) {
+        setError(QString("Failed to write %1 snapshot: %2").arg(what, file->errorString()));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Walk the root map, handing each element of the entity arrays to readElement
+ */
+bool CborSnapshot::readSnapshot(QIODevice& device, Type expectedType, const ElementReader& readElement) {
+    m_lastError.clear();
+    QCborStreamReader reader(&device);
+
+    if (!reader.isMap() || !reader.enterContainer()) {
+        setError("Invalid CBOR snapshot: root is not a map");
+        return false;
+    }
+
+    bool typeChecked = false;
+    while (reader.hasNext()) {
+        if (!reader.isInteger()) {
+            setError("Invalid CBOR snapshot: non-integer key");
+            return false;
+        }
+        int key = static_cast<int>(reader.toInteger());
+        reader.next();
+
+        if (key == RootVersion) {
+            if (!reader.isInteger() || reader.toInteger() > FormatVersion) {
+                setError("Unsupported CBOR snapshot version");
+                return false;
+            }
+            reader.next();
+        } else if (key == RootType) {
+            if (!reader.isInteger() || reader.toInteger() != static_cast<int>(expectedType)) {
+                setError("Invalid CBOR snapshot: unexpected collection type");
+                return false;
+            }
+            typeChecked = true;
+            reader.next();
+        } else if ((key == RootData || key == RootHistory) && reader.isArray()) {
+            if (!typeChecked) {
+                setError("Invalid CBOR snapshot: data precedes type");
+                return false;
+            }
+            if (!reader.enterContainer()) {
+                break;
+            }
+            while (reader.hasNext()) {
+                if (!readElement(key, reader)) {
+                    return false;
+                }
+            }
+            if (!reader.leaveContainer()) {
+                break;
+            }
+        } else if (!reader.next()) {
+            break;
+        }
+    }
+
+    if (reader.lastError() != QCborError::NoError) {
+        setError("CBOR parse error: " + reader.lastError().toString());
+        return false;
+    }
+    if (!typeChecked) {
+        setError("Invalid CBOR snapshot: missing collection type");
+        return false;
+    }
+    return reader.leaveContainer();
+}
+
+/**
+ * @brief Read an array of loan maps nested inside another record
+ */
+bool CborSnapshot::readLoanArray(QCborStreamReader& reader, std::vector<std::unique_ptr<Loan>>& loans) {
+    if (!reader.enterContainer()) {
+        return false;
+    }
+
+    CborRecord record;
+    while (reader.hasNext()) {
+        if (!record.read(reader)) {
+            setError("Malformed nested loan record");
+            return false;
+        }
+        loans.push_back(createLoan(record));
+    }
+    return reader.leaveContainer();
+}
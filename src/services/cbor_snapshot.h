@@ -0,0 +1,88 @@
+#ifndef CBOR_SNAPSHOT_H
+#define CBOR_SNAPSHOT_H
+
+#include <QString>
+#include <QIODevice>
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <vector>
+#include <span>
+#include <memory>
+#include <functional>
+
+// Forward declarations
+class Resource;
+class User;
+class Loan;
+class Reservation;
+class ResourceStore;
+class CborRecord;
+
+/**
+ * @brief Streaming codec for the binary (CBOR) snapshot files
+ *
+ * A snapshot file is one CBOR map with integer keys:
+ *   0 format version | 1 collection type | 2 write time (epoch ms) |
+ *   3 array of entities | 4 array of historical entities (loans, reservations)
+ * Each entity is written by its model's writeCbor() and read back through a
+ * reused CborRecord, so neither direction builds an in-memory document.
+ */
+class CborSnapshot {
+public:
+    static constexpr int FormatVersion = 1;
+
+    enum RootKey : int {
+        RootVersion = 0,
+        RootType,
+        RootTimestamp,
+        RootData,
+        RootHistory
+    };
+
+    enum class Type : int {
+        Resources = 1,
+        Users,
+        Loans,
+        Reservations
+    };
+
+    CborSnapshot() = default;
+
+    // Writing
+    bool writeResources(QIODevice& device, const ResourceStore& store);
+    bool writeResources(QIODevice& device, std::span<const std::unique_ptr<Resource>> resources);
+    bool writeUsers(QIODevice& device, std::span<const std::unique_ptr<User>> users);
+    bool writeLoans(QIODevice& device, std::span<const std::unique_ptr<Loan>> activeLoans,
+                    std::span<const std::unique_ptr<Loan>> loanHistory);
+    bool writeReservations(QIODevice& device, std::span<const std::unique_ptr<Reservation>> activeReservations,
+                           std::span<const std::unique_ptr<Reservation>> reservationHistory);
+
+    // Reading
+    bool readResources(QIODevice& device, std::vector<std::unique_ptr<Resource>>& resources);
+    bool readUsers(QIODevice& device, std::vector<std::unique_ptr<User>>& users);
+    bool readLoans(QIODevice& device, std::vector<std::unique_ptr<Loan>>& activeLoans,
+                   std::vector<std::unique_ptr<Loan>>& loanHistory);
+    bool readReservations(QIODevice& device, std::vector<std::unique_ptr<Reservation>>& activeReservations,
+                          std::vector<std::unique_ptr<Reservation>>& reservationHistory);
+
+    // Entity factories from decoded records
+    static std::unique_ptr<Resource> createResource(const CborRecord& record);
+    static std::unique_ptr<Loan> createLoan(const CborRecord& record);
+    static std::unique_ptr<Reservation> createReservation(const CborRecord& record);
+
+    QString getLastError() const { return m_lastError; }
+
+private:
+    QString m_lastError;
+
+    // Reads one element of the data/history array the reader is positioned on
+    using ElementReader = std::function<bool(int rootKey, QCborStreamReader& reader)>;
+
+    static void writeHeader(QCborStreamWriter& writer, Type type);
+    bool finishWrite(QIODevice& device, const QString& what);
+    bool readSnapshot(QIODevice& device, Type expectedType, const ElementReader& readElement);
+    bool readLoanArray(QCborStreamReader& reader, std::vector<std::unique_ptr<Loan>>& loans);
+    void setError(const QString& error) { m_lastError = error; }
+};
+
+#endif // CBOR_SNAPSHOT_H
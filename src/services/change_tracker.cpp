@@ -0,0 +1,54 @@
+#include "change_tracker.h"
+
+/**
+ * @brief Constructor for ChangeTracker
+ */
+ChangeTracker::ChangeTracker()
+    : m_counter(0) {
+    m_revisions.fill(0);
+}
+
+/**
+ * @brief Record a change that affects the collection as a whole
+ */
+void ChangeTracker::markChanged(Collection collection) {
+    m_revisions[indexOf(collection)] = ++m_counter;
+}
+
+/**
+ * @brief Record a change to one entity (and therefore its collection)
+ */
+void ChangeTracker::markEntityChanged(Collection collection, const QString& entityId) {
+    const quint64 revision = ++m_counter;
+    m_revisions[indexOf(collection)] = revision;
+    m_entityRevisions[indexOf(collection)].insert(entityId, revision);
+}
+
+/**
+ * @brief Record that an entity left its collection
+ */
+void ChangeTracker::markEntityRemoved(Collection collection, const QString& entityId) {
+    m_revisions[indexOf(collection)] = ++m_counter;
+    m_entityRevisions[indexOf(collection)].remove(entityId);
+}
+
+/**
+ * @brief Get the revision an entity was last changed at
+ */
+quint64 ChangeTracker::entityRevision(Collection collection, const QString& entityId) const {
+    return m_entityRevisions[indexOf(collection)].value(entityId, 0);
+}
+
+/**
+ * @brief Get the entities of a collection changed after a revision
+ */
+QStringList ChangeTracker::changedSince(Collection collection, quint64 revision) const {
+    QStringList changed;
+    const QHash<QString, quint64>& revisions = m_entityRevisions[indexOf(collection)];
+    for (auto it = revisions.cbegin(); it != revisions.cend(); ++it) {
+        if (it.value() > revision) {
+            changed.append(it.key());
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,56 @@
+#ifndef CHANGE_TRACKER_H
+#define CHANGE_TRACKER_H
+
+#include <QString>
+#include <QHash>
+#include <QStringList>
+#include <array>
+#include <cstddef>
+
+/**
+ * @brief Revision counters for the library's persisted collections
+ * 
+ * LibraryManager bumps a revision every time it mutates a collection or an
+ * entity in it. PersistenceService remembers the revisions it last wrote and
+ * compares them on the next save: unchanged collections are not rewritten,
+ * and unchanged entities reuse their previously serialized JSON.
+ * 
+ * Revisions come from a single monotonically increasing counter, so a value
+ * is never reused, even for an entity that is removed and added again.
+ */
+class ChangeTracker {
+public:
+    enum class Collection : quint8 {
+        Resources,
+        Users,
+        Loans,
+        Reservations,
+        Configuration
+    };
+    static constexpr std::size_t CollectionCount = 5;
+
+private:
+    quint64 m_counter;
+    std::array<quint64, CollectionCount> m_revisions;
+    std::array<QHash<QString, quint64>, CollectionCount> m_entityRevisions;
+
+public:
+    ChangeTracker();
+
+    // Recording changes
+    void markChanged(Collection collection);
+    void markEntityChanged(Collection collection, const QString& entityId);
+    void markEntityRemoved(Collection collection, const QString& entityId);
+
+    // Querying revisions (0 means "never changed")
+    quint64 revision(Collection collection) const { return m_revisions[indexOf(collection)]; }
+    quint64 entityRevision(Collection collection, const QString& entityId) const;
+    quint64 latestRevision() const { return m_counter; }
+    QStringList changedSince(Collection collection, quint64 revision) const; // Removed entities are not listed
+
+    static constexpr std::size_t indexOf(Collection collection) {
+        return static_cast<std::size_t>(collection);
+    }
+};
+
+#endif // CHANGE_TRACKER_H
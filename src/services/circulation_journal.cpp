@@ -0,0 +1,510 @@
+#include "circulation_journal.h"
+#include <QCborMap>
+#include <QCborArray>
+#include <QCborValue>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <QDebug>
+#include <chrono>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    const QByteArray JournalMagic = QByteArrayLiteral("ENSJRNL1");
+    constexpr qint64 RecordHeaderSize = sizeof(quint32) + sizeof(quint16);
+    constexpr quint32 MaxRecordSize = 64 * 1024 * 1024;
+
+    // Compact integer keys used in the CBOR payload
+    enum RecordField : int {
+        RecordSequence = 0,
+        RecordMutation = 1,
+        RecordTimestamp = 2,
+        RecordChanges = 3
+    };
+
+    enum ChangeField : int {
+        ChangeCollection = 0,
+        ChangeKind = 1,
+        ChangeEntityId = 2,
+        ChangeState = 3
+    };
+}
+
+/**
+ * @brief Constructor for CirculationJournal
+ */
+CirculationJournal::CirculationJournal(const QString& filePath)
+    : m_filePath(filePath), m_file(filePath), m_open(false), m_pendingBytes(0),
+      m_writing(false), m_stopping(false), m_nextSequence(1), m_size(0),
+      m_syncMode(SyncMode::Fsync), m_commitWindowMicros(2000) {
+}
+
+/**
+ * @brief Destructor for CirculationJournal
+ */
+CirculationJournal::~CirculationJournal() {
+    close();
+}
+
+/**
+ * @brief Open the journal for appending and start the writer thread
+ * 
+ * Existing records are scanned to find the last valid one; anything after
+ * it (a record torn by a crash) is cut off before new records are appended.
+ */
+bool CirculationJournal::open() {
+    if (m_open) {
+        return true;
+    }
+    
+    std::vector<Record> records;
+    qint64 validLength = 0;
+    if (!readRecords(records, &validLength)) {
+        return false;
+    }
+    
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        setError(QString("Cannot open journal %1: %2").arg(m_filePath, m_file.errorString()));
+        return false;
+    }
+    
+    if (validLength == 0) {
+        // New or unreadable-from-the-start journal: start fresh with the magic
+        m_file.resize(0);
+        m_file.write(JournalMagic);
+        validLength = JournalMagic.size();
+    } else if (m_file.size() > validLength) {
+        qWarning() << "Discarding" << (m_file.size() - validLength) << "bytes of torn journal tail";
+        m_file.resize(validLength);
+    }
+    
+    m_file.seek(validLength);
+    if (!m_file.flush()) {
+        setError(QString("Cannot prepare journal %1: %2").arg(m_filePath, m_file.errorString()));
+        m_file.close();
+        return false;
+    }
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!records.empty()) {
+            m_nextSequence = records.back().sequence + 1;
+        }
+        m_size = validLength;
+        m_pending.clear();
+        m_pendingBytes = 0;
+        m_stopping = false;
+    }
+    
+    m_writer.reset(QThread::create([this]() { writerLoop(); }));
+    m_writer->start();
+    m_open = true;
+    return true;
+}
+
+/**
+ * @brief Close the journal; records already queued are written first
+ */
+void CirculationJournal::close() {
+    if (!m_open) {
+        return;
+    }
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_pendingChanged.wakeAll();
+    }
+    m_writer->wait();
+    m_writer.reset();
+    
+    m_file.close();
+    m_open = false;
+}
+
+/**
+ * @brief Append one record and wait until its batch is durable
+ * 
+ * Assigns the record's sequence number.
+ */
+bool CirculationJournal::append(Record& record) {
+    QFuture<bool> durable = appendAsync(record);
+    return durable.result();
+}
+
+/**
+ * @brief Queue one record for the next group commit
+ * 
+ * The returned future resolves to true once the batch containing the record
+ * has been written (and fsynced in SyncMode::Fsync), or false if that failed.
+ */
+QFuture<bool> CirculationJournal::appendAsync(Record& record) {
+    QPromise<bool> promise;
+    QFuture<bool> future = promise.future();
+    promise.start();
+    
+    if (!m_open) {
+        setError("Journal is not open");
+        promise.addResult(false);
+        promise.finish();
+        return future;
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    record.sequence = m_nextSequence++;
+    QByteArray frame = frameRecord(record);
+    m_pendingBytes += frame.size();
+    m_pending.push_back(PendingRecord{std::move(frame), std::move(promise)});
+    m_pendingChanged.wakeAll();
+    
+    return future;
+}
+
+/**
+ * @brief Block until every queued record has been committed
+ */
+bool CirculationJournal::waitForDurable() {
+    QMutexLocker locker(&m_mutex);
+    while (!m_pending.empty() || m_writing) {
+        m_writerIdle.wait(&m_mutex);
+    }
+    return true;
+}
+
+/**
+ * @brief Drop all records, e.g. after they were folded into a snapshot
+ * 
+ * Queued records are committed first. Sequence numbers keep increasing
+ * across truncations.
+ */
+bool CirculationJournal::truncate() {
+    if (!m_open) {
+        if (QFile::exists(m_filePath) && !QFile::resize(m_filePath, JournalMagic.size())) {
+            setError("Failed to truncate journal: " + m_filePath);
+            return false;
+        }
+        return true;
+    }
+    
+    // Holding the mutex with the writer idle keeps it off the file
+    QMutexLocker locker(&m_mutex);
+    while (!m_pending.empty() || m_writing) {
+        m_writerIdle.wait(&m_mutex);
+    }
+    
+    if (!m_file.resize(JournalMagic.size()) || !m_file.seek(JournalMagic.size())) {
+        setErrorLocked(QString("Failed to truncate journal: %1").arg(m_file.errorString()));
+        return false;
+    }
+    m_size = JournalMagic.size();
+    return true;
+}
+
+/**
+ * @brief Set how far each commit goes before callers are acknowledged
+ */
+void CirculationJournal::setSyncMode(SyncMode mode) {
+    QMutexLocker locker(&m_mutex);
+    m_syncMode = mode;
+}
+
+/**
+ * @brief Get the current sync mode
+ */
+CirculationJournal::SyncMode CirculationJournal::getSyncMode() const {
+    QMutexLocker locker(&m_mutex);
+    return m_syncMode;
+}
+
+/**
+ * @brief Set how long the writer waits for more records before committing
+ * 
+ * Only applies in SyncMode::Fsync; 0 commits as soon as a record arrives.
+ */
+void CirculationJournal::setCommitWindowMicros(int micros) {
+    QMutexLocker locker(&m_mutex);
+    m_commitWindowMicros = qMax(0, micros);
+}
+
+/**
+ * @brief Get the commit window in microseconds
+ */
+int CirculationJournal::getCommitWindowMicros() const {
+    QMutexLocker locker(&m_mutex);
+    return m_commitWindowMicros;
+}
+
+/**
+ * @brief Writer thread: coalesce queued records into batches and commit them
+ */
+void CirculationJournal::writerLoop() {
+    QMutexLocker locker(&m_mutex);
+    
+    while (true) {
+        while (m_pending.empty() && !m_stopping) {
+            m_pendingChanged.wait(&m_mutex);
+        }
+        if (m_pending.empty()) {
+            break; // Stopping with nothing left to write
+        }
+        
+        // Let concurrent callers join this batch until the window closes,
+        // so many of them share one fsync
+        if (m_syncMode == SyncMode::Fsync && m_commitWindowMicros > 0) {
+            QDeadlineTimer deadline(std::chrono::microseconds(m_commitWindowMicros), Qt::PreciseTimer);
+            while (!m_stopping && m_pendingBytes < MaxBatchBytes) {
+                if (!m_pendingChanged.wait(&m_mutex, deadline)) {
+                    break;
+                }
+            }
+        }
+        
+        std::vector<PendingRecord> batch;
+        batch.swap(m_pending);
+        const qint64 batchBytes = m_pendingBytes;
+        const qint64 startSize = m_size;
+        const SyncMode mode = m_syncMode;
+        m_pendingBytes = 0;
+        m_writing = true;
+        locker.unlock();
+        
+        QByteArray buffer;
+        buffer.reserve(batchBytes);
+        for (const PendingRecord& pending : batch) {
+            buffer.append(pending.frame);
+        }
+        
+        bool committed = writeBatch(buffer, mode);
+        if (!committed) {
+            // Cut off a partial write so later batches stay readable
+            m_file.resize(startSize);
+            m_file.seek(startSize);
+        }
+        
+        for (PendingRecord& pending : batch) {
+            pending.promise.addResult(committed);
+            pending.promise.finish();
+        }
+        
+        locker.relock();
+        if (committed) {
+            m_size = startSize + buffer.size();
+        }
+        m_writing = false;
+        m_writerIdle.wakeAll();
+    }
+}
+
+/**
+ * @brief Write one batch and make it as durable as the sync mode requires
+ */
+bool CirculationJournal::writeBatch(const QByteArray& buffer, SyncMode mode) {
+    if (m_file.write(buffer) != buffer.size() || !m_file.flush()) {
+        setError(QString("Failed to append to journal: %1").arg(m_file.errorString()));
+        return false;
+    }
+    if (mode == SyncMode::Fsync && !syncToDisk(m_file)) {
+        setError("Failed to sync journal to disk: " + m_filePath);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Force written data to stable storage
+ */
+bool CirculationJournal::syncToDisk(QFile& file) {
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+/**
+ * @brief Read every intact record in the journal
+ * @param validLength Receives the byte length of the intact prefix
+ * @return false only if the file exists but cannot be read as a journal
+ */
+bool CirculationJournal::readRecords(std::vector<Record>& records, qint64* validLength) {
+    records.clear();
+    if (validLength) {
+        *validLength = 0;
+    }
+    
+    QFile file(m_filePath);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(QString("Cannot read journal %1: %2").arg(m_filePath, file.errorString()));
+        return false;
+    }
+    
+    const QByteArray data = file.readAll();
+    if (data.size() < JournalMagic.size()) {
+        return true; // Empty or torn before the magic was complete
+    }
+    if (!data.startsWith(JournalMagic)) {
+        setError("Not a circulation journal: " + m_filePath);
+        return false;
+    }
+    
+    qint64 offset = JournalMagic.size();
+    while (offset + RecordHeaderSize <= data.size()) {
+        QDataStream header(data.mid(offset, RecordHeaderSize));
+        quint32 length = 0;
+        quint16 checksum = 0;
+        header >> length >> checksum;
+        
+        if (length > MaxRecordSize || offset + RecordHeaderSize + length > data.size()) {
+            break; // Torn tail
+        }
+        
+        const QByteArray payload = data.mid(offset + RecordHeaderSize, length);
+        if (qChecksum(payload) != checksum) {
+            break; // Corrupt tail
+        }
+        
+        Record record;
+        if (!decodeRecord(payload, record)) {
+            break;
+        }
+        records.push_back(std::move(record));
+        offset += RecordHeaderSize + length;
+    }
+    
+    if (validLength) {
+        *validLength = offset;
+    }
+    return true;
+}
+
+/**
+ * @brief Get the current journal size in bytes
+ */
+qint64 CirculationJournal::size() const {
+    if (m_open) {
+        QMutexLocker locker(&m_mutex);
+        return m_size;
+    }
+    return QFileInfo(m_filePath).size();
+}
+
+/**
+ * @brief Get the last error message
+ */
+QString CirculationJournal::getLastError() const {
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
+
+/**
+ * @brief Encode a record as a CBOR payload
+ */
+QByteArray CirculationJournal::encodeRecord(const Record& record) {
+    QCborArray changes;
+    for (const EntityChange& change : record.changes) {
+        QCborMap changeMap;
+        changeMap[ChangeCollection] = static_cast<int>(change.collection);
+        changeMap[ChangeKind] = static_cast<int>(change.type);
+        changeMap[ChangeEntityId] = change.entityId;
+        if (change.type == ChangeType::Upsert) {
+            changeMap[ChangeState] = QCborMap::fromJsonObject(change.state);
+        }
+        changes.append(changeMap);
+    }
+    
+    QCborMap map;
+    map[RecordSequence] = static_cast<qint64>(record.sequence);
+    map[RecordMutation] = static_cast<int>(record.mutation);
+    map[RecordTimestamp] = record.timestamp;
+    map[RecordChanges] = changes;
+    
+    return QCborValue(map).toCbor();
+}
+
+/**
+ * @brief Decode a CBOR payload into a record
+ */
+bool CirculationJournal::decodeRecord(const QByteArray& payload, Record& record) {
+    QCborParserError error;
+    const QCborValue value = QCborValue::fromCbor(payload, &error);
+    if (error.error != QCborError::NoError || !value.isMap()) {
+        return false;
+    }
+    
+    const QCborMap map = value.toMap();
+    const qint64 mutation = map.value(RecordMutation).toInteger();
+    if (mutation < static_cast<int>(Mutation::AddResource) ||
+        mutation > static_cast<int>(Mutation::ExpireReservation)) {
+        return false;
+    }
+    
+    record.sequence = static_cast<quint64>(map.value(RecordSequence).toInteger());
+    record.mutation = static_cast<Mutation>(mutation);
+    record.timestamp = map.value(RecordTimestamp).toInteger();
+    record.changes.clear();
+    
+    const QCborArray changes = map.value(RecordChanges).toArray();
+    record.changes.reserve(changes.size());
+    for (const QCborValue& changeValue : changes) {
+        const QCborMap changeMap = changeValue.toMap();
+        const qint64 collection = changeMap.value(ChangeCollection).toInteger(-1);
+        const qint64 type = changeMap.value(ChangeKind).toInteger();
+        if (collection < 0 || collection >= static_cast<qint64>(ChangeTracker::CollectionCount) ||
+            (type != static_cast<int>(ChangeType::Upsert) && type != static_cast<int>(ChangeType::Remove))) {
+            return false;
+        }
+        
+        EntityChange change;
+        change.collection = static_cast<ChangeTracker::Collection>(collection);
+        change.type = static_cast<ChangeType>(type);
+        change.entityId = changeMap.value(ChangeEntityId).toString();
+        if (change.type == ChangeType::Upsert) {
+            change.state = changeMap.value(ChangeState).toMap().toJsonObject();
+        }
+        record.changes.push_back(std::move(change));
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Encode a record with its length and checksum header
+ */
+QByteArray CirculationJournal::frameRecord(const Record& record) {
+    const QByteArray payload = encodeRecord(record);
+    
+    QByteArray frame;
+    frame.reserve(RecordHeaderSize + payload.size());
+    QDataStream out(&frame, QIODevice::WriteOnly);
+    out << static_cast<quint32>(payload.size()) << qChecksum(payload);
+    frame.append(payload);
+    return frame;
+}
+
+/**
+ * @brief Record an error message
+ */
+void CirculationJournal::setError(const QString& error) {
+    QMutexLocker locker(&m_mutex);
+    setErrorLocked(error);
+}
+
+/**
+ * @brief Record an error message; m_mutex must be held
+ */
+void CirculationJournal::setErrorLocked(const QString& error) {
+    m_lastError = error;
+    qWarning() << "CirculationJournal Error:" << error;
+}
@@ -0,0 +1,152 @@
+#ifndef CIRCULATION_JOURNAL_H
+#define CIRCULATION_JOURNAL_H
+
+#include <QString>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QFile>
+#include <QFuture>
+#include <QPromise>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <vector>
+#include <memory>
+
+#include "change_tracker.h"
+
+/**
+ * @brief Append-only write-ahead journal of LibraryManager mutations
+ * 
+ * Each mutation (borrow, return, renew, reserve, add/remove entity, ...) is
+ * written as one self-contained record holding the resulting state of every
+ * entity it touched. Replaying a record is therefore an idempotent upsert,
+ * and a borrow's loan, user and resource changes land together or not at all.
+ * 
+ * File layout: an 8-byte magic, followed by records framed as
+ *   quint32 payload length | quint16 CRC-16 of payload | CBOR payload
+ * (big-endian, written with QDataStream). A torn or corrupt tail record ends
+ * the readable journal and is cut off when the journal is reopened.
+ * 
+ * Writes go through a single writer thread that implements group commit:
+ * records arriving within the commit window are coalesced into one write and
+ * one fsync, and every caller's future resolves once its batch is durable.
+ */
+class CirculationJournal {
+public:
+    enum class Mutation : quint8 {
+        AddResource = 1,
+        RemoveResource,
+        ModifyResource, // No longer written (edits are a remove and an add); still replayed
+        AddUser,
+        RemoveUser,
+        ModifyUser, // As ModifyResource
+        Borrow,
+        Return,
+        Renew,
+        Reserve,
+        CancelReservation,
+        ExpireReservation
+    };
+
+    enum class ChangeType : quint8 {
+        Upsert = 1,
+        Remove
+    };
+
+    struct EntityChange {
+        ChangeTracker::Collection collection;
+        ChangeType type;
+        QString entityId;
+        QJsonObject state; // Empty for removals
+    };
+
+    enum class SyncMode : quint8 {
+        Flush,  // Hand records to the OS; survives a process crash only
+        Fsync   // Group commit to stable storage; survives power loss
+    };
+
+    static constexpr qint64 MaxBatchBytes = 1024 * 1024; // A batch this large commits without waiting out the window
+
+    struct Record {
+        quint64 sequence = 0;
+        Mutation mutation = Mutation::AddResource;
+        qint64 timestamp = 0; // UTC epoch milliseconds
+        std::vector<EntityChange> changes;
+    };
+
+private:
+    struct PendingRecord {
+        QByteArray frame;
+        QPromise<bool> promise;
+    };
+
+    QString m_filePath;
+    QFile m_file;
+    bool m_open;
+    
+    // Group commit state, guarded by m_mutex
+    mutable QMutex m_mutex;
+    QWaitCondition m_pendingChanged;
+    QWaitCondition m_writerIdle;
+    std::vector<PendingRecord> m_pending;
+    qint64 m_pendingBytes;
+    bool m_writing;
+    bool m_stopping;
+    quint64 m_nextSequence;
+    qint64 m_size;
+    SyncMode m_syncMode;
+    int m_commitWindowMicros;
+    QString m_lastError;
+    
+    std::unique_ptr<QThread> m_writer;
+
+public:
+    explicit CirculationJournal(const QString& filePath);
+    virtual ~CirculationJournal();
+
+    CirculationJournal(const CirculationJournal&) = delete;
+    CirculationJournal& operator=(const CirculationJournal&) = delete;
+
+    // Appending
+    bool open();
+    void close();
+    bool isOpen() const { return m_open; }
+    bool append(Record& record);
+    QFuture<bool> appendAsync(Record& record);
+    bool waitForDurable();
+    bool truncate();
+    
+    // Durability settings
+    void setSyncMode(SyncMode mode);
+    SyncMode getSyncMode() const;
+    void setCommitWindowMicros(int micros);
+    int getCommitWindowMicros() const;
+
+    // Reading
+    bool readRecords(std::vector<Record>& records, qint64* validLength = nullptr);
+
+    // Information
+    QString getFilePath() const { return m_filePath; }
+    qint64 size() const;
+    QString getLastError() const;
+
+    // Encoding
+    static QByteArray encodeRecord(const Record& record);
+    static bool decodeRecord(const QByteArray& payload, Record& record);
+    static QByteArray frameRecord(const Record& record);
+
+    // Flush a file's OS buffers to stable storage
+    static bool syncToDisk(QFile& file);
+
+protected:
+    // Runs on the writer thread; a subclass that overrides it must close() in its destructor
+    virtual bool writeBatch(const QByteArray& buffer, SyncMode mode);
+
+private:
+    void setError(const QString& error);
+    void setErrorLocked(const QString& error);
+    void writerLoop();
+};
+
+#endif // CIRCULATION_JOURNAL_H
@@ -0,0 +1,29 @@
+#include "clock.h"
+
+/**
+ * @brief Get the current system time
+ */
+qint64 SystemClock::nowMSecsSinceEpoch() const {
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+/**
+ * @brief Constructor for FixedClock
+ */
+FixedClock::FixedClock(const QDateTime& now)
+    : m_now(EpochTime::fromDateTime(now)) {
+}
+
+/**
+ * @brief Move the clock forward by a number of seconds
+ */
+void FixedClock::advanceSeconds(qint64 seconds) {
+    m_now += seconds * 1000;
+}
+
+/**
+ * @brief Move the clock forward by a number of days
+ */
+void FixedClock::advanceDays(int days) {
+    m_now = EpochTime::addDays(m_now, days);
+}
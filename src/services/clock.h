@@ -0,0 +1,52 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <QDateTime>
+
+#include "../models/epoch_time.h"
+
+/**
+ * @brief Abstract time source used by the library services
+ * 
+ * LibraryManager samples the clock once per batch operation and passes the
+ * resulting "now" into the model status checks, so a loop over many loans
+ * sees one consistent instant. Tests and benchmarks can inject a FixedClock
+ * to get deterministic time.
+ */
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    // Current instant as UTC epoch milliseconds (no timezone conversion)
+    virtual qint64 nowMSecsSinceEpoch() const = 0;
+
+    // Current instant as a local QDateTime, for display purposes
+    QDateTime now() const { return EpochTime::toDateTime(nowMSecsSinceEpoch()); }
+};
+
+/**
+ * @brief Clock backed by the system wall clock
+ */
+class SystemClock : public Clock {
+public:
+    qint64 nowMSecsSinceEpoch() const override;
+};
+
+/**
+ * @brief Manually driven clock for tests and benchmarks
+ */
+class FixedClock : public Clock {
+private:
+    qint64 m_now;
+
+public:
+    explicit FixedClock(const QDateTime& now = QDateTime::currentDateTime());
+
+    qint64 nowMSecsSinceEpoch() const override { return m_now; }
+
+    void setNow(const QDateTime& now) { m_now = EpochTime::fromDateTime(now); }
+    void advanceSeconds(qint64 seconds);
+    void advanceDays(int days);
+};
+
+#endif // CLOCK_H
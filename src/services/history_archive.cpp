@@ -0,0 +1,453 @@
+#include "history_archive.h"
+#include "circulation_journal.h"
+#include "../models/epoch_time.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QJsonDocument>
+#include <QMap>
+#include <QDebug>
+
+namespace {
+
+constexpr quint32 IndexMagic = 0x454E4849; // "ENHI"
+constexpr quint32 IndexVersion = 2; // 1: single unpartitioned segment, no summaries
+
+/**
+ * @brief Serialize a partition summary into an index
+ */
+QDataStream& operator<<(QDataStream& out, const HistorySummary& summary) {
+    return out << summary.records << summary.byUser << summary.byResource << summary.byCategory;
+}
+
+/**
+ * @brief Deserialize a partition summary from an index
+ */
+QDataStream& operator>>(QDataStream& in, HistorySummary& summary) {
+    return in >> summary.records >> summary.byUser >> summary.byResource >> summary.byCategory;
+}
+
+} // namespace
+
+/**
+ * @brief Count one record in the summary
+ */
+void HistorySummary::count(const QString& userId, const QString& resourceId, const QString& category) {
+    ++records;
+    ++byUser[userId];
+    ++byResource[resourceId];
+    if (!category.isEmpty()) {
+        ++byCategory[category];
+    }
+}
+
+/**
+ * @brief Add another summary's counts to this one
+ */
+void HistorySummary::merge(const HistorySummary& other) {
+    records += other.records;
+    for (auto it = other.byUser.cbegin(); it != other.byUser.cend(); ++it) {
+        byUser[it.key()] += it.value();
+    }
+    for (auto it = other.byResource.cbegin(); it != other.byResource.cend(); ++it) {
+        byResource[it.key()] += it.value();
+    }
+    for (auto it = other.byCategory.cbegin(); it != other.byCategory.cend(); ++it) {
+        byCategory[it.key()] += it.value();
+    }
+}
+
+/**
+ * @brief Partition name of an instant's UTC month
+ */
+QString HistoryPageFile::monthPartition(qint64 msecs) {
+    if (!EpochTime::isValid(msecs)) {
+        return QString();
+    }
+    return EpochTime::toDateTime(msecs).toUTC().toString("yyyy-MM");
+}
+
+/**
+ * @brief Constructor for HistoryPageFile; the store is empty until an index is read
+ * @param basePath Segment file path without its ".pages" suffix
+ */
+HistoryPageFile::HistoryPageFile(const QString& basePath)
+    : m_basePath(basePath) {
+}
+
+/**
+ * @brief Load the segments, page table and key maps of one generation
+ */
+bool HistoryPageFile::readIndex(const QString& indexPath) {
+    QFile file(indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError("Cannot open history index: " + indexPath);
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != IndexMagic || (version != 1 && version != IndexVersion)) {
+        setError("Not a history index: " + indexPath);
+        return false;
+    }
+
+    std::vector<Segment> segments;
+    if (version == 1) {
+        segments.resize(1);
+        in >> segments.front().end;
+    } else {
+        quint32 segmentCount = 0;
+        in >> segmentCount;
+        segments.resize(segmentCount);
+        for (Segment& segment : segments) {
+            in >> segment.partition >> segment.end >> segment.summary;
+        }
+    }
+
+    quint32 pageCount = 0;
+    in >> pageCount;
+    std::vector<PageInfo> pages(pageCount);
+    for (PageInfo& page : pages) {
+        if (version != 1) {
+            in >> page.segment;
+        }
+        in >> page.offset >> page.length >> page.count >> page.checksum;
+    }
+    QHash<QString, QList<quint32>> userPages;
+    QHash<QString, QList<quint32>> resourcePages;
+    in >> userPages >> resourcePages;
+
+    if (in.status() != QDataStream::Ok) {
+        setError("Truncated history index: " + indexPath);
+        return false;
+    }
+    for (const PageInfo& page : pages) {
+        if (page.segment >= segments.size()) {
+            setError("Corrupt history index: " + indexPath);
+            return false;
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_segments = std::move(segments);
+    m_pages = std::move(pages);
+    m_userPages = std::move(userPages);
+    m_resourcePages = std::move(resourcePages);
+    return true;
+}
+
+/**
+ * @brief Write the current segments, page table and key maps as an index file
+ */
+bool HistoryPageFile::writeIndex(const QString& indexPath) {
+    QByteArray index;
+    {
+        QMutexLocker locker(&m_mutex);
+        QDataStream out(&index, QIODevice::WriteOnly);
+        out << IndexMagic << IndexVersion << static_cast<quint32>(m_segments.size());
+        for (const Segment& segment : m_segments) {
+            out << segment.partition << segment.end << segment.summary;
+        }
+        out << static_cast<quint32>(m_pages.size());
+        for (const PageInfo& page : m_pages) {
+            out << page.segment << page.offset << page.length << page.count << page.checksum;
+        }
+        out << m_userPages << m_resourcePages;
+    }
+
+    QSaveFile file(indexPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(index) != index.size() || !file.commit()) {
+        setError(QString("Failed to write history index: %1 (%2)").arg(indexPath, file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Append records as new pages to the segments of their partitions
+ *
+ * Anything past a segment's indexed end (left by a save that never wrote its
+ * index) is overwritten. The new pages are visible to queries straight away
+ * and become durable with the next writeIndex().
+ */
+bool HistoryPageFile::append(const std::vector<Record>& records) {
+    if (records.empty()) {
+        return true;
+    }
+
+    // Pages never span partitions; records keep their order within each one
+    QMap<QString, std::vector<const Record*>> byPartition;
+    for (const Record& record : records) {
+        byPartition[record.partition].push_back(&record);
+    }
+
+    for (auto it = byPartition.cbegin(); it != byPartition.cend(); ++it) {
+        quint32 segment;
+        {
+            QMutexLocker locker(&m_mutex);
+            segment = segmentIndex(it.key());
+        }
+        if (!appendToSegment(segment, it.value())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Names of all partitions in order, the unpartitioned segment (if any) first
+ */
+QStringList HistoryPageFile::partitions() const {
+    QMutexLocker locker(&m_mutex);
+    QStringList names;
+    for (const Segment& segment : m_segments) {
+        names.append(segment.partition);
+    }
+    names.sort();
+    return names;
+}
+
+/**
+ * @brief Combined summary of the partitions from firstPartition to lastPartition
+ */
+HistoryPageFile::Summary HistoryPageFile::summarize(const QString& firstPartition,
+                                                    const QString& lastPartition) const {
+    QMutexLocker locker(&m_mutex);
+    Summary summary;
+    for (const Segment& segment : m_segments) {
+        if (!segment.partition.isEmpty() && segment.partition >= firstPartition &&
+            segment.partition <= lastPartition) {
+            summary.merge(segment.summary);
+        }
+    }
+    return summary;
+}
+
+/**
+ * @brief Path of a partition's segment file
+ */
+QString HistoryPageFile::segmentPath(const QString& partition) const {
+    return partition.isEmpty() ? m_basePath + ".pages" : m_basePath + "." + partition + ".pages";
+}
+
+/**
+ * @brief Get the number of pages
+ */
+int HistoryPageFile::pageCount() const {
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_pages.size());
+}
+
+/**
+ * @brief Get the number of stored records (re-appended records count again)
+ */
+qint64 HistoryPageFile::recordCount() const {
+    QMutexLocker locker(&m_mutex);
+    qint64 count = 0;
+    for (const PageInfo& page : m_pages) {
+        count += page.count;
+    }
+    return count;
+}
+
+/**
+ * @brief Check whether a record was appended through this instance
+ */
+bool HistoryPageFile::wasAppended(const QString& id) const {
+    QMutexLocker locker(&m_mutex);
+    return m_appendedIds.contains(id);
+}
+
+/**
+ * @brief Get the last error message
+ */
+QString HistoryPageFile::getLastError() const {
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
+
+/**
+ * @brief Pages holding records of a user, oldest first
+ */
+QList<quint32> HistoryPageFile::pagesForUser(const QString& userId) const {
+    QMutexLocker locker(&m_mutex);
+    return m_userPages.value(userId);
+}
+
+/**
+ * @brief Pages holding records of a resource, oldest first
+ */
+QList<quint32> HistoryPageFile::pagesForResource(const QString& resourceId) const {
+    QMutexLocker locker(&m_mutex);
+    return m_resourcePages.value(resourceId);
+}
+
+/**
+ * @brief Pages of a range of partitions and of the unpartitioned segment, oldest first
+ * 
+ * Unpartitioned pages (from version 1 indexes) are included because their
+ * records may fall into any range; callers filter the records themselves.
+ */
+QList<quint32> HistoryPageFile::pagesForPartitions(const QString& firstPartition,
+                                                   const QString& lastPartition) const {
+    QMutexLocker locker(&m_mutex);
+    QList<quint32> pages;
+    for (quint32 page = 0; page < m_pages.size(); ++page) {
+        const QString& partition = m_segments[m_pages[page].segment].partition;
+        if (partition.isEmpty() || (partition >= firstPartition && partition <= lastPartition)) {
+            pages.append(page);
+        }
+    }
+    return pages;
+}
+
+/**
+ * @brief Read and check one page
+ */
+bool HistoryPageFile::readPage(quint32 page, QJsonArray& records) {
+    PageInfo info;
+    QString path;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (page >= m_pages.size()) {
+            return false;
+        }
+        info = m_pages[page];
+        path = segmentPath(m_segments[info.segment].partition);
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(info.offset)) {
+        setError("Cannot open history pages: " + path);
+        return false;
+    }
+
+    const QByteArray compressed = file.read(info.length);
+    if (compressed.size() != static_cast<qsizetype>(info.length) || qChecksum(compressed) != info.checksum) {
+        setError(QString("History page %1 is damaged: %2").arg(page).arg(path));
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(qUncompress(compressed), &error);
+    if (error.error != QJsonParseError::NoError || !document.isArray()) {
+        setError(QString("History page %1 is unreadable: %2").arg(page).arg(path));
+        return false;
+    }
+
+    records = document.array();
+    return true;
+}
+
+// Private helper methods
+
+/**
+ * @brief Index of a partition's segment, added empty if it is new
+ */
+quint32 HistoryPageFile::segmentIndex(const QString& partition) {
+    for (quint32 i = 0; i < m_segments.size(); ++i) {
+        if (m_segments[i].partition == partition) {
+            return i;
+        }
+    }
+    Segment segment;
+    segment.partition = partition;
+    m_segments.push_back(std::move(segment));
+    return static_cast<quint32>(m_segments.size() - 1);
+}
+
+/**
+ * @brief Append one partition's records as pages to its segment file
+ */
+bool HistoryPageFile::appendToSegment(quint32 segment, const std::vector<const Record*>& records) {
+    QMutexLocker locker(&m_mutex);
+    const QString path = segmentPath(m_segments[segment].partition);
+    const qint64 end = m_segments[segment].end;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite) || !file.resize(end) || !file.seek(end)) {
+        locker.unlock();
+        setError("Cannot open history pages for writing: " + path);
+        return false;
+    }
+
+    std::vector<PageInfo> pages;
+    QHash<QString, QList<quint32>> userPages;
+    QHash<QString, QList<quint32>> resourcePages;
+    Summary summary;
+    qint64 offset = end;
+
+    for (std::size_t first = 0; first < records.size(); first += RecordsPerPage) {
+        const std::size_t last = std::min(records.size(), first + static_cast<std::size_t>(RecordsPerPage));
+        const quint32 pageNumber = static_cast<quint32>(m_pages.size() + pages.size());
+
+        QByteArray json = "[";
+        for (std::size_t i = first; i < last; ++i) {
+            const Record& record = *records[i];
+            if (i != first) {
+                json += ',';
+            }
+            json += record.json;
+            // One entry per page, however many of its records the key has
+            auto addPage = [pageNumber](QList<quint32>& list) {
+                if (list.isEmpty() || list.last() != pageNumber) {
+                    list.append(pageNumber);
+                }
+            };
+            addPage(userPages[record.userId]);
+            addPage(resourcePages[record.resourceId]);
+            if (!record.replaces) {
+                summary.count(record.userId, record.resourceId, record.category);
+            }
+        }
+        json += ']';
+
+        const QByteArray compressed = qCompress(json);
+        if (file.write(compressed) != compressed.size()) {
+            locker.unlock();
+            setError(QString("Failed to write history pages: %1 (%2)").arg(path, file.errorString()));
+            return false;
+        }
+
+        PageInfo page;
+        page.segment = segment;
+        page.offset = offset;
+        page.length = static_cast<quint32>(compressed.size());
+        page.count = static_cast<quint32>(last - first);
+        page.checksum = qChecksum(compressed);
+        pages.push_back(page);
+        offset += compressed.size();
+    }
+
+    // The index written after this append must never point past durable pages
+    if (!file.flush() || !CirculationJournal::syncToDisk(file)) {
+        locker.unlock();
+        setError(QString("Failed to write history pages: %1 (%2)").arg(path, file.errorString()));
+        return false;
+    }
+
+    m_pages.insert(m_pages.end(), pages.begin(), pages.end());
+    m_segments[segment].end = offset;
+    m_segments[segment].summary.merge(summary);
+    for (auto it = userPages.cbegin(); it != userPages.cend(); ++it) {
+        m_userPages[it.key()].append(it.value());
+    }
+    for (auto it = resourcePages.cbegin(); it != resourcePages.cend(); ++it) {
+        m_resourcePages[it.key()].append(it.value());
+    }
+    for (const Record* record : records) {
+        m_appendedIds.insert(record->id);
+    }
+    return true;
+}
+
+/**
+ * @brief Set error message
+ */
+void HistoryPageFile::setError(const QString& error) {
+    QMutexLocker locker(&m_mutex);
+    m_lastError = error;
+    qDebug() << "HistoryPageFile Error:" << error;
+}
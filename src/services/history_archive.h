@@ -0,0 +1,358 @@
+#ifndef HISTORY_ARCHIVE_H
+#define HISTORY_ARCHIVE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <vector>
+#include <memory>
+#include <list>
+#include <algorithm>
+#include <functional>
+#include <exception>
+
+/**
+ * @brief Record counts of one or more history partitions
+ */
+struct HistorySummary {
+    qint64 records = 0;
+    QHash<QString, qint64> byUser;
+    QHash<QString, qint64> byResource;
+    QHash<QString, qint64> byCategory;
+
+    void count(const QString& userId, const QString& resourceId, const QString& category);
+    void merge(const HistorySummary& other);
+};
+
+/**
+ * @brief Exception class for history that is on disk but cannot be read
+ */
+class HistoryArchiveException : public std::exception {
+private:
+    QString m_message;
+    QByteArray m_what;
+
+public:
+    explicit HistoryArchiveException(const QString& message) : m_message(message), m_what(message.toUtf8()) {}
+    const char* what() const noexcept override {
+        return m_what.constData();
+    }
+    QString getMessage() const { return m_message; }
+};
+
+/**
+ * @brief Read-only history record that keeps alive whatever holds it
+ *
+ * An archived record shares ownership of its cached page, so evicting the
+ * page does not invalidate it; other records are owned outright.
+ */
+template <typename T>
+using HistoryRecord = std::shared_ptr<const T>;
+
+/**
+ * @brief Queryable store of history records that are not held in memory
+ *
+ * LibraryManager merges these with its in-memory history. Queries skip IDs
+ * already in `seen` (and add the ones they return), so newer copies shadow
+ * older ones. A query that cannot read part of the store throws
+ * HistoryArchiveException rather than returning an incomplete result.
+ */
+template <typename T>
+class HistorySource {
+public:
+    virtual ~HistorySource() = default;
+
+    // Matching records, oldest first
+    virtual std::vector<HistoryRecord<T>> all(QSet<QString>& seen) = 0;
+    virtual std::vector<HistoryRecord<T>> newest(qsizetype count, QSet<QString>& seen) = 0; // At most count
+    virtual std::vector<HistoryRecord<T>> forUser(const QString& userId, QSet<QString>& seen) = 0;
+    virtual std::vector<HistoryRecord<T>> forResource(const QString& resourceId, QSet<QString>& seen) = 0;
+    // Records of an inclusive range of partitions (plus unpartitioned ones) that match
+    virtual std::vector<HistoryRecord<T>> forPartitions(const QString& firstPartition, const QString& lastPartition,
+                                                        QSet<QString>& seen,
+                                                        const std::function<bool(const T&)>& matches) = 0;
+    virtual HistoryRecord<T> find(const QString& id) = 0;
+
+    // Aggregates and bookkeeping
+    virtual HistorySummary summarize(const QString& firstPartition, const QString& lastPartition) const = 0;
+    virtual bool wasAppended(const QString& id) const = 0; // Already counted in summarize()
+};
+
+/**
+ * @brief Append-only, paged on-disk store of history records with a key index
+ *
+ * Records (encoded JSON objects) are grouped into pages of RecordsPerPage
+ * and appended as qCompress'ed JSON arrays to the segment file of their
+ * partition: "<base>.<partition>.pages", or "<base>.pages" for records
+ * without one. Time-partitioned stores (loans by month) thereby stop
+ * touching a month's segment once that month is over, and each partition
+ * carries a summary of how many records it holds per user, resource and
+ * category, so aggregates over whole partitions never read a page.
+ *
+ * The page table, the user/resource -> pages maps and the summaries live in
+ * a separate, small index file that is written per save generation, so the
+ * index - not the segment files - decides which pages exist: bytes appended
+ * by an unfinished save are ignored and overwritten by the next append.
+ *
+ * Index layout (QDataStream): magic, version, per segment {partition, end
+ * offset, summary}, then per page {segment, offset, length, record count,
+ * CRC-16}, then the user and resource maps. Version 1 indexes (a single
+ * unpartitioned segment, no summaries) are still read.
+ *
+ * Appends (save worker) and page reads (GUI) may run concurrently.
+ */
+class HistoryPageFile {
+public:
+    struct Record {
+        QString id;
+        QString userId;
+        QString resourceId;
+        QByteArray json; // As produced by JsonStreamWriter::encodeElement
+        QString partition; // Empty: the unpartitioned segment
+        QString category; // Counted in the partition summary when set
+        bool replaces = false; // A newer copy of an archived record; not counted again
+    };
+
+    using Summary = HistorySummary;
+
+    static constexpr qsizetype RecordsPerPage = 256;
+
+    // Partition name of an instant: its UTC month as "yyyy-MM", which sorts chronologically
+    static QString monthPartition(qint64 msecs);
+
+    explicit HistoryPageFile(const QString& basePath);
+    virtual ~HistoryPageFile() = default;
+
+    HistoryPageFile(const HistoryPageFile&) = delete;
+    HistoryPageFile& operator=(const HistoryPageFile&) = delete;
+
+    // Index
+    bool readIndex(const QString& indexPath);
+    bool writeIndex(const QString& indexPath);
+
+    // Appending
+    bool append(const std::vector<Record>& records);
+
+    // Partitions, inclusive range of names; the unpartitioned segment is never in a range
+    QStringList partitions() const;
+    Summary summarize(const QString& firstPartition, const QString& lastPartition) const;
+
+    // Information
+    QString getBasePath() const { return m_basePath; }
+    QString segmentPath(const QString& partition) const;
+    int pageCount() const;
+    qint64 recordCount() const;
+    bool wasAppended(const QString& id) const; // By this instance, i.e. counted in a summary already
+    QString getLastError() const;
+
+protected:
+    QList<quint32> pagesForUser(const QString& userId) const;
+    QList<quint32> pagesForResource(const QString& resourceId) const;
+    QList<quint32> pagesForPartitions(const QString& firstPartition, const QString& lastPartition) const;
+    bool readPage(quint32 page, QJsonArray& records);
+
+private:
+    struct Segment {
+        QString partition;
+        qint64 end = 0; // Length of the segment file covered by the index
+        Summary summary;
+    };
+
+    struct PageInfo {
+        quint32 segment = 0;
+        qint64 offset = 0;
+        quint32 length = 0;
+        quint32 count = 0;
+        quint16 checksum = 0;
+    };
+
+    QString m_basePath;
+    mutable QMutex m_mutex; // Guards everything below
+    std::vector<Segment> m_segments;
+    std::vector<PageInfo> m_pages;
+    QHash<QString, QList<quint32>> m_userPages;
+    QHash<QString, QList<quint32>> m_resourcePages;
+    QSet<QString> m_appendedIds;
+    QString m_lastError;
+
+    quint32 segmentIndex(const QString& partition); // Adds the segment if needed; lock held
+    bool appendToSegment(quint32 segment, const std::vector<const Record*>& records);
+    void setError(const QString& error);
+};
+
+/**
+ * @brief Typed, lazily loaded view of a HistoryPageFile
+ *
+ * Pages are decoded into model objects on first use and kept in an LRU
+ * cache bounded by page count. Returned records share ownership of their
+ * page, so a page the cache evicts lives on only as long as its records are
+ * held; the cache itself never grows past its bound.
+ *
+ * Queries visit pages newest first and skip IDs already in `seen`, so a
+ * record re-appended later (or still held in memory by the caller, who
+ * seeds `seen` with those IDs) shadows its older copies.
+ */
+template <typename T>
+class HistoryArchive : public HistoryPageFile, public HistorySource<T> {
+public:
+    using Factory = std::unique_ptr<T> (*)(const QJsonObject&);
+    using Page = std::vector<std::unique_ptr<T>>;
+
+    static constexpr int DefaultCachePages = 64;
+
+    HistoryArchive(const QString& basePath, Factory factory, int cachePages = DefaultCachePages)
+        : HistoryPageFile(basePath), m_factory(factory), m_cachePages(std::max(1, cachePages)) {}
+
+    void setCacheCapacity(int pages) {
+        QMutexLocker locker(&m_cacheMutex);
+        m_cachePages = std::max(1, pages);
+        trimCache();
+    }
+
+    // Every archived record, oldest first
+    std::vector<HistoryRecord<T>> all(QSet<QString>& seen) override {
+        return collect(allPages(), seen, [](const T&) { return true; });
+    }
+
+    // Only the newest pages are read, until count records are found
+    std::vector<HistoryRecord<T>> newest(qsizetype count, QSet<QString>& seen) override {
+        return collect(allPages(), seen, [](const T&) { return true; }, count);
+    }
+
+    // Records of one user or one resource, oldest first, read through the index
+    std::vector<HistoryRecord<T>> forUser(const QString& userId, QSet<QString>& seen) override {
+        return collect(newestFirst(pagesForUser(userId)), seen,
+                       [&userId](const T& record) { return record.getUserId() == userId; });
+    }
+
+    std::vector<HistoryRecord<T>> forResource(const QString& resourceId, QSet<QString>& seen) override {
+        return collect(newestFirst(pagesForResource(resourceId)), seen,
+                       [&resourceId](const T& record) { return record.getResourceId() == resourceId; });
+    }
+
+    // Only the pages of the partitions in range are read
+    std::vector<HistoryRecord<T>> forPartitions(const QString& firstPartition, const QString& lastPartition,
+                                                QSet<QString>& seen,
+                                                const std::function<bool(const T&)>& matches) override {
+        return collect(newestFirst(pagesForPartitions(firstPartition, lastPartition)), seen, matches);
+    }
+
+    // Newest archived copy of a record; scans pages, so meant for rare lookups
+    HistoryRecord<T> find(const QString& id) override {
+        QSet<QString> seen;
+        std::vector<HistoryRecord<T>> found = collect(allPages(), seen,
+                                                      [&id](const T& record) { return record.getId() == id; }, 1);
+        return found.empty() ? nullptr : found.front();
+    }
+
+    HistorySummary summarize(const QString& firstPartition, const QString& lastPartition) const override {
+        return HistoryPageFile::summarize(firstPartition, lastPartition);
+    }
+
+    bool wasAppended(const QString& id) const override {
+        return HistoryPageFile::wasAppended(id);
+    }
+
+private:
+    struct CacheEntry {
+        std::shared_ptr<Page> page;
+        typename std::list<quint32>::iterator position;
+    };
+
+    Factory m_factory;
+    QMutex m_cacheMutex;
+    int m_cachePages;
+    QHash<quint32, CacheEntry> m_cache;
+    std::list<quint32> m_lru; // Most recently used first
+
+    QList<quint32> allPages() const {
+        QList<quint32> pages;
+        for (int page = pageCount() - 1; page >= 0; --page) {
+            pages.append(static_cast<quint32>(page));
+        }
+        return pages;
+    }
+
+    static QList<quint32> newestFirst(QList<quint32> pages) {
+        std::sort(pages.begin(), pages.end(), std::greater<quint32>());
+        return pages;
+    }
+
+    // Pages are visited in the given (newest first) order; a negative limit collects every match
+    template <typename Predicate>
+    std::vector<HistoryRecord<T>> collect(const QList<quint32>& pages, QSet<QString>& seen, Predicate&& matches,
+                                          qsizetype limit = -1) {
+        QMutexLocker locker(&m_cacheMutex);
+        std::vector<HistoryRecord<T>> records;
+
+        for (quint32 index : pages) {
+            if (limit >= 0 && static_cast<qsizetype>(records.size()) >= limit) {
+                break;
+            }
+            std::shared_ptr<Page> page = load(index);
+            if (!page) {
+                throw HistoryArchiveException(getLastError());
+            }
+            // Later records in a page are newer as well
+            for (auto it = page->rbegin(); it != page->rend(); ++it) {
+                const T& record = **it;
+                if (seen.contains(record.getId()) || !matches(record)) {
+                    continue;
+                }
+                seen.insert(record.getId());
+                records.push_back(HistoryRecord<T>(page, &record));
+                if (limit >= 0 && static_cast<qsizetype>(records.size()) >= limit) {
+                    break;
+                }
+            }
+        }
+
+        std::reverse(records.begin(), records.end());
+        return records;
+    }
+
+    std::shared_ptr<Page> load(quint32 index) {
+        auto cached = m_cache.find(index);
+        if (cached != m_cache.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, cached->position);
+            return cached->page;
+        }
+
+        QJsonArray records;
+        if (!readPage(index, records)) {
+            return nullptr;
+        }
+        auto page = std::make_shared<Page>();
+        page->reserve(static_cast<std::size_t>(records.size()));
+        for (const QJsonValue& value : records) {
+            try {
+                if (auto record = m_factory(value.toObject())) {
+                    page->push_back(std::move(record));
+                }
+            } catch (const std::exception&) {
+                // An unreadable record is left out rather than losing the whole page
+            }
+        }
+
+        m_lru.push_front(index);
+        m_cache.insert(index, CacheEntry{page, m_lru.begin()});
+        trimCache();
+        return page;
+    }
+
+    void trimCache() {
+        while (static_cast<int>(m_lru.size()) > m_cachePages) {
+            m_cache.remove(m_lru.back());
+            m_lru.pop_back();
+        }
+    }
+};
+
+#endif // HISTORY_ARCHIVE_H
@@ -0,0 +1,452 @@
+#include "json_pull_reader.h"
+#include <QJsonObject>
+#include <QJsonArray>
+
+/**
+ * @brief Constructor for JsonPullReader
+ */
+JsonPullReader::JsonPullReader(QIODevice& device, qsizetype chunkSize)
+    : m_device(device), m_position(0), m_end(0), m_offset(0), m_eof(false),
+      m_token(Token::None), m_number(0.0), m_boolean(false),
+      m_expectKey(false), m_afterValue(false) {
+    m_buffer.resize(chunkSize);
+}
+
+/**
+ * @brief Advance to the next token
+ * @return The new current token; Invalid (sticky) on malformed input
+ */
+JsonPullReader::Token JsonPullReader::next() {
+    if (m_token == Token::Invalid || m_token == Token::EndDocument) {
+        return m_token;
+    }
+
+    skipWhitespace();
+    int c = peek();
+    if (c < 0) {
+        if (m_containers.empty() && m_afterValue) {
+            m_token = Token::EndDocument;
+            return m_token;
+        }
+        return fail("Unexpected end of data");
+    }
+
+    // Separators between members are consumed here, so callers only see values
+    if (m_afterValue) {
+        if (m_containers.empty()) {
+            return fail("Unexpected data after document");
+        }
+        if (c == ',') {
+            get();
+            m_afterValue = false;
+            m_expectKey = m_containers.back() == '{';
+            skipWhitespace();
+            c = peek();
+            if (c < 0 || c == '}' || c == ']') {
+                return fail("Expected value after ','");
+            }
+        } else if (c != '}' && c != ']') {
+            return fail("Expected ',' or closing bracket");
+        }
+    }
+
+    if (m_expectKey && c != '"' && c != '}') {
+        return fail("Expected object key");
+    }
+
+    switch (c) {
+        case '{':
+            get();
+            m_containers.push_back('{');
+            m_expectKey = true;
+            m_afterValue = false;
+            m_token = Token::BeginObject;
+            return m_token;
+        case '[':
+            get();
+            m_containers.push_back('[');
+            m_expectKey = false;
+            m_afterValue = false;
+            m_token = Token::BeginArray;
+            return m_token;
+        case '}':
+        case ']': {
+            char open = c == '}' ? '{' : '[';
+            if (m_containers.empty() || m_containers.back() != open) {
+                return fail("Mismatched closing bracket");
+            }
+            if (m_token == Token::Key) {
+                return fail("Missing value after key");
+            }
+            get();
+            m_containers.pop_back();
+            return finishValue(c == '}' ? Token::EndObject : Token::EndArray);
+        }
+        case '"':
+            if (!readString(m_string)) {
+                return m_token;
+            }
+            if (m_expectKey) {
+                skipWhitespace();
+                if (get() != ':') {
+                    return fail("Expected ':' after object key");
+                }
+                m_expectKey = false;
+                m_token = Token::Key;
+                return m_token;
+            }
+            return finishValue(Token::String);
+        case 't':
+            m_boolean = true;
+            return readLiteral("true") ? finishValue(Token::Bool) : m_token;
+        case 'f':
+            m_boolean = false;
+            return readLiteral("false") ? finishValue(Token::Bool) : m_token;
+        case 'n':
+            return readLiteral("null") ? finishValue(Token::Null) : m_token;
+        default:
+            if (c == '-' || (c >= '0' && c <= '9')) {
+                return readNumber() ? finishValue(Token::Number) : m_token;
+            }
+            return fail(QString("Unexpected character '%1'").arg(QChar(c)));
+    }
+}
+
+/**
+ * @brief Materialize the value that starts at the current token
+ *
+ * On return the current token is the value's last token (its closing
+ * bracket, or the scalar itself), so next() continues after it.
+ */
+QJsonValue JsonPullReader::readValue() {
+    switch (m_token) {
+        case Token::BeginObject: {
+            QJsonObject object;
+            while (next() == Token::Key) {
+                QString key = m_string;
+                if (next() == Token::Invalid) {
+                    return QJsonValue();
+                }
+                QJsonValue value = readValue();
+                if (hasError()) {
+                    return QJsonValue();
+                }
+                object.insert(key, value);
+            }
+            if (m_token != Token::EndObject) {
+                if (!hasError()) {
+                    fail("Expected object key");
+                }
+                return QJsonValue();
+            }
+            return object;
+        }
+        case Token::BeginArray: {
+            QJsonArray array;
+            while (next() != Token::EndArray) {
+                if (hasError()) {
+                    return QJsonValue();
+                }
+                QJsonValue value = readValue();
+                if (hasError()) {
+                    return QJsonValue();
+                }
+                array.append(value);
+            }
+            return array;
+        }
+        case Token::String:
+            return m_string;
+        case Token::Number:
+            return m_number;
+        case Token::Bool:
+            return m_boolean;
+        case Token::Null:
+            return QJsonValue(QJsonValue::Null);
+        default:
+            fail("Expected a value");
+            return QJsonValue();
+    }
+}
+
+/**
+ * @brief Skip the value that starts at the current token without building it
+ */
+bool JsonPullReader::skipValue() {
+    if (m_token == Token::BeginObject || m_token == Token::BeginArray) {
+        int targetDepth = depth() - 1;
+        while (depth() > targetDepth) {
+            Token token = next();
+            if (token == Token::Invalid || token == Token::EndDocument) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return m_token == Token::String || m_token == Token::Number ||
+           m_token == Token::Bool || m_token == Token::Null;
+}
+
+// Private helper methods
+
+/**
+ * @brief Look at the next byte without consuming it (-1 at end of data)
+ */
+int JsonPullReader::peek() {
+    if (m_position >= m_end && !fill()) {
+        return -1;
+    }
+    return static_cast<uchar>(m_buffer[m_position]);
+}
+
+/**
+ * @brief Consume and return the next byte (-1 at end of data)
+ */
+int JsonPullReader::get() {
+    int c = peek();
+    if (c >= 0) {
+        ++m_position;
+    }
+    return c;
+}
+
+/**
+ * @brief Read the next chunk into the buffer, replacing the consumed one
+ */
+bool JsonPullReader::fill() {
+    if (m_eof) {
+        return false;
+    }
+
+    m_offset += m_end;
+    qint64 bytesRead = m_device.read(m_buffer.data(), m_buffer.size());
+    m_position = 0;
+    if (bytesRead <= 0) {
+        m_eof = true;
+        m_end = 0;
+        return false;
+    }
+    m_end = bytesRead;
+    return true;
+}
+
+/**
+ * @brief Skip JSON whitespace
+ */
+void JsonPullReader::skipWhitespace() {
+    for (int c = peek(); c == ' ' || c == '\n' || c == '\r' || c == '\t'; c = peek()) {
+        ++m_position;
+    }
+}
+
+/**
+ * @brief Enter the error state
+ */
+JsonPullReader::Token JsonPullReader::fail(const QString& message) {
+    m_token = Token::Invalid;
+    m_errorString = QString("%1 at offset %2").arg(message).arg(m_offset + m_position);
+    return m_token;
+}
+
+/**
+ * @brief Record a completed value token
+ */
+JsonPullReader::Token JsonPullReader::finishValue(Token token) {
+    m_token = token;
+    m_afterValue = true;
+    m_expectKey = false;
+    return m_token;
+}
+
+/**
+ * @brief Read a quoted string, decoding escapes
+ *
+ * Runs of plain bytes are copied straight out of the buffer; the UTF-8 is
+ * decoded once the closing quote is reached. A high surrogate escape is held
+ * until the next character shows whether it has its low half; unpaired
+ * halves become U+FFFD, and whatever followed is decoded as usual.
+ */
+bool JsonPullReader::readString(QString& value) {
+    get(); // Opening quote
+    m_scratch.resize(0);
+
+    uint pendingHigh = 0; // High surrogate waiting for its low half
+    auto flushPendingHigh = [this, &pendingHigh]() {
+        if (pendingHigh != 0) {
+            appendUtf8(m_scratch, 0xFFFD);
+            pendingHigh = 0;
+        }
+    };
+
+    while (true) {
+        // Fast path: copy the plain run available in the buffer
+        qsizetype start = m_position;
+        while (m_position < m_end) {
+            uchar b = static_cast<uchar>(m_buffer[m_position]);
+            if (b == '"' || b == '\\' || b < 0x20) {
+                break;
+            }
+            ++m_position;
+        }
+        if (m_position > start) {
+            flushPendingHigh();
+            m_scratch.append(m_buffer.constData() + start, m_position - start);
+        }
+
+        int c = get();
+        if (c < 0) {
+            fail("Unterminated string");
+            return false;
+        }
+        if (c == '"') {
+            flushPendingHigh();
+            break;
+        }
+        if (c < 0x20) {
+            fail("Control character in string");
+            return false;
+        }
+        if (c != '\\') {
+            flushPendingHigh();
+            m_scratch.append(static_cast<char>(c)); // Run ended at the buffer boundary
+            continue;
+        }
+
+        int escape = get();
+        if (escape != 'u') {
+            flushPendingHigh();
+        }
+        switch (escape) {
+            case '"': m_scratch.append('"'); break;
+            case '\\': m_scratch.append('\\'); break;
+            case '/': m_scratch.append('/'); break;
+            case 'b': m_scratch.append('\b'); break;
+            case 'f': m_scratch.append('\f'); break;
+            case 'n': m_scratch.append('\n'); break;
+            case 'r': m_scratch.append('\r'); break;
+            case 't': m_scratch.append('\t'); break;
+            case 'u': {
+                auto readHex = [this](uint& unit) {
+                    unit = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        int h = get();
+                        int digit = (h >= '0' && h <= '9') ? h - '0'
+                                  : (h >= 'a' && h <= 'f') ? h - 'a' + 10
+                                  : (h >= 'A' && h <= 'F') ? h - 'A' + 10 : -1;
+                        if (digit < 0) {
+                            return false;
+                        }
+                        unit = unit * 16 + static_cast<uint>(digit);
+                    }
+                    return true;
+                };
+
+                uint unit = 0;
+                if (!readHex(unit)) {
+                    fail("Invalid \\u escape");
+                    return false;
+                }
+                const bool isLow = unit >= 0xDC00 && unit <= 0xDFFF;
+                if (isLow && pendingHigh != 0) {
+                    appendUtf8(m_scratch, 0x10000 + ((pendingHigh - 0xD800) << 10) + (unit - 0xDC00));
+                    pendingHigh = 0;
+                    break;
+                }
+                flushPendingHigh();
+                if (unit >= 0xD800 && unit <= 0xDBFF) {
+                    pendingHigh = unit;
+                } else {
+                    appendUtf8(m_scratch, isLow ? 0xFFFD : unit);
+                }
+                break;
+            }
+            default:
+                fail("Invalid escape sequence");
+                return false;
+        }
+    }
+
+    value = QString::fromUtf8(m_scratch);
+    return true;
+}
+
+/**
+ * @brief Read a number token
+ *
+ * Follows the JSON grammar, -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?,
+ * so forms toDouble() would take anyway, like leading zeros, are rejected.
+ */
+bool JsonPullReader::readNumber() {
+    m_scratch.resize(0);
+    auto accept = [this](char expected) {
+        if (peek() != static_cast<uchar>(expected)) {
+            return false;
+        }
+        m_scratch.append(expected);
+        ++m_position;
+        return true;
+    };
+    auto digits = [this]() {
+        qsizetype count = 0;
+        for (int c = peek(); c >= '0' && c <= '9'; c = peek()) {
+            m_scratch.append(static_cast<char>(c));
+            ++m_position;
+            ++count;
+        }
+        return count;
+    };
+
+    accept('-');
+    bool valid = accept('0') ? !(peek() >= '0' && peek() <= '9') : digits() > 0;
+    if (valid && accept('.')) {
+        valid = digits() > 0;
+    }
+    if (valid && (accept('e') || accept('E'))) {
+        if (!accept('+')) {
+            accept('-');
+        }
+        valid = digits() > 0;
+    }
+
+    bool ok = false;
+    m_number = valid ? m_scratch.toDouble(&ok) : 0.0;
+    if (!ok) {
+        fail("Invalid number");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Consume an exact keyword (true, false, null)
+ */
+bool JsonPullReader::readLiteral(const char* literal) {
+    for (const char* p = literal; *p; ++p) {
+        if (get() != static_cast<uchar>(*p)) {
+            fail(QString("Invalid literal, expected '%1'").arg(QLatin1String(literal)));
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Append a code point as UTF-8
+ */
+void JsonPullReader::appendUtf8(QByteArray& bytes, uint codePoint) {
+    if (codePoint < 0x80) {
+        bytes.append(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        bytes.append(static_cast<char>(0xC0 | (codePoint >> 6)));
+        bytes.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        bytes.append(static_cast<char>(0xE0 | (codePoint >> 12)));
+        bytes.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        bytes.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        bytes.append(static_cast<char>(0xF0 | (codePoint >> 18)));
+        bytes.append(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        bytes.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        bytes.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
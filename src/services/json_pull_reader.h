@@ -0,0 +1,87 @@
+#ifndef JSON_PULL_READER_H
+#define JSON_PULL_READER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QIODevice>
+#include <QJsonValue>
+#include <vector>
+
+/**
+ * @brief Incremental (pull) tokenizer for JSON read from a device
+ *
+ * The device is read in fixed-size chunks into one reused buffer, and the
+ * caller advances token by token with next(). Only the value the caller asks
+ * for with readValue() is materialized, so a loader can build one array
+ * element at a time instead of parsing the whole file into a document.
+ */
+class JsonPullReader {
+public:
+    enum class Token {
+        None,
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        Bool,
+        Null,
+        EndDocument,
+        Invalid
+    };
+
+    static constexpr qsizetype DefaultChunkSize = 64 * 1024;
+
+    explicit JsonPullReader(QIODevice& device, qsizetype chunkSize = DefaultChunkSize);
+
+    // Tokenizing
+    Token next();
+    Token token() const { return m_token; }
+    int depth() const { return static_cast<int>(m_containers.size()); }
+
+    // Current token's payload
+    QString string() const { return m_string; } // Key name or string value
+    double number() const { return m_number; }
+    bool boolean() const { return m_boolean; }
+
+    // Whole values: start at the current token and leave it on the value's last token
+    QJsonValue readValue();
+    bool skipValue();
+
+    // Error handling
+    bool hasError() const { return m_token == Token::Invalid; }
+    QString errorString() const { return m_errorString; }
+
+private:
+    QIODevice& m_device;
+    QByteArray m_buffer;
+    qsizetype m_position;
+    qsizetype m_end;
+    qint64 m_offset; // Device offset of m_buffer[0], for error messages
+    bool m_eof;
+
+    Token m_token;
+    QString m_string;
+    double m_number;
+    bool m_boolean;
+    std::vector<char> m_containers; // '{' or '[' per open container
+    bool m_expectKey;
+    bool m_afterValue;
+    QByteArray m_scratch;
+    QString m_errorString;
+
+    int peek();
+    int get();
+    bool fill();
+    void skipWhitespace();
+    Token fail(const QString& message);
+    Token finishValue(Token token);
+    bool readString(QString& value);
+    bool readNumber();
+    bool readLiteral(const char* literal);
+    static void appendUtf8(QByteArray& bytes, uint codePoint);
+};
+
+#endif // JSON_PULL_READER_H
@@ -0,0 +1,200 @@
+#include "json_schema.h"
+#include <QJsonArray>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Constructor for JsonSchema
+ * @param entityName Used in error messages, e.g. "loan"
+ * @param idField Field holding the entity's ID, reported with its errors
+ */
+JsonSchema::JsonSchema(const QString& entityName, const QString& idField)
+    : m_entityName(entityName), m_idField(idField) {
+}
+
+/**
+ * @brief Add a field of a plain JSON type
+ */
+JsonSchema& JsonSchema::field(const QString& name, Type type, bool required) {
+    Field field;
+    field.name = name;
+    field.type = type;
+    field.required = required;
+    return addField(std::move(field));
+}
+
+/**
+ * @brief Add a string field that only accepts the given values
+ */
+JsonSchema& JsonSchema::enumField(const QString& name, const QStringList& allowed, bool required) {
+    Field field;
+    field.name = name;
+    field.type = Type::String;
+    field.required = required;
+    field.allowed = allowed;
+    return addField(std::move(field));
+}
+
+/**
+ * @brief Add an array field whose elements are objects of another schema
+ *
+ * The element schema is referenced, not copied, so it must outlive this one.
+ */
+JsonSchema& JsonSchema::arrayField(const QString& name, const JsonSchema& elements, bool required) {
+    Field field;
+    field.name = name;
+    field.type = Type::Array;
+    field.required = required;
+    field.elements = &elements;
+    return addField(std::move(field));
+}
+
+/**
+ * @brief Add every field of another schema, e.g. the shared fields of a base class
+ */
+JsonSchema& JsonSchema::extend(const JsonSchema& other) {
+    for (const Field& field : other.m_fields) {
+        addField(field);
+    }
+    return *this;
+}
+
+/**
+ * @brief Validate one object against the schema
+ *
+ * Each key is looked up once; whatever required fields were not seen are
+ * then read off the mask.
+ */
+bool JsonSchema::validate(const QJsonObject& json, QStringList& errors) const {
+    const qsizetype errorCount = errors.size();
+    quint64 seen = 0;
+
+    for (auto it = json.constBegin(); it != json.constEnd(); ++it) {
+        const qsizetype index = indexOf(it.key());
+        if (index < 0) {
+            continue;
+        }
+        seen |= quint64(1) << index;
+        checkValue(m_fields[static_cast<std::size_t>(index)], it.value(), errors);
+    }
+
+    for (quint64 missing = m_requiredMask & ~seen; missing != 0; missing &= missing - 1) {
+        const Field& field = m_fields[qCountTrailingZeroBits(missing)];
+        errors << QString("missing required field \"%1\"").arg(field.name);
+    }
+
+    return errors.size() == errorCount;
+}
+
+/**
+ * @brief Insert a field in name order, replacing one of the same name
+ */
+JsonSchema& JsonSchema::addField(Field field) {
+    auto it = std::lower_bound(m_fields.begin(), m_fields.end(), field.name,
+                               [](const Field& existing, const QString& name) { return existing.name < name; });
+    if (it != m_fields.end() && it->name == field.name) {
+        *it = std::move(field);
+    } else {
+        Q_ASSERT(static_cast<qsizetype>(m_fields.size()) < MaxFields);
+        m_fields.insert(it, std::move(field));
+    }
+
+    // Insertion shifts the indexes after it, so the mask is rebuilt
+    m_requiredMask = 0;
+    for (std::size_t i = 0; i < m_fields.size(); ++i) {
+        if (m_fields[i].required) {
+            m_requiredMask |= quint64(1) << i;
+        }
+    }
+    return *this;
+}
+
+/**
+ * @brief Index of a field by name, or -1 if the schema does not list it
+ */
+qsizetype JsonSchema::indexOf(const QString& name) const {
+    auto it = std::lower_bound(m_fields.begin(), m_fields.end(), name,
+                               [](const Field& field, const QString& key) { return field.name < key; });
+    if (it == m_fields.end() || it->name != name) {
+        return -1;
+    }
+    return static_cast<qsizetype>(it - m_fields.begin());
+}
+
+/**
+ * @brief Check one present field's value against its type and allowed values
+ */
+void JsonSchema::checkValue(const Field& field, const QJsonValue& value, QStringList& errors) const {
+    bool valid = false;
+    switch (field.type) {
+        case Type::String:
+            valid = value.isString();
+            break;
+        case Type::NonEmptyString:
+            valid = value.isString() && !value.toString().isEmpty();
+            break;
+        case Type::Integer: {
+            const double number = value.toDouble();
+            valid = value.isDouble() && std::trunc(number) == number &&
+                    number >= std::numeric_limits<int>::min() && number <= std::numeric_limits<int>::max();
+            break;
+        }
+        case Type::Number:
+            valid = value.isDouble();
+            break;
+        case Type::Boolean:
+            valid = value.isBool();
+            break;
+        case Type::Array:
+            valid = value.isArray();
+            break;
+        case Type::Object:
+            valid = value.isObject();
+            break;
+    }
+    if (!valid) {
+        errors << QString("field \"%1\" must be %2").arg(field.name, typeName(field.type));
+        return;
+    }
+
+    if (!field.allowed.isEmpty() && !field.allowed.contains(value.toString())) {
+        errors << QString("field \"%1\" has unknown value \"%2\" (expected one of: %3)")
+                      .arg(field.name, value.toString(), field.allowed.join(", "));
+    }
+
+    if (field.elements) {
+        const QJsonArray elements = value.toArray();
+        for (qsizetype i = 0; i < elements.size(); ++i) {
+            const QJsonValue element = elements.at(i);
+            const QString location = QString("%1[%2]").arg(field.name).arg(i);
+            if (!element.isObject()) {
+                errors << QString("%1 must be an object").arg(location);
+                continue;
+            }
+            QStringList elementErrors;
+            if (!field.elements->validate(element.toObject(), elementErrors)) {
+                for (const QString& error : elementErrors) {
+                    errors << location + ": " + error;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Describe a type for error messages
+ */
+QString JsonSchema::typeName(Type type) {
+    switch (type) {
+        case Type::String: return "a string";
+        case Type::NonEmptyString: return "a non-empty string";
+        case Type::Integer: return "an integer";
+        case Type::Number: return "a number";
+        case Type::Boolean: return "a boolean";
+        case Type::Array: return "an array";
+        case Type::Object: return "an object";
+        default: return "a valid value";
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef JSON_SCHEMA_H
+#define JSON_SCHEMA_H
+
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <vector>
+
+/**
+ * @brief Structural check for one entity type's JSON objects, built once and reused
+ *
+ * A schema lists the fields an entity's toJson() writes: each field's JSON
+ * type, whether it must be present, and for enum fields the accepted
+ * strings. Fields are kept sorted by name, so validating an object is a
+ * single pass over its keys with a binary search each. Required fields are
+ * tracked in a bit mask, so a missing one needs no lookup of its own.
+ *
+ * Every problem in an object is reported, not just the first. Keys the
+ * schema does not list are ignored, like the models' fromJson() ignores them.
+ */
+class JsonSchema {
+public:
+    enum class Type {
+        String,
+        NonEmptyString,
+        Integer, // A number with no fractional part, within int range
+        Number,
+        Boolean,
+        Array,
+        Object
+    };
+
+    static constexpr qsizetype MaxFields = 64; // One bit each in the required mask
+
+    JsonSchema(const QString& entityName, const QString& idField);
+
+    // Building
+    JsonSchema& field(const QString& name, Type type, bool required = false);
+    JsonSchema& enumField(const QString& name, const QStringList& allowed, bool required = true);
+    JsonSchema& arrayField(const QString& name, const JsonSchema& elements, bool required = false);
+    JsonSchema& extend(const JsonSchema& other); // Adds every field of other
+
+    // Validation; appends one message per problem and returns whether there were none
+    bool validate(const QJsonObject& json, QStringList& errors) const;
+
+    QString getEntityName() const { return m_entityName; }
+    QString entityId(const QJsonObject& json) const { return json.value(m_idField).toString(); }
+
+private:
+    struct Field {
+        QString name;
+        Type type = Type::String;
+        bool required = false;
+        QStringList allowed; // Enum values; empty: any value of the type
+        const JsonSchema* elements = nullptr; // Arrays: schema of each object element
+    };
+
+    QString m_entityName;
+    QString m_idField;
+    std::vector<Field> m_fields; // Sorted by name
+    quint64 m_requiredMask = 0; // Bit i: m_fields[i] is required
+
+    JsonSchema& addField(Field field);
+    qsizetype indexOf(const QString& name) const;
+    void checkValue(const Field& field, const QJsonValue& value, QStringList& errors) const;
+    static QString typeName(Type type);
+};
+
+#endif // JSON_SCHEMA_H
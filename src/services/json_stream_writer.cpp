@@ -0,0 +1,253 @@
+#include "json_stream_writer.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QFileDevice>
+#include <QLocale>
+#include <cmath>
+
+namespace {
+
+// Array elements of a top-level field sit two levels deep
+constexpr int ElementIndent = 8;
+
+} // namespace
+
+/**
+ * @brief Constructor for JsonStreamWriter
+ */
+JsonStreamWriter::JsonStreamWriter(QIODevice& device, qsizetype bufferSize)
+    : m_device(device), m_bufferSize(bufferSize), m_failed(false) {
+    m_buffer.reserve(bufferSize + bufferSize / 4);
+}
+
+/**
+ * @brief Open an object (the document root, or an array element)
+ */
+void JsonStreamWriter::beginObject() {
+    if (!m_hasMembers.empty()) {
+        beginMember();
+    }
+    append("{\n");
+    m_hasMembers.push_back(false);
+}
+
+/**
+ * @brief Close the innermost object
+ */
+void JsonStreamWriter::endObject() {
+    bool hadMembers = m_hasMembers.back();
+    m_hasMembers.pop_back();
+    if (hadMembers) {
+        append('\n');
+    }
+    writeIndent();
+    append('}');
+
+    // QJsonDocument ends the document with a newline
+    if (m_hasMembers.empty()) {
+        append('\n');
+    }
+    flushIfFull();
+}
+
+/**
+ * @brief Open an array-valued field of the current object
+ */
+void JsonStreamWriter::beginArrayField(const QString& key) {
+    beginMember();
+    append(encodeString(key));
+    append(": [\n");
+    m_hasMembers.push_back(false);
+}
+
+/**
+ * @brief Close the innermost array
+ */
+void JsonStreamWriter::endArray() {
+    bool hadMembers = m_hasMembers.back();
+    m_hasMembers.pop_back();
+    if (hadMembers) {
+        append('\n');
+    }
+    writeIndent();
+    append(']');
+    flushIfFull();
+}
+
+/**
+ * @brief Write a scalar field of the current object
+ */
+void JsonStreamWriter::writeField(const QString& key, const QJsonValue& value) {
+    beginMember();
+    append(encodeString(key));
+    append(": ");
+    append(encodeScalar(value));
+    flushIfFull();
+}
+
+/**
+ * @brief Serialize an object and write it as the next array element
+ */
+void JsonStreamWriter::writeElement(const QJsonObject& object) {
+    writeEncodedElement(encodeElement(object));
+}
+
+/**
+ * @brief Write an element already produced by encodeElement()
+ */
+void JsonStreamWriter::writeEncodedElement(const QByteArray& encoded) {
+    beginMember();
+    append(encoded);
+    flushIfFull();
+}
+
+/**
+ * @brief Flush everything written so far to the device
+ */
+bool JsonStreamWriter::finish() {
+    flush();
+
+    auto* file = qobject_cast<QFileDevice*>(&m_device);
+    if (!m_failed && file && !file->flush()) {
+        m_failed = true;
+        m_errorString = file->errorString();
+    }
+    return !m_failed;
+}
+
+/**
+ * @brief Encode an object indented for its place inside a top-level array
+ *
+ * QJsonDocument lays the object out at depth 0; shifting every line after
+ * the first gives the bytes QJsonDocument would write for it at depth 2.
+ */
+QByteArray JsonStreamWriter::encodeElement(const QJsonObject& object) {
+    QByteArray flat = QJsonDocument(object).toJson(QJsonDocument::Indented);
+    if (flat.endsWith('\n')) {
+        flat.chop(1);
+    }
+
+    QByteArray encoded;
+    encoded.reserve(flat.size() + flat.count('\n') * ElementIndent);
+    for (char c : flat) {
+        encoded.append(c);
+        if (c == '\n') {
+            encoded.append(ElementIndent, ' ');
+        }
+    }
+    return encoded;
+}
+
+// Private helper methods
+
+/**
+ * @brief Separate from the previous member and indent the next one
+ */
+void JsonStreamWriter::beginMember() {
+    if (m_hasMembers.back()) {
+        append(",\n");
+    }
+    m_hasMembers.back() = true;
+    writeIndent();
+}
+
+/**
+ * @brief Indent to the current nesting depth
+ */
+void JsonStreamWriter::writeIndent() {
+    m_buffer.append(static_cast<qsizetype>(m_hasMembers.size()) * 4, ' ');
+}
+
+/**
+ * @brief Append bytes to the output buffer
+ */
+void JsonStreamWriter::append(const QByteArray& bytes) {
+    m_buffer.append(bytes);
+}
+
+/**
+ * @brief Append one character to the output buffer
+ */
+void JsonStreamWriter::append(char c) {
+    m_buffer.append(c);
+}
+
+/**
+ * @brief Hand the buffer to the device once it reaches its target size
+ */
+void JsonStreamWriter::flushIfFull() {
+    if (m_buffer.size() >= m_bufferSize) {
+        flush();
+    }
+}
+
+/**
+ * @brief Write the buffer out, keeping its capacity for reuse
+ */
+void JsonStreamWriter::flush() {
+    if (!m_failed && !m_buffer.isEmpty() && m_device.write(m_buffer) != m_buffer.size()) {
+        m_failed = true;
+        m_errorString = m_device.errorString();
+    }
+    m_buffer.resize(0);
+}
+
+/**
+ * @brief Quote and escape a string the way QJsonDocument does
+ */
+QByteArray JsonStreamWriter::encodeString(const QString& value) {
+    QByteArray utf8 = value.toUtf8();
+    QByteArray encoded;
+    encoded.reserve(utf8.size() + 2);
+    encoded.append('"');
+    for (char c : utf8) {
+        switch (c) {
+            case '"': encoded.append("\\\""); break;
+            case '\\': encoded.append("\\\\"); break;
+            case '\b': encoded.append("\\b"); break;
+            case '\f': encoded.append("\\f"); break;
+            case '\n': encoded.append("\\n"); break;
+            case '\r': encoded.append("\\r"); break;
+            case '\t': encoded.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    encoded.append("\\u00");
+                    encoded.append(QByteArray::number(static_cast<unsigned char>(c), 16).rightJustified(2, '0'));
+                } else {
+                    encoded.append(c);
+                }
+        }
+    }
+    encoded.append('"');
+    return encoded;
+}
+
+/**
+ * @brief Encode a non-container value
+ */
+QByteArray JsonStreamWriter::encodeScalar(const QJsonValue& value) {
+    switch (value.type()) {
+        case QJsonValue::Bool:
+            return value.toBool() ? "true" : "false";
+        case QJsonValue::Double: {
+            double number = value.toDouble();
+            if (!std::isfinite(number)) {
+                return "null";
+            }
+            // Integral values are written without a fraction, as QJsonDocument does
+            if (number == std::floor(number) && std::abs(number) < 9007199254740992.0) {
+                return QByteArray::number(static_cast<qint64>(number));
+            }
+            return QByteArray::number(number, 'g', QLocale::FloatingPointShortest);
+        }
+        case QJsonValue::String:
+            return encodeString(value.toString());
+        case QJsonValue::Object:
+            // Containers normally go through writeElement; compact form keeps this total
+            return QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact);
+        case QJsonValue::Array:
+            return QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact);
+        default:
+            return "null";
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef JSON_STREAM_WRITER_H
+#define JSON_STREAM_WRITER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QIODevice>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <vector>
+
+/**
+ * @brief Buffered, forward-only writer for the JSON data files
+ *
+ * Produces the same indented layout as QJsonDocument::toJson(), but emits
+ * each array element as soon as it is written instead of assembling the
+ * whole document first. Memory use is one element plus the output buffer,
+ * whatever the collection size. Callers write object keys in sorted order,
+ * as QJsonObject would.
+ */
+class JsonStreamWriter {
+public:
+    static constexpr qsizetype DefaultBufferSize = 64 * 1024;
+
+    explicit JsonStreamWriter(QIODevice& device, qsizetype bufferSize = DefaultBufferSize);
+
+    // Structure
+    void beginObject();
+    void endObject();
+    void beginArrayField(const QString& key);
+    void endArray();
+
+    // Values
+    void writeField(const QString& key, const QJsonValue& value);
+    void writeElement(const QJsonObject& object);
+    void writeEncodedElement(const QByteArray& encoded);
+
+    // Flush buffered output; false if the device rejected any of it
+    bool finish();
+    QString errorString() const { return m_errorString; }
+
+    // Encode an object as an array element of a top-level field, ready for writeEncodedElement
+    static QByteArray encodeElement(const QJsonObject& object);
+
+private:
+    QIODevice& m_device;
+    QByteArray m_buffer;
+    qsizetype m_bufferSize;
+    std::vector<bool> m_hasMembers; // One entry per open container
+    bool m_failed;
+    QString m_errorString;
+
+    void beginMember();
+    void writeIndent();
+    void append(const QByteArray& bytes);
+    void append(char c);
+    void flushIfFull();
+    void flush();
+
+    static QByteArray encodeString(const QString& value);
+    static QByteArray encodeScalar(const QJsonValue& value);
+};
+
+#endif // JSON_STREAM_WRITER_H
@@ -8,6 +8,76 @@
 #include <algorithm>
 #include <QUuid>
 #include <QDebug>
+#include <QSet>
+#include <QTimeZone>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief Merge archived history with the records still held in memory
+ * @param queryArchive Callable (QSet<QString>& seen) -> std::vector<HistoryRecord<T>> over the archive
+ * 
+ * In-memory records are newer, so their IDs shadow archived copies; the
+ * result is archived matches followed by in-memory matches, oldest first.
+ * In-memory matches are returned as copies, so no result points into
+ * containers the manager keeps changing.
+ */
+template <typename T, typename ArchiveQuery, typename Filter>
+std::vector<HistoryRecord<T>> mergeHistory(const std::vector<std::unique_ptr<T>>& recent,
+                                           ArchiveQuery&& queryArchive, Filter&& matches) {
+    QSet<QString> seen;
+    seen.reserve(static_cast<qsizetype>(recent.size()));
+    for (const auto& record : recent) {
+        seen.insert(record->getId());
+    }
+    
+    std::vector<HistoryRecord<T>> records = queryArchive(seen);
+    for (const auto& record : recent) {
+        if (matches(*record)) {
+            records.push_back(std::make_shared<const T>(*record));
+        }
+    }
+    return records;
+}
+
+/**
+ * @brief Inclusive partition range of the months from fromMonth to toMonth; invalid dates leave an end open
+ */
+std::pair<QString, QString> monthRange(const QDate& fromMonth, const QDate& toMonth) {
+    return {fromMonth.isValid() ? fromMonth.toString("yyyy-MM") : QString(),
+            toMonth.isValid() ? toMonth.toString("yyyy-MM") : QString("9999-12")};
+}
+
+/**
+ * @brief Check whether an instant's month lies in a partition range
+ */
+bool inMonthRange(qint64 msecs, const std::pair<QString, QString>& range) {
+    const QString month = HistoryPageFile::monthPartition(msecs);
+    return !month.isEmpty() && month >= range.first && month <= range.second;
+}
+
+/**
+ * @brief IDs ordered by count, highest first (ties by ID, for stable reports)
+ */
+QStringList rankByCount(const QHash<QString, qint64>& counts) {
+    std::vector<std::pair<QString, qint64>> ranked;
+    ranked.reserve(static_cast<std::size_t>(counts.size()));
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        ranked.emplace_back(it.key(), it.value());
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    
+    QStringList ids;
+    for (const auto& entry : ranked) {
+        ids.append(entry.first);
+    }
+    return ids;
+}
+
+} // namespace
 
 /**
  * @brief Constructor for LibraryManager
@@ -15,11 +85,22 @@
 LibraryManager::LibraryManager(QObject* parent)
     : QObject(parent), m_libraryName("ENSIARY Library Management System"),
       m_operatingHours("Monday-Friday: 8:00 AM - 8:00 PM, Saturday-Sunday: 10:00 AM - 6:00 PM"),
-      m_defaultLoanPeriodDays(14) {
+      m_searchIndexRevision(0), m_searchIndexBuilt(false), m_searchRanksValid(false),
+      m_defaultLoanPeriodDays(14), m_clock(std::make_shared<SystemClock>()) {
     
     // Events list is empty by default - users can add their own events
 }
 
+/**
+ * @brief Replace the time source (e.g. with a FixedClock in tests)
+ */
+void LibraryManager::setClock(std::shared_ptr<const Clock> clock) {
+    if (!clock) {
+        throw LibraryManagerException("Cannot set null clock");
+    }
+    m_clock = std::move(clock);
+}
+
 /**
  * @brief Add a resource to the library
  */
@@ -30,13 +111,17 @@ void LibraryManager::addResource(std::unique_ptr<Resource> resource) {
     
     validateResourceData(*resource);
     
-    // Check for duplicate resource ID using linear search
+    // Check for duplicate resource ID
     if (findResourceById(resource->getId()) != nullptr) {
         throw LibraryManagerException("Resource with ID " + resource->getId() + " already exists");
     }
     
     QString resourceId = resource->getId();
+    m_resourceStore.add(resource.get());
+    m_resourceIndex.insert(resourceId, resource.get());
     m_resources.push_back(std::move(resource));
+    m_searchRanksValid = false;
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Resources, resourceId);
     
     emit resourceAdded(resourceId);
 }
@@ -56,33 +141,105 @@ bool LibraryManager::removeResource(const QString& resourceId) {
         throw LibraryManagerException("Cannot remove resource that is currently borrowed");
     }
     
+    m_resourceStore.remove(resource);
+    m_resourceIndex.remove(resourceId);
     m_resources.erase(it);
+    m_searchRanksValid = false;
+    m_changeTracker.markEntityRemoved(ChangeTracker::Collection::Resources, resourceId);
     emit resourceRemoved(resourceId);
     return true;
 }
 
 /**
- * @brief Find resource by ID using linear search
+ * @brief Find resource by ID using the ID index
  */
 Resource* LibraryManager::findResourceById(const QString& resourceId) {
-    auto it = std::find_if(m_resources.begin(), m_resources.end(),
-                          [&resourceId](const std::unique_ptr<Resource>& resource) {
-                              return resource->getId() == resourceId;
-                          });
-    
-    return (it != m_resources.end()) ? it->get() : nullptr;
+    return m_resourceIndex.value(resourceId, nullptr);
 }
 
 /**
- * @brief Find resource by ID using linear search (const version)
+ * @brief Find resource by ID using the ID index (const version)
  */
 const Resource* LibraryManager::findResourceById(const QString& resourceId) const {
-    auto it = std::find_if(m_resources.begin(), m_resources.end(),
-                          [&resourceId](const std::unique_ptr<Resource>& resource) {
-                              return resource->getId() == resourceId;
-                          });
+    return m_resourceIndex.value(resourceId, nullptr);
+}
+
+/**
+ * @brief Append every resource, in catalog order
+ */
+template <typename Container>
+void LibraryManager::appendAllResources(Container& results) const {
+    results.reserve(results.size() + m_resources.size());
+    for (const auto& resource : m_resources) {
+        results.push_back(resource.get());
+    }
+}
+
+/**
+ * @brief Append the resources matching a search query
+ * 
+ * Queries long enough to contain a trigram only confirm the index's
+ * candidates; shorter ones scan every resource.
+ */
+template <typename Container>
+void LibraryManager::appendSearchResults(const QString& query, Container& results,
+                                         std::pmr::memory_resource* memory) const {
+    if (!ResourceIndex::canSearch(query)) {
+        results.reserve(results.size() + m_resources.size()); // Upper bound: every resource matches
+        for (const auto& resource : m_resources) {
+            if (matchesSearchQuery(*resource, query)) {
+                results.push_back(resource.get());
+            }
+        }
+        return;
+    }
     
-    return (it != m_resources.end()) ? it->get() : nullptr;
+    updateSearchIndex();
+    ResourceIndex::Ordinals candidates = m_searchIndex.search(query, memory);
+    sortByCatalogOrder(candidates);
+    results.reserve(results.size() + candidates.size()); // Upper bound: every candidate matches
+    for (quint32 ordinal : candidates) {
+        Resource* resource = indexedResource(ordinal);
+        if (resource && matchesSearchQuery(*resource, query)) {
+            results.push_back(resource);
+        }
+    }
+}
+
+/**
+ * @brief Append the resources of a category
+ */
+template <typename Container>
+void LibraryManager::appendCategoryResults(Resource::Category category, Container& results,
+                                           std::pmr::memory_resource* memory) const {
+    updateSearchIndex();
+    ResourceIndex::Ordinals ordinals = m_searchIndex.withCategory(category, memory);
+    sortByCatalogOrder(ordinals);
+    results.reserve(results.size() + ordinals.size());
+    for (quint32 ordinal : ordinals) {
+        Resource* resource = indexedResource(ordinal);
+        if (resource && resource->getCategory() == category) {
+            results.push_back(resource);
+        }
+    }
+}
+
+/**
+ * @brief Append the resources with a status
+ */
+template <typename Container>
+void LibraryManager::appendStatusResults(Resource::Status status, Container& results,
+                                         std::pmr::memory_resource* memory) const {
+    updateSearchIndex();
+    ResourceIndex::Ordinals ordinals = m_searchIndex.withStatus(status, memory);
+    sortByCatalogOrder(ordinals);
+    results.reserve(results.size() + ordinals.size());
+    for (quint32 ordinal : ordinals) {
+        Resource* resource = indexedResource(ordinal);
+        if (resource && resource->getStatus() == status) {
+            results.push_back(resource);
+        }
+    }
 }
 
 /**
@@ -90,9 +247,7 @@ const Resource* LibraryManager::findResourceById(const QString& resourceId) cons
  */
 std::vector<Resource*> LibraryManager::getAllResources() {
     std::vector<Resource*> resources;
-    for (const auto& resource : m_resources) {
-        resources.push_back(resource.get());
-    }
+    appendAllResources(resources);
     return resources;
 }
 
@@ -101,24 +256,16 @@ std::vector<Resource*> LibraryManager::getAllResources() {
  */
 std::vector<const Resource*> LibraryManager::getAllResources() const {
     std::vector<const Resource*> resources;
-    for (const auto& resource : m_resources) {
-        resources.push_back(resource.get());
-    }
+    appendAllResources(resources);
     return resources;
 }
 
 /**
- * @brief Search resources by query using linear search
+ * @brief Search resources by query
  */
 std::vector<Resource*> LibraryManager::searchResources(const QString& query) {
     std::vector<Resource*> results;
-    
-    for (const auto& resource : m_resources) {
-        if (matchesSearchQuery(*resource, query)) {
-            results.push_back(resource.get());
-        }
-    }
-    
+    appendSearchResults(query, results, std::pmr::get_default_resource());
     return results;
 }
 
@@ -127,13 +274,7 @@ std::vector<Resource*> LibraryManager::searchResources(const QString& query) {
  */
 std::vector<Resource*> LibraryManager::filterResourcesByCategory(Resource::Category category) {
     std::vector<Resource*> results;
-    
-    for (const auto& resource : m_resources) {
-        if (resource->getCategory() == category) {
-            results.push_back(resource.get());
-        }
-    }
-    
+    appendCategoryResults(category, results, std::pmr::get_default_resource());
     return results;
 }
 
@@ -142,13 +283,7 @@ std::vector<Resource*> LibraryManager::filterResourcesByCategory(Resource::Categ
  */
 std::vector<Resource*> LibraryManager::filterResourcesByStatus(Resource::Status status) {
     std::vector<Resource*> results;
-    
-    for (const auto& resource : m_resources) {
-        if (resource->getStatus() == status) {
-            results.push_back(resource.get());
-        }
-    }
-    
+    appendStatusResults(status, results, std::pmr::get_default_resource());
     return results;
 }
 
@@ -159,6 +294,47 @@ std::vector<Resource*> LibraryManager::getAvailableResources() {
     return filterResourcesByStatus(Resource::Status::Available);
 }
 
+/**
+ * @brief Get all resources into a caller-provided memory resource
+ * 
+ * The result is reserved once up front, so with a monotonic buffer the
+ * whole assembly is a single bump allocation.
+ */
+std::pmr::vector<Resource*> LibraryManager::getAllResources(std::pmr::memory_resource* memory) {
+    std::pmr::vector<Resource*> resources(memory);
+    appendAllResources(resources);
+    return resources;
+}
+
+/**
+ * @brief Search resources into a caller-provided memory resource
+ */
+std::pmr::vector<Resource*> LibraryManager::searchResources(const QString& query, std::pmr::memory_resource* memory) {
+    std::pmr::vector<Resource*> results(memory);
+    appendSearchResults(query, results, memory);
+    return results;
+}
+
+/**
+ * @brief Filter resources by category into a caller-provided memory resource
+ */
+std::pmr::vector<Resource*> LibraryManager::filterResourcesByCategory(Resource::Category category,
+                                                                      std::pmr::memory_resource* memory) {
+    std::pmr::vector<Resource*> results(memory);
+    appendCategoryResults(category, results, memory);
+    return results;
+}
+
+/**
+ * @brief Filter resources by status into a caller-provided memory resource
+ */
+std::pmr::vector<Resource*> LibraryManager::filterResourcesByStatus(Resource::Status status,
+                                                                    std::pmr::memory_resource* memory) {
+    std::pmr::vector<Resource*> results(memory);
+    appendStatusResults(status, results, memory);
+    return results;
+}
+
 /**
  * @brief Add a user to the system
  */
@@ -169,7 +345,7 @@ void LibraryManager::addUser(std::unique_ptr<User> user) {
     
     validateUserData(*user);
     
-    // Check for duplicate user ID using linear search
+    // Check for duplicate user ID
     if (findUserById(user->getUserId()) != nullptr) {
         throw LibraryManagerException("User with ID " + user->getUserId() + " already exists");
     }
@@ -180,8 +356,11 @@ void LibraryManager::addUser(std::unique_ptr<User> user) {
     }
     
     QString userId = user->getUserId();
+    m_userIndex.insert(userId, user.get());
     m_users.push_back(std::move(user));
     
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Users, userId);
+    
     emit userAdded(userId);
 }
 
@@ -200,33 +379,25 @@ bool LibraryManager::removeUser(const QString& userId) {
         throw LibraryManagerException("Cannot remove user with active loans");
     }
     
+    m_userIndex.remove(userId);
     m_users.erase(it);
+    m_changeTracker.markEntityRemoved(ChangeTracker::Collection::Users, userId);
     emit userRemoved(userId);
     return true;
 }
 
 /**
- * @brief Find user by ID using linear search
+ * @brief Find user by ID using the ID index
  */
 User* LibraryManager::findUserById(const QString& userId) {
-    auto it = std::find_if(m_users.begin(), m_users.end(),
-                          [&userId](const std::unique_ptr<User>& user) {
-                              return user->getUserId() == userId;
-                          });
-    
-    return (it != m_users.end()) ? it->get() : nullptr;
+    return m_userIndex.value(userId, nullptr);
 }
 
 /**
- * @brief Find user by ID using linear search (const version)
+ * @brief Find user by ID using the ID index (const version)
  */
 const User* LibraryManager::findUserById(const QString& userId) const {
-    auto it = std::find_if(m_users.begin(), m_users.end(),
-                          [&userId](const std::unique_ptr<User>& user) {
-                              return user->getUserId() == userId;
-                          });
-    
-    return (it != m_users.end()) ? it->get() : nullptr;
+    return m_userIndex.value(userId, nullptr);
 }
 
 /**
@@ -263,6 +434,18 @@ std::vector<const User*> LibraryManager::getAllUsers() const {
     return users;
 }
 
+/**
+ * @brief Get all users into a caller-provided memory resource
+ */
+std::pmr::vector<User*> LibraryManager::getAllUsers(std::pmr::memory_resource* memory) {
+    std::pmr::vector<User*> users(memory);
+    users.reserve(m_users.size());
+    for (const auto& user : m_users) {
+        users.push_back(user.get());
+    }
+    return users;
+}
+
 /**
  * @brief Search users by query using linear search
  */
@@ -283,9 +466,10 @@ std::vector<User*> LibraryManager::searchUsers(const QString& query) {
  */
 std::vector<User*> LibraryManager::getUsersWithOverdueItems() {
     std::vector<User*> results;
+    const qint64 now = m_clock->nowMSecsSinceEpoch();
     
     for (const auto& user : m_users) {
-        if (user->hasOverdueItems()) {        results.push_back(user.get());
+        if (user->hasOverdueItems(now)) {        results.push_back(user.get());
         }
     }
     
@@ -316,8 +500,8 @@ QString LibraryManager::borrowResource(const QString& userId, const QString& res
     
     // Create loan
     QString loanId = generateLoanId();
-    QDateTime borrowDate = QDateTime::currentDateTime();
-    QDateTime dueDate = calculateDueDate();
+    QDateTime borrowDate = m_clock->now();
+    QDateTime dueDate = calculateDueDate(borrowDate);
     
     auto loan = std::make_unique<Loan>(loanId, userId, resourceId, resource->getTitle(),
                                       borrowDate, dueDate);
@@ -331,6 +515,10 @@ QString LibraryManager::borrowResource(const QString& userId, const QString& res
     // Add loan to active loans
     m_activeLoans.push_back(std::move(loan));
     
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Resources, resourceId);
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Users, userId);
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Loans, loanId);
+    
     emit resourceBorrowed(loanId, userId, resourceId);
     return loanId;
 }
@@ -354,11 +542,15 @@ bool LibraryManager::returnResource(const QString& loanId) {
     }
     
     // Process loan return
-    processLoanReturn(*loan);
+    processLoanReturn(*loan, m_clock->nowMSecsSinceEpoch());
     
     // Move loan to history
     moveLoanToHistory(loanId);
     
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Resources, resourceId);
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Users, loan->getUserId());
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Loans, loanId);
+    
     emit resourceReturned(loanId, loan->getUserId(), resourceId);
     
     // Check if anyone has this resource reserved and notify them
@@ -377,12 +569,14 @@ QDateTime LibraryManager::renewLoan(const QString& loanId, int additionalDays) {
     }
     
     Loan* loan = it->get();
+    const qint64 now = m_clock->nowMSecsSinceEpoch();
     
-    if (!loan->canBeRenewed()) {
+    if (!loan->canBeRenewed(now)) {
         throw LibraryManagerException("Loan cannot be renewed");
     }
     
-    if (loan->renewLoan(additionalDays)) {
+    if (loan->renewLoan(additionalDays, now)) {
+        m_changeTracker.markEntityChanged(ChangeTracker::Collection::Loans, loanId);
         emit loanRenewed(loanId, loan->getDueDate());
         return loan->getDueDate();
     }
@@ -417,9 +611,10 @@ std::vector<const Loan*> LibraryManager::getActiveLoans() const {
  */
 std::vector<Loan*> LibraryManager::getOverdueLoans() {
     std::vector<Loan*> overdueLoans;
+    const qint64 now = m_clock->nowMSecsSinceEpoch();
     
     for (const auto& loan : m_activeLoans) {
-        if (loan->isOverdue()) {
+        if (loan->isOverdue(now)) {
             overdueLoans.push_back(loan.get());
         }
     }
@@ -428,47 +623,75 @@ std::vector<Loan*> LibraryManager::getOverdueLoans() {
 }
 
 /**
- * @brief Get loan history
+ * @brief Get active loans into a caller-provided memory resource
  */
-std::vector<Loan*> LibraryManager::getLoanHistory() {
-    std::vector<Loan*> loans;
-    for (const auto& loan : m_loanHistory) {
+std::pmr::vector<Loan*> LibraryManager::getActiveLoans(std::pmr::memory_resource* memory) {
+    std::pmr::vector<Loan*> loans(memory);
+    loans.reserve(m_activeLoans.size());
+    for (const auto& loan : m_activeLoans) {
         loans.push_back(loan.get());
     }
     return loans;
 }
 
 /**
- * @brief Get loan history (const version)
+ * @brief Get overdue loans into a caller-provided memory resource
  */
-std::vector<const Loan*> LibraryManager::getLoanHistory() const {
-    std::vector<const Loan*> loans;
-    for (const auto& loan : m_loanHistory) {
-        loans.push_back(loan.get());
+std::pmr::vector<Loan*> LibraryManager::getOverdueLoans(std::pmr::memory_resource* memory) {
+    std::pmr::vector<Loan*> overdueLoans(memory);
+    overdueLoans.reserve(m_activeLoans.size());
+    const qint64 now = m_clock->nowMSecsSinceEpoch();
+    
+    for (const auto& loan : m_activeLoans) {
+        if (loan->isOverdue(now)) {
+            overdueLoans.push_back(loan.get());
+        }
     }
-    return loans;
+    
+    return overdueLoans;
+}
+
+/**
+ * @brief Get loan history
+ */
+std::vector<HistoryRecord<Loan>> LibraryManager::getLoanHistory() const {
+    return mergeHistory(m_loanHistory, [this](QSet<QString>& seen) {
+        return m_loanArchive ? m_loanArchive->all(seen) : std::vector<HistoryRecord<Loan>>();
+    }, [](const Loan&) { return true; });
 }
 
 /**
  * @brief Get reservation history
  */
-std::vector<Reservation*> LibraryManager::getReservationHistory() {
-    std::vector<Reservation*> reservations;
-    for (const auto& reservation : m_reservationHistory) {
-        reservations.push_back(reservation.get());
-    }
-    return reservations;
+std::vector<HistoryRecord<Reservation>> LibraryManager::getReservationHistory() const {
+    return mergeHistory(m_reservationHistory, [this](QSet<QString>& seen) {
+        return m_reservationArchive ? m_reservationArchive->all(seen) : std::vector<HistoryRecord<Reservation>>();
+    }, [](const Reservation&) { return true; });
 }
 
 /**
- * @brief Get reservation history (const version)
+ * @brief Get the most recent completed reservations, oldest first
+ * 
+ * In-memory history is newest; the archive is only asked for the rest,
+ * and reads only the pages that hold them.
  */
-std::vector<const Reservation*> LibraryManager::getReservationHistory() const {
-    std::vector<const Reservation*> reservations;
-    for (const auto& reservation : m_reservationHistory) {
-        reservations.push_back(reservation.get());
+std::vector<HistoryRecord<Reservation>> LibraryManager::getRecentReservationHistory(qsizetype count) const {
+    const qsizetype held = static_cast<qsizetype>(m_reservationHistory.size());
+    const qsizetype fromMemory = std::min(count, held);
+    
+    std::vector<HistoryRecord<Reservation>> records;
+    if (m_reservationArchive && fromMemory < count) {
+        QSet<QString> seen;
+        seen.reserve(held);
+        for (const auto& reservation : m_reservationHistory) {
+            seen.insert(reservation->getId());
+        }
+        records = m_reservationArchive->newest(count - fromMemory, seen);
     }
-    return reservations;
+    for (qsizetype i = held - fromMemory; i < held; ++i) {
+        records.push_back(std::make_shared<const Reservation>(*m_reservationHistory[static_cast<std::size_t>(i)]));
+    }
+    return records;
 }
 
 /**
@@ -487,25 +710,49 @@ std::vector<Loan*> LibraryManager::getUserLoans(const QString& userId) {
 }
 
 /**
- * @brief Get resource loans using linear search
+ * @brief Get a user's completed loans, paging in only the archive pages that hold them
+ */
+std::vector<HistoryRecord<Loan>> LibraryManager::getUserLoanHistory(const QString& userId) const {
+    return mergeHistory(m_loanHistory, [this, &userId](QSet<QString>& seen) {
+        return m_loanArchive ? m_loanArchive->forUser(userId, seen) : std::vector<HistoryRecord<Loan>>();
+    }, [&userId](const Loan& loan) { return loan.getUserId() == userId; });
+}
+
+/**
+ * @brief Get user loans into a caller-provided memory resource
  */
-std::vector<Loan*> LibraryManager::getResourceLoans(const QString& resourceId) {
-    std::vector<Loan*> resourceLoans;
+std::pmr::vector<Loan*> LibraryManager::getUserLoans(const QString& userId, std::pmr::memory_resource* memory) {
+    std::pmr::vector<Loan*> userLoans(memory);
+    userLoans.reserve(m_activeLoans.size());
     
-    // Check active loans
     for (const auto& loan : m_activeLoans) {
-        if (loan->getResourceId() == resourceId) {
-            resourceLoans.push_back(loan.get());
+        if (loan->getUserId() == userId) {
+            userLoans.push_back(loan.get());
         }
     }
     
-    // Check loan history
-    for (const auto& loan : m_loanHistory) {
+    return userLoans;
+}
+
+/**
+ * @brief Get a resource's active and completed loans, as copies
+ */
+std::vector<HistoryRecord<Loan>> LibraryManager::getResourceLoans(const QString& resourceId) const {
+    std::vector<HistoryRecord<Loan>> resourceLoans;
+    
+    // Check active loans
+    for (const auto& loan : m_activeLoans) {
         if (loan->getResourceId() == resourceId) {
-            resourceLoans.push_back(loan.get());
+            resourceLoans.push_back(std::make_shared<const Loan>(*loan));
         }
     }
     
+    // Check loan history, archived pages through the resource index
+    std::vector<HistoryRecord<Loan>> history = mergeHistory(m_loanHistory, [this, &resourceId](QSet<QString>& seen) {
+        return m_loanArchive ? m_loanArchive->forResource(resourceId, seen) : std::vector<HistoryRecord<Loan>>();
+    }, [&resourceId](const Loan& loan) { return loan.getResourceId() == resourceId; });
+    resourceLoans.insert(resourceLoans.end(), history.begin(), history.end());
+    
     return resourceLoans;
 }
 
@@ -544,10 +791,12 @@ QString LibraryManager::reserveResource(const QString& userId, const QString& re
     }
     
     // Create the reservation
-    auto reservation = std::make_unique<Reservation>(userId, resourceId, resource->getTitle());
+    auto reservation = std::make_unique<Reservation>(userId, resourceId, resource->getTitle(),
+                                                     7, m_clock->nowMSecsSinceEpoch());
     QString reservationId = reservation->getReservationId();
     
     m_activeReservations.push_back(std::move(reservation));
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Reservations, reservationId);
     
     // Emit signal for notification
     emit resourceReserved(reservationId, userId, resourceId);
@@ -573,6 +822,7 @@ bool LibraryManager::cancelReservation(const QString& reservationId) {
         // Move to history
         m_reservationHistory.push_back(std::move(*it));
         m_activeReservations.erase(it);
+        m_changeTracker.markEntityChanged(ChangeTracker::Collection::Reservations, reservationId);
         
         emit reservationCancelled(reservationId, userId, resourceId);
         return true;
@@ -652,7 +902,27 @@ std::vector<Reservation*> LibraryManager::getResourceReservations(const QString&
     // Sort by reservation date (earliest first)
     std::sort(reservations.begin(), reservations.end(),
               [](const Reservation* a, const Reservation* b) {
-                  return a->getReservationDate() < b->getReservationDate();
+                  return a->getReservationDateMSecs() < b->getReservationDateMSecs();
+              });
+    return reservations;
+}
+
+/**
+ * @brief Get active reservations for a resource into a caller-provided memory resource
+ */
+std::pmr::vector<Reservation*> LibraryManager::getResourceReservations(const QString& resourceId,
+                                                                       std::pmr::memory_resource* memory) {
+    std::pmr::vector<Reservation*> reservations(memory);
+    reservations.reserve(m_activeReservations.size());
+    for (const auto& reservation : m_activeReservations) {
+        if (reservation->getResourceId() == resourceId && reservation->isActive()) {
+            reservations.push_back(reservation.get());
+        }
+    }
+    // Sort by reservation date (earliest first)
+    std::sort(reservations.begin(), reservations.end(),
+              [](const Reservation* a, const Reservation* b) {
+                  return a->getReservationDateMSecs() < b->getReservationDateMSecs();
               });
     return reservations;
 }
@@ -662,8 +932,9 @@ std::vector<Reservation*> LibraryManager::getResourceReservations(const QString&
  */
 std::vector<Reservation*> LibraryManager::getExpiredReservations() {
     std::vector<Reservation*> reservations;
+    const qint64 now = m_clock->nowMSecsSinceEpoch();
     for (const auto& reservation : m_activeReservations) {
-        if (reservation->isExpired()) {
+        if (reservation->isExpired(now)) {
             reservations.push_back(reservation.get());
         }
     }
@@ -687,10 +958,11 @@ Reservation* LibraryManager::findReservationById(const QString& reservationId) {
  */
 bool LibraryManager::processExpiredReservations() {
     bool hasExpired = false;
+    const qint64 now = m_clock->nowMSecsSinceEpoch();
     auto it = m_activeReservations.begin();
     
     while (it != m_activeReservations.end()) {
-        if ((*it)->isExpired()) {
+        if ((*it)->isExpired(now)) {
             QString reservationId = (*it)->getReservationId();
             QString userId = (*it)->getUserId();
             QString resourceId = (*it)->getResourceId();
@@ -700,6 +972,7 @@ bool LibraryManager::processExpiredReservations() {
             // Move to history
             m_reservationHistory.push_back(std::move(*it));
             it = m_activeReservations.erase(it);
+            m_changeTracker.markEntityChanged(ChangeTracker::Collection::Reservations, reservationId);
             
             emit reservationExpired(reservationId, userId, resourceId);
             hasExpired = true;
@@ -721,7 +994,7 @@ void LibraryManager::notifyWhenResourceAvailable(const QString& resourceId) {
     if (!reservations.empty()) {
         // Notify the first user in the reservation queue
         Reservation* firstReservation = reservations[0];
-        if (firstReservation->canBeFulfilled()) {
+        if (firstReservation->canBeFulfilled(m_clock->nowMSecsSinceEpoch())) {
             emit reservedResourceAvailable(firstReservation->getReservationId(),
                                          firstReservation->getUserId(),
                                          resourceId);
@@ -732,12 +1005,8 @@ void LibraryManager::notifyWhenResourceAvailable(const QString& resourceId) {
 /**
  * @brief Get completed loans (loan history)
  */
-std::vector<Loan*> LibraryManager::getCompletedLoans() {
-    std::vector<Loan*> loans;
-    for (const auto& loan : m_loanHistory) {
-        loans.push_back(loan.get());
-    }
-    return loans;
+std::vector<HistoryRecord<Loan>> LibraryManager::getCompletedLoans() const {
+    return getLoanHistory();
 }
 
 /**
@@ -751,10 +1020,21 @@ int LibraryManager::getTotalResourceCount() const {
  * @brief Get available resource count
  */
 int LibraryManager::getAvailableResourceCount() const {
-    return static_cast<int>(std::count_if(m_resources.begin(), m_resources.end(),
-                                         [](const std::unique_ptr<Resource>& resource) {
-                                             return resource->isAvailable();
-                                         }));
+    return static_cast<int>(m_resourceStore.countByStatus(Resource::Status::Available));
+}
+
+/**
+ * @brief Get resource count for one concrete type
+ */
+int LibraryManager::getResourceCountByKind(Resource::Kind kind) const {
+    return static_cast<int>(m_resourceStore.count(kind));
+}
+
+/**
+ * @brief Get available resource count for one concrete type
+ */
+int LibraryManager::getAvailableResourceCountByKind(Resource::Kind kind) const {
+    return static_cast<int>(m_resourceStore.countByStatus(kind, Resource::Status::Available));
 }
 
 /**
@@ -785,32 +1065,115 @@ int LibraryManager::getTotalActiveLoans() const {
  * @brief Get total overdue loans
  */
 int LibraryManager::getTotalOverdueLoans() const {
+    const qint64 now = m_clock->nowMSecsSinceEpoch();
     return static_cast<int>(std::count_if(m_activeLoans.begin(), m_activeLoans.end(),
-                                         [](const std::unique_ptr<Loan>& loan) {
-                                             return loan->isOverdue();
+                                         [now](const std::unique_ptr<Loan>& loan) {
+                                             return loan->isOverdue(now);
                                          }));
 }
 
 /**
- * @brief Get most borrowed resources (placeholder implementation)
+ * @brief Get the resources borrowed most often overall, counting completed loans
  */
 std::vector<Resource*> LibraryManager::getMostBorrowedResources(int count) {
-    // This would require tracking borrow counts - simplified implementation
-    std::vector<Resource*> resources = getAllResources();
-    if (resources.size() > static_cast<size_t>(count)) {
-        resources.resize(count);
+    return getMostBorrowedResources(count, QDate(), QDate());
+}
+
+/**
+ * @brief Get the users who borrowed most often overall, counting completed loans
+ */
+std::vector<User*> LibraryManager::getMostActiveUsers(int count) {
+    return getMostActiveUsers(count, QDate(), QDate());
+}
+
+/**
+ * @brief Get loans completed between two dates (inclusive)
+ * 
+ * Only archive partitions of the months in between are paged in.
+ */
+std::vector<HistoryRecord<Loan>> LibraryManager::getLoanHistory(const QDate& from, const QDate& to) const {
+    const qint64 start = from.isValid() ? from.startOfDay(QTimeZone::UTC).toMSecsSinceEpoch()
+                                        : std::numeric_limits<qint64>::min() + 1;
+    const qint64 end = to.isValid() ? to.addDays(1).startOfDay(QTimeZone::UTC).toMSecsSinceEpoch()
+                                    : std::numeric_limits<qint64>::max();
+    auto completedInPeriod = [start, end](const Loan& loan) {
+        const qint64 completed = loan.getCompletionDateMSecs();
+        return EpochTime::isValid(completed) && completed >= start && completed < end;
+    };
+    
+    const auto range = monthRange(from, to);
+    return mergeHistory(m_loanHistory, [this, &range, &completedInPeriod](QSet<QString>& seen) {
+        return m_loanArchive ? m_loanArchive->forPartitions(range.first, range.second, seen, completedInPeriod)
+                             : std::vector<HistoryRecord<Loan>>();
+    }, completedInPeriod);
+}
+
+/**
+ * @brief Count completed loans per user, resource and category over whole months
+ * 
+ * Archived months are answered from their partition summaries; only loans
+ * completed since the last save are counted one by one.
+ */
+HistorySummary LibraryManager::getLoanSummary(const QDate& fromMonth, const QDate& toMonth) const {
+    const auto range = monthRange(fromMonth, toMonth);
+    HistorySummary summary;
+    if (m_loanArchive) {
+        summary = m_loanArchive->summarize(range.first, range.second);
+    }
+    
+    for (const auto& loan : m_loanHistory) {
+        if ((m_loanArchive && m_loanArchive->wasAppended(loan->getLoanId())) ||
+            !inMonthRange(loan->getCompletionDateMSecs(), range)) {
+            continue;
+        }
+        const Resource* resource = findResourceById(loan->getResourceId());
+        summary.count(loan->getUserId(), loan->getResourceId(),
+                      resource ? Resource::categoryToString(resource->getCategory()) : QString());
+    }
+    return summary;
+}
+
+/**
+ * @brief Get the resources borrowed most often in a range of months
+ * 
+ * Loans count in the month they were completed (returned or marked lost),
+ * the month the archive partitions them by, so the counts come straight
+ * from the loan summary. Loans still out are not counted until they are
+ * completed; a loan is therefore counted once and never moves to another
+ * month.
+ */
+std::vector<Resource*> LibraryManager::getMostBorrowedResources(int count, const QDate& fromMonth,
+                                                                const QDate& toMonth) {
+    const QHash<QString, qint64> borrows = getLoanSummary(fromMonth, toMonth).byResource;
+    
+    std::vector<Resource*> resources;
+    for (const QString& resourceId : rankByCount(borrows)) {
+        if (resources.size() >= static_cast<size_t>(count)) {
+            break;
+        }
+        if (Resource* resource = findResourceById(resourceId)) {
+            resources.push_back(resource);
+        }
     }
     return resources;
 }
 
 /**
- * @brief Get most active users (placeholder implementation)
+ * @brief Get the users who borrowed most often in a range of months
+ * 
+ * Counts loans by completion month, like getMostBorrowedResources().
  */
-std::vector<User*> LibraryManager::getMostActiveUsers(int count) {
-    // This would require tracking activity - simplified implementation
-    std::vector<User*> users = getAllUsers();
-    if (users.size() > static_cast<size_t>(count)) {
-        users.resize(count);
+std::vector<User*> LibraryManager::getMostActiveUsers(int count, const QDate& fromMonth, const QDate& toMonth) {
+    const QHash<QString, qint64> borrows = getLoanSummary(fromMonth, toMonth).byUser;
+    
+    std::vector<User*> users;
+    for (const QString& userId : rankByCount(borrows)) {
+        if (users.size() >= static_cast<size_t>(count)) {
+            break;
+        }
+        if (User* user = findUserById(userId)) {
+            users.push_back(user);
+        }
     }
     return users;
 }
@@ -821,6 +1184,7 @@ std::vector<User*> LibraryManager::getMostActiveUsers(int count) {
 void LibraryManager::addUpcomingEvent(const QString& event) {
     if (!event.isEmpty() && std::find(m_upcomingEvents.begin(), m_upcomingEvents.end(), event) == m_upcomingEvents.end()) {
         m_upcomingEvents.push_back(event);
+        m_changeTracker.markChanged(ChangeTracker::Collection::Configuration);
     }
 }
 
@@ -828,8 +1192,41 @@ void LibraryManager::addUpcomingEvent(const QString& event) {
  * @brief Remove upcoming event
  */
 void LibraryManager::removeUpcomingEvent(const QString& event) {
-    m_upcomingEvents.erase(std::remove(m_upcomingEvents.begin(), m_upcomingEvents.end(), event),
-                          m_upcomingEvents.end());
+    auto it = std::remove(m_upcomingEvents.begin(), m_upcomingEvents.end(), event);
+    if (it != m_upcomingEvents.end()) {
+        m_upcomingEvents.erase(it, m_upcomingEvents.end());
+        m_changeTracker.markChanged(ChangeTracker::Collection::Configuration);
+    }
+}
+
+/**
+ * @brief Set the library name
+ */
+void LibraryManager::setLibraryName(const QString& name) {
+    if (name != m_libraryName) {
+        m_libraryName = name;
+        m_changeTracker.markChanged(ChangeTracker::Collection::Configuration);
+    }
+}
+
+/**
+ * @brief Set the operating hours
+ */
+void LibraryManager::setOperatingHours(const QString& hours) {
+    if (hours != m_operatingHours) {
+        m_operatingHours = hours;
+        m_changeTracker.markChanged(ChangeTracker::Collection::Configuration);
+    }
+}
+
+/**
+ * @brief Set the default loan period
+ */
+void LibraryManager::setDefaultLoanPeriod(int days) {
+    if (days != m_defaultLoanPeriodDays) {
+        m_defaultLoanPeriodDays = days;
+        m_changeTracker.markChanged(ChangeTracker::Collection::Configuration);
+    }
 }
 
 /**
@@ -903,8 +1300,9 @@ void LibraryManager::performDailyMaintenance() {
     processExpiredReservations();
     
     // Emit overdue notifications
+    const qint64 now = m_clock->nowMSecsSinceEpoch();
     for (const auto& loan : m_activeLoans) {
-        if (loan->isOverdue()) {
+        if (loan->isOverdue(now)) {
             emit itemOverdue(loan->getLoanId(), loan->getUserId(), loan->getResourceId());
         }
     }
@@ -971,19 +1369,119 @@ bool LibraryManager::matchesSearchQuery(const User& user, const QString& query)
            user.getUserId().toLower().contains(lowerQuery);
 }
 
+/**
+ * @brief Bring the search index up to date with the resources
+ * 
+ * Only resources the change tracker reports as changed since the last
+ * update are re-indexed. The first use, a tracker that was reset, or an
+ * index with more removed than live entries rebuilds from scratch.
+ */
+void LibraryManager::updateSearchIndex() const {
+    const quint64 revision = m_changeTracker.revision(ChangeTracker::Collection::Resources);
+    if (m_searchIndexBuilt && revision == m_searchIndexRevision) {
+        return;
+    }
+    
+    const qsizetype removed = m_searchIndex.ordinalCount() - m_searchIndex.liveCount();
+    bool rebuild = !m_searchIndexBuilt || revision < m_searchIndexRevision || removed > m_searchIndex.liveCount();
+    if (!rebuild) {
+        const QStringList changed = m_changeTracker.changedSince(ChangeTracker::Collection::Resources,
+                                                                 m_searchIndexRevision);
+        for (const QString& resourceId : changed) {
+            if (const Resource* resource = m_resourceIndex.value(resourceId, nullptr)) {
+                m_searchIndex.add(*resource);
+            } else {
+                m_searchIndex.remove(resourceId);
+            }
+        }
+        rebuild = !sweepSearchIndex();
+    }
+    
+    if (rebuild) {
+        m_searchIndex.clear();
+        m_searchRanksValid = false;
+        m_searchIndex.reserve(static_cast<qsizetype>(m_resources.size()));
+        for (const auto& resource : m_resources) {
+            m_searchIndex.add(*resource);
+        }
+    }
+    
+    m_searchIndexRevision = revision;
+    m_searchIndexBuilt = true;
+}
+
+/**
+ * @brief Drop resources from the search index that are no longer in the library
+ * 
+ * The change tracker forgets removed resources, but they show up as a
+ * difference between the index's live count and the resource count.
+ * Returns false if the index still disagrees with the library afterwards,
+ * i.e. resources are missing from it.
+ */
+bool LibraryManager::sweepSearchIndex() const {
+    const auto resourceCount = static_cast<qsizetype>(m_resources.size());
+    if (m_searchIndex.liveCount() == resourceCount) {
+        return true;
+    }
+    const QStringList ids = m_searchIndex.ids();
+    for (const QString& resourceId : ids) {
+        if (!m_resourceIndex.contains(resourceId)) {
+            m_searchIndex.remove(resourceId);
+        }
+    }
+    return m_searchIndex.liveCount() == resourceCount;
+}
+
+/**
+ * @brief Resolve a search index ordinal to the library's resource
+ */
+Resource* LibraryManager::indexedResource(quint32 ordinal) const {
+    return m_resourceIndex.value(m_searchIndex.idAt(ordinal), nullptr);
+}
+
+/**
+ * @brief Sort search index ordinals into the order of m_resources
+ * 
+ * Ordinals follow the order resources were first indexed, which drifts from
+ * m_resources once resources are re-added or caught up out of order. The
+ * position of each ordinal is recomputed only after resources are added or
+ * removed, not on every status change, and an already ordered list is left as is.
+ */
+void LibraryManager::sortByCatalogOrder(ResourceIndex::Ordinals& ordinals) const {
+    if (!m_searchRanksValid) {
+        m_searchRanks.assign(static_cast<std::size_t>(m_searchIndex.ordinalCount()),
+                             std::numeric_limits<quint32>::max());
+        for (std::size_t position = 0; position < m_resources.size(); ++position) {
+            const quint32 ordinal = m_searchIndex.ordinalOf(m_resources[position]->getId());
+            if (ordinal < m_searchRanks.size()) {
+                m_searchRanks[ordinal] = static_cast<quint32>(position);
+            }
+        }
+        m_searchRanksValid = true;
+    }
+    
+    auto rank = [this](quint32 ordinal) {
+        return ordinal < m_searchRanks.size() ? m_searchRanks[ordinal] : std::numeric_limits<quint32>::max();
+    };
+    auto byRank = [&rank](quint32 left, quint32 right) { return rank(left) < rank(right); };
+    if (!std::is_sorted(ordinals.begin(), ordinals.end(), byRank)) {
+        std::sort(ordinals.begin(), ordinals.end(), byRank);
+    }
+}
+
 /**
  * @brief Calculate due date
  */
-QDateTime LibraryManager::calculateDueDate(int loanPeriodDays) const {
+QDateTime LibraryManager::calculateDueDate(const QDateTime& borrowDate, int loanPeriodDays) const {
     int days = (loanPeriodDays > 0) ? loanPeriodDays : m_defaultLoanPeriodDays;
-    return QDateTime::currentDateTime().addDays(days);
+    return borrowDate.addDays(days);
 }
 
 /**
  * @brief Process loan return
  */
-void LibraryManager::processLoanReturn(Loan& loan) {
-    loan.returnItem();
+void LibraryManager::processLoanReturn(Loan& loan, qint64 returnDateMSecs) {
+    loan.returnItem(returnDateMSecs);
     
     // Update user's loan collections
     User* user = findUserById(loan.getUserId());
@@ -1059,6 +1557,7 @@ void LibraryManager::validateLoanData(const Loan& loan) const {
  */
 void LibraryManager::addActiveLoan(std::unique_ptr<Loan> loan) {
     if (loan) {
+        m_changeTracker.markEntityChanged(ChangeTracker::Collection::Loans, loan->getLoanId());
         m_activeLoans.push_back(std::move(loan));
     }
 }
@@ -1068,6 +1567,7 @@ void LibraryManager::addActiveLoan(std::unique_ptr<Loan> loan) {
  */
 void LibraryManager::addLoanHistory(std::unique_ptr<Loan> loan) {
     if (loan) {
+        m_changeTracker.markEntityChanged(ChangeTracker::Collection::Loans, loan->getLoanId());
         m_loanHistory.push_back(std::move(loan));
     }
 }
@@ -1077,6 +1577,7 @@ void LibraryManager::addLoanHistory(std::unique_ptr<Loan> loan) {
  */
 void LibraryManager::addActiveReservation(std::unique_ptr<Reservation> reservation) {
     if (reservation) {
+        m_changeTracker.markEntityChanged(ChangeTracker::Collection::Reservations, reservation->getReservationId());
         m_activeReservations.push_back(std::move(reservation));
     }
 }
@@ -1086,6 +1587,376 @@ void LibraryManager::addActiveReservation(std::unique_ptr<Reservation> reservati
  */
 void LibraryManager::addReservationHistory(std::unique_ptr<Reservation> reservation) {
     if (reservation) {
+        m_changeTracker.markEntityChanged(ChangeTracker::Collection::Reservations, reservation->getReservationId());
         m_reservationHistory.push_back(std::move(reservation));
     }
 }
+
+/**
+ * @brief Load resources in one pass, skipping invalid or duplicate ones
+ * @return The skipped resources; the rest are in the library
+ */
+std::vector<LoadConflict> LibraryManager::bulkLoadResources(std::vector<std::unique_ptr<Resource>> resources) {
+    std::vector<LoadConflict> conflicts;
+    m_resources.reserve(m_resources.size() + resources.size());
+    m_resourceIndex.reserve(static_cast<qsizetype>(m_resources.size() + resources.size()));
+    
+    for (auto& resource : resources) {
+        if (!resource) {
+            continue;
+        }
+        
+        const QString resourceId = resource->getId();
+        try {
+            validateResourceData(*resource);
+        } catch (const LibraryManagerException& e) {
+            conflicts.push_back({ChangeTracker::Collection::Resources, resourceId,
+                                 LoadConflict::Reason::InvalidData, e.getMessage()});
+            continue;
+        }
+        
+        if (m_resourceIndex.contains(resourceId)) {
+            conflicts.push_back({ChangeTracker::Collection::Resources, resourceId, LoadConflict::Reason::DuplicateId,
+                                 "Resource with ID " + resourceId + " already exists"});
+            continue;
+        }
+        
+        m_resourceStore.add(resource.get());
+        m_resourceIndex.insert(resourceId, resource.get());
+        m_changeTracker.markEntityChanged(ChangeTracker::Collection::Resources, resourceId);
+        m_resources.push_back(std::move(resource));
+        m_searchRanksValid = false;
+    }
+    
+    return conflicts;
+}
+
+/**
+ * @brief Load users in one pass, skipping invalid users and duplicate IDs or emails
+ * @return The skipped users; the rest are in the library
+ */
+std::vector<LoadConflict> LibraryManager::bulkLoadUsers(std::vector<std::unique_ptr<User>> users) {
+    std::vector<LoadConflict> conflicts;
+    m_users.reserve(m_users.size() + users.size());
+    m_userIndex.reserve(static_cast<qsizetype>(m_users.size() + users.size()));
+    
+    // Emails can change after insertion, so they are indexed only for this pass
+    QHash<QString, const User*> emails;
+    emails.reserve(static_cast<qsizetype>(m_users.size() + users.size()));
+    for (const auto& user : m_users) {
+        emails.insert(user->getEmail(), user.get());
+    }
+    
+    for (auto& user : users) {
+        if (!user) {
+            continue;
+        }
+        
+        const QString userId = user->getUserId();
+        try {
+            validateUserData(*user);
+        } catch (const LibraryManagerException& e) {
+            conflicts.push_back({ChangeTracker::Collection::Users, userId,
+                                 LoadConflict::Reason::InvalidData, e.getMessage()});
+            continue;
+        }
+        
+        if (m_userIndex.contains(userId)) {
+            conflicts.push_back({ChangeTracker::Collection::Users, userId, LoadConflict::Reason::DuplicateId,
+                                 "User with ID " + userId + " already exists"});
+            continue;
+        }
+        
+        if (emails.contains(user->getEmail())) {
+            conflicts.push_back({ChangeTracker::Collection::Users, userId, LoadConflict::Reason::DuplicateEmail,
+                                 "User with email " + user->getEmail() + " already exists"});
+            continue;
+        }
+        
+        emails.insert(user->getEmail(), user.get());
+        m_userIndex.insert(userId, user.get());
+        m_changeTracker.markEntityChanged(ChangeTracker::Collection::Users, userId);
+        m_users.push_back(std::move(user));
+    }
+    
+    return conflicts;
+}
+
+/**
+ * @brief Load active and historical loans, skipping duplicate loan IDs
+ * @return The skipped loans; the rest are in the library
+ */
+std::vector<LoadConflict> LibraryManager::bulkLoadLoans(std::vector<std::unique_ptr<Loan>> activeLoans,
+                                                        std::vector<std::unique_ptr<Loan>> loanHistory) {
+    std::vector<LoadConflict> conflicts;
+    m_activeLoans.reserve(m_activeLoans.size() + activeLoans.size());
+    m_loanHistory.reserve(m_loanHistory.size() + loanHistory.size());
+    
+    QSet<QString> loanIds;
+    loanIds.reserve(static_cast<qsizetype>(m_activeLoans.size() + m_loanHistory.size() +
+                                           activeLoans.size() + loanHistory.size()));
+    for (const auto& loan : m_activeLoans) {
+        loanIds.insert(loan->getLoanId());
+    }
+    for (const auto& loan : m_loanHistory) {
+        loanIds.insert(loan->getLoanId());
+    }
+    
+    auto load = [&](std::vector<std::unique_ptr<Loan>>& source, std::vector<std::unique_ptr<Loan>>& target) {
+        for (auto& loan : source) {
+            if (!loan) {
+                continue;
+            }
+            
+            const QString loanId = loan->getLoanId();
+            if (loanIds.contains(loanId)) {
+                conflicts.push_back({ChangeTracker::Collection::Loans, loanId, LoadConflict::Reason::DuplicateId,
+                                     "Loan with ID " + loanId + " already exists"});
+                continue;
+            }
+            
+            loanIds.insert(loanId);
+            m_changeTracker.markEntityChanged(ChangeTracker::Collection::Loans, loanId);
+            target.push_back(std::move(loan));
+        }
+    };
+    load(activeLoans, m_activeLoans);
+    load(loanHistory, m_loanHistory);
+    
+    return conflicts;
+}
+
+/**
+ * @brief Load active and historical reservations, skipping duplicate reservation IDs
+ * @return The skipped reservations; the rest are in the library
+ */
+std::vector<LoadConflict> LibraryManager::bulkLoadReservations(
+        std::vector<std::unique_ptr<Reservation>> activeReservations,
+        std::vector<std::unique_ptr<Reservation>> reservationHistory) {
+    std::vector<LoadConflict> conflicts;
+    m_activeReservations.reserve(m_activeReservations.size() + activeReservations.size());
+    m_reservationHistory.reserve(m_reservationHistory.size() + reservationHistory.size());
+    
+    QSet<QString> reservationIds;
+    reservationIds.reserve(static_cast<qsizetype>(m_activeReservations.size() + m_reservationHistory.size() +
+                                                  activeReservations.size() + reservationHistory.size()));
+    for (const auto& reservation : m_activeReservations) {
+        reservationIds.insert(reservation->getReservationId());
+    }
+    for (const auto& reservation : m_reservationHistory) {
+        reservationIds.insert(reservation->getReservationId());
+    }
+    
+    auto load = [&](std::vector<std::unique_ptr<Reservation>>& source,
+                    std::vector<std::unique_ptr<Reservation>>& target) {
+        for (auto& reservation : source) {
+            if (!reservation) {
+                continue;
+            }
+            
+            const QString reservationId = reservation->getReservationId();
+            if (reservationIds.contains(reservationId)) {
+                conflicts.push_back({ChangeTracker::Collection::Reservations, reservationId,
+                                     LoadConflict::Reason::DuplicateId,
+                                     "Reservation with ID " + reservationId + " already exists"});
+                continue;
+            }
+            
+            reservationIds.insert(reservationId);
+            m_changeTracker.markEntityChanged(ChangeTracker::Collection::Reservations, reservationId);
+            target.push_back(std::move(reservation));
+        }
+    };
+    load(activeReservations, m_activeReservations);
+    load(reservationHistory, m_reservationHistory);
+    
+    return conflicts;
+}
+
+/**
+ * @brief Install a resource from the journal, replacing any existing one
+ */
+void LibraryManager::restoreResource(std::unique_ptr<Resource> resource) {
+    if (!resource) {
+        return;
+    }
+    
+    const QString resourceId = resource->getId();
+    auto it = findResourceIterator(resourceId);
+    if (it != m_resources.end()) {
+        m_resourceStore.remove(it->get());
+        m_resources.erase(it);
+    }
+    
+    m_resourceStore.add(resource.get());
+    m_resourceIndex.insert(resourceId, resource.get());
+    m_resources.push_back(std::move(resource));
+    m_searchRanksValid = false;
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Resources, resourceId);
+}
+
+/**
+ * @brief Remove a resource recorded as removed in the journal
+ */
+bool LibraryManager::discardResource(const QString& resourceId) {
+    auto it = findResourceIterator(resourceId);
+    if (it == m_resources.end()) {
+        return false;
+    }
+    
+    m_resourceStore.remove(it->get());
+    m_resourceIndex.remove(resourceId);
+    m_resources.erase(it);
+    m_searchRanksValid = false;
+    m_changeTracker.markEntityRemoved(ChangeTracker::Collection::Resources, resourceId);
+    return true;
+}
+
+/**
+ * @brief Install a user from the journal, replacing any existing one
+ */
+void LibraryManager::restoreUser(std::unique_ptr<User> user) {
+    if (!user) {
+        return;
+    }
+    
+    const QString userId = user->getId();
+    m_userIndex.insert(userId, user.get());
+    auto it = findUserIterator(userId);
+    if (it != m_users.end()) {
+        *it = std::move(user);
+    } else {
+        m_users.push_back(std::move(user));
+    }
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Users, userId);
+}
+
+/**
+ * @brief Remove a user recorded as removed in the journal
+ */
+bool LibraryManager::discardUser(const QString& userId) {
+    auto it = findUserIterator(userId);
+    if (it == m_users.end()) {
+        return false;
+    }
+    
+    m_userIndex.remove(userId);
+    m_users.erase(it);
+    m_changeTracker.markEntityRemoved(ChangeTracker::Collection::Users, userId);
+    return true;
+}
+
+/**
+ * @brief Install a loan from the journal into active loans or history by its status
+ */
+void LibraryManager::restoreLoan(std::unique_ptr<Loan> loan) {
+    if (!loan) {
+        return;
+    }
+    
+    const QString loanId = loan->getLoanId();
+    auto matchesId = [&loanId](const std::unique_ptr<Loan>& existing) {
+        return existing->getLoanId() == loanId;
+    };
+    m_activeLoans.erase(std::remove_if(m_activeLoans.begin(), m_activeLoans.end(), matchesId),
+                        m_activeLoans.end());
+    m_loanHistory.erase(std::remove_if(m_loanHistory.begin(), m_loanHistory.end(), matchesId),
+                        m_loanHistory.end());
+    
+    if (loan->getStatus() == Loan::Status::Returned) {
+        m_loanHistory.push_back(std::move(loan));
+    } else {
+        m_activeLoans.push_back(std::move(loan));
+    }
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Loans, loanId);
+}
+
+/**
+ * @brief Install a reservation from the journal into active reservations or history by its status
+ */
+void LibraryManager::restoreReservation(std::unique_ptr<Reservation> reservation) {
+    if (!reservation) {
+        return;
+    }
+    
+    const QString reservationId = reservation->getReservationId();
+    auto matchesId = [&reservationId](const std::unique_ptr<Reservation>& existing) {
+        return existing->getReservationId() == reservationId;
+    };
+    m_activeReservations.erase(std::remove_if(m_activeReservations.begin(), m_activeReservations.end(), matchesId),
+                               m_activeReservations.end());
+    m_reservationHistory.erase(std::remove_if(m_reservationHistory.begin(), m_reservationHistory.end(), matchesId),
+                               m_reservationHistory.end());
+    
+    if (reservation->isActive()) {
+        m_activeReservations.push_back(std::move(reservation));
+    } else {
+        m_reservationHistory.push_back(std::move(reservation));
+    }
+    m_changeTracker.markEntityChanged(ChangeTracker::Collection::Reservations, reservationId);
+}
+
+/**
+ * @brief Find a loan in active loans or history
+ */
+HistoryRecord<Loan> LibraryManager::findLoanRecord(const QString& loanId) const {
+    for (const auto& loan : m_activeLoans) {
+        if (loan->getLoanId() == loanId) {
+            return std::make_shared<const Loan>(*loan);
+        }
+    }
+    for (const auto& loan : m_loanHistory) {
+        if (loan->getLoanId() == loanId) {
+            return std::make_shared<const Loan>(*loan);
+        }
+    }
+    return m_loanArchive ? m_loanArchive->find(loanId) : nullptr;
+}
+
+/**
+ * @brief Find a reservation in active reservations or history
+ */
+HistoryRecord<Reservation> LibraryManager::findReservationRecord(const QString& reservationId) const {
+    for (const auto& reservation : m_activeReservations) {
+        if (reservation->getReservationId() == reservationId) {
+            return std::make_shared<const Reservation>(*reservation);
+        }
+    }
+    for (const auto& reservation : m_reservationHistory) {
+        if (reservation->getReservationId() == reservationId) {
+            return std::make_shared<const Reservation>(*reservation);
+        }
+    }
+    return m_reservationArchive ? m_reservationArchive->find(reservationId) : nullptr;
+}
+
+/**
+ * @brief Attach the on-disk history that precedes the in-memory history records
+ */
+void LibraryManager::attachHistoryArchives(std::shared_ptr<HistorySource<Loan>> loanArchive,
+                                           std::shared_ptr<HistorySource<Reservation>> reservationArchive) {
+    m_loanArchive = std::move(loanArchive);
+    m_reservationArchive = std::move(reservationArchive);
+}
+
+/**
+ * @brief Adopt a search index read back from disk instead of rebuilding it
+ * 
+ * The index must describe the resources as loaded. Entries for resources
+ * that were not loaded are dropped; an index missing any loaded resource
+ * is rebuilt on first use instead.
+ */
+void LibraryManager::attachSearchIndex(ResourceIndex index) {
+    m_searchIndex = std::move(index);
+    m_searchRanksValid = false;
+    m_searchIndexRevision = m_changeTracker.revision(ChangeTracker::Collection::Resources);
+    m_searchIndexBuilt = sweepSearchIndex();
+}
+
+/**
+ * @brief Get the search index, caught up with the resources
+ */
+const ResourceIndex& LibraryManager::getSearchIndex() const {
+    updateSearchIndex();
+    return m_searchIndex;
+}
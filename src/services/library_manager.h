@@ -3,21 +3,32 @@
 
 #include <vector>
 #include <memory>
+#include <memory_resource>
+#include <span>
 #include <QString>
 #include <QObject>
 #include <QDateTime>
+#include <QHash>
 
 // Include headers for model classes
 #include "../models/resource.h"
 #include "../models/user.h"
 #include "../models/loan.h"
 #include "../models/reservation.h"
+#include "clock.h"
+#include "resource_store.h"
+#include "change_tracker.h"
+#include "load_conflict.h"
+#include "history_archive.h"
+#include "resource_index.h"
 
 /**
  * @brief Main business logic class for the library management system
  * 
- * This class manages all library operations using vector-based storage
- * and linear search algorithms for data retrieval.
+ * This class manages all library operations using vector-based storage.
+ * Resources and users are additionally indexed by ID for constant-time
+ * lookup. Resource text searches and category/status filters go through a
+ * ResourceIndex; user searches scan the vector.
  */
 class LibraryManager : public QObject {
     Q_OBJECT
@@ -25,16 +36,38 @@ class LibraryManager : public QObject {
 private:
     // Vector-based storage for all data
     std::vector<std::unique_ptr<Resource>> m_resources;
+    ResourceStore m_resourceStore; // Non-owning typed view of m_resources
     std::vector<std::unique_ptr<User>> m_users;
     std::vector<std::unique_ptr<Loan>> m_activeLoans;
-    std::vector<std::unique_ptr<Loan>> m_loanHistory;
+    std::vector<std::unique_ptr<Loan>> m_loanHistory; // Only records not in m_loanArchive yet
     std::vector<std::unique_ptr<Reservation>> m_activeReservations;
-    std::vector<std::unique_ptr<Reservation>> m_reservationHistory;
+    std::vector<std::unique_ptr<Reservation>> m_reservationHistory; // Only records not in m_reservationArchive yet
+    
+    // Older history, kept on disk (archive pages or a database) and read when a query needs it
+    std::shared_ptr<HistorySource<Loan>> m_loanArchive;
+    std::shared_ptr<HistorySource<Reservation>> m_reservationArchive;
+    
+    // ID indexes over m_resources and m_users (IDs never change after construction)
+    QHash<QString, Resource*> m_resourceIndex;
+    QHash<QString, User*> m_userIndex;
+    
+    // Search index over m_resources, caught up through the change tracker when queried
+    mutable ResourceIndex m_searchIndex;
+    mutable quint64 m_searchIndexRevision;
+    mutable bool m_searchIndexBuilt;
+    mutable std::vector<quint32> m_searchRanks; // Position in m_resources of each index ordinal
+    mutable bool m_searchRanksValid; // Cleared when resources are added or removed, or the index is replaced
       // System settings
     QString m_libraryName;
     QString m_operatingHours;
     std::vector<QString> m_upcomingEvents;
     int m_defaultLoanPeriodDays;
+    
+    // Time source, sampled once per operation
+    std::shared_ptr<const Clock> m_clock;
+    
+    // Revisions of every mutation, consumed by incremental saves
+    ChangeTracker m_changeTracker;
 
 public:
     explicit LibraryManager(QObject* parent = nullptr);
@@ -49,6 +82,13 @@ public:
     std::vector<Resource*> filterResourcesByCategory(Resource::Category category);
     std::vector<Resource*> filterResourcesByStatus(Resource::Status status);
     std::vector<Resource*> getAvailableResources();
+    const ResourceStore& getResourceStore() const { return m_resourceStore; }
+    
+    // Scratch-allocated queries: results are assembled in the caller's memory resource
+    std::pmr::vector<Resource*> getAllResources(std::pmr::memory_resource* memory);
+    std::pmr::vector<Resource*> searchResources(const QString& query, std::pmr::memory_resource* memory);
+    std::pmr::vector<Resource*> filterResourcesByCategory(Resource::Category category, std::pmr::memory_resource* memory);
+    std::pmr::vector<Resource*> filterResourcesByStatus(Resource::Status status, std::pmr::memory_resource* memory);
     
     // User Management
     void addUser(std::unique_ptr<User> user);
@@ -59,6 +99,7 @@ public:
     std::vector<const User*> getAllUsers() const;
     std::vector<User*> searchUsers(const QString& query);
     std::vector<User*> getUsersWithOverdueItems();
+    std::pmr::vector<User*> getAllUsers(std::pmr::memory_resource* memory);
     
     // Loan Management
     QString borrowResource(const QString& userId, const QString& resourceId);
@@ -67,11 +108,15 @@ public:
     std::vector<Loan*> getActiveLoans();
     std::vector<const Loan*> getActiveLoans() const;
     std::vector<Loan*> getOverdueLoans();
-    std::vector<Loan*> getLoanHistory();
-    std::vector<const Loan*> getLoanHistory() const;
-    std::vector<Loan*> getCompletedLoans();
+    std::vector<HistoryRecord<Loan>> getLoanHistory() const;
+    std::vector<HistoryRecord<Loan>> getCompletedLoans() const;
     std::vector<Loan*> getUserLoans(const QString& userId);
-    std::vector<Loan*> getResourceLoans(const QString& resourceId);    
+    std::vector<HistoryRecord<Loan>> getUserLoanHistory(const QString& userId) const;
+    std::vector<HistoryRecord<Loan>> getResourceLoans(const QString& resourceId) const;
+    std::pmr::vector<Loan*> getActiveLoans(std::pmr::memory_resource* memory);
+    std::pmr::vector<Loan*> getOverdueLoans(std::pmr::memory_resource* memory);
+    std::pmr::vector<Loan*> getUserLoans(const QString& userId, std::pmr::memory_resource* memory);
+    
     // Reservation System
     QString reserveResource(const QString& userId, const QString& resourceId);
     bool cancelReservation(const QString& reservationId);
@@ -80,9 +125,10 @@ public:
     std::vector<const Reservation*> getActiveReservations() const;
     std::vector<Reservation*> getUserReservations(const QString& userId);
     std::vector<Reservation*> getResourceReservations(const QString& resourceId);
+    std::pmr::vector<Reservation*> getResourceReservations(const QString& resourceId, std::pmr::memory_resource* memory);
     std::vector<Reservation*> getExpiredReservations();
-    std::vector<Reservation*> getReservationHistory();
-    std::vector<const Reservation*> getReservationHistory() const;
+    std::vector<HistoryRecord<Reservation>> getReservationHistory() const;
+    std::vector<HistoryRecord<Reservation>> getRecentReservationHistory(qsizetype count) const;
     Reservation* findReservationById(const QString& reservationId);
     bool processExpiredReservations(); // Clean up expired reservations
     void notifyWhenResourceAvailable(const QString& resourceId); // Notify users when reserved resource becomes available
@@ -90,6 +136,8 @@ public:
     // Statistics and Reports
     int getTotalResourceCount() const;
     int getAvailableResourceCount() const;
+    int getResourceCountByKind(Resource::Kind kind) const;
+    int getAvailableResourceCountByKind(Resource::Kind kind) const;
     int getTotalUserCount() const;
     int getActiveUserCount() const;
     int getTotalActiveLoans() const;
@@ -97,22 +145,81 @@ public:
     std::vector<Resource*> getMostBorrowedResources(int count = 10);
     std::vector<User*> getMostActiveUsers(int count = 10);
     
+    // Period reports over completed loans. Archived loans are partitioned by month,
+    // so only the months overlapping the period are read, and summaries (whole
+    // months; an invalid date leaves that end open) never read a loan record.
+    // Loans count in the month they were completed; loans still out are not counted.
+    std::vector<HistoryRecord<Loan>> getLoanHistory(const QDate& from, const QDate& to) const;
+    HistorySummary getLoanSummary(const QDate& fromMonth, const QDate& toMonth) const;
+    std::vector<Resource*> getMostBorrowedResources(int count, const QDate& fromMonth, const QDate& toMonth);
+    std::vector<User*> getMostActiveUsers(int count, const QDate& fromMonth, const QDate& toMonth);
+    
     // Data loading methods (for persistence)
     void addActiveLoan(std::unique_ptr<Loan> loan);
     void addLoanHistory(std::unique_ptr<Loan> loan);
     void addActiveReservation(std::unique_ptr<Reservation> reservation);
     void addReservationHistory(std::unique_ptr<Reservation> reservation);
     
+    // Bulk loading (for persistence): reserve once, check duplicates in one hash pass,
+    // skip and report conflicting entities, and emit no per-item signals
+    std::vector<LoadConflict> bulkLoadResources(std::vector<std::unique_ptr<Resource>> resources);
+    std::vector<LoadConflict> bulkLoadUsers(std::vector<std::unique_ptr<User>> users);
+    std::vector<LoadConflict> bulkLoadLoans(std::vector<std::unique_ptr<Loan>> activeLoans,
+                                            std::vector<std::unique_ptr<Loan>> loanHistory);
+    std::vector<LoadConflict> bulkLoadReservations(std::vector<std::unique_ptr<Reservation>> activeReservations,
+                                                   std::vector<std::unique_ptr<Reservation>> reservationHistory);
+    
+    // Journal replay (for persistence): install recorded state, replacing any
+    // entity with the same ID, without re-running business rules or emitting signals
+    void restoreResource(std::unique_ptr<Resource> resource);
+    bool discardResource(const QString& resourceId);
+    void restoreUser(std::unique_ptr<User> user);
+    bool discardUser(const QString& userId);
+    void restoreLoan(std::unique_ptr<Loan> loan);
+    void restoreReservation(std::unique_ptr<Reservation> reservation);
+    
+    // Lookups across active and historical records
+    HistoryRecord<Loan> findLoanRecord(const QString& loanId) const;
+    HistoryRecord<Reservation> findReservationRecord(const QString& reservationId) const;
+    
+    // Archived history (for persistence). History queries return archived records
+    // first; every returned record owns what it points into, so it outlives later queries.
+    void attachHistoryArchives(std::shared_ptr<HistorySource<Loan>> loanArchive,
+                               std::shared_ptr<HistorySource<Reservation>> reservationArchive);
+    std::shared_ptr<HistorySource<Loan>> getLoanArchive() const { return m_loanArchive; }
+    std::shared_ptr<HistorySource<Reservation>> getReservationArchive() const { return m_reservationArchive; }
+    
+    // Search index (for persistence): one read from a sidecar must describe the resources as loaded
+    void attachSearchIndex(ResourceIndex index);
+    const ResourceIndex& getSearchIndex() const; // Up to date with the resources
+    
     // System Configuration
-    void setLibraryName(const QString& name) { m_libraryName = name; }
+    void setLibraryName(const QString& name);
     QString getLibraryName() const { return m_libraryName; }
-    void setOperatingHours(const QString& hours) { m_operatingHours = hours; }
-    QString getOperatingHours() const { return m_operatingHours; }    void addUpcomingEvent(const QString& event);
+    void setOperatingHours(const QString& hours);
+    QString getOperatingHours() const { return m_operatingHours; }
+    void addUpcomingEvent(const QString& event);
     void removeUpcomingEvent(const QString& event);
     std::vector<QString> getUpcomingEvents() const { return m_upcomingEvents; }
-    void setDefaultLoanPeriod(int days) { m_defaultLoanPeriodDays = days; }
+    void setDefaultLoanPeriod(int days);
     int getDefaultLoanPeriod() const { return m_defaultLoanPeriodDays; }
     
+    // Read-only views of the owning storage, for serializers (no per-call copies)
+    std::span<const std::unique_ptr<User>> getUserStorage() const { return m_users; }
+    std::span<const std::unique_ptr<Loan>> getActiveLoanStorage() const { return m_activeLoans; }
+    std::span<const std::unique_ptr<Loan>> getLoanHistoryStorage() const { return m_loanHistory; } // Unarchived part
+    std::span<const std::unique_ptr<Reservation>> getActiveReservationStorage() const { return m_activeReservations; }
+    std::span<const std::unique_ptr<Reservation>> getReservationHistoryStorage() const { return m_reservationHistory; } // Unarchived part
+    
+    // Change tracking
+    const ChangeTracker& getChangeTracker() const { return m_changeTracker; }
+    
+    // Time source
+    void setClock(std::shared_ptr<const Clock> clock);
+    const Clock& getClock() const { return *m_clock; }
+    QDateTime currentTime() const { return m_clock->now(); }
+    qint64 currentTimeMSecs() const { return m_clock->nowMSecsSinceEpoch(); }
+    
     // Data Validation
     bool isValidResourceId(const QString& resourceId) const;
     bool isValidUserId(const QString& userId) const;
@@ -153,10 +260,24 @@ private:
     // Search and filter helpers
     bool matchesSearchQuery(const Resource& resource, const QString& query) const;
     bool matchesSearchQuery(const User& user, const QString& query) const;
+    void updateSearchIndex() const;
+    bool sweepSearchIndex() const;
+    Resource* indexedResource(quint32 ordinal) const;
+    void sortByCatalogOrder(ResourceIndex::Ordinals& ordinals) const;
+    
+    // Query bodies shared by the std:: and std::pmr:: overloads; each appends to results,
+    // taking the index's ordinal lists from memory
+    template <typename Container> void appendAllResources(Container& results) const;
+    template <typename Container>
+    void appendSearchResults(const QString& query, Container& results, std::pmr::memory_resource* memory) const;
+    template <typename Container>
+    void appendCategoryResults(Resource::Category category, Container& results, std::pmr::memory_resource* memory) const;
+    template <typename Container>
+    void appendStatusResults(Resource::Status status, Container& results, std::pmr::memory_resource* memory) const;
     
     // Loan processing helpers
-    QDateTime calculateDueDate(int loanPeriodDays = 0) const;
-    void processLoanReturn(Loan& loan);
+    QDateTime calculateDueDate(const QDateTime& borrowDate, int loanPeriodDays = 0) const;
+    void processLoanReturn(Loan& loan, qint64 returnDateMSecs);
     void moveLoanToHistory(const QString& loanId);
     
     // Validation helpers
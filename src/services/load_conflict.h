@@ -0,0 +1,24 @@
+#ifndef LOAD_CONFLICT_H
+#define LOAD_CONFLICT_H
+
+#include <QString>
+
+#include "change_tracker.h"
+
+/**
+ * @brief An entity a bulk load skipped, reported instead of thrown
+ */
+struct LoadConflict {
+    enum class Reason {
+        InvalidData,
+        DuplicateId,
+        DuplicateEmail
+    };
+    
+    ChangeTracker::Collection collection;
+    QString entityId;
+    Reason reason;
+    QString message;
+};
+
+#endif // LOAD_CONFLICT_H
@@ -8,862 +8,2674 @@
 #include "../models/user.h"
 #include "../models/loan.h"
 #include "../models/reservation.h"
+#include "resource_store.h"
+#include "json_pull_reader.h"
+#include "sqlite_storage_backend.h"
+#include "json_schema.h"
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QSaveFile>
+#include <QRegularExpression>
 #include <QStandardPaths>
 #include <QDateTime>
 #include <QDebug>
+#include <QScopedValueRollback>
+#include <QTextStream>
+#include <QMutexLocker>
+#include <QScopeGuard>
+#include <QThreadPool>
+#include <QFuture>
+#include <deque>
+#include <functional>
+#include <algorithm>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace {
+
+// Per ChangeTracker::indexOf: key in the generation manifest, and base name of the collection's files
+constexpr std::array<const char*, ChangeTracker::CollectionCount> CollectionKeys = {
+    "resources", "users", "loans", "reservations", "configuration"
+};
+constexpr std::array<const char*, ChangeTracker::CollectionCount> CollectionFileBases = {
+    "resources", "users", "loans", "reservations", "config"
+};
+
+// Base names of the history archives' segment files ("<base>[.<partition>].pages");
+// unlike their indexes these are appended to, never replaced
+constexpr const char* LoanHistoryBase = "loan_history";
+constexpr const char* ReservationHistoryBase = "reservation_history";
 
 /**
- * @brief Constructor for PersistenceService
+ * @brief The strings an enum's toString function produces, in enum order
  */
-PersistenceService::PersistenceService(const QString& dataDirectory)
-    : m_dataDirectory(dataDirectory) {
-      // Set up file paths
-    m_resourcesFile = m_dataDirectory + "/resources.json";
-    m_usersFile = m_dataDirectory + "/users.json";
-    m_loansFile = m_dataDirectory + "/loans.json";
-    m_reservationsFile = m_dataDirectory + "/reservations.json";
-    m_configFile = m_dataDirectory + "/config.json";
-    
-    // Initialize data directory
-    initializeDataDirectory();
+template <typename Enum>
+QStringList enumStrings(QString (*toString)(Enum), Enum last) {
+    QStringList strings;
+    for (int i = 0; i <= static_cast<int>(last); ++i) {
+        strings << toString(static_cast<Enum>(i));
+    }
+    return strings;
 }
 
 /**
- * @brief Save all library data
+ * @brief Schema of the JSON Loan::toJson() writes
+ * 
+ * Like every entity schema, it only demands what the model's own
+ * validation would reject anyway, so nothing the program saved is refused.
  */
-bool PersistenceService::saveLibraryData(const LibraryManager& libraryManager) {
-    clearError();
-    
-    try {
-        bool success = true;
-        
-        // Save configuration
-        QJsonObject config;
-        config["libraryName"] = libraryManager.getLibraryName();
-        config["operatingHours"] = libraryManager.getOperatingHours();
-        config["defaultLoanPeriod"] = libraryManager.getDefaultLoanPeriod();
-        
-        QJsonArray eventsArray;
-        for (const QString& event : libraryManager.getUpcomingEvents()) {
-            eventsArray.append(event);
-        }
-        config["upcomingEvents"] = eventsArray;
-        config["lastSaved"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-        
-        success &= saveConfiguration(config);
-        
-        // Save resources - convert raw pointers to owned objects for saving
-        auto resources = libraryManager.getAllResources();
-        std::vector<std::unique_ptr<Resource>> resourcesCopy;
-        for (const Resource* resource : resources) {
-            if (const Book* book = dynamic_cast<const Book*>(resource)) {
-                resourcesCopy.push_back(std::make_unique<Book>(*book));
-            } else if (const Article* article = dynamic_cast<const Article*>(resource)) {
-                resourcesCopy.push_back(std::make_unique<Article>(*article));
-            }
+const JsonSchema& loanSchema() {
+    static const JsonSchema schema = [] {
+        JsonSchema loan("loan", "loanId");
+        loan.field("loanId", JsonSchema::Type::NonEmptyString, true)
+            .field("userId", JsonSchema::Type::NonEmptyString, true)
+            .field("resourceId", JsonSchema::Type::NonEmptyString, true)
+            .field("resourceTitle", JsonSchema::Type::String)
+            .field("borrowDate", JsonSchema::Type::String, true)
+            .field("dueDate", JsonSchema::Type::String, true)
+            .field("returnDate", JsonSchema::Type::String)
+            .enumField("status", enumStrings(&Loan::statusToString, Loan::Status::Lost))
+            .field("renewalCount", JsonSchema::Type::Integer)
+            .field("maxRenewals", JsonSchema::Type::Integer)
+            .field("fineAmount", JsonSchema::Type::Number)
+            .field("notes", JsonSchema::Type::String);
+        return loan;
+    }();
+    return schema;
+}
+
+/**
+ * @brief Schema of the JSON Reservation::toJson() writes
+ */
+const JsonSchema& reservationSchema() {
+    static const JsonSchema schema = [] {
+        JsonSchema reservation("reservation", "reservationId");
+        reservation.field("reservationId", JsonSchema::Type::NonEmptyString, true)
+            .field("userId", JsonSchema::Type::String, true)
+            .field("resourceId", JsonSchema::Type::String, true)
+            .field("resourceTitle", JsonSchema::Type::String)
+            .field("reservationDate", JsonSchema::Type::String, true)
+            .field("expirationDate", JsonSchema::Type::String, true)
+            .enumField("status", enumStrings(&Reservation::statusToString, Reservation::Status::Cancelled))
+            .field("notes", JsonSchema::Type::String);
+        return reservation;
+    }();
+    return schema;
+}
+
+/**
+ * @brief Schema of the JSON User::toJson() writes, current loans included
+ */
+const JsonSchema& userSchema() {
+    static const JsonSchema schema = [] {
+        JsonSchema user("user", "userId");
+        user.field("userId", JsonSchema::Type::NonEmptyString, true)
+            .field("firstName", JsonSchema::Type::NonEmptyString, true)
+            .field("lastName", JsonSchema::Type::String, true) // Empty for single-word names
+            .field("email", JsonSchema::Type::NonEmptyString, true)
+            .field("phoneNumber", JsonSchema::Type::String)
+            .field("address", JsonSchema::Type::String)
+            .enumField("userType", enumStrings(&User::userTypeToString, User::UserType::Guest))
+            .enumField("status", enumStrings(&User::statusToString, User::Status::Expired))
+            .field("registrationDate", JsonSchema::Type::String)
+            .field("lastActivity", JsonSchema::Type::String)
+            .field("maxBorrowLimit", JsonSchema::Type::Integer)
+            .field("notes", JsonSchema::Type::String)
+            .field("year", JsonSchema::Type::Integer)
+            .arrayField("currentLoans", loanSchema())
+            .field("loanHistory", JsonSchema::Type::Array);
+        return user;
+    }();
+    return schema;
+}
+
+/**
+ * @brief Schema of the JSON a resource's toJson() writes, by Kind
+ * 
+ * Index KindCount holds the fields every kind shares; it checks objects
+ * whose "type" names no known kind, and reports that type.
+ */
+const JsonSchema& resourceSchema(int kindIndex) {
+    static const std::array<JsonSchema, Resource::KindCount + 1> schemas = [] {
+        JsonSchema common("resource", "id");
+        QStringList kinds;
+        for (int i = 0; i < Resource::KindCount; ++i) {
+            kinds << Resource::kindToTypeString(static_cast<Resource::Kind>(i));
         }
-        success &= saveResources(resourcesCopy);
-        
-        // Save users
-        auto users = libraryManager.getAllUsers();
-        std::vector<std::unique_ptr<User>> usersCopy;
-        for (const User* user : users) {
-            usersCopy.push_back(std::make_unique<User>(*user));
-        }        success &= saveUsers(usersCopy);
+        common.field("id", JsonSchema::Type::NonEmptyString, true)
+            .enumField("type", kinds)
+            .field("title", JsonSchema::Type::NonEmptyString, true)
+            .field("author", JsonSchema::Type::NonEmptyString, true)
+            .field("publicationYear", JsonSchema::Type::Integer, true)
+            .enumField("category", enumStrings(&Resource::categoryToString, Resource::Category::Other))
+            .enumField("status", enumStrings(&Resource::statusToString, Resource::Status::Lost))
+            .field("dateAdded", JsonSchema::Type::String)
+            .field("description", JsonSchema::Type::String);
         
-        // Save loans
-        auto activeLoans = libraryManager.getActiveLoans();
-        auto loanHistory = libraryManager.getLoanHistory();
-        std::vector<std::unique_ptr<Loan>> activeLoansCopy;
-        std::vector<std::unique_ptr<Loan>> loanHistoryCopy;
+        JsonSchema book = common;
+        book.field("isbn", JsonSchema::Type::String)
+            .field("publisher", JsonSchema::Type::String)
+            .field("pageCount", JsonSchema::Type::Integer)
+            .field("language", JsonSchema::Type::String)
+            .field("genre", JsonSchema::Type::String)
+            .field("isHardcover", JsonSchema::Type::Boolean);
         
-        for (const Loan* loan : activeLoans) {
-            activeLoansCopy.push_back(std::make_unique<Loan>(*loan));
-        }
-        for (const Loan* loan : loanHistory) {
-            loanHistoryCopy.push_back(std::make_unique<Loan>(*loan));
-        }
-        success &= saveLoans(activeLoansCopy, loanHistoryCopy);
+        JsonSchema article = common;
+        article.field("journal", JsonSchema::Type::String)
+            .field("volume", JsonSchema::Type::Integer)
+            .field("issue", JsonSchema::Type::Integer)
+            .field("pageRange", JsonSchema::Type::String)
+            .field("doi", JsonSchema::Type::String)
+            .field("abstract", JsonSchema::Type::String)
+            .field("researchField", JsonSchema::Type::String)
+            .field("keywords", JsonSchema::Type::Array);
         
-        // Save reservations
-        auto activeReservations = libraryManager.getActiveReservations();
-        auto reservationHistory = libraryManager.getReservationHistory();
-        std::vector<std::unique_ptr<Reservation>> activeReservationsCopy;
-        std::vector<std::unique_ptr<Reservation>> reservationHistoryCopy;
-        
-        for (const Reservation* reservation : activeReservations) {
-            activeReservationsCopy.push_back(std::make_unique<Reservation>(*reservation));
-        }
-        for (const Reservation* reservation : reservationHistory) {
-            reservationHistoryCopy.push_back(std::make_unique<Reservation>(*reservation));
-        }
-        success &= saveReservations(activeReservationsCopy, reservationHistoryCopy);
+        JsonSchema thesis = common;
+        thesis.field("supervisor", JsonSchema::Type::String)
+            .field("university", JsonSchema::Type::String)
+            .field("department", JsonSchema::Type::String)
+            .enumField("degreeLevel", enumStrings(&Thesis::degreeLevelToString, Thesis::DegreeLevel::Postdoc), false)
+            .field("keywords", JsonSchema::Type::String);
         
-        return success;
+        JsonSchema digitalContent = common;
+        digitalContent
+            .enumField("contentType",
+                       enumStrings(&DigitalContent::contentTypeToString, DigitalContent::ContentType::WebResource),
+                       false)
+            .enumField("accessType",
+                       enumStrings(&DigitalContent::accessTypeToString, DigitalContent::AccessType::Streaming), false)
+            .field("fileFormat", JsonSchema::Type::String)
+            .field("fileSize", JsonSchema::Type::String)
+            .field("url", JsonSchema::Type::String)
+            .field("platform", JsonSchema::Type::String)
+            .field("requiresAuthentication", JsonSchema::Type::Boolean)
+            .field("simultaneousUsers", JsonSchema::Type::Integer)
+            .field("systemRequirements", JsonSchema::Type::String);
         
-    } catch (const std::exception& e) {
-        setError(QString("Failed to save library data: %1").arg(e.what()));
-        return false;
+        // In Kind order
+        return std::array<JsonSchema, Resource::KindCount + 1>{book, article, thesis, digitalContent, common};
+    }();
+    return schemas[static_cast<std::size_t>(kindIndex)];
+}
+
+/**
+ * @brief Validate an entity object, describing every problem in one conflict
+ */
+bool checkEntityJson(const JsonSchema& schema, const QJsonObject& json, ChangeTracker::Collection collection,
+                     LoadConflict& conflict) {
+    QStringList errors;
+    if (schema.validate(json, errors)) {
+        return true;
     }
+    const QString entityId = schema.entityId(json);
+    conflict = {collection, entityId, LoadConflict::Reason::InvalidData,
+                QString("Invalid %1 %2: %3").arg(schema.getEntityName(),
+                                                 entityId.isEmpty() ? QString("(no ID)") : entityId,
+                                                 errors.join("; "))};
+    return false;
 }
 
 /**
- * @brief Load all library data
+ * @brief Converts parsed JSON elements into model objects on a thread pool
+ * 
+ * The pull parser queues elements in file order. Each full chunk is handed
+ * to a worker that builds its own vector, and finished chunks are appended
+ * to the output in the order they were queued. Only a couple of chunks per
+ * thread are in flight at once, so memory stays bounded on large files.
+ * 
+ * Elements are validated before conversion. One that fails is skipped, and
+ * the conflict describing everything wrong with it is kept for the report.
  */
-bool PersistenceService::loadLibraryData(LibraryManager& libraryManager) {
-    clearError();
+template <typename T>
+class ChunkedJsonDecoder {
+public:
+    using Factory = std::unique_ptr<T> (*)(const QJsonObject&);
+    using Validator = bool (*)(const QJsonObject&, LoadConflict&);
+    static constexpr std::size_t ChunkSize = 512;
     
-    try {
-        // Load configuration first
-        QJsonObject config;        if (loadConfiguration(config)) {
-            libraryManager.setLibraryName(config["libraryName"].toString());
-            libraryManager.setOperatingHours(config["operatingHours"].toString());
-            libraryManager.setDefaultLoanPeriod(config["defaultLoanPeriod"].toInt());
-            
-            // Load upcoming events
-            QJsonArray eventsArray = config["upcomingEvents"].toArray();
-            for (const QJsonValue& value : eventsArray) {
-                libraryManager.addUpcomingEvent(value.toString());
-            }
+    ChunkedJsonDecoder(QThreadPool& pool, Factory factory, Validator validator, const QString& elementName,
+                       std::vector<std::unique_ptr<T>>& output)
+        : m_pool(pool), m_factory(factory), m_validator(validator), m_elementName(elementName),
+          m_output(output),
+          m_maxInFlight(std::max(2, pool.maxThreadCount() * 2)) {
+        m_pending.reserve(ChunkSize);
+    }
+    
+    void reserve(qsizetype count) {
+        if (count > 0) {
+            m_output.reserve(m_output.size() + static_cast<std::size_t>(count));
         }
-        
-        // Load actual data from files
-        bool success = true;
-        
-        // Load resources
-        std::vector<std::unique_ptr<Resource>> resources;
-        if (loadResources(resources)) {
-            for (auto& resource : resources) {
-                libraryManager.addResource(std::move(resource));
-            }
-        } else {
-            qDebug() << "No resources file found, starting with empty resources";
+    }
+    
+    void add(const QJsonObject& element) {
+        m_pending.push_back(element);
+        if (m_pending.size() >= ChunkSize) {
+            dispatch();
         }
-        
-        // Load users
-        std::vector<std::unique_ptr<User>> users;
-        if (loadUsers(users)) {
-            for (auto& user : users) {
-                libraryManager.addUser(std::move(user));
-            }
-        } else {
-            qDebug() << "No users file found, starting with empty users";
+    }
+    
+    // Wait for every chunk; false if any element could not be converted
+    bool finish() {
+        if (m_inFlight.empty()) {
+            // Less than one chunk: not worth a hand-off
+            collect(decode(m_factory, m_validator, m_elementName, std::move(m_pending)));
+            m_pending.clear();
+        } else if (!m_pending.empty()) {
+            dispatch();
         }
-          // Load loans
-        std::vector<std::unique_ptr<Loan>> activeLoans;
-        std::vector<std::unique_ptr<Loan>> loanHistory;
-        if (loadLoans(activeLoans, loanHistory)) {
-            for (auto& loan : activeLoans) {
-                libraryManager.addActiveLoan(std::move(loan));
-            }
-            for (auto& loan : loanHistory) {
-                libraryManager.addLoanHistory(std::move(loan));
+        while (!m_inFlight.empty()) {
+            collectOldest();
+        }
+        return m_error.isEmpty();
+    }
+    
+    QString errorString() const { return m_error; }
+    
+    // Elements rejected by the validator, in file order
+    std::vector<LoadConflict> takeSkipped() { return std::exchange(m_skipped, {}); }
+    
+private:
+    struct Chunk {
+        std::vector<std::unique_ptr<T>> items;
+        std::vector<LoadConflict> skipped;
+        QString error;
+    };
+    
+    QThreadPool& m_pool;
+    Factory m_factory;
+    Validator m_validator;
+    QString m_elementName;
+    std::vector<std::unique_ptr<T>>& m_output;
+    int m_maxInFlight;
+    std::vector<QJsonObject> m_pending;
+    std::deque<QFuture<Chunk>> m_inFlight;
+    std::vector<LoadConflict> m_skipped;
+    QString m_error;
+    
+    void dispatch() {
+        if (static_cast<int>(m_inFlight.size()) >= m_maxInFlight) {
+            collectOldest();
+        }
+        m_inFlight.push_back(QtConcurrent::run(&m_pool,
+            [factory = m_factory, validator = m_validator, elementName = m_elementName,
+             elements = std::move(m_pending)]() mutable {
+                return decode(factory, validator, elementName, std::move(elements));
+            }));
+        m_pending = std::vector<QJsonObject>();
+        m_pending.reserve(ChunkSize);
+    }
+    
+    void collectOldest() {
+        collect(m_inFlight.front().takeResult());
+        m_inFlight.pop_front();
+    }
+    
+    void collect(Chunk chunk) {
+        m_skipped.insert(m_skipped.end(), std::make_move_iterator(chunk.skipped.begin()),
+                         std::make_move_iterator(chunk.skipped.end()));
+        if (!m_error.isEmpty()) {
+            return;
+        }
+        if (!chunk.error.isEmpty()) {
+            m_error = chunk.error;
+            return;
+        }
+        m_output.insert(m_output.end(), std::make_move_iterator(chunk.items.begin()),
+                        std::make_move_iterator(chunk.items.end()));
+    }
+    
+    static Chunk decode(Factory factory, Validator validator, const QString& elementName,
+                        std::vector<QJsonObject> elements) {
+        Chunk chunk;
+        chunk.items.reserve(elements.size());
+        try {
+            for (const QJsonObject& element : elements) {
+                LoadConflict conflict{};
+                if (!validator(element, conflict)) {
+                    chunk.skipped.push_back(std::move(conflict));
+                    continue;
+                }
+                auto item = factory(element);
+                if (!item) {
+                    chunk.error = QString("Failed to create %1 from JSON").arg(elementName);
+                    break;
+                }
+                chunk.items.push_back(std::move(item));
             }
-        } else {
-            qDebug() << "No loans file found, starting with empty loans";
+        } catch (const std::exception& e) {
+            chunk.error = QString("Failed to create %1 from JSON: %2").arg(elementName, e.what());
+        }
+        return chunk;
+    }
+};
+
+// Error slot of the loader running on this thread, if any
+thread_local QString* t_loaderError = nullptr;
+
+/**
+ * @brief Route setError/clearError/getLastError on this thread to one loader's own slot
+ * 
+ * The loaders of loadLibraryData run concurrently and each starts with
+ * clearError(), so on the shared m_lastError one loader could wipe or
+ * overwrite another's message. Each gets its own slot instead, and the
+ * slots are merged once every loader has finished.
+ */
+class LoaderErrorScope {
+public:
+    explicit LoaderErrorScope(QString& error) : m_previous(t_loaderError) { t_loaderError = &error; }
+    ~LoaderErrorScope() { t_loaderError = m_previous; }
+    LoaderErrorScope(const LoaderErrorScope&) = delete;
+    LoaderErrorScope& operator=(const LoaderErrorScope&) = delete;
+
+private:
+    QString* m_previous;
+};
+
+/**
+ * @brief Copy a list of entities for a CBOR writer running on another thread
+ */
+template <typename T>
+std::shared_ptr<const std::vector<std::unique_ptr<T>>> copyEntities(std::span<const std::unique_ptr<T>> entities) {
+    auto copies = std::make_shared<std::vector<std::unique_ptr<T>>>();
+    copies->reserve(entities.size());
+    for (const auto& entity : entities) {
+        copies->push_back(std::make_unique<T>(*entity));
+    }
+    return copies;
+}
+
+/**
+ * @brief Writer of the archived history records an array of in-memory history does not shadow
+ * 
+ * The archive is read when the writer runs, on the save worker; its locks
+ * let that overlap with queries from the GUI. Archived records go first,
+ * as in LibraryManager's merged history.
+ */
+template <typename T>
+std::function<qsizetype(JsonStreamWriter&)> archivedHistoryWriter(
+        std::shared_ptr<HistorySource<T>> archive, const std::vector<PersistenceService::CapturedElement>& recent) {
+    QSet<QString> seen;
+    seen.reserve(static_cast<qsizetype>(recent.size()));
+    for (const PersistenceService::CapturedElement& element : recent) {
+        seen.insert(element.id);
+    }
+    
+    return [archive = std::move(archive), seen = std::move(seen)](JsonStreamWriter& writer) mutable {
+        const std::vector<HistoryRecord<T>> records = archive->all(seen);
+        for (const HistoryRecord<T>& record : records) {
+            writer.writeElement(record->toJson());
         }
+        return static_cast<qsizetype>(records.size());
+    };
+}
+
+} // namespace
+
+/**
+ * @brief Stream a JSON data file: root object fields are written by writeFields
+ * 
+ * Elements go out through a bounded buffer as they are written, so the file
+ * is never assembled in memory.
+ */
+template <typename FieldWriter>
+bool PersistenceService::writeJsonStreamToFile(const QString& filePath, FieldWriter&& writeFields) {
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        setError("Cannot open file for writing: " + filePath);
+        return false;
+    }
+    
+    JsonStreamWriter writer(file);
+    writer.beginObject();
+    writeFields(writer);
+    writer.endObject();
+    
+    // An unfinished QSaveFile is discarded, leaving the previous file untouched
+    if (!writer.finish()) {
+        setError(QString("Failed to write to file: %1 (%2)").arg(filePath, writer.errorString()));
+        return false;
+    }
+    if (!file.commit()) {
+        setError(QString("Failed to commit file: %1 (%2)").arg(filePath, file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Pull-parse a JSON data file, handing over array elements as they complete
+ * @param arrayKeys Root fields whose elements are materialized; other fields are skipped
+ * @param elementName Entity name used in error messages
+ * @param handleElement Callable (const QString& key, const QJsonObject& element) -> bool
+ * @param reserve Optional; told an array's size when its count field precedes it
+ * 
+ * Only one element is held as a QJsonObject at a time, so peak memory stays
+ * close to the size of the objects built from the file.
+ */
+template <typename ElementHandler>
+bool PersistenceService::readJsonStreamFromFile(const QString& filePath, const QString& expectedType,
+                                                const QStringList& arrayKeys, const QString& elementName,
+                                                ElementHandler&& handleElement,
+                                                const std::function<void(const QString&, qsizetype)>& reserve) {
+    QFile file(filePath);
+    if (!file.exists()) {
+        setError("File does not exist: " + filePath);
+        return false;
+    }
+    
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError("Cannot open file for reading: " + filePath);
+        return false;
+    }
+    
+    JsonPullReader reader(file);
+    if (reader.next() != JsonPullReader::Token::BeginObject) {
+        setError(reader.hasError() ? "JSON parse error: " + reader.errorString()
+                                   : QString("Invalid JSON document: not an object"));
+        return false;
+    }
+    
+    QString type;
+    bool hasVersion = false;
+    while (reader.next() == JsonPullReader::Token::Key) {
+        QString key = reader.string();
+        JsonPullReader::Token valueToken = reader.next();
         
-        // Load reservations
-        std::vector<std::unique_ptr<Reservation>> activeReservations;
-        std::vector<std::unique_ptr<Reservation>> reservationHistory;
-        if (loadReservations(activeReservations, reservationHistory)) {
-            for (auto& reservation : activeReservations) {
-                libraryManager.addActiveReservation(std::move(reservation));
-            }
-            for (auto& reservation : reservationHistory) {
-                libraryManager.addReservationHistory(std::move(reservation));
+        if (valueToken == JsonPullReader::Token::BeginArray && arrayKeys.contains(key)) {
+            while (reader.next() != JsonPullReader::Token::EndArray) {
+                if (reader.hasError()) {
+                    break;
+                }
+                if (reader.token() != JsonPullReader::Token::BeginObject) {
+                    setError(QString("Invalid %1 JSON: not an object").arg(elementName));
+                    return false;
+                }
+                QJsonValue element = reader.readValue();
+                if (reader.hasError()) {
+                    break;
+                }
+                if (!handleElement(key, element.toObject())) {
+                    return false;
+                }
             }
+        } else if (key == "type" && valueToken == JsonPullReader::Token::String) {
+            type = reader.string();
+        } else if (reserve && valueToken == JsonPullReader::Token::Number &&
+                   (key == "count" || key.endsWith("Count"))) {
+            // "count" sizes "data"; "<array>Count" sizes "<array>"
+            reserve(key == "count" ? QString("data") : key.chopped(5), static_cast<qsizetype>(reader.number()));
         } else {
-            qDebug() << "No reservations file found, starting with empty reservations";
-        }        // Start with empty data - no sample data creation
-        qDebug() << "Library data loaded successfully. Starting with clean slate.";
-        
-        return success;
+            hasVersion |= key == "version";
+            reader.skipValue();
+        }
         
-    } catch (const std::exception& e) {
-        setError(QString("Failed to load library data: %1").arg(e.what()));
+        if (reader.hasError()) {
+            break;
+        }
+    }
+    
+    if (reader.token() != JsonPullReader::Token::EndObject || reader.next() != JsonPullReader::Token::EndDocument) {
+        setError("JSON parse error: " + reader.errorString());
+        return false;
+    }
+    
+    // The envelope is written after the data, so it is checked once the whole file is read
+    if (type != expectedType) {
+        setError("Invalid JSON type: expected " + expectedType);
+        return false;
+    }
+    
+    if (!hasVersion) {
+        setError("Missing version information");
         return false;
     }
+    
+    return true;
 }
 
 /**
- * @brief Save resources to JSON file
+ * @brief Stream a CBOR snapshot into a file
+ * @param write Callable (CborSnapshot&, QIODevice&) -> bool
  */
-bool PersistenceService::saveResources(const std::vector<std::unique_ptr<Resource>>& resources) {
-    clearError();
+template <typename Writer>
+bool PersistenceService::writeCborToFile(const QString& filePath, Writer&& write) {
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        setError("Cannot open file for writing: " + filePath);
+        return false;
+    }
     
-    try {
-        QJsonArray resourcesArray = resourcesToJsonArray(resources);
-        
-        QJsonObject root;
-        root["version"] = "1.0";
-        root["type"] = "resources";
-        root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-        root["count"] = resourcesArray.size();
-        root["data"] = resourcesArray;
-        
-        QJsonDocument document(root);
-        return writeJsonToFile(m_resourcesFile, document);
-        
-    } catch (const std::exception& e) {
-        setError(QString("Failed to save resources: %1").arg(e.what()));
+    CborSnapshot snapshot;
+    if (!write(snapshot, file)) {
+        setError(snapshot.getLastError());
+        return false;
+    }
+    if (!file.commit()) {
+        setError(QString("Failed to commit file: %1 (%2)").arg(filePath, file.errorString()));
         return false;
     }
+    return true;
 }
 
 /**
- * @brief Load resources from JSON file
+ * @brief Stream a CBOR snapshot out of a file
+ * @param read Callable (CborSnapshot&, QIODevice&) -> bool
  */
-bool PersistenceService::loadResources(std::vector<std::unique_ptr<Resource>>& resources) {
+template <typename Reader>
+bool PersistenceService::readCborFromFile(const QString& filePath, Reader&& read) {
+    QFile file(filePath);
+    if (!file.exists()) {
+        setError("File does not exist: " + filePath);
+        return false;
+    }
+    
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError("Cannot open file for reading: " + filePath);
+        return false;
+    }
+    
+    CborSnapshot snapshot;
+    if (!read(snapshot, file)) {
+        setError(QString("%1: %2").arg(filePath, snapshot.getLastError()));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Constructor for PersistenceService
+ */
+PersistenceService::PersistenceService(const QString& dataDirectory)
+    : m_dataDirectory(dataDirectory), m_journalFile(dataDirectory + "/journal.log"),
+      m_formatFile(dataDirectory + "/snapshot.format"), m_manifestFile(dataDirectory + "/manifest.json"),
+      m_snapshotFormat(SnapshotFormat::Json), m_generational(true),
+      m_engineFile(dataDirectory + "/storage.engine"),
+      m_storageEngine(StorageEngine::Files), m_trackedSource(nullptr), m_journal(m_journalFile), m_journalSuspended(false),
+      m_journalCompactionThreshold(4 * 1024 * 1024), m_backupStore(dataDirectory + "/backups") {
+      // Set up file paths for the generation (or, without a manifest, the format) this directory was saved in
+    m_snapshotFormat = readSnapshotFormat();
+    GenerationManifest manifest;
+    if (readManifest(manifest)) {
+        applyManifest(manifest);
+    } else {
+        updateSnapshotPaths();
+    }
+    
+    resetChangeTracking();
+    
+    // The database is opened on first use
+    m_storageEngine = readStorageEngine();
+    if (m_storageEngine == StorageEngine::Sqlite) {
+        m_backend = std::make_shared<SqliteStorageBackend>(getDatabaseFilePath());
+    }
+    
+    // Initialize data directory
+    initializeDataDirectory();
+}
+
+/**
+ * @brief Destructor for PersistenceService
+ */
+PersistenceService::~PersistenceService() {
+    disableJournal();
+}
+
+/**
+ * @brief Save all library data
+ */
+bool PersistenceService::saveLibraryData(const LibraryManager& libraryManager) {
     clearError();
     
-    try {
-        QJsonDocument document;
-        if (!readJsonFromFile(m_resourcesFile, document)) {
-            return false;
-        }
-        
-        if (!validateJsonStructure(document, "resources")) {
+    if (m_backend) {
+        if (!m_backend->saveLibrary(libraryManager)) {
+            setError("Failed to save library data: " + m_backend->getLastError());
             return false;
         }
-        
-        QJsonObject root = document.object();
-        QJsonArray resourcesArray = root["data"].toArray();
-        
-        return jsonArrayToResources(resourcesArray, resources);
-        
-    } catch (const std::exception& e) {
-        setError(QString("Failed to load resources: %1").arg(e.what()));
+        return true;
+    }
+    
+    bool success = saveCollections(libraryManager);
+    
+    // Every journaled change is now in the snapshot
+    if (success && !m_journal.truncate()) {
+        setError(m_journal.getLastError());
+        success = false;
+    }
+    
+    return success;
+}
+
+/**
+ * @brief Write every collection that changed since it was last saved
+ */
+bool PersistenceService::saveCollections(const LibraryManager& libraryManager) {
+    SaveSnapshot snapshot;
+    if (!captureSnapshot(libraryManager, snapshot)) {
         return false;
     }
+    
+    bool written = writeSnapshot(snapshot);
+    return markSnapshotSaved(snapshot) && written;
 }
 
 /**
- * @brief Save users to JSON file
+ * @brief Capture every collection that changed since it was last saved
+ * 
+ * Unchanged entities contribute their cached encoding, which is implicitly
+ * shared rather than copied, and every other entity a copy of itself, whose
+ * strings stay shared with the live one. Nothing is serialized here: the
+ * writer encodes the copies, renders CBOR and reads archived history on
+ * whatever thread it runs on. The snapshot owns everything it refers to, so
+ * the manager can keep changing meanwhile.
  */
-bool PersistenceService::saveUsers(const std::vector<std::unique_ptr<User>>& users) {
-    clearError();
+bool PersistenceService::captureSnapshot(const LibraryManager& libraryManager, SaveSnapshot& snapshot) {
+    snapshot = SaveSnapshot();
+    
+    // A backend writes only what changed, in one transaction; that leaves nothing for a worker
+    if (m_backend) {
+        return saveLibraryData(libraryManager);
+    }
     
     try {
-        QJsonArray usersArray = usersToJsonArray(users);
+        const ChangeTracker& tracker = libraryManager.getChangeTracker();
         
-        QJsonObject root;
-        root["version"] = "1.0";
-        root["type"] = "users";
-        root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-        root["count"] = usersArray.size();
-        root["data"] = usersArray;
+        // Saved revisions only mean something for the manager they came from
+        if (m_trackedSource != &tracker) {
+            resetChangeTracking();
+            m_trackedSource = &tracker;
+        }
+        snapshot.tracker = &tracker;
+        snapshot.latestRevision = tracker.latestRevision();
         
-        QJsonDocument document(root);
-        return writeJsonToFile(m_usersFile, document);
+        // Configuration
+        if (needsSave(tracker, ChangeTracker::Collection::Configuration, m_configFile)) {
+            QJsonObject config = configurationJson(libraryManager);
+            config["lastSaved"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+            
+            CollectionSnapshot collection = makeCollectionSnapshot(ChangeTracker::Collection::Configuration,
+                                                                   m_configFile, "configuration", tracker);
+            collection.contents = configurationDocument(config).toJson();
+            snapshot.collections.push_back(std::move(collection));
+        }
         
-    } catch (const std::exception& e) {
-        setError(QString("Failed to save users: %1").arg(e.what()));
+        // Resources straight from the manager's typed segments
+        if (needsSave(tracker, ChangeTracker::Collection::Resources, m_resourcesFile)) {
+            snapshot.collections.push_back(captureResources(libraryManager.getResourceStore(), tracker));
+        }
+        
+        if (needsSave(tracker, ChangeTracker::Collection::Users, m_usersFile)) {
+            snapshot.collections.push_back(captureUsers(libraryManager.getUserStorage(), tracker));
+        }
+        
+        // With an archive attached, generations keep only active records and move
+        // history into the archive; exports still carry the complete history inline
+        if (needsSave(tracker, ChangeTracker::Collection::Loans, m_loansFile)) {
+            const bool archived = m_loanArchive && libraryManager.getLoanArchive() == m_loanArchive;
+            if (archived && m_generational) {
+                CollectionSnapshot collection = captureLoans(libraryManager.getActiveLoanStorage(), {}, tracker);
+                // Completed loans are partitioned by the month they left circulation
+                captureArchiveAppends(collection, m_loanArchive, libraryManager.getLoanHistoryStorage(), tracker,
+                                      m_archivedLoanRevisions,
+                                      [&libraryManager](const Loan& loan, HistoryPageFile::Record& record) {
+                    record.partition = HistoryPageFile::monthPartition(loan.getCompletionDateMSecs());
+                    if (const Resource* resource = libraryManager.findResourceById(loan.getResourceId())) {
+                        record.category = Resource::categoryToString(resource->getCategory());
+                    }
+                });
+                snapshot.collections.push_back(std::move(collection));
+            } else {
+                CollectionSnapshot collection = captureLoans(libraryManager.getActiveLoanStorage(),
+                                                             libraryManager.getLoanHistoryStorage(), tracker);
+                if (libraryManager.getLoanArchive() && !collection.arrays.empty()) {
+                    CapturedArray& history = collection.arrays.back();
+                    history.writeArchived = archivedHistoryWriter(libraryManager.getLoanArchive(), history.elements);
+                }
+                snapshot.collections.push_back(std::move(collection));
+            }
+        }
+        
+        if (needsSave(tracker, ChangeTracker::Collection::Reservations, m_reservationsFile)) {
+            const bool archived = m_reservationArchive &&
+                                  libraryManager.getReservationArchive() == m_reservationArchive;
+            if (archived && m_generational) {
+                CollectionSnapshot collection = captureReservations(libraryManager.getActiveReservationStorage(),
+                                                                    {}, tracker);
+                captureArchiveAppends(collection, m_reservationArchive, libraryManager.getReservationHistoryStorage(),
+                                      tracker,
+                                      m_archivedReservationRevisions,
+                                      [](const Reservation&, HistoryPageFile::Record&) {});
+                snapshot.collections.push_back(std::move(collection));
+            } else {
+                CollectionSnapshot collection = captureReservations(libraryManager.getActiveReservationStorage(),
+                                                                    libraryManager.getReservationHistoryStorage(),
+                                                                    tracker);
+                if (libraryManager.getReservationArchive() && !collection.arrays.empty()) {
+                    CapturedArray& history = collection.arrays.back();
+                    history.writeArchived = archivedHistoryWriter(libraryManager.getReservationArchive(),
+                                                                  history.elements);
+                }
+                snapshot.collections.push_back(std::move(collection));
+            }
+        }
+        
+        // Changed collections go to fresh files of the next generation; the rest
+        // stay where the current manifest points
+        if (m_generational && !snapshot.isEmpty()) {
+            GenerationManifest& manifest = snapshot.manifest;
+            manifest.generation = m_manifest.generation + 1;
+            manifest.format = m_snapshotFormat;
+            for (std::size_t i = 0; i < ChangeTracker::CollectionCount; ++i) {
+                auto collection = static_cast<ChangeTracker::Collection>(i);
+                manifest.files[i] = QFileInfo(collectionFilePath(collection)).fileName();
+            }
+            manifest.loanHistoryIndex = m_manifest.loanHistoryIndex;
+            manifest.reservationHistoryIndex = m_manifest.reservationHistoryIndex;
+            manifest.searchIndex = m_manifest.searchIndex;
+            for (CollectionSnapshot& collection : snapshot.collections) {
+                QString fileName = generationFileName(collection.collection, manifest.generation, m_snapshotFormat);
+                manifest.files[ChangeTracker::indexOf(collection.collection)] = fileName;
+                collection.filePath = m_dataDirectory + "/" + fileName;
+                
+                // The archive index only moves to a new generation when records were appended
+                if (collection.archive && !collection.archiveRecords.empty()) {
+                    QString indexName = historyIndexFileName(collection.collection, manifest.generation);
+                    if (collection.collection == ChangeTracker::Collection::Loans) {
+                        manifest.loanHistoryIndex = indexName;
+                    } else {
+                        manifest.reservationHistoryIndex = indexName;
+                    }
+                    collection.archiveIndexPath = m_dataDirectory + "/" + indexName;
+                }
+                
+                // The search index is saved beside every new resources file, so loads skip the rebuild
+                if (collection.collection == ChangeTracker::Collection::Resources) {
+                    QString indexName = searchIndexFileName(manifest.generation);
+                    manifest.searchIndex = indexName;
+                    collection.searchIndex = std::make_shared<const ResourceIndex>(libraryManager.getSearchIndex());
+                    collection.searchIndexPath = m_dataDirectory + "/" + indexName;
+                }
+            }
+        }
+        
+        return true;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to save library data: %1").arg(e.what()));
+        snapshot = SaveSnapshot();
+        return false;
+    }
+}
+
+/**
+ * @brief Write the files of a captured snapshot (safe to call from a worker thread)
+ */
+bool PersistenceService::writeSnapshot(SaveSnapshot& snapshot) {
+    bool success = true;
+    snapshot.manifestWritten = false;
+    for (CollectionSnapshot& collection : snapshot.collections) {
+        try {
+            success &= writeCollection(collection);
+        } catch (const std::exception& e) {
+            setError(QString("Failed to save %1: %2").arg(collection.type, e.what()));
+            collection.written = false;
+            success = false;
+        }
+    }
+    
+    // The manifest switch is the commit point: until it is replaced, loads
+    // keep opening the previous generation's complete set of files
+    if (success && snapshot.manifest.generation != 0) {
+        snapshot.manifestWritten = writeJsonToFile(m_manifestFile, manifestDocument(snapshot.manifest));
+        success = snapshot.manifestWritten;
+    }
+    return success;
+}
+
+/**
+ * @brief Record a written snapshot as saved, and clear the journal it supersedes
+ * 
+ * Operations journaled after the capture are not in the snapshot, so the
+ * journal is only truncated when nothing has changed since.
+ */
+bool PersistenceService::commitSnapshot(const SaveSnapshot& snapshot) {
+    if (!markSnapshotSaved(snapshot)) {
+        return false;
+    }
+    
+    if (snapshot.tracker && snapshot.tracker->latestRevision() == snapshot.latestRevision &&
+        !m_journal.truncate()) {
+        setError(m_journal.getLastError());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Load all library data
+ */
+bool PersistenceService::loadLibraryData(LibraryManager& libraryManager) {
+    clearError();
+    QScopedValueRollback<bool> suspendJournal(m_journalSuspended, true);
+    
+    // The backend has every operation already; there is no journal to replay
+    if (m_backend) {
+        m_loadConflicts.clear();
+        resetChangeTracking();
+        m_loanArchive.reset();
+        m_reservationArchive.reset();
+        if (!m_backend->loadLibrary(libraryManager, m_loadConflicts)) {
+            setError("Failed to load library data: " + m_backend->getLastError());
+            return false;
+        }
+        return true;
+    }
+    
+    // Always open the set of files the manifest names, never a mix of generations
+    GenerationManifest manifest;
+    if (m_generational && readManifest(manifest)) {
+        applyManifest(manifest);
+    }
+    
+    try {
+        // Read and parse every file concurrently on the global pool; the loaders
+        // only touch their own output and error slot, and the (locked) conflicts
+        m_loadConflicts.clear();
+        std::array<QString, 5> loaderErrors;
+        QJsonObject config;
+        std::vector<std::unique_ptr<Resource>> resources;
+        std::vector<std::unique_ptr<User>> users;
+        std::vector<std::unique_ptr<Loan>> activeLoans;
+        std::vector<std::unique_ptr<Loan>> loanHistory;
+        std::vector<std::unique_ptr<Reservation>> activeReservations;
+        std::vector<std::unique_ptr<Reservation>> reservationHistory;
+        
+        QFuture<bool> configLoaded = QtConcurrent::run([this, &config, &error = loaderErrors[0]]() {
+            LoaderErrorScope errorScope(error);
+            return loadConfiguration(config);
+        });
+        QFuture<bool> resourcesLoaded = QtConcurrent::run([this, &resources, &error = loaderErrors[1]]() {
+            LoaderErrorScope errorScope(error);
+            return loadResources(resources);
+        });
+        QFuture<bool> usersLoaded = QtConcurrent::run([this, &users, &error = loaderErrors[2]]() {
+            LoaderErrorScope errorScope(error);
+            return loadUsers(users);
+        });
+        QFuture<bool> loansLoaded = QtConcurrent::run([this, &activeLoans, &loanHistory, &error = loaderErrors[3]]() {
+            LoaderErrorScope errorScope(error);
+            return loadLoans(activeLoans, loanHistory);
+        });
+        QFuture<bool> reservationsLoaded = QtConcurrent::run([this, &activeReservations, &reservationHistory, &error = loaderErrors[4]]() {
+            LoaderErrorScope errorScope(error);
+            return loadReservations(activeReservations, reservationHistory);
+        });
+        
+        // The loaders write into the locals above, so never unwind past them early
+        auto waitForLoaders = qScopeGuard([&]() {
+            configLoaded.waitForFinished();
+            resourcesLoaded.waitForFinished();
+            usersLoaded.waitForFinished();
+            loansLoaded.waitForFinished();
+            reservationsLoaded.waitForFinished();
+        });
+        
+        // Insert into the manager in dependency order as each parse completes
+        if (configLoaded.result()) {
+            applyConfiguration(libraryManager, config);
+        }
+        
+        bool success = true;
+        
+        // Load resources
+        if (resourcesLoaded.result()) {
+            recordLoadConflicts(libraryManager.bulkLoadResources(std::move(resources)));
+            loadSearchIndex(libraryManager);
+        } else {
+            qDebug() << "No resources file found, starting with empty resources";
+        }
+        
+        // Load users
+        if (usersLoaded.result()) {
+            recordLoadConflicts(libraryManager.bulkLoadUsers(std::move(users)));
+        } else {
+            qDebug() << "No users file found, starting with empty users";
+        }
+        
+        // Load loans
+        if (loansLoaded.result()) {
+            recordLoadConflicts(libraryManager.bulkLoadLoans(std::move(activeLoans), std::move(loanHistory)));
+        } else {
+            qDebug() << "No loans file found, starting with empty loans";
+        }
+        
+        // Load reservations
+        if (reservationsLoaded.result()) {
+            recordLoadConflicts(libraryManager.bulkLoadReservations(std::move(activeReservations),
+                                                                    std::move(reservationHistory)));
+        } else {
+            qDebug() << "No reservations file found, starting with empty reservations";
+        }
+        
+        // Every loader has finished by now; report each one's error, not whichever came last
+        QStringList loadErrors;
+        for (const QString& error : loaderErrors) {
+            if (!error.isEmpty()) {
+                loadErrors << error;
+            }
+        }
+        if (!loadErrors.isEmpty()) {
+            setError(loadErrors.join("; "));
+        }
+        
+        // History lives in the archives; it is paged in when a query needs it
+        if (m_generational) {
+            success &= attachHistoryArchives(libraryManager);
+        }
+        
+        // What was just loaded matches the files, so nothing is dirty yet
+        const ChangeTracker& tracker = libraryManager.getChangeTracker();
+        resetChangeTracking();
+        m_trackedSource = &tracker;
+        for (std::size_t i = 0; i < ChangeTracker::CollectionCount; ++i) {
+            auto collection = static_cast<ChangeTracker::Collection>(i);
+            markSaved(collection, tracker.revision(collection));
+        }
+        
+        // History still stored inline (files from before the archive) moves there on the next save
+        if (m_loanArchive && !libraryManager.getLoanHistoryStorage().empty()) {
+            m_hasSavedRevision[ChangeTracker::indexOf(ChangeTracker::Collection::Loans)] = false;
+        }
+        if (m_reservationArchive && !libraryManager.getReservationHistoryStorage().empty()) {
+            m_hasSavedRevision[ChangeTracker::indexOf(ChangeTracker::Collection::Reservations)] = false;
+        }
+        
+        // Bring the snapshot forward with operations recorded since it was written;
+        // replayed entities are marked dirty so the next save folds them in
+        success &= replayJournal(libraryManager);
+        
+        // Start with empty data - no sample data creation
+        qDebug() << "Library data loaded successfully. Starting with clean slate.";
+        
+        return success;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to load library data: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Save resources to JSON file
+ */
+bool PersistenceService::saveResources(const std::vector<std::unique_ptr<Resource>>& resources) {
+    clearError();
+    
+    try {
+        if (m_snapshotFormat == SnapshotFormat::Cbor) {
+            return writeCborToFile(m_resourcesFile, [&](CborSnapshot& snapshot, QIODevice& device) {
+                return snapshot.writeResources(device, resources);
+            });
+        }
+        
+        return writeJsonStreamToFile(m_resourcesFile, [&](JsonStreamWriter& writer) {
+            writer.writeField("count", static_cast<qint64>(resources.size()));
+            writer.beginArrayField("data");
+            writeResourcesJson(writer, resources);
+            writer.endArray();
+            writeJsonEnvelope(writer, "resources");
+        });
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to save resources: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Save resources to JSON file from a type-segmented store
+ */
+bool PersistenceService::saveResources(const ResourceStore& store, const ChangeTracker& tracker) {
+    clearError();
+    
+    try {
+        CollectionSnapshot snapshot = captureResources(store, tracker);
+        bool written = writeCollection(snapshot);
+        keepEntityCache(snapshot);
+        return written;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to save resources: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Load resources from JSON file
+ */
+bool PersistenceService::loadResources(std::vector<std::unique_ptr<Resource>>& resources) {
+    clearError();
+    
+    try {
+        if (m_snapshotFormat == SnapshotFormat::Cbor) {
+            return readCborFromFile(m_resourcesFile, [&](CborSnapshot& snapshot, QIODevice& device) {
+                return snapshot.readResources(device, resources);
+            });
+        }
+        
+        resources.clear();
+        ChunkedJsonDecoder<Resource> decoder(m_decodePool, &createResourceFromJson, &validateResourceJson,
+                                             "resource", resources);
+        bool parsed = readJsonStreamFromFile(m_resourcesFile, "resources", {"data"}, "resource",
+                                             [&](const QString&, const QJsonObject& json) {
+            decoder.add(json);
+            return true;
+        }, [&](const QString&, qsizetype count) { decoder.reserve(count); });
+        
+        bool decoded = decoder.finish();
+        recordLoadConflicts(decoder.takeSkipped());
+        if (parsed && !decoded) {
+            setError(decoder.errorString());
+        }
+        return parsed && decoded;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to load resources: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Save users to JSON file
+ */
+bool PersistenceService::saveUsers(const std::vector<std::unique_ptr<User>>& users) {
+    clearError();
+    
+    try {
+        if (m_snapshotFormat == SnapshotFormat::Cbor) {
+            return writeCborToFile(m_usersFile, [&](CborSnapshot& snapshot, QIODevice& device) {
+                return snapshot.writeUsers(device, users);
+            });
+        }
+        
+        return writeJsonStreamToFile(m_usersFile, [&](JsonStreamWriter& writer) {
+            writer.writeField("count", static_cast<qint64>(users.size()));
+            writer.beginArrayField("data");
+            writeUsersJson(writer, users);
+            writer.endArray();
+            writeJsonEnvelope(writer, "users");
+        });
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to save users: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Load users from JSON file
+ */
+bool PersistenceService::loadUsers(std::vector<std::unique_ptr<User>>& users) {
+    clearError();
+    
+    try {
+        if (m_snapshotFormat == SnapshotFormat::Cbor) {
+            return readCborFromFile(m_usersFile, [&](CborSnapshot& snapshot, QIODevice& device) {
+                return snapshot.readUsers(device, users);
+            });
+        }
+        
+        users.clear();
+        ChunkedJsonDecoder<User> decoder(m_decodePool, &createUserFromJson, &validateUserJson, "user", users);
+        bool parsed = readJsonStreamFromFile(m_usersFile, "users", {"data"}, "user",
+                                             [&](const QString&, const QJsonObject& json) {
+            decoder.add(json);
+            return true;
+        }, [&](const QString&, qsizetype count) { decoder.reserve(count); });
+        
+        bool decoded = decoder.finish();
+        recordLoadConflicts(decoder.takeSkipped());
+        if (parsed && !decoded) {
+            setError(decoder.errorString());
+        }
+        return parsed && decoded;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to load users: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Save users to JSON file, reusing JSON of unchanged users
+ */
+bool PersistenceService::saveUsers(std::span<const std::unique_ptr<User>> users, const ChangeTracker& tracker) {
+    clearError();
+    
+    try {
+        CollectionSnapshot snapshot = captureUsers(users, tracker);
+        bool written = writeCollection(snapshot);
+        keepEntityCache(snapshot);
+        return written;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to save users: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Save loans to JSON file
+ */
+bool PersistenceService::saveLoans(const std::vector<std::unique_ptr<Loan>>& activeLoans,
+                                  const std::vector<std::unique_ptr<Loan>>& loanHistory) {
+    clearError();
+    
+    try {
+        if (m_snapshotFormat == SnapshotFormat::Cbor) {
+            return writeCborToFile(m_loansFile, [&](CborSnapshot& snapshot, QIODevice& device) {
+                return snapshot.writeLoans(device, activeLoans, loanHistory);
+            });
+        }
+        
+        // Keys in sorted order, as QJsonObject writes them
+        return writeJsonStreamToFile(m_loansFile, [&](JsonStreamWriter& writer) {
+            writer.beginArrayField("activeLoans");
+            writeLoansJson(writer, activeLoans);
+            writer.endArray();
+            writer.writeField("activeLoansCount", static_cast<qint64>(activeLoans.size()));
+            writer.beginArrayField("loanHistory");
+            writeLoansJson(writer, loanHistory);
+            writer.endArray();
+            writer.writeField("loanHistoryCount", static_cast<qint64>(loanHistory.size()));
+            writeJsonEnvelope(writer, "loans");
+        });
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to save loans: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Load loans from JSON file
+ */
+bool PersistenceService::loadLoans(std::vector<std::unique_ptr<Loan>>& activeLoans,
+                                  std::vector<std::unique_ptr<Loan>>& loanHistory) {
+    clearError();
+    
+    try {
+        if (m_snapshotFormat == SnapshotFormat::Cbor) {
+            return readCborFromFile(m_loansFile, [&](CborSnapshot& snapshot, QIODevice& device) {
+                return snapshot.readLoans(device, activeLoans, loanHistory);
+            });
+        }
+        
+        activeLoans.clear();
+        loanHistory.clear();
+        ChunkedJsonDecoder<Loan> activeDecoder(m_decodePool, &createLoanFromJson, &validateLoanJson, "loan",
+                                               activeLoans);
+        ChunkedJsonDecoder<Loan> historyDecoder(m_decodePool, &createLoanFromJson, &validateLoanJson, "loan",
+                                                loanHistory);
+        bool parsed = readJsonStreamFromFile(m_loansFile, "loans", {"activeLoans", "loanHistory"}, "loan",
+                                             [&](const QString& key, const QJsonObject& json) {
+            (key == "activeLoans" ? activeDecoder : historyDecoder).add(json);
+            return true;
+        });
+        
+        bool decoded = activeDecoder.finish();
+        decoded = historyDecoder.finish() && decoded;
+        recordLoadConflicts(activeDecoder.takeSkipped());
+        recordLoadConflicts(historyDecoder.takeSkipped());
+        if (parsed && !decoded) {
+            setError(!activeDecoder.errorString().isEmpty() ? activeDecoder.errorString()
+                                                            : historyDecoder.errorString());
+        }
+        return parsed && decoded;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to load loans: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Save loans to JSON file, reusing JSON of unchanged loans
+ */
+bool PersistenceService::saveLoans(std::span<const std::unique_ptr<Loan>> activeLoans,
+                                  std::span<const std::unique_ptr<Loan>> loanHistory,
+                                  const ChangeTracker& tracker) {
+    clearError();
+    
+    try {
+        CollectionSnapshot snapshot = captureLoans(activeLoans, loanHistory, tracker);
+        bool written = writeCollection(snapshot);
+        keepEntityCache(snapshot);
+        return written;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to save loans: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Save reservations to JSON file
+ */
+bool PersistenceService::saveReservations(const std::vector<std::unique_ptr<Reservation>>& activeReservations,
+                                          const std::vector<std::unique_ptr<Reservation>>& reservationHistory) {
+    clearError();
+    
+    try {
+        if (m_snapshotFormat == SnapshotFormat::Cbor) {
+            return writeCborToFile(m_reservationsFile, [&](CborSnapshot& snapshot, QIODevice& device) {
+                return snapshot.writeReservations(device, activeReservations,
+                                                  reservationHistory);
+            });
+        }
+        
+        return writeJsonStreamToFile(m_reservationsFile, [&](JsonStreamWriter& writer) {
+            writer.beginArrayField("activeReservations");
+            writeReservationsJson(writer, activeReservations);
+            writer.endArray();
+            writer.writeField("activeReservationsCount", static_cast<qint64>(activeReservations.size()));
+            writer.beginArrayField("reservationHistory");
+            writeReservationsJson(writer, reservationHistory);
+            writer.endArray();
+            writer.writeField("reservationHistoryCount", static_cast<qint64>(reservationHistory.size()));
+            writeJsonEnvelope(writer, "reservations");
+        });
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to save reservations: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Load reservations from JSON file
+ */
+bool PersistenceService::loadReservations(std::vector<std::unique_ptr<Reservation>>& activeReservations,
+                                          std::vector<std::unique_ptr<Reservation>>& reservationHistory) {
+    clearError();
+    
+    try {
+        if (m_snapshotFormat == SnapshotFormat::Cbor) {
+            return readCborFromFile(m_reservationsFile, [&](CborSnapshot& snapshot, QIODevice& device) {
+                return snapshot.readReservations(device, activeReservations, reservationHistory);
+            });
+        }
+        
+        activeReservations.clear();
+        reservationHistory.clear();
+        ChunkedJsonDecoder<Reservation> activeDecoder(m_decodePool, &createReservationFromJson,
+                                                      &validateReservationJson, "reservation",
+                                                      activeReservations);
+        ChunkedJsonDecoder<Reservation> historyDecoder(m_decodePool, &createReservationFromJson,
+                                                       &validateReservationJson, "reservation",
+                                                       reservationHistory);
+        bool parsed = readJsonStreamFromFile(m_reservationsFile, "reservations",
+                                             {"activeReservations", "reservationHistory"}, "reservation",
+                                             [&](const QString& key, const QJsonObject& json) {
+            (key == "activeReservations" ? activeDecoder : historyDecoder).add(json);
+            return true;
+        });
+        
+        bool decoded = activeDecoder.finish();
+        decoded = historyDecoder.finish() && decoded;
+        recordLoadConflicts(activeDecoder.takeSkipped());
+        recordLoadConflicts(historyDecoder.takeSkipped());
+        if (parsed && !decoded) {
+            setError(!activeDecoder.errorString().isEmpty() ? activeDecoder.errorString()
+                                                            : historyDecoder.errorString());
+        }
+        return parsed && decoded;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to load reservations: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Save reservations to JSON file, reusing JSON of unchanged reservations
+ */
+bool PersistenceService::saveReservations(std::span<const std::unique_ptr<Reservation>> activeReservations,
+                                          std::span<const std::unique_ptr<Reservation>> reservationHistory,
+                                          const ChangeTracker& tracker) {
+    clearError();
+    
+    try {
+        CollectionSnapshot snapshot = captureReservations(activeReservations, reservationHistory, tracker);
+        bool written = writeCollection(snapshot);
+        keepEntityCache(snapshot);
+        return written;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to save reservations: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Save configuration to JSON file
+ */
+bool PersistenceService::saveConfiguration(const QJsonObject& config) {
+    clearError();
+    
+    try {
+        return writeJsonToFile(m_configFile, configurationDocument(config));
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to save configuration: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Load configuration from JSON file
+ */
+bool PersistenceService::loadConfiguration(QJsonObject& config) {
+    clearError();
+    
+    try {
+        QJsonDocument document;
+        if (!readJsonFromFile(m_configFile, document)) {
+            return false;
+        }
+        
+        if (!validateJsonStructure(document, "configuration")) {
+            return false;
+        }
+        
+        QJsonObject root = document.object();
+        config = root["data"].toObject();
+        
+        return true;
+        
+    } catch (const std::exception& e) {
+        setError(QString("Failed to load configuration: %1").arg(e.what()));
+        return false;
+    }
+}
+
+/**
+ * @brief Switch the directory's snapshot format
+ * 
+ * Every collection is rewritten in the new format before the directory's
+ * format marker changes, so a failure leaves the old snapshot in charge.
+ */
+bool PersistenceService::setSnapshotFormat(SnapshotFormat format, const LibraryManager& libraryManager) {
+    clearError();
+    if (format == m_snapshotFormat) {
+        return true;
+    }
+    
+    SnapshotFormat previousFormat = m_snapshotFormat;
+    m_snapshotFormat = format;
+    updateSnapshotPaths();
+    resetChangeTracking();
+    
+    if (!saveCollections(libraryManager) || !writeSnapshotFormat()) {
+        QString error = m_lastError;
+        // Follow whichever generation the manifest names now
+        m_snapshotFormat = m_manifest.generation != 0 ? m_manifest.format : previousFormat;
+        updateSnapshotPaths();
+        resetChangeTracking();
+        setError("Failed to switch snapshot format: " + error);
+        return false;
+    }
+    
+    // The new snapshot holds everything the journal did
+    if (!m_journal.truncate()) {
+        setError(m_journal.getLastError());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Switch the directory's storage engine
+ * 
+ * The whole library, history included, is written into the new engine
+ * before the directory's engine marker changes, so a failure leaves the old
+ * engine in charge. The old engine's files stay behind untouched.
+ */
+bool PersistenceService::setStorageEngine(StorageEngine engine, const LibraryManager& libraryManager) {
+    clearError();
+    if (engine == m_storageEngine) {
+        return true;
+    }
+    
+    // History attached by the old engine is still readable while the new one is written
+    std::shared_ptr<StorageBackend> previousBackend = std::move(m_backend);
+    StorageEngine previousEngine = m_storageEngine;
+    m_storageEngine = engine;
+    resetChangeTracking();
+    
+    bool success = false;
+    if (engine == StorageEngine::Sqlite) {
+        m_backend = std::make_shared<SqliteStorageBackend>(getDatabaseFilePath());
+        success = m_backend->replaceLibrary(libraryManager);
+        if (!success) {
+            setError(m_backend->getLastError());
+        }
+    } else {
+        // Without attached archives of its own, the files engine writes the history inline
+        m_loanArchive.reset();
+        m_reservationArchive.reset();
+        success = saveCollections(libraryManager);
+    }
+    
+    if (!success || !writeStorageEngine()) {
+        QString error = m_lastError;
+        if (m_backend) {
+            m_backend->close();
+        }
+        m_backend = std::move(previousBackend);
+        m_storageEngine = previousEngine;
+        resetChangeTracking();
+        setError("Failed to switch storage engine: " + error);
+        return false;
+    }
+    
+    // Operations journaled for the files engine are in the new store now
+    if (!m_journal.truncate()) {
+        setError(m_journal.getLastError());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Write the library as JSON files into another directory
+ */
+bool PersistenceService::exportJson(const LibraryManager& libraryManager, const QString& directory) {
+    clearError();
+    
+    PersistenceService exporter(directory);
+    exporter.m_backend.reset();
+    exporter.m_generational = false;
+    exporter.m_snapshotFormat = SnapshotFormat::Json;
+    exporter.updateSnapshotPaths();
+    
+    if (!exporter.saveCollections(libraryManager) || !exporter.writeSnapshotFormat()) {
+        setError("JSON export failed: " + exporter.getLastError());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Load JSON files from another directory into the library
+ * 
+ * Meant for an empty manager; the imported data is saved in this
+ * directory's own format straight away rather than journaled record by record.
+ */
+bool PersistenceService::importJson(LibraryManager& libraryManager, const QString& directory) {
+    clearError();
+    
+    {
+        QScopedValueRollback<bool> suspendJournal(m_journalSuspended, true);
+        
+        PersistenceService importer(directory);
+        importer.m_backend.reset();
+        importer.m_generational = false;
+        importer.m_snapshotFormat = SnapshotFormat::Json;
+        importer.updateSnapshotPaths();
+        
+        // Records the import skipped are reported as this service's load conflicts
+        const bool loaded = importer.loadLibraryData(libraryManager);
+        m_loadConflicts = importer.getLoadConflicts();
+        if (!loaded) {
+            setError("JSON import failed: " + importer.getLastError());
+            return false;
+        }
+    }
+    
+    return saveLibraryData(libraryManager);
+}
+
+/**
+ * @brief Initialize data directory
+ */
+bool PersistenceService::initializeDataDirectory() {
+    QDir dir;
+    if (!dir.exists(m_dataDirectory)) {
+        if (!dir.mkpath(m_dataDirectory)) {
+            setError("Failed to create data directory: " + m_dataDirectory);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Back up the current data files into the compressed backup store
+ * 
+ * Only content not already in the store is compressed and written, so
+ * repeated backups of a mostly unchanged library stay small. Backups outside
+ * the retention policy are pruned afterwards.
+ */
+bool PersistenceService::backupData(const QString& backupSuffix) {
+    QString id = backupSuffix.isEmpty() ? 
+                 QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") : 
+                 backupSuffix;
+    
+    // Journaled operations still in flight belong in the backup
+    if (m_journal.isOpen()) {
+        syncJournal();
+    }
+    
+    // The manifest goes last, so a restore switches generations only once its files are back
+    QStringList fileNames;
+    QStringList archiveFiles;
+    if (m_backend) {
+        QStringList backendFiles;
+        if (!m_backend->checkpoint(backendFiles)) {
+            setError("Failed to back up data: " + m_backend->getLastError());
+            return false;
+        }
+        archiveFiles << backendFiles;
+    }
+    for (const QString& indexName : {m_manifest.loanHistoryIndex, m_manifest.reservationHistoryIndex,
+                                     m_manifest.searchIndex}) {
+        if (!indexName.isEmpty()) {
+            archiveFiles << m_dataDirectory + "/" + indexName;
+        }
+    }
+    // Closed months' loan segments no longer change, so the store reuses their entries unread
+    QDir dataDir(m_dataDirectory);
+    for (const char* base : {LoanHistoryBase, ReservationHistoryBase}) {
+        for (const QString& segment : dataDir.entryList({QString("%1*.pages").arg(QLatin1String(base))},
+                                                        QDir::Files, QDir::Name)) {
+            archiveFiles << dataDir.filePath(segment);
+        }
+    }
+    
+    for (const QString& file : QStringList{m_configFile, m_resourcesFile, m_usersFile, m_loansFile,
+                                           m_reservationsFile} + archiveFiles +
+                               QStringList{m_formatFile, m_engineFile, m_journalFile, m_manifestFile}) {
+        if (QFile::exists(file)) {
+            fileNames << QFileInfo(file).fileName();
+        }
+    }
+    
+    if (!m_backupStore.create(id, m_dataDirectory, fileNames)) {
+        setError("Failed to back up data: " + m_backupStore.getLastError());
+        return false;
+    }
+    
+    if (!m_backupStore.prune(m_backupRetention)) {
+        setError("Failed to prune backups: " + m_backupStore.getLastError());
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Restore from backup
+ * @param backupSuffix Id of the backup; empty picks the newest one that verifies
+ */
+bool PersistenceService::restoreFromBackup(const QString& backupSuffix) {
+    BackupStore::Backup backup;
+    
+    // Copies left by older versions become ordinary backups first; one that
+    // fails to import stays where it is and does not block the others
+    importLegacyBackups();
+    
+    if (backupSuffix.isEmpty()) {
+        std::vector<BackupStore::Backup> backups = m_backupStore.list();
+        auto valid = std::find_if(backups.begin(), backups.end(), [this](const BackupStore::Backup& candidate) {
+            return m_backupStore.verify(candidate);
+        });
+        if (valid == backups.end()) {
+            setError("No valid backup found");
+            return false;
+        }
+        backup = *valid;
+    } else {
+        if (!BackupStore::isPlainName(backupSuffix)) {
+            setError("Invalid backup id: " + backupSuffix);
+            return false;
+        }
+        if (!m_backupStore.find(backupSuffix, backup)) {
+            setError("Backup not found: " + backupSuffix);
+            return false;
+        }
+        if (!m_backupStore.verify(backup)) {
+            setError("Backup " + backupSuffix + " is damaged: " + m_backupStore.getLastError());
+            return false;
+        }
+    }
+    
+    return restoreBackup(backup);
+}
+
+/**
+ * @brief Validate JSON structure
+ */
+bool PersistenceService::validateJsonStructure(const QJsonDocument& doc, const QString& expectedType) {
+    if (!doc.isObject()) {
+        setError("Invalid JSON document: not an object");
+        return false;
+    }
+    
+    QJsonObject root = doc.object();
+    
+    if (!root.contains("type") || root["type"].toString() != expectedType) {
+        setError("Invalid JSON type: expected " + expectedType);
         return false;
     }
+    
+    if (!root.contains("version")) {
+        setError("Missing version information");
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Attempt data recovery
+ */
+bool PersistenceService::attemptDataRecovery() {
+    // A manifest only ever names complete files, so its generation needs no repair
+    GenerationManifest manifest;
+    if (m_generational && readManifest(manifest)) {
+        bool complete = std::all_of(manifest.files.begin(), manifest.files.end(), [this](const QString& file) {
+            return QFile::exists(m_dataDirectory + "/" + file);
+        });
+        if (complete) {
+            applyManifest(manifest);
+            return true;
+        }
+    }
+    
+    // Otherwise the newest backup whose checksums all match
+    return restoreFromBackup();
+}
+
+/*
+bool PersistenceService::createSampleData() {
+    // This creates sample data when no data files exist
+    // In a real application, this would only be called on first run
+    
+    try {
+        // Create sample configuration
+        QJsonObject config;
+        config["libraryName"] = "ENSIARY Library Management System";
+        config["operatingHours"] = "Monday-Friday: 8:00 AM - 8:00 PM, Saturday-Sunday: 10:00 AM - 6:00 PM";
+        config["dailyFineRate"] = 0.50;
+        config["defaultLoanPeriod"] = 14;
+        config["firstRun"] = true;
+        
+        QJsonArray events;
+        events.append("Book Club Meeting - June 15, 2025");
+        events.append("Research Workshop - June 20, 2025");
+        events.append("Digital Resources Training - June 25, 2025");
+        config["upcomingEvents"] = events;
+        
+        return saveConfiguration(config);
+          } catch (const std::exception& e) {
+        setError(QString("Failed to create sample data: %1").arg(e.what()));
+        return false;
+    }
+}
+*/
+
+/**
+ * @brief Add skipped entities to the last load's conflicts (safe to call from the loaders)
+ */
+void PersistenceService::recordLoadConflicts(std::vector<LoadConflict> conflicts) {
+    QMutexLocker locker(&m_errorMutex);
+    for (LoadConflict& conflict : conflicts) {
+        qDebug() << "Skipped while loading:" << conflict.message;
+        m_loadConflicts.push_back(std::move(conflict));
+    }
+}
+
+/**
+ * @brief Validate resource JSON object against the schema of its type
+ */
+bool PersistenceService::validateResourceJson(const QJsonObject& json, LoadConflict& conflict) {
+    Resource::Kind kind;
+    const bool knownKind = Resource::typeStringToKind(json["type"].toString(), kind);
+    return checkEntityJson(resourceSchema(knownKind ? static_cast<int>(kind) : Resource::KindCount), json,
+                           ChangeTracker::Collection::Resources, conflict);
+}
+
+/**
+ * @brief Validate user JSON object
+ */
+bool PersistenceService::validateUserJson(const QJsonObject& json, LoadConflict& conflict) {
+    return checkEntityJson(userSchema(), json, ChangeTracker::Collection::Users, conflict);
+}
+
+/**
+ * @brief Validate loan JSON object
+ */
+bool PersistenceService::validateLoanJson(const QJsonObject& json, LoadConflict& conflict) {
+    return checkEntityJson(loanSchema(), json, ChangeTracker::Collection::Loans, conflict);
+}
+
+/**
+ * @brief Validate reservation JSON object
+ */
+bool PersistenceService::validateReservationJson(const QJsonObject& json, LoadConflict& conflict) {
+    return checkEntityJson(reservationSchema(), json, ChangeTracker::Collection::Reservations, conflict);
+}
+
+// Private helper methods
+
+/**
+ * @brief Write JSON document to file
+ */
+bool PersistenceService::writeJsonToFile(const QString& filePath, const QJsonDocument& document) {
+    return writeBytesToFile(filePath, document.toJson());
+}
+
+/**
+ * @brief Write raw bytes to a file, atomically replacing its contents
+ */
+bool PersistenceService::writeBytesToFile(const QString& filePath, const QByteArray& bytes) {
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        setError("Cannot open file for writing: " + filePath);
+        return false;
+    }
+    
+    if (file.write(bytes) != bytes.size()) {
+        setError(QString("Failed to write to file: %1 (%2)").arg(filePath, file.errorString()));
+        return false;
+    }
+    if (!file.commit()) {
+        setError(QString("Failed to commit file: %1 (%2)").arg(filePath, file.errorString()));
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Read JSON document from file
+ */
+bool PersistenceService::readJsonFromFile(const QString& filePath, QJsonDocument& document) {
+    QFile file(filePath);
+    if (!file.exists()) {
+        setError("File does not exist: " + filePath);
+        return false;
+    }
+    
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError("Cannot open file for reading: " + filePath);
+        return false;
+    }
+    
+    QByteArray data = file.readAll();
+    QJsonParseError error;
+    document = QJsonDocument::fromJson(data, &error);
+    
+    if (error.error != QJsonParseError::NoError) {
+        setError("JSON parse error: " + error.errorString());
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Point the collection file paths at the current generation's files
+ * 
+ * Without a manifest (a directory from before generations, or a plain
+ * export) the fixed file names of the current format are used.
+ */
+void PersistenceService::updateSnapshotPaths() {
+    if (m_generational && m_manifest.generation != 0) {
+        m_resourcesFile = m_dataDirectory + "/" + m_manifest.files[ChangeTracker::indexOf(ChangeTracker::Collection::Resources)];
+        m_usersFile = m_dataDirectory + "/" + m_manifest.files[ChangeTracker::indexOf(ChangeTracker::Collection::Users)];
+        m_loansFile = m_dataDirectory + "/" + m_manifest.files[ChangeTracker::indexOf(ChangeTracker::Collection::Loans)];
+        m_reservationsFile = m_dataDirectory + "/" + m_manifest.files[ChangeTracker::indexOf(ChangeTracker::Collection::Reservations)];
+        m_configFile = m_dataDirectory + "/" + m_manifest.files[ChangeTracker::indexOf(ChangeTracker::Collection::Configuration)];
+        return;
+    }
+    
+    QString extension = m_snapshotFormat == SnapshotFormat::Cbor ? ".cbor" : ".json";
+    m_resourcesFile = m_dataDirectory + "/resources" + extension;
+    m_usersFile = m_dataDirectory + "/users" + extension;
+    m_loansFile = m_dataDirectory + "/loans" + extension;
+    m_reservationsFile = m_dataDirectory + "/reservations" + extension;
+    m_configFile = m_dataDirectory + "/config.json";
+}
+
+/**
+ * @brief Read the directory's format marker (JSON if there is none)
+ */
+PersistenceService::SnapshotFormat PersistenceService::readSnapshotFormat() const {
+    QFile file(m_formatFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return SnapshotFormat::Json;
+    }
+    
+    QString format = QTextStream(&file).readLine().trimmed();
+    return format == QLatin1String("cbor") ? SnapshotFormat::Cbor : SnapshotFormat::Json;
 }
 
 /**
- * @brief Load users from JSON file
+ * @brief Record the current format in the directory's format marker
  */
-bool PersistenceService::loadUsers(std::vector<std::unique_ptr<User>>& users) {
-    clearError();
-    
-    try {
-        QJsonDocument document;
-        if (!readJsonFromFile(m_usersFile, document)) {
-            return false;
-        }
-        
-        if (!validateJsonStructure(document, "users")) {
-            return false;
-        }
-        
-        QJsonObject root = document.object();
-        QJsonArray usersArray = root["data"].toArray();
-        
-        return jsonArrayToUsers(usersArray, users);
-        
-    } catch (const std::exception& e) {
-        setError(QString("Failed to load users: %1").arg(e.what()));
-        return false;
-    }
+bool PersistenceService::writeSnapshotFormat() {
+    return writeBytesToFile(m_formatFile, m_snapshotFormat == SnapshotFormat::Cbor ? "cbor\n" : "json\n");
 }
 
 /**
- * @brief Save loans to JSON file
+ * @brief Read the directory's storage engine marker (files if there is none)
  */
-bool PersistenceService::saveLoans(const std::vector<std::unique_ptr<Loan>>& activeLoans,
-                                  const std::vector<std::unique_ptr<Loan>>& loanHistory) {
-    clearError();
-    
-    try {
-        QJsonArray activeLoansArray = loansToJsonArray(activeLoans);
-        QJsonArray loanHistoryArray = loansToJsonArray(loanHistory);
-        
-        QJsonObject root;
-        root["version"] = "1.0";
-        root["type"] = "loans";
-        root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-        root["activeLoansCount"] = activeLoansArray.size();
-        root["loanHistoryCount"] = loanHistoryArray.size();
-        root["activeLoans"] = activeLoansArray;
-        root["loanHistory"] = loanHistoryArray;
-        
-        QJsonDocument document(root);
-        return writeJsonToFile(m_loansFile, document);
-        
-    } catch (const std::exception& e) {
-        setError(QString("Failed to save loans: %1").arg(e.what()));
-        return false;
+PersistenceService::StorageEngine PersistenceService::readStorageEngine() const {
+    QFile file(m_engineFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return StorageEngine::Files;
     }
+    
+    QString engine = QTextStream(&file).readLine().trimmed();
+    return engine == QLatin1String("sqlite") ? StorageEngine::Sqlite : StorageEngine::Files;
 }
 
 /**
- * @brief Load loans from JSON file
+ * @brief Record the current storage engine in the directory's engine marker
  */
-bool PersistenceService::loadLoans(std::vector<std::unique_ptr<Loan>>& activeLoans,
-                                  std::vector<std::unique_ptr<Loan>>& loanHistory) {
-    clearError();
-    
-    try {
-        QJsonDocument document;
-        if (!readJsonFromFile(m_loansFile, document)) {
-            return false;
-        }
-        
-        if (!validateJsonStructure(document, "loans")) {
-            return false;
-        }
-        
-        QJsonObject root = document.object();
-        QJsonArray activeLoansArray = root["activeLoans"].toArray();
-        QJsonArray loanHistoryArray = root["loanHistory"].toArray();
-        
-        bool success = true;
-        success &= jsonArrayToLoans(activeLoansArray, activeLoans);
-        success &= jsonArrayToLoans(loanHistoryArray, loanHistory);
-        
-        return success;
-        
-    } catch (const std::exception& e) {
-        setError(QString("Failed to load loans: %1").arg(e.what()));
-        return false;
-    }
+bool PersistenceService::writeStorageEngine() {
+    return writeBytesToFile(m_engineFile, m_storageEngine == StorageEngine::Sqlite ? "sqlite\n" : "files\n");
 }
 
 /**
- * @brief Save reservations to JSON file
+ * @brief Get the current file path of one collection
  */
-bool PersistenceService::saveReservations(const std::vector<std::unique_ptr<Reservation>>& activeReservations,
-                                          const std::vector<std::unique_ptr<Reservation>>& reservationHistory) {
-    clearError();
-    
-    try {
-        QJsonArray activeReservationsArray = reservationsToJsonArray(activeReservations);
-        QJsonArray reservationHistoryArray = reservationsToJsonArray(reservationHistory);
-        
-        QJsonObject root;
-        root["version"] = "1.0";
-        root["type"] = "reservations";
-        root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-        root["activeReservationsCount"] = activeReservationsArray.size();
-        root["reservationHistoryCount"] = reservationHistoryArray.size();
-        root["activeReservations"] = activeReservationsArray;
-        root["reservationHistory"] = reservationHistoryArray;
-        
-        QJsonDocument document(root);
-        return writeJsonToFile(m_reservationsFile, document);
-        
-    } catch (const std::exception& e) {
-        setError(QString("Failed to save reservations: %1").arg(e.what()));
-        return false;
+QString PersistenceService::collectionFilePath(ChangeTracker::Collection collection) const {
+    switch (collection) {
+        case ChangeTracker::Collection::Resources:
+            return m_resourcesFile;
+        case ChangeTracker::Collection::Users:
+            return m_usersFile;
+        case ChangeTracker::Collection::Loans:
+            return m_loansFile;
+        case ChangeTracker::Collection::Reservations:
+            return m_reservationsFile;
+        case ChangeTracker::Collection::Configuration:
+            return m_configFile;
     }
+    return QString();
 }
 
 /**
- * @brief Load reservations from JSON file
+ * @brief Name of a collection's file in a given generation, e.g. "loans.000042.json"
  */
-bool PersistenceService::loadReservations(std::vector<std::unique_ptr<Reservation>>& activeReservations,
-                                          std::vector<std::unique_ptr<Reservation>>& reservationHistory) {
-    clearError();
+QString PersistenceService::generationFileName(ChangeTracker::Collection collection, quint64 generation,
+                                               SnapshotFormat format) {
+    // Configuration is always JSON
+    QString extension = (format == SnapshotFormat::Cbor && collection != ChangeTracker::Collection::Configuration)
+                            ? "cbor" : "json";
+    return QString("%1.%2.%3").arg(QLatin1String(CollectionFileBases[ChangeTracker::indexOf(collection)]))
+                              .arg(generation, 6, 10, QChar('0'))
+                              .arg(extension);
+}
+
+/**
+ * @brief Read the directory's generation manifest
+ * @return false if there is none or it is not usable
+ */
+bool PersistenceService::readManifest(GenerationManifest& manifest) const {
+    QFile file(m_manifestFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
     
-    try {
-        QJsonDocument document;
-        if (!readJsonFromFile(m_reservationsFile, document)) {
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    QJsonObject root = document.object();
+    if (error.error != QJsonParseError::NoError || root["type"].toString() != "manifest") {
+        qDebug() << "Ignoring unreadable manifest:" << m_manifestFile;
+        return false;
+    }
+    
+    GenerationManifest parsed;
+    parsed.generation = static_cast<quint64>(root["generation"].toInteger());
+    parsed.format = root["format"].toString() == "cbor" ? SnapshotFormat::Cbor : SnapshotFormat::Json;
+    
+    QJsonObject files = root["files"].toObject();
+    for (std::size_t i = 0; i < ChangeTracker::CollectionCount; ++i) {
+        parsed.files[i] = files[QLatin1String(CollectionKeys[i])].toString();
+        // Names only: a manifest never points outside its directory
+        if (parsed.files[i].isEmpty() || parsed.files[i].contains('/') || parsed.files[i].contains('\\')) {
+            qDebug() << "Ignoring manifest with an invalid file entry:" << m_manifestFile;
             return false;
         }
-        
-        if (!validateJsonStructure(document, "reservations")) {
+    }
+    
+    // Archive indexes are optional; they appear with the first archived record
+    parsed.loanHistoryIndex = files["loanHistory"].toString();
+    parsed.reservationHistoryIndex = files["reservationHistory"].toString();
+    parsed.searchIndex = files["searchIndex"].toString();
+    for (const QString& indexName : {parsed.loanHistoryIndex, parsed.reservationHistoryIndex, parsed.searchIndex}) {
+        if (indexName.contains('/') || indexName.contains('\\')) {
+            qDebug() << "Ignoring manifest with an invalid file entry:" << m_manifestFile;
             return false;
         }
-        
-        QJsonObject root = document.object();
-        QJsonArray activeReservationsArray = root["activeReservations"].toArray();
-        QJsonArray reservationHistoryArray = root["reservationHistory"].toArray();
-        
-        bool success = true;
-        success &= jsonArrayToReservations(activeReservationsArray, activeReservations);
-        success &= jsonArrayToReservations(reservationHistoryArray, reservationHistory);
-        
-        return success;
-        
-    } catch (const std::exception& e) {
-        setError(QString("Failed to load reservations: %1").arg(e.what()));
+    }
+    
+    if (parsed.generation == 0) {
         return false;
     }
+    
+    manifest = parsed;
+    return true;
 }
 
 /**
- * @brief Save configuration to JSON file
+ * @brief Build the manifest file's JSON document
  */
-bool PersistenceService::saveConfiguration(const QJsonObject& config) {
-    clearError();
-    
-    try {
-        QJsonObject root;
-        root["version"] = "1.0";
-        root["type"] = "configuration";
-        root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-        root["data"] = config;
-        
-        QJsonDocument document(root);
-        return writeJsonToFile(m_configFile, document);
-        
-    } catch (const std::exception& e) {
-        setError(QString("Failed to save configuration: %1").arg(e.what()));
-        return false;
+QJsonDocument PersistenceService::manifestDocument(const GenerationManifest& manifest) {
+    QJsonObject files;
+    for (std::size_t i = 0; i < ChangeTracker::CollectionCount; ++i) {
+        files[QLatin1String(CollectionKeys[i])] = manifest.files[i];
+    }
+    if (!manifest.loanHistoryIndex.isEmpty()) {
+        files["loanHistory"] = manifest.loanHistoryIndex;
+    }
+    if (!manifest.reservationHistoryIndex.isEmpty()) {
+        files["reservationHistory"] = manifest.reservationHistoryIndex;
     }
+    if (!manifest.searchIndex.isEmpty()) {
+        files["searchIndex"] = manifest.searchIndex;
+    }
+    
+    QJsonObject root;
+    root["version"] = "1.0";
+    root["type"] = "manifest";
+    root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    root["generation"] = static_cast<qint64>(manifest.generation);
+    root["format"] = manifest.format == SnapshotFormat::Cbor ? "cbor" : "json";
+    root["files"] = files;
+    return QJsonDocument(root);
 }
 
 /**
- * @brief Load configuration from JSON file
+ * @brief Make a manifest's generation the current one
  */
-bool PersistenceService::loadConfiguration(QJsonObject& config) {
-    clearError();
-    
-    try {
-        QJsonDocument document;
-        if (!readJsonFromFile(m_configFile, document)) {
-            return false;
-        }
-        
-        if (!validateJsonStructure(document, "configuration")) {
-            return false;
-        }
-        
-        QJsonObject root = document.object();
-        config = root["data"].toObject();
-        
-        return true;
-        
-    } catch (const std::exception& e) {
-        setError(QString("Failed to load configuration: %1").arg(e.what()));
-        return false;
-    }
+void PersistenceService::applyManifest(const GenerationManifest& manifest) {
+    m_manifest = manifest;
+    m_snapshotFormat = manifest.format;
+    updateSnapshotPaths();
 }
 
 /**
- * @brief Initialize data directory
+ * @brief Move backups made before the backup store into it
+ * 
+ * Older versions copied each data file next to itself as
+ * "<file>.backup_<suffix>". The copies sharing a suffix become the backup
+ * with that id, dated by the newest of them, and are deleted once the
+ * imported backup verifies. A suffix that is already a backup id is left alone.
  */
-bool PersistenceService::initializeDataDirectory() {
-    QDir dir;
-    if (!dir.exists(m_dataDirectory)) {
-        if (!dir.mkpath(m_dataDirectory)) {
-            setError("Failed to create data directory: " + m_dataDirectory);
-            return false;
+bool PersistenceService::importLegacyBackups() {
+    QDir dataDir(m_dataDirectory);
+    QMap<QString, std::vector<BackupStore::ImportFile>> legacyBackups;
+    QMap<QString, QDateTime> timestamps;
+    for (const QString& fileName : dataDir.entryList({"*.backup_*"}, QDir::Files, QDir::Name)) {
+        const qsizetype marker = fileName.indexOf(".backup_");
+        const QString name = fileName.left(marker);
+        const QString id = fileName.mid(marker + 8);
+        if (!BackupStore::isPlainName(name) || !BackupStore::isPlainName(id)) {
+            continue;
+        }
+        
+        legacyBackups[id].push_back({dataDir.filePath(fileName), name});
+        const QDateTime modified = QFileInfo(dataDir.filePath(fileName)).lastModified();
+        if (!timestamps.contains(id) || modified > timestamps[id]) {
+            timestamps[id] = modified;
         }
     }
-    return true;
+    
+    bool success = true;
+    for (auto it = legacyBackups.cbegin(); it != legacyBackups.cend(); ++it) {
+        BackupStore::Backup backup;
+        if (m_backupStore.find(it.key(), backup)) {
+            qDebug() << "Keeping old-style backup files, id already in use:" << it.key();
+            continue;
+        }
+        if (!m_backupStore.importFiles(it.key(), timestamps[it.key()], it.value()) ||
+            !m_backupStore.find(it.key(), backup) || !m_backupStore.verify(backup)) {
+            setError("Failed to import backup " + it.key() + ": " + m_backupStore.getLastError());
+            success = false;
+            continue;
+        }
+        for (const BackupStore::ImportFile& file : it.value()) {
+            QFile::remove(file.sourcePath);
+        }
+    }
+    return success;
 }
 
 /**
- * @brief Backup data files
+ * @brief Write a verified backup's files back into the data directory
+ * 
+ * Files are restored in backup order, manifest last. Whatever the backup did
+ * not hold is cleared rather than mixed in: a newer manifest would point past
+ * the restored files, and a newer journal would replay onto the wrong state.
  */
-bool PersistenceService::backupData(const QString& backupSuffix) {
-    QString suffix = backupSuffix.isEmpty() ? 
-                    QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") : 
-                    backupSuffix;
+bool PersistenceService::restoreBackup(const BackupStore::Backup& backup) {
+    auto contains = [&backup](const QString& filePath) {
+        const QString name = QFileInfo(filePath).fileName();
+        return std::any_of(backup.files.begin(), backup.files.end(),
+                           [&name](const BackupStore::FileEntry& entry) { return entry.name == name; });
+    };
     
-    QStringList filesToBackup = {m_resourcesFile, m_usersFile, m_loansFile, m_configFile};
+    // The journal and database files are replaced underneath, so they are closed meanwhile
+    const bool journalOpen = m_journal.isOpen();
+    syncJournal();
+    m_journal.close();
+    if (m_backend) {
+        m_backend->close();
+    }
     
-    for (const QString& file : filesToBackup) {
-        if (QFile::exists(file)) {
-            QString backupFile = file + ".backup_" + suffix;
-            if (!QFile::copy(file, backupFile)) {
-                setError("Failed to backup file: " + file);
-                return false;
-            }
+    bool success = true;
+    QByteArray contents;
+    for (const BackupStore::FileEntry& entry : backup.files) {
+        if (!m_backupStore.readFile(entry, contents)) {
+            setError("Failed to restore file: " + m_backupStore.getLastError());
+            success = false;
+            break;
+        }
+        if (!writeBytesToFile(m_dataDirectory + "/" + entry.name, contents)) {
+            success = false;
+            break;
         }
     }
     
-    return true;
+    if (success) {
+        if (!contains(m_manifestFile)) {
+            QFile::remove(m_manifestFile);
+        }
+        if (!contains(m_journalFile) && !m_journal.truncate()) {
+            setError(m_journal.getLastError());
+            success = false;
+        }
+    }
+    
+    // Follow whatever is on disk now; none of it matches the tracked revisions
+    m_snapshotFormat = readSnapshotFormat();
+    GenerationManifest manifest;
+    if (readManifest(manifest)) {
+        applyManifest(manifest);
+    } else {
+        m_manifest = GenerationManifest();
+        updateSnapshotPaths();
+    }
+    resetChangeTracking();
+    m_loanArchive.reset();
+    m_reservationArchive.reset();
+    m_storageEngine = readStorageEngine();
+    m_backend.reset();
+    if (m_storageEngine == StorageEngine::Sqlite) {
+        m_backend = std::make_shared<SqliteStorageBackend>(getDatabaseFilePath());
+    }
+    
+    if (journalOpen && !m_journal.open()) {
+        setError(m_journal.getLastError());
+        success = false;
+    }
+    return success;
 }
 
 /**
- * @brief Restore from backup
+ * @brief Delete generation files the current manifest no longer names
+ * 
+ * This also clears out files left by saves that never reached their
+ * manifest switch. Files with the fixed pre-generation names are left alone.
  */
-bool PersistenceService::restoreFromBackup(const QString& backupSuffix) {
-    QStringList filesToRestore = {m_resourcesFile, m_usersFile, m_loansFile, m_configFile};
+void PersistenceService::removeStaleGenerations() {
+    static const QRegularExpression generationFile(
+        "^((resources|users|loans|reservations|config)\\.\\d+\\.(json|cbor)|"
+        "(loan_history|reservation_history|search)\\.\\d+\\.index)$");
     
-    for (const QString& file : filesToRestore) {
-        QString backupFile = file + ".backup_" + backupSuffix;
-        if (QFile::exists(backupFile)) {
-            if (QFile::exists(file)) {
-                QFile::remove(file);
-            }
-            if (!QFile::copy(backupFile, file)) {
-                setError("Failed to restore file: " + file);
-                return false;
-            }
+    QDir dataDir(m_dataDirectory);
+    for (const QString& fileName : dataDir.entryList(QDir::Files)) {
+        if (generationFile.match(fileName).hasMatch() &&
+            std::find(m_manifest.files.begin(), m_manifest.files.end(), fileName) == m_manifest.files.end() &&
+            fileName != m_manifest.loanHistoryIndex && fileName != m_manifest.reservationHistoryIndex &&
+            fileName != m_manifest.searchIndex) {
+            dataDir.remove(fileName);
         }
     }
-    
-    return true;
 }
 
 /**
- * @brief Validate JSON structure
+ * @brief Name of a history archive's index in a given generation, e.g. "loan_history.000042.index"
  */
-bool PersistenceService::validateJsonStructure(const QJsonDocument& doc, const QString& expectedType) {
-    if (!doc.isObject()) {
-        setError("Invalid JSON document: not an object");
+QString PersistenceService::historyIndexFileName(ChangeTracker::Collection collection, quint64 generation) {
+    return QString("%1.%2.index")
+        .arg(collection == ChangeTracker::Collection::Loans ? "loan_history" : "reservation_history")
+        .arg(generation, 6, 10, QChar('0'));
+}
+
+/**
+ * @brief Name of the search index sidecar in a given generation, e.g. "search.000042.index"
+ */
+QString PersistenceService::searchIndexFileName(quint64 generation) {
+    return QString("search.%1.index").arg(generation, 6, 10, QChar('0'));
+}
+
+/**
+ * @brief Write a resources collection's search index sidecar
+ * 
+ * The sidecar is keyed by the resources file's name, which is unique per
+ * generation, so it is only ever read back alongside the data it describes.
+ */
+bool PersistenceService::writeSearchIndex(const CollectionSnapshot& snapshot) {
+    QSaveFile file(snapshot.searchIndexPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        setError("Cannot open file for writing: " + snapshot.searchIndexPath);
         return false;
     }
-    
-    QJsonObject root = doc.object();
-    
-    if (!root.contains("type") || root["type"].toString() != expectedType) {
-        setError("Invalid JSON type: expected " + expectedType);
+    if (!snapshot.searchIndex->write(file, QFileInfo(snapshot.filePath).fileName())) {
+        setError(QString("Failed to write to file: %1 (%2)").arg(snapshot.searchIndexPath, file.errorString()));
         return false;
     }
-    
-    if (!root.contains("version")) {
-        setError("Missing version information");
+    if (!file.commit()) {
+        setError(QString("Failed to commit file: %1 (%2)").arg(snapshot.searchIndexPath, file.errorString()));
         return false;
     }
-    
     return true;
 }
 
 /**
- * @brief Attempt data recovery
+ * @brief Hand the manager the search index saved with the loaded resources file
+ * 
+ * The index is derived data: a missing, stale or damaged sidecar is not an
+ * error, the manager just builds the index itself on first use.
  */
-bool PersistenceService::attemptDataRecovery() {
-    // Try to find the most recent backup
-    QDir dataDir(m_dataDirectory);
-    QStringList backupFiles = dataDir.entryList(QStringList() << "*.backup_*", QDir::Files);
-    
-    if (backupFiles.isEmpty()) {
-        setError("No backup files found for recovery");
-        return false;
+void PersistenceService::loadSearchIndex(LibraryManager& libraryManager) {
+    if (m_manifest.searchIndex.isEmpty()) {
+        return;
     }
     
-    // Find the most recent backup (this is simplified)
-    QString mostRecentBackup;
-    for (const QString& backup : backupFiles) {
-        if (backup.contains("config.json.backup_")) {
-            mostRecentBackup = backup.mid(backup.indexOf("backup_") + 7);
-            break;
-        }
+    QFile file(m_dataDirectory + "/" + m_manifest.searchIndex);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Search index unavailable, rebuilding:" << file.errorString();
+        return;
     }
+    ResourceIndex index;
+    if (!index.read(file, QFileInfo(m_resourcesFile).fileName())) {
+        qDebug() << "Search index rejected, rebuilding:" << index.getLastError();
+        return;
+    }
+    libraryManager.attachSearchIndex(std::move(index));
+}
+
+/**
+ * @brief Open the history archives the current manifest names and hand them to the manager
+ * 
+ * An archive whose index cannot be read is not attached at all, so saves
+ * keep history inline instead of appending over pages they cannot see.
+ */
+bool PersistenceService::attachHistoryArchives(LibraryManager& libraryManager) {
+    auto loanArchive = std::make_shared<HistoryArchive<Loan>>(m_dataDirectory + "/" + LoanHistoryBase,
+                                                              &PersistenceService::createLoanFromJson);
+    auto reservationArchive = std::make_shared<HistoryArchive<Reservation>>(
+        m_dataDirectory + "/" + ReservationHistoryBase, &PersistenceService::createReservationFromJson);
     
-    if (mostRecentBackup.isEmpty()) {
-        setError("Could not determine backup suffix");
-        return false;
+    bool success = true;
+    if (!m_manifest.loanHistoryIndex.isEmpty() &&
+        !loanArchive->readIndex(m_dataDirectory + "/" + m_manifest.loanHistoryIndex)) {
+        setError(loanArchive->getLastError());
+        loanArchive.reset();
+        success = false;
+    }
+    if (!m_manifest.reservationHistoryIndex.isEmpty() &&
+        !reservationArchive->readIndex(m_dataDirectory + "/" + m_manifest.reservationHistoryIndex)) {
+        setError(reservationArchive->getLastError());
+        reservationArchive.reset();
+        success = false;
     }
     
-    return restoreFromBackup(mostRecentBackup);
+    m_loanArchive = loanArchive;
+    m_reservationArchive = reservationArchive;
+    libraryManager.attachHistoryArchives(std::move(loanArchive), std::move(reservationArchive));
+    return success;
 }
 
-/*
-bool PersistenceService::createSampleData() {
-    // This creates sample data when no data files exist
-    // In a real application, this would only be called on first run
+/**
+ * @brief Write the timestamp, type and version fields that close every data file
+ */
+void PersistenceService::writeJsonEnvelope(JsonStreamWriter& writer, const QString& type) {
+    writer.writeField("timestamp", QDateTime::currentDateTime().toString(Qt::ISODate));
+    writer.writeField("type", type);
+    writer.writeField("version", "1.0");
+}
+
+/**
+ * @brief Write resources as array elements
+ */
+void PersistenceService::writeResourcesJson(JsonStreamWriter& writer,
+                                            const std::vector<std::unique_ptr<Resource>>& resources) {
+    for (const auto& resource : resources) {
+        writer.writeElement(resource->toJson());
+    }
+}
+
+/**
+ * @brief Capture one entity as an array element: its cached JSON if its revision is unchanged, else a copy
+ * 
+ * The copy shares its strings with the live entity, so taking it costs a
+ * small fixed amount and no serialization; T is the entity's final type,
+ * so the writer's toJson() call binds statically. Reused encodings go into
+ * nextCache here, new ones when the writer produces them.
+ */
+template <typename T>
+PersistenceService::CapturedElement PersistenceService::captureElement(ChangeTracker::Collection collection,
+                                                                       const T& entity, const ChangeTracker& tracker,
+                                                                       EntityJsonCache& nextCache) const {
+    CapturedElement element;
+    element.id = entity.getId();
+    element.revision = tracker.entityRevision(collection, element.id);
+    const EntityJsonCache& cache = m_entityCache[ChangeTracker::indexOf(collection)];
     
-    try {
-        // Create sample configuration
-        QJsonObject config;
-        config["libraryName"] = "ENSIARY Library Management System";
-        config["operatingHours"] = "Monday-Friday: 8:00 AM - 8:00 PM, Saturday-Sunday: 10:00 AM - 6:00 PM";
-        config["dailyFineRate"] = 0.50;
-        config["defaultLoanPeriod"] = 14;
-        config["firstRun"] = true;
-        
-        QJsonArray events;
-        events.append("Book Club Meeting - June 15, 2025");
-        events.append("Research Workshop - June 20, 2025");
-        events.append("Digital Resources Training - June 25, 2025");
-        config["upcomingEvents"] = events;
-        
-        return saveConfiguration(config);
-          } catch (const std::exception& e) {
-        setError(QString("Failed to create sample data: %1").arg(e.what()));
-        return false;
+    auto it = cache.entries.constFind(element.id);
+    if (element.revision != 0 && it != cache.entries.cend() && it->revision == element.revision) {
+        element.json = it->json;
+        cacheEntityJson(nextCache, element);
+    } else {
+        element.serialize = [copy = std::make_shared<const T>(entity)]() { return copy->toJson(); };
+    }
+    return element;
+}
+
+/**
+ * @brief Capture a list of entities as one root array
+ */
+template <typename T>
+PersistenceService::CapturedArray PersistenceService::captureArray(const QString& key,
+                                                                   ChangeTracker::Collection collection,
+                                                                   std::span<const std::unique_ptr<T>> entities,
+                                                                   const ChangeTracker& tracker,
+                                                                   EntityJsonCache& nextCache) const {
+    CapturedArray array;
+    array.key = key;
+    array.elements.reserve(entities.size());
+    for (const auto& entity : entities) {
+        array.elements.push_back(captureElement(collection, *entity, tracker, nextCache));
     }
+    return array;
 }
-*/
 
 /**
- * @brief Validate resource JSON object
+ * @brief Add an element's encoding to a collection's next entity cache
+ * 
+ * Entities visited are recorded in the next cache, which replaces the cache
+ * for the collection once the snapshot is committed, so removed entities
+ * drop out. Once it holds MaxCachedJsonBytes, the remaining entities are
+ * encoded on every save instead of being cached.
  */
-bool PersistenceService::validateResourceJson(const QJsonObject& json) {
-    // Check required fields for a resource
-    QStringList requiredFields = {"id", "title", "type", "author", "year", "isAvailable"};
-    
-    for (const QString& field : requiredFields) {
-        if (!json.contains(field)) {
-            setError(QString("Missing required field in resource JSON: %1").arg(field));
-            return false;
-        }
+void PersistenceService::cacheEntityJson(EntityJsonCache& cache, const CapturedElement& element) {
+    // Revision 0 (never changed since loading) can never be matched, so it is not kept
+    if (element.revision != 0 && cache.bytes + element.json.size() <= MaxCachedJsonBytes) {
+        cache.entries.insert(element.id, CachedEntityJson{element.revision, element.json});
+        cache.bytes += element.json.size();
     }
-    
-    return true;
 }
 
 /**
- * @brief Validate user JSON object
+ * @brief Start a snapshot of one collection at its current revision
  */
-bool PersistenceService::validateUserJson(const QJsonObject& json) {
-    // Check required fields for a user
-    QStringList requiredFields = {"id", "name", "email", "type", "status", "registrationDate"};
-    
-    for (const QString& field : requiredFields) {
-        if (!json.contains(field)) {
-            setError(QString("Missing required field in user JSON: %1").arg(field));
-            return false;
-        }
-    }
-    
-    return true;
+PersistenceService::CollectionSnapshot PersistenceService::makeCollectionSnapshot(
+        ChangeTracker::Collection collection, const QString& filePath, const QString& type,
+        const ChangeTracker& tracker) {
+    CollectionSnapshot snapshot;
+    snapshot.collection = collection;
+    snapshot.revision = tracker.revision(collection);
+    snapshot.filePath = filePath;
+    snapshot.type = type;
+    return snapshot;
 }
 
 /**
- * @brief Validate loan JSON object
+ * @brief Capture resources in the current snapshot format
+ * 
+ * Each typed segment is captured in its own loop over a final type, so the
+ * copies are taken, and later serialized, without going through the vtable.
  */
-bool PersistenceService::validateLoanJson(const QJsonObject& json) {
-    // Check required fields for a loan
-    QStringList requiredFields = {"id", "userId", "resourceId", "loanDate", "dueDate", "status"};
+PersistenceService::CollectionSnapshot PersistenceService::captureResources(const ResourceStore& store,
+                                                                            const ChangeTracker& tracker) {
+    constexpr auto collection = ChangeTracker::Collection::Resources;
+    CollectionSnapshot snapshot = makeCollectionSnapshot(collection, m_resourcesFile, "resources", tracker);
+    if (m_snapshotFormat == SnapshotFormat::Cbor) {
+        auto copies = std::make_shared<std::vector<std::unique_ptr<Resource>>>();
+        copies->reserve(store.size());
+        store.forEachSegment([&copies](const auto& segment) {
+            for (const auto* resource : segment) {
+                copies->push_back(std::make_unique<std::remove_cvref_t<decltype(*resource)>>(*resource));
+            }
+        });
+        snapshot.writeCbor = [copies](CborSnapshot& cbor, QIODevice& device) {
+            return cbor.writeResources(device, *copies);
+        };
+        return snapshot;
+    }
     
-    for (const QString& field : requiredFields) {
-        if (!json.contains(field)) {
-            setError(QString("Missing required field in loan JSON: %1").arg(field));
-            return false;
+    CapturedArray array;
+    array.key = "data";
+    array.elements.reserve(store.size());
+    snapshot.entityCache.entries.reserve(static_cast<qsizetype>(store.size()));
+    store.forEachSegment([&](const auto& segment) {
+        for (const auto* resource : segment) {
+            array.elements.push_back(captureElement(collection, *resource, tracker, snapshot.entityCache));
         }
+    });
+    snapshot.arrays.push_back(std::move(array));
+    return snapshot;
+}
+
+/**
+ * @brief Capture users in the current snapshot format
+ */
+PersistenceService::CollectionSnapshot PersistenceService::captureUsers(std::span<const std::unique_ptr<User>> users,
+                                                                        const ChangeTracker& tracker) {
+    constexpr auto collection = ChangeTracker::Collection::Users;
+    CollectionSnapshot snapshot = makeCollectionSnapshot(collection, m_usersFile, "users", tracker);
+    if (m_snapshotFormat == SnapshotFormat::Cbor) {
+        snapshot.writeCbor = [copies = copyEntities(users)](CborSnapshot& cbor, QIODevice& device) {
+            return cbor.writeUsers(device, *copies);
+        };
+        return snapshot;
     }
     
-    return true;
+    snapshot.entityCache.entries.reserve(static_cast<qsizetype>(users.size()));
+    snapshot.arrays.push_back(captureArray("data", collection, users, tracker, snapshot.entityCache));
+    return snapshot;
 }
 
 /**
- * @brief Validate reservation JSON object
+ * @brief Capture active loans and loan history in the current snapshot format
  */
-bool PersistenceService::validateReservationJson(const QJsonObject& json) {
-    // Check required fields for a reservation
-    QStringList requiredFields = {"id", "userId", "resourceId", "reservationDate", "expiryDate", "status"};
-    
-    for (const QString& field : requiredFields) {
-        if (!json.contains(field)) {
-            setError(QString("Missing required field in reservation JSON: %1").arg(field));
-            return false;
-        }
+PersistenceService::CollectionSnapshot PersistenceService::captureLoans(
+        std::span<const std::unique_ptr<Loan>> activeLoans, std::span<const std::unique_ptr<Loan>> loanHistory,
+        const ChangeTracker& tracker) {
+    constexpr auto collection = ChangeTracker::Collection::Loans;
+    CollectionSnapshot snapshot = makeCollectionSnapshot(collection, m_loansFile, "loans", tracker);
+    if (m_snapshotFormat == SnapshotFormat::Cbor) {
+        snapshot.writeCbor = [active = copyEntities(activeLoans), history = copyEntities(loanHistory)](
+                CborSnapshot& cbor, QIODevice& device) {
+            return cbor.writeLoans(device, *active, *history);
+        };
+        return snapshot;
     }
     
-    return true;
+    snapshot.entityCache.entries.reserve(static_cast<qsizetype>(activeLoans.size() + loanHistory.size()));
+    snapshot.arrays.push_back(captureArray("activeLoans", collection, activeLoans, tracker, snapshot.entityCache));
+    snapshot.arrays.push_back(captureArray("loanHistory", collection, loanHistory, tracker, snapshot.entityCache));
+    return snapshot;
 }
 
-// Private helper methods
-
 /**
- * @brief Write JSON document to file
+ * @brief Capture active reservations and reservation history in the current snapshot format
  */
-bool PersistenceService::writeJsonToFile(const QString& filePath, const QJsonDocument& document) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        setError("Cannot open file for writing: " + filePath);
-        return false;
+PersistenceService::CollectionSnapshot PersistenceService::captureReservations(
+        std::span<const std::unique_ptr<Reservation>> activeReservations,
+        std::span<const std::unique_ptr<Reservation>> reservationHistory, const ChangeTracker& tracker) {
+    constexpr auto collection = ChangeTracker::Collection::Reservations;
+    CollectionSnapshot snapshot = makeCollectionSnapshot(collection, m_reservationsFile, "reservations", tracker);
+    if (m_snapshotFormat == SnapshotFormat::Cbor) {
+        snapshot.writeCbor = [active = copyEntities(activeReservations),
+                              history = copyEntities(reservationHistory)](CborSnapshot& cbor, QIODevice& device) {
+            return cbor.writeReservations(device, *active, *history);
+        };
+        return snapshot;
     }
     
-    qint64 bytesWritten = file.write(document.toJson());
-    if (bytesWritten == -1) {
-        setError("Failed to write to file: " + filePath);
-        return false;
+    snapshot.entityCache.entries.reserve(
+        static_cast<qsizetype>(activeReservations.size() + reservationHistory.size()));
+    snapshot.arrays.push_back(captureArray("activeReservations", collection, activeReservations, tracker,
+                                           snapshot.entityCache));
+    snapshot.arrays.push_back(captureArray("reservationHistory", collection, reservationHistory, tracker,
+                                           snapshot.entityCache));
+    return snapshot;
+}
+
+/**
+ * @brief Queue history records the archive does not hold yet, at their current revision
+ * @param annotate Sets the partition and summary category of each record
+ * 
+ * A record is appended again whenever it changed since it was archived; the
+ * newer copy shadows the older one in queries and is not counted again.
+ * Records are captured as copies and encoded by the writer.
+ */
+template <typename T, typename Annotate>
+void PersistenceService::captureArchiveAppends(CollectionSnapshot& snapshot, std::shared_ptr<HistoryArchive<T>> archive,
+                                               std::span<const std::unique_ptr<T>> history,
+                                               const ChangeTracker& tracker,
+                                               const QHash<QString, quint64>& archivedRevisions,
+                                               Annotate&& annotate) {
+    snapshot.archive = std::move(archive);
+    for (const auto& record : history) {
+        const QString id = record->getId();
+        const quint64 revision = tracker.entityRevision(snapshot.collection, id);
+        auto archived = archivedRevisions.constFind(id);
+        if (archived != archivedRevisions.cend() && archived.value() == revision) {
+            continue;
+        }
+        HistoryPageFile::Record archiveRecord;
+        archiveRecord.id = id;
+        archiveRecord.userId = record->getUserId();
+        archiveRecord.resourceId = record->getResourceId();
+        archiveRecord.replaces = archived != archivedRevisions.cend() || snapshot.archive->wasAppended(id);
+        annotate(*record, archiveRecord);
+        snapshot.archiveRecords.push_back(std::move(archiveRecord));
+        snapshot.archiveSerializers.push_back([copy = std::make_shared<const T>(*record)]() {
+            return copy->toJson();
+        });
+        snapshot.archiveRevisions.emplace_back(id, revision);
     }
-    
-    return true;
 }
 
 /**
- * @brief Read JSON document from file
+ * @brief Write one captured collection to its file, encoding it on the way
+ * 
+ * JSON elements are encoded one at a time as they are written and released
+ * right after, so beyond the captured copies and the entity cache only one
+ * element's encoding is held at a time.
  */
-bool PersistenceService::readJsonFromFile(const QString& filePath, QJsonDocument& document) {
-    QFile file(filePath);
-    if (!file.exists()) {
-        setError("File does not exist: " + filePath);
+bool PersistenceService::writeCollection(CollectionSnapshot& snapshot) {
+    snapshot.written = false;
+    if (!snapshot.error.isEmpty()) {
+        setError(snapshot.error);
         return false;
     }
     
-    if (!file.open(QIODevice::ReadOnly)) {
-        setError("Cannot open file for reading: " + filePath);
+    // Archived history first: the collection file no longer holds those records
+    if (snapshot.archive && !snapshot.archiveIndexPath.isEmpty()) {
+        for (std::size_t i = 0; i < snapshot.archiveRecords.size(); ++i) {
+            snapshot.archiveRecords[i].json = JsonStreamWriter::encodeElement(snapshot.archiveSerializers[i]());
+        }
+        if (!snapshot.archive->append(snapshot.archiveRecords) ||
+            !snapshot.archive->writeIndex(snapshot.archiveIndexPath)) {
+            setError(snapshot.archive->getLastError());
+            return false;
+        }
+    }
+    
+    // The search index before the resources file it describes, like the archive index
+    if (snapshot.searchIndex && !snapshot.searchIndexPath.isEmpty() && !writeSearchIndex(snapshot)) {
         return false;
     }
     
-    QByteArray data = file.readAll();
-    QJsonParseError error;
-    document = QJsonDocument::fromJson(data, &error);
+    if (snapshot.writeCbor) {
+        snapshot.written = writeCborToFile(snapshot.filePath, snapshot.writeCbor);
+        return snapshot.written;
+    }
     
-    if (error.error != QJsonParseError::NoError) {
-        setError("JSON parse error: " + error.errorString());
-        return false;
+    // Pre-rendered files (configuration) go out as they are
+    if (snapshot.arrays.empty()) {
+        snapshot.written = writeBytesToFile(snapshot.filePath, snapshot.contents);
+        return snapshot.written;
     }
     
-    return true;
+    // A lone "data" array follows its "count"; several arrays are each followed by
+    // "<key>Count", which keeps the root keys in sorted order
+    const bool singleArray = snapshot.arrays.size() == 1;
+    snapshot.written = writeJsonStreamToFile(snapshot.filePath, [&](JsonStreamWriter& writer) {
+        if (singleArray) {
+            writer.writeField("count", static_cast<qint64>(snapshot.arrays.front().elements.size()));
+        }
+        for (CapturedArray& array : snapshot.arrays) {
+            writer.beginArrayField(array.key);
+            qsizetype count = array.writeArchived ? array.writeArchived(writer) : 0;
+            for (CapturedElement& element : array.elements) {
+                writeCapturedElement(writer, element, snapshot.entityCache);
+            }
+            count += static_cast<qsizetype>(array.elements.size());
+            writer.endArray();
+            if (!singleArray) {
+                writer.writeField(array.key + "Count", static_cast<qint64>(count));
+            }
+        }
+        writeJsonEnvelope(writer, snapshot.type);
+    });
+    return snapshot.written;
 }
 
 /**
- * @brief Convert resources vector to JSON array
+ * @brief Write one captured element, encoding its copy first if the cache did not hold it
+ * 
+ * A new encoding joins the collection's next entity cache if it fits; the
+ * element lets go of its copy and encoding once written.
  */
-QJsonArray PersistenceService::resourcesToJsonArray(const std::vector<std::unique_ptr<Resource>>& resources) {
-    QJsonArray array;
-    for (const auto& resource : resources) {
-        array.append(resource->toJson());
+void PersistenceService::writeCapturedElement(JsonStreamWriter& writer, CapturedElement& element,
+                                              EntityJsonCache& nextCache) {
+    if (element.serialize) {
+        element.json = JsonStreamWriter::encodeElement(element.serialize());
+        element.serialize = nullptr;
+        cacheEntityJson(nextCache, element);
+    }
+    writer.writeEncodedElement(element.json);
+    element.json = QByteArray();
+}
+
+/**
+ * @brief Replace a collection's entity cache with the one its JSON capture and write built
+ * 
+ * The encodings match the entity revisions they were built from whether or
+ * not the file was written, so the cache is kept either way.
+ */
+void PersistenceService::keepEntityCache(const CollectionSnapshot& snapshot) {
+    if (!snapshot.arrays.empty()) {
+        m_entityCache[ChangeTracker::indexOf(snapshot.collection)] = snapshot.entityCache;
     }
-    return array;
 }
 
 /**
- * @brief Convert JSON array to resources vector
+ * @brief Mark the written collections of a snapshot as saved at their captured revisions
  */
-bool PersistenceService::jsonArrayToResources(const QJsonArray& jsonArray, std::vector<std::unique_ptr<Resource>>& resources) {
-    resources.clear();
+bool PersistenceService::markSnapshotSaved(const SaveSnapshot& snapshot) {
+    if (snapshot.manifestWritten) {
+        applyManifest(snapshot.manifest);
+        removeStaleGenerations();
+    } else if (snapshot.manifest.generation != 0) {
+        // Never switched to: the new files are orphans and nothing counts as saved
+        return snapshot.collections.empty();
+    }
     
-    for (const QJsonValue& value : jsonArray) {
-        if (!value.isObject()) {
-            setError("Invalid resource JSON: not an object");
-            return false;
-        }
-        
-        QJsonObject resourceJson = value.toObject();
-        auto resource = createResourceFromJson(resourceJson);
-        if (resource) {
-            resources.push_back(std::move(resource));
+    // A different manager was tracked since the capture; its revisions mean nothing now
+    if (snapshot.tracker != m_trackedSource) {
+        return snapshot.collections.empty();
+    }
+    
+    bool success = true;
+    for (const CollectionSnapshot& collection : snapshot.collections) {
+        keepEntityCache(collection);
+        if (collection.written) {
+            markSaved(collection.collection, collection.revision);
+            QHash<QString, quint64>& archived = collection.collection == ChangeTracker::Collection::Loans
+                                                    ? m_archivedLoanRevisions : m_archivedReservationRevisions;
+            for (const auto& [id, revision] : collection.archiveRevisions) {
+                archived.insert(id, revision);
+            }
         } else {
-            setError("Failed to create resource from JSON");
-            return false;
+            success = false;
         }
     }
-    
-    return true;
+    return success;
 }
 
 /**
- * @brief Convert users vector to JSON array
+ * @brief Configuration settings of a library as stored in the configuration file
  */
-QJsonArray PersistenceService::usersToJsonArray(const std::vector<std::unique_ptr<User>>& users) {
-    QJsonArray array;
-    for (const auto& user : users) {
-        array.append(user->toJson());
+QJsonObject PersistenceService::configurationJson(const LibraryManager& libraryManager) {
+    QJsonObject config;
+    config["libraryName"] = libraryManager.getLibraryName();
+    config["operatingHours"] = libraryManager.getOperatingHours();
+    config["defaultLoanPeriod"] = libraryManager.getDefaultLoanPeriod();
+    
+    QJsonArray eventsArray;
+    for (const QString& event : libraryManager.getUpcomingEvents()) {
+        eventsArray.append(event);
     }
-    return array;
+    config["upcomingEvents"] = eventsArray;
+    return config;
 }
 
 /**
- * @brief Convert JSON array to users vector
+ * @brief Apply stored configuration settings to a library
  */
-bool PersistenceService::jsonArrayToUsers(const QJsonArray& jsonArray, std::vector<std::unique_ptr<User>>& users) {
-    users.clear();
+void PersistenceService::applyConfiguration(LibraryManager& libraryManager, const QJsonObject& config) {
+    libraryManager.setLibraryName(config["libraryName"].toString());
+    libraryManager.setOperatingHours(config["operatingHours"].toString());
+    libraryManager.setDefaultLoanPeriod(config["defaultLoanPeriod"].toInt());
     
-    for (const QJsonValue& value : jsonArray) {
-        if (!value.isObject()) {
-            setError("Invalid user JSON: not an object");
-            return false;
-        }
-        
-        QJsonObject userJson = value.toObject();
-        auto user = createUserFromJson(userJson);
-        if (user) {
-            users.push_back(std::move(user));
-        } else {
-            setError("Failed to create user from JSON");
-            return false;
-        }
+    // Load upcoming events
+    QJsonArray eventsArray = config["upcomingEvents"].toArray();
+    for (const QJsonValue& value : eventsArray) {
+        libraryManager.addUpcomingEvent(value.toString());
     }
-    
-    return true;
 }
 
 /**
- * @brief Convert loans vector to JSON array
+ * @brief Wrap the configuration object in its file envelope
  */
-QJsonArray PersistenceService::loansToJsonArray(const std::vector<std::unique_ptr<Loan>>& loans) {
-    QJsonArray array;
-    for (const auto& loan : loans) {
-        array.append(loan->toJson());
-    }
-    return array;
+QJsonDocument PersistenceService::configurationDocument(const QJsonObject& config) {
+    QJsonObject root;
+    root["version"] = "1.0";
+    root["type"] = "configuration";
+    root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    root["data"] = config;
+    return QJsonDocument(root);
 }
 
 /**
- * @brief Convert JSON array to loans vector
+ * @brief Write users as array elements
  */
-bool PersistenceService::jsonArrayToLoans(const QJsonArray& jsonArray, std::vector<std::unique_ptr<Loan>>& loans) {
-    loans.clear();
-    
-    for (const QJsonValue& value : jsonArray) {
-        if (!value.isObject()) {
-            setError("Invalid loan JSON: not an object");
-            return false;
-        }
-        
-        QJsonObject loanJson = value.toObject();
-        auto loan = createLoanFromJson(loanJson);
-        if (loan) {
-            loans.push_back(std::move(loan));
-        } else {
-            setError("Failed to create loan from JSON");
-            return false;
-        }
+void PersistenceService::writeUsersJson(JsonStreamWriter& writer, const std::vector<std::unique_ptr<User>>& users) {
+    for (const auto& user : users) {
+        writer.writeElement(user->toJson());
     }
-    
-    return true;
 }
 
 /**
- * @brief Convert reservations vector to JSON array
+ * @brief Write loans as array elements
  */
-QJsonArray PersistenceService::reservationsToJsonArray(const std::vector<std::unique_ptr<Reservation>>& reservations) {
-    QJsonArray array;
-    for (const auto& reservation : reservations) {
-        array.append(reservation->toJson());
+void PersistenceService::writeLoansJson(JsonStreamWriter& writer, const std::vector<std::unique_ptr<Loan>>& loans) {
+    for (const auto& loan : loans) {
+        writer.writeElement(loan->toJson());
     }
-    return array;
 }
 
 /**
- * @brief Convert JSON array to reservations vector
+ * @brief Write reservations as array elements
  */
-bool PersistenceService::jsonArrayToReservations(const QJsonArray& jsonArray, std::vector<std::unique_ptr<Reservation>>& reservations) {
-    reservations.clear();
-    
-    for (const QJsonValue& value : jsonArray) {
-        if (!value.isObject()) {
-            setError("Invalid reservation JSON: not an object");
-            return false;
-        }
-        
-        QJsonObject reservationJson = value.toObject();
-        auto reservation = createReservationFromJson(reservationJson);
-        if (reservation) {
-            reservations.push_back(std::move(reservation));
-        } else {
-            setError("Failed to create reservation from JSON");
-            return false;
-        }
+void PersistenceService::writeReservationsJson(JsonStreamWriter& writer,
+                                               const std::vector<std::unique_ptr<Reservation>>& reservations) {
+    for (const auto& reservation : reservations) {
+        writer.writeElement(reservation->toJson());
     }
-    
-    return true;
 }
 
 // Static utility functions
@@ -879,25 +2691,40 @@ QJsonObject PersistenceService::createResourceJson(const Resource& resource) {
  * @brief Create resource from JSON object
  */
 std::unique_ptr<Resource> PersistenceService::createResourceFromJson(const QJsonObject& json) {
-    QString type = json["type"].toString();
-      if (type == "Book") {
-        auto book = std::make_unique<Book>("", "", "", 2000, "", "");
-        book->fromJson(json);
-        return std::move(book);
-    } else if (type == "Article") {
-        auto article = std::make_unique<Article>("", "", "", 2000, "");
-        article->fromJson(json);
-        return std::move(article);    } else if (type == "Thesis") {
-        auto thesis = std::make_unique<Thesis>("", "", "", 2000);
-        thesis->fromJson(json);
-        return std::move(thesis);
-    } else if (type == "Digital Content") {
-        auto digitalContent = std::make_unique<DigitalContent>("", "", "", 2000);
-        digitalContent->fromJson(json);
-        return std::move(digitalContent);
+    Resource::Kind kind;
+    if (!Resource::typeStringToKind(json["type"].toString(), kind)) {
+        return nullptr;
+    }
+    
+    // Construct with the stored identity so constructor validation passes,
+    // then let fromJson fill in the remaining fields
+    const QString id = json["id"].toString();
+    const QString title = json["title"].toString();
+    const QString author = json["author"].toString();
+    const int publicationYear = json["publicationYear"].toInt();
+    
+    std::unique_ptr<Resource> resource;
+    switch (kind) {
+        case Resource::Kind::Book:
+            resource = std::make_unique<Book>(id, title, author, publicationYear,
+                                              json["isbn"].toString(), json["publisher"].toString());
+            break;
+        case Resource::Kind::Article:
+            resource = std::make_unique<Article>(id, title, author, publicationYear,
+                                                 json["journal"].toString());
+            break;
+        case Resource::Kind::Thesis:
+            resource = std::make_unique<Thesis>(id, title, author, publicationYear);
+            break;
+        case Resource::Kind::DigitalContent:
+            resource = std::make_unique<DigitalContent>(id, title, author, publicationYear);
+            break;
     }
     
-    return nullptr;
+    if (resource) {
+        resource->fromJson(json);
+    }
+    return resource;
 }
 
 /**
@@ -931,9 +2758,7 @@ std::unique_ptr<User> PersistenceService::createUserFromJson(const QJsonObject&
     // Handle loans if present (keep this part from fromJson)
     QJsonArray currentLoansArray = json["currentLoans"].toArray();
     for (const QJsonValue& value : currentLoansArray) {
-        auto loan = std::make_unique<Loan>("", "", "", "", QDateTime(), QDateTime());
-        loan->fromJson(value.toObject());
-        user->addCurrentLoan(std::move(loan));
+        user->addCurrentLoan(createLoanFromJson(value.toObject()));
     }
     
     return user;
@@ -950,7 +2775,11 @@ QJsonObject PersistenceService::createLoanJson(const Loan& loan) {
  * @brief Create loan from JSON object
  */
 std::unique_ptr<Loan> PersistenceService::createLoanFromJson(const QJsonObject& json) {
-    auto loan = std::make_unique<Loan>("", "", "", "", QDateTime(), QDateTime());
+    // Construct from the stored identity and dates so constructor validation passes
+    auto loan = std::make_unique<Loan>(json["loanId"].toString(), json["userId"].toString(),
+                                      json["resourceId"].toString(), json["resourceTitle"].toString(),
+                                      QDateTime::fromString(json["borrowDate"].toString(), Qt::ISODate),
+                                      QDateTime::fromString(json["dueDate"].toString(), Qt::ISODate));
     loan->fromJson(json);
     return loan;
 }
@@ -971,21 +2800,398 @@ std::unique_ptr<Reservation> PersistenceService::createReservationFromJson(const
     return reservation;
 }
 
+/**
+ * @brief Start journaling the manager's mutations
+ * 
+ * Each LibraryManager notification is turned into one journal record holding
+ * the post-mutation state of the entities involved.
+ */
+bool PersistenceService::enableJournal(LibraryManager& libraryManager) {
+    clearError();
+    disableJournal();
+    
+    if (!m_journal.open()) {
+        setError(m_journal.getLastError());
+        return false;
+    }
+    
+    using Mutation = CirculationJournal::Mutation;
+    using Changes = std::vector<CirculationJournal::EntityChange>;
+    const LibraryManager* manager = &libraryManager;
+    
+    auto resourceUpsert = [this, manager](Mutation mutation) {
+        return [this, manager, mutation](const QString& resourceId) {
+            Changes changes;
+            addResourceChange(*manager, resourceId, changes);
+            recordMutation(*manager, mutation, std::move(changes));
+        };
+    };
+    auto userUpsert = [this, manager](Mutation mutation) {
+        return [this, manager, mutation](const QString& userId) {
+            Changes changes;
+            addUserChange(*manager, userId, changes);
+            recordMutation(*manager, mutation, std::move(changes));
+        };
+    };
+    auto circulation = [this, manager](Mutation mutation) {
+        return [this, manager, mutation](const QString& loanId, const QString& userId, const QString& resourceId) {
+            Changes changes;
+            addLoanChange(*manager, loanId, changes);
+            addUserChange(*manager, userId, changes);
+            addResourceChange(*manager, resourceId, changes);
+            recordMutation(*manager, mutation, std::move(changes));
+        };
+    };
+    auto reservationChange = [this, manager](Mutation mutation) {
+        return [this, manager, mutation](const QString& reservationId, const QString&, const QString&) {
+            Changes changes;
+            addReservationChange(*manager, reservationId, changes);
+            recordMutation(*manager, mutation, std::move(changes));
+        };
+    };
+    
+    m_journalConnections = {
+        QObject::connect(&libraryManager, &LibraryManager::resourceAdded, resourceUpsert(Mutation::AddResource)),
+        QObject::connect(&libraryManager, &LibraryManager::resourceRemoved, [this, manager](const QString& resourceId) {
+            recordMutation(*manager, Mutation::RemoveResource,
+                           {{ChangeTracker::Collection::Resources, CirculationJournal::ChangeType::Remove, resourceId, {}}});
+        }),
+        QObject::connect(&libraryManager, &LibraryManager::userAdded, userUpsert(Mutation::AddUser)),
+        QObject::connect(&libraryManager, &LibraryManager::userRemoved, [this, manager](const QString& userId) {
+            recordMutation(*manager, Mutation::RemoveUser,
+                           {{ChangeTracker::Collection::Users, CirculationJournal::ChangeType::Remove, userId, {}}});
+        }),
+        QObject::connect(&libraryManager, &LibraryManager::resourceBorrowed, circulation(Mutation::Borrow)),
+        QObject::connect(&libraryManager, &LibraryManager::resourceReturned, circulation(Mutation::Return)),
+        QObject::connect(&libraryManager, &LibraryManager::loanRenewed, [this, manager](const QString& loanId, const QDateTime&) {
+            Changes changes;
+            addLoanChange(*manager, loanId, changes);
+            recordMutation(*manager, Mutation::Renew, std::move(changes));
+        }),
+        QObject::connect(&libraryManager, &LibraryManager::resourceReserved, reservationChange(Mutation::Reserve)),
+        QObject::connect(&libraryManager, &LibraryManager::reservationCancelled, reservationChange(Mutation::CancelReservation)),
+        QObject::connect(&libraryManager, &LibraryManager::reservationExpired, reservationChange(Mutation::ExpireReservation))
+    };
+    
+    return true;
+}
+
+/**
+ * @brief Stop journaling and close the journal file
+ */
+void PersistenceService::disableJournal() {
+    for (const QMetaObject::Connection& connection : m_journalConnections) {
+        QObject::disconnect(connection);
+    }
+    m_journalConnections.clear();
+    syncJournal();
+    m_journal.close();
+}
+
+/**
+ * @brief Fold the journal into a fresh snapshot and empty it
+ */
+bool PersistenceService::compactJournal(const LibraryManager& libraryManager) {
+    // saveLibraryData truncates the journal once every collection is on disk
+    return saveLibraryData(libraryManager);
+}
+
+/**
+ * @brief Configure how journal appends are made durable
+ * 
+ * In SyncMode::Fsync, mutations recorded within commitWindowMicros of each
+ * other share one write and one fsync. Recording never waits for it; see
+ * syncJournal() and mutationsDurable().
+ */
+void PersistenceService::setJournalDurability(CirculationJournal::SyncMode mode, int commitWindowMicros) {
+    m_journal.setSyncMode(mode);
+    m_journal.setCommitWindowMicros(commitWindowMicros);
+}
+
+/**
+ * @brief Check whether the journal has grown enough to be worth compacting
+ */
+bool PersistenceService::shouldCompactJournal() const {
+    return m_journal.size() > m_journalCompactionThreshold;
+}
+
+/**
+ * @brief Append one mutation record to the journal
+ * @return Resolves to whether the record is durable; ready at once when nothing is journaled
+ */
+QFuture<bool> PersistenceService::recordMutation(const LibraryManager& libraryManager,
+                                                 CirculationJournal::Mutation mutation,
+                                                 std::vector<CirculationJournal::EntityChange> changes) {
+    if (m_journalSuspended || changes.empty()) {
+        return QtFuture::makeReadyValueFuture(true);
+    }
+    
+    // A backend commits the operation itself, in place of the journal record
+    if (m_backend) {
+        const bool applied = m_backend->applyChanges(changes);
+        if (!applied) {
+            setError(m_backend->getLastError());
+        }
+        m_unacknowledgedMutations.push_back(QtFuture::makeReadyValueFuture(applied));
+        return m_unacknowledgedMutations.back();
+    }
+    if (!m_journal.isOpen()) {
+        return QtFuture::makeReadyValueFuture(true);
+    }
+    
+    CirculationJournal::Record record;
+    record.mutation = mutation;
+    record.timestamp = libraryManager.currentTimeMSecs();
+    record.changes = std::move(changes);
+    
+    // Queued rather than waited for: mutations are recorded on the GUI thread, the only
+    // producer, so a burst of them shares a group commit only if none of them blocks
+    QFuture<bool> durable = m_journal.appendAsync(record);
+    m_journalAppends.push_back(durable);
+    collectJournalAppends(false);
+    
+    // Nobody asks for the durability of some operations; those that made it need no reporting
+    std::erase_if(m_unacknowledgedMutations, [](const QFuture<bool>& recorded) {
+        return recorded.isFinished() && recorded.result();
+    });
+    m_unacknowledgedMutations.push_back(durable);
+    return durable;
+}
+
+/**
+ * @brief Future of the mutations recorded since the last call
+ * 
+ * Resolves to true once every one of them is durable, or to false if any
+ * failed, so a caller can report an operation as done only once it would
+ * survive a crash. Ready at once if nothing was recorded.
+ */
+QFuture<bool> PersistenceService::mutationsDurable() {
+    if (m_unacknowledgedMutations.empty()) {
+        return QtFuture::makeReadyValueFuture(true);
+    }
+    
+    std::vector<QFuture<bool>> mutations;
+    mutations.swap(m_unacknowledgedMutations);
+    return QtFuture::whenAll(mutations.begin(), mutations.end()).then([](const QList<QFuture<bool>>& appends) {
+        return std::all_of(appends.cbegin(), appends.cend(), [](const QFuture<bool>& append) {
+            return append.result();
+        });
+    });
+}
+
+/**
+ * @brief Wait until every recorded mutation is durable
+ * 
+ * Saves, backups and closing the journal wait as well; this is for callers
+ * that must know an operation is on disk before going on.
+ * @return false if any append since the last check failed
+ */
+bool PersistenceService::syncJournal() {
+    return collectJournalAppends(true);
+}
+
+/**
+ * @brief Drop finished journal appends, reporting any that failed
+ * @param wait Wait for unfinished appends as well
+ */
+bool PersistenceService::collectJournalAppends(bool wait) {
+    bool success = true;
+    auto it = m_journalAppends.begin();
+    while (it != m_journalAppends.end()) {
+        if (!wait && !it->isFinished()) {
+            ++it;
+            continue;
+        }
+        if (!it->result()) {
+            setError(m_journal.getLastError());
+            success = false;
+        }
+        it = m_journalAppends.erase(it);
+    }
+    return success;
+}
+
+/**
+ * @brief Add the current state of a resource to a journal record
+ */
+void PersistenceService::addResourceChange(const LibraryManager& libraryManager, const QString& resourceId,
+                                           std::vector<CirculationJournal::EntityChange>& changes) {
+    if (const Resource* resource = libraryManager.findResourceById(resourceId)) {
+        changes.push_back({ChangeTracker::Collection::Resources, CirculationJournal::ChangeType::Upsert,
+                           resourceId, resource->toJson()});
+    }
+}
+
+/**
+ * @brief Add the current state of a user to a journal record
+ */
+void PersistenceService::addUserChange(const LibraryManager& libraryManager, const QString& userId,
+                                       std::vector<CirculationJournal::EntityChange>& changes) {
+    if (const User* user = libraryManager.findUserById(userId)) {
+        changes.push_back({ChangeTracker::Collection::Users, CirculationJournal::ChangeType::Upsert,
+                           userId, user->toJson()});
+    }
+}
+
+/**
+ * @brief Add the current state of a loan to a journal record
+ */
+void PersistenceService::addLoanChange(const LibraryManager& libraryManager, const QString& loanId,
+                                       std::vector<CirculationJournal::EntityChange>& changes) {
+    try {
+        if (HistoryRecord<Loan> loan = libraryManager.findLoanRecord(loanId)) {
+            changes.push_back({ChangeTracker::Collection::Loans, CirculationJournal::ChangeType::Upsert,
+                               loanId, loan->toJson()});
+        }
+    } catch (const HistoryArchiveException& e) {
+        setError(QString("Cannot journal loan %1: %2").arg(loanId, e.getMessage()));
+    }
+}
+
+/**
+ * @brief Add the current state of a reservation to a journal record
+ */
+void PersistenceService::addReservationChange(const LibraryManager& libraryManager, const QString& reservationId,
+                                              std::vector<CirculationJournal::EntityChange>& changes) {
+    try {
+        if (HistoryRecord<Reservation> reservation = libraryManager.findReservationRecord(reservationId)) {
+            changes.push_back({ChangeTracker::Collection::Reservations, CirculationJournal::ChangeType::Upsert,
+                               reservationId, reservation->toJson()});
+        }
+    } catch (const HistoryArchiveException& e) {
+        setError(QString("Cannot journal reservation %1: %2").arg(reservationId, e.getMessage()));
+    }
+}
+
+/**
+ * @brief Apply every intact journal record on top of the loaded snapshot
+ */
+bool PersistenceService::replayJournal(LibraryManager& libraryManager) {
+    std::vector<CirculationJournal::Record> records;
+    if (!m_journal.readRecords(records)) {
+        setError(m_journal.getLastError());
+        return false;
+    }
+    
+    for (const CirculationJournal::Record& record : records) {
+        for (const CirculationJournal::EntityChange& change : record.changes) {
+            applyJournalChange(libraryManager, change);
+        }
+    }
+    
+    if (!records.empty()) {
+        qDebug() << "Replayed" << records.size() << "journal records";
+    }
+    return true;
+}
+
+/**
+ * @brief Apply one recorded entity change to the manager
+ */
+void PersistenceService::applyJournalChange(LibraryManager& libraryManager,
+                                            const CirculationJournal::EntityChange& change) {
+    const bool remove = change.type == CirculationJournal::ChangeType::Remove;
+    
+    try {
+        switch (change.collection) {
+            case ChangeTracker::Collection::Resources:
+                if (remove) {
+                    libraryManager.discardResource(change.entityId);
+                } else {
+                    libraryManager.restoreResource(createResourceFromJson(change.state));
+                }
+                break;
+            case ChangeTracker::Collection::Users:
+                if (remove) {
+                    libraryManager.discardUser(change.entityId);
+                } else {
+                    libraryManager.restoreUser(createUserFromJson(change.state));
+                }
+                break;
+            case ChangeTracker::Collection::Loans:
+                if (!remove) {
+                    libraryManager.restoreLoan(createLoanFromJson(change.state));
+                }
+                break;
+            case ChangeTracker::Collection::Reservations:
+                if (!remove) {
+                    libraryManager.restoreReservation(createReservationFromJson(change.state));
+                }
+                break;
+            case ChangeTracker::Collection::Configuration:
+                break;
+        }
+    } catch (const std::exception& e) {
+        qDebug() << "Skipping unreadable journal entry for" << change.entityId << ":" << e.what();
+    }
+}
+
+/**
+ * @brief Check whether a collection changed since it was last written
+ */
+bool PersistenceService::needsSave(const ChangeTracker& tracker, ChangeTracker::Collection collection,
+                                   const QString& filePath) const {
+    return tracker.revision(collection) != m_savedRevisions[ChangeTracker::indexOf(collection)] ||
+           !m_hasSavedRevision[ChangeTracker::indexOf(collection)] ||
+           !QFile::exists(filePath);
+}
+
+/**
+ * @brief Record that a collection is on disk at its current revision
+ */
+void PersistenceService::markSaved(ChangeTracker::Collection collection, quint64 revision) {
+    m_savedRevisions[ChangeTracker::indexOf(collection)] = revision;
+    m_hasSavedRevision[ChangeTracker::indexOf(collection)] = true;
+}
+
+/**
+ * @brief Forget all saved revisions and cached entity JSON
+ */
+void PersistenceService::resetChangeTracking() {
+    m_trackedSource = nullptr;
+    m_savedRevisions.fill(0);
+    m_hasSavedRevision.fill(false);
+    m_archivedLoanRevisions.clear();
+    m_archivedReservationRevisions.clear();
+    m_entityCache.fill(EntityJsonCache());
+}
+
 /**
  * @brief Set error message
  */
 void PersistenceService::setError(const QString& error) {
-    m_lastError = error;
     qDebug() << "PersistenceService Error:" << error;
+    if (t_loaderError) {
+        *t_loaderError = error;
+        return;
+    }
+    QMutexLocker locker(&m_errorMutex);
+    m_lastError = error;
 }
 
 /**
  * @brief Clear error message
  */
 void PersistenceService::clearError() {
+    if (t_loaderError) {
+        t_loaderError->clear();
+        return;
+    }
+    QMutexLocker locker(&m_errorMutex);
     m_lastError.clear();
 }
 
+/**
+ * @brief Get the last error message
+ */
+QString PersistenceService::getLastError() const {
+    if (t_loaderError) {
+        return *t_loaderError;
+    }
+    QMutexLocker locker(&m_errorMutex);
+    return m_lastError;
+}
+
 /*
 void PersistenceService::createSampleDataForLibraryManager(LibraryManager& libraryManager) {
     qDebug() << "Creating sample users and resources...";
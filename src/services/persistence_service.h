@@ -5,8 +5,27 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <QObject>
 #include <vector>
 #include <memory>
+#include <array>
+#include <span>
+#include <functional>
+#include <utility>
+
+#include "change_tracker.h"
+#include "circulation_journal.h"
+#include "cbor_snapshot.h"
+#include "json_stream_writer.h"
+#include "load_conflict.h"
+#include "backup_store.h"
+#include "history_archive.h"
+#include "storage_backend.h"
+#include "resource_index.h"
 
 // Forward declarations
 class Resource;
@@ -16,14 +35,106 @@ class User;
 class Loan;
 class Reservation;
 class LibraryManager;
+class ResourceStore;
 
 /**
  * @brief Service class for handling data persistence using JSON files
  * 
  * This class manages saving and loading of all library data to/from JSON files.
  * It provides methods for serializing and deserializing library objects.
+ * A data directory may instead keep its snapshots in a compact binary (CBOR)
+ * format; JSON then remains available for import and export.
+ * Saves write a new generation of files and then atomically replace a small
+ * manifest naming them, so a crash mid-save never leaves a torn set behind.
+ * Alternatively a directory can be stored by a StorageBackend (an SQLite
+ * database), which then takes over loading, saving and journaling.
  */
 class PersistenceService {
+public:
+    // On-disk encoding of the collection snapshots, recorded per data directory
+    enum class SnapshotFormat {
+        Json,
+        Cbor
+    };
+    
+    // Engine that stores the data directory, recorded per directory like the snapshot format
+    enum class StorageEngine {
+        Files, // Generations of collection files plus the journal
+        Sqlite // An SQLite database, written per operation
+    };
+    
+    // Dirty tracking: encoded entity JSON keyed by id, with the revision it was built from
+    struct CachedEntityJson {
+        quint64 revision = 0;
+        QByteArray json; // As produced by JsonStreamWriter::encodeElement
+    };
+    struct EntityJsonCache {
+        QHash<QString, CachedEntityJson> entries;
+        qsizetype bytes = 0; // Sum of the cached JSON sizes, at most MaxCachedJsonBytes
+    };
+    
+    // One entity of a captured JSON array: its cached encoding, or a copy the writer encodes
+    struct CapturedElement {
+        QString id;
+        quint64 revision = 0; // Entity revision at capture; 0 is never cached
+        QByteArray json; // Set when the cache held this revision
+        std::function<QJsonObject()> serialize; // Otherwise: serializes a copy taken at capture
+    };
+    
+    // One root array of a JSON data file
+    struct CapturedArray {
+        QString key;
+        std::vector<CapturedElement> elements;
+        // Optional: archived records the elements do not shadow, written first; returns their count
+        std::function<qsizetype(JsonStreamWriter&)> writeArchived;
+    };
+    
+    // One collection's file content, captured on the owning thread and encoded by the writer
+    struct CollectionSnapshot {
+        ChangeTracker::Collection collection = ChangeTracker::Collection::Resources;
+        quint64 revision = 0; // Collection revision the content reflects
+        QString filePath;
+        QString type;
+        // JSON data files: the root arrays, and the collection's next entity cache, which
+        // holds the reused encodings and gains the ones the writer produces
+        std::vector<CapturedArray> arrays;
+        EntityJsonCache entityCache;
+        std::function<bool(CborSnapshot&, QIODevice&)> writeCbor; // CBOR data files, from copies
+        QByteArray contents; // Complete file when pre-rendered (configuration)
+        // History records moved into the collection's archive, and its index for this generation
+        std::shared_ptr<HistoryPageFile> archive;
+        std::vector<HistoryPageFile::Record> archiveRecords; // json is filled in by the writer
+        std::vector<std::function<QJsonObject()>> archiveSerializers; // Per record, of a copy
+        std::vector<std::pair<QString, quint64>> archiveRevisions; // Entity revisions being archived
+        QString archiveIndexPath; // Empty: the archive index is unchanged
+        // Resources only: the search index written beside the collection file
+        std::shared_ptr<const ResourceIndex> searchIndex;
+        QString searchIndexPath; // Empty: no sidecar for this generation
+        QString error;
+        bool written = false;
+    };
+    
+    // The set of files that make up one saved generation of the library
+    struct GenerationManifest {
+        quint64 generation = 0; // 0: no manifest, the fixed file names are in use
+        SnapshotFormat format = SnapshotFormat::Json;
+        // File names relative to the data directory, by ChangeTracker::indexOf
+        std::array<QString, ChangeTracker::CollectionCount> files;
+        QString loanHistoryIndex; // Empty: no loan history archived yet
+        QString reservationHistoryIndex;
+        QString searchIndex; // ResourceIndex sidecar of the resources file; empty: rebuilt on load
+    };
+    
+    // Everything a save writes, independent of the live LibraryManager
+    struct SaveSnapshot {
+        std::vector<CollectionSnapshot> collections;
+        const ChangeTracker* tracker = nullptr;
+        quint64 latestRevision = 0; // Tracker state at capture
+        GenerationManifest manifest; // Switched to once every collection is written
+        bool manifestWritten = false;
+        bool isEmpty() const { return collections.empty(); }
+    };
+
 private:
     QString m_dataDirectory;
     QString m_resourcesFile;
@@ -31,43 +142,92 @@ private:
     QString m_loansFile;
     QString m_reservationsFile;
     QString m_configFile;
+    QString m_journalFile;
+    QString m_formatFile;
+    QString m_manifestFile;
+    SnapshotFormat m_snapshotFormat;
+    GenerationManifest m_manifest; // Generation the collection file paths point into
+    bool m_generational; // False for plain export/import directories
+    QString m_engineFile;
+    StorageEngine m_storageEngine;
+    std::shared_ptr<StorageBackend> m_backend; // Set unless the files engine is in use
 
 public:
     // Constructor
     explicit PersistenceService(const QString& dataDirectory = "data");
+    ~PersistenceService();
     
     // Main persistence operations
     bool saveLibraryData(const LibraryManager& libraryManager);
     bool loadLibraryData(LibraryManager& libraryManager);
     
+    // Split save for writing off the GUI thread: capture and commit on the thread
+    // that owns the LibraryManager, write on any thread in between
+    bool captureSnapshot(const LibraryManager& libraryManager, SaveSnapshot& snapshot);
+    bool writeSnapshot(SaveSnapshot& snapshot);
+    bool commitSnapshot(const SaveSnapshot& snapshot);
+    
     // Individual data type operations
     bool saveResources(const std::vector<std::unique_ptr<Resource>>& resources);
+    bool saveResources(const ResourceStore& store, const ChangeTracker& tracker);
     bool loadResources(std::vector<std::unique_ptr<Resource>>& resources);
     
     bool saveUsers(const std::vector<std::unique_ptr<User>>& users);
+    bool saveUsers(std::span<const std::unique_ptr<User>> users, const ChangeTracker& tracker);
     bool loadUsers(std::vector<std::unique_ptr<User>>& users);
     
     bool saveLoans(const std::vector<std::unique_ptr<Loan>>& activeLoans,
                    const std::vector<std::unique_ptr<Loan>>& loanHistory);
+    bool saveLoans(std::span<const std::unique_ptr<Loan>> activeLoans,
+                   std::span<const std::unique_ptr<Loan>> loanHistory,
+                   const ChangeTracker& tracker);
     bool loadLoans(std::vector<std::unique_ptr<Loan>>& activeLoans,
                    std::vector<std::unique_ptr<Loan>>& loanHistory);
     
     bool saveReservations(const std::vector<std::unique_ptr<Reservation>>& activeReservations,
                          const std::vector<std::unique_ptr<Reservation>>& reservationHistory);
+    bool saveReservations(std::span<const std::unique_ptr<Reservation>> activeReservations,
+                         std::span<const std::unique_ptr<Reservation>> reservationHistory,
+                         const ChangeTracker& tracker);
     bool loadReservations(std::vector<std::unique_ptr<Reservation>>& activeReservations,
                          std::vector<std::unique_ptr<Reservation>>& reservationHistory);
     
     bool saveConfiguration(const QJsonObject& config);
     bool loadConfiguration(QJsonObject& config);
     
+    // Write-ahead journal of circulation operations
+    bool enableJournal(LibraryManager& libraryManager);
+    void disableJournal();
+    bool isJournalEnabled() const { return m_journal.isOpen(); }
+    bool compactJournal(const LibraryManager& libraryManager); // Synchronous; never during a background save
+    bool shouldCompactJournal() const;
+    qint64 getJournalSize() const { return m_journal.size(); }
+    void setJournalDurability(CirculationJournal::SyncMode mode, int commitWindowMicros = 2000);
+    bool syncJournal(); // Wait until every recorded mutation is durable
+    QFuture<bool> mutationsDurable(); // Of the mutations recorded since the last call; never blocks
+    
+    // Snapshot format: switching rewrites every collection in the new format
+    bool setSnapshotFormat(SnapshotFormat format, const LibraryManager& libraryManager);
+    SnapshotFormat getSnapshotFormat() const { return m_snapshotFormat; }
+    quint64 getGeneration() const { return m_manifest.generation; }
+    
+    // Storage engine: switching copies the whole library into the new engine
+    bool setStorageEngine(StorageEngine engine, const LibraryManager& libraryManager);
+    StorageEngine getStorageEngine() const { return m_storageEngine; }
+    bool exportJson(const LibraryManager& libraryManager, const QString& directory);
+    bool importJson(LibraryManager& libraryManager, const QString& directory);
+    
     // File management
     bool initializeDataDirectory();
     bool backupData(const QString& backupSuffix = "");
-    bool restoreFromBackup(const QString& backupSuffix = "");
+    bool restoreFromBackup(const QString& backupSuffix = ""); // Empty: the newest valid backup
+    std::vector<BackupStore::Backup> listBackups() const { return m_backupStore.list(); }
+    void setBackupRetention(const BackupStore::RetentionPolicy& policy) { m_backupRetention = policy; }
     
     // Validation and error handling
     bool validateJsonStructure(const QJsonDocument& doc, const QString& expectedType);
-    QString getLastError() const { return m_lastError; }
+    QString getLastError() const;
+    const std::vector<LoadConflict>& getLoadConflicts() const { return m_loadConflicts; } // From the last load or import
     
     // Utility functions
     QString getResourcesFilePath() const { return m_resourcesFile; }
@@ -75,6 +235,9 @@ public:
     QString getLoansFilePath() const { return m_loansFile; }
     QString getReservationsFilePath() const { return m_reservationsFile; }
     QString getConfigFilePath() const { return m_configFile; }
+    QString getJournalFilePath() const { return m_journalFile; }
+    QString getManifestFilePath() const { return m_manifestFile; }
+    QString getDatabaseFilePath() const { return m_dataDirectory + "/library.sqlite"; }
     
     // Static utility functions
     static QJsonObject createResourceJson(const Resource& resource);
@@ -85,34 +248,152 @@ public:
     static std::unique_ptr<Loan> createLoanFromJson(const QJsonObject& json);
     static QJsonObject createReservationJson(const Reservation& reservation);
     static std::unique_ptr<Reservation> createReservationFromJson(const QJsonObject& json);
+    static QJsonObject configurationJson(const LibraryManager& libraryManager);
+    static void applyConfiguration(LibraryManager& libraryManager, const QJsonObject& config);
       // Error recovery
     bool attemptDataRecovery();
 
 private:
-    QString m_lastError;
+    QString m_lastError; // Concurrent loaders write their own slots instead (see loadLibraryData)
+    mutable QMutex m_errorMutex; // Loaders run concurrently during loadLibraryData
+    std::vector<LoadConflict> m_loadConflicts; // Guarded by m_errorMutex while loaders run
+    
+    // Dirty tracking
+    static constexpr qsizetype MaxCachedJsonBytes = 16 * 1024 * 1024; // Per collection
+    
+    const ChangeTracker* m_trackedSource; // Tracker the saved revisions refer to
+    std::array<quint64, ChangeTracker::CollectionCount> m_savedRevisions;
+    std::array<bool, ChangeTracker::CollectionCount> m_hasSavedRevision;
+    std::array<EntityJsonCache, ChangeTracker::CollectionCount> m_entityCache;
+    
+    // Write-ahead journal: records are appended from LibraryManager signals
+    CirculationJournal m_journal;
+    std::vector<QMetaObject::Connection> m_journalConnections;
+    std::vector<QFuture<bool>> m_journalAppends; // Appends not yet known to be durable
+    std::vector<QFuture<bool>> m_unacknowledgedMutations; // Not yet handed out by mutationsDurable()
+    bool m_journalSuspended; // Set while loading, so replayed state is not re-recorded
+    qint64 m_journalCompactionThreshold;
+    
+    // Entity revisions already appended to the history archives this session
+    QHash<QString, quint64> m_archivedLoanRevisions;
+    QHash<QString, quint64> m_archivedReservationRevisions;
+    
+    // The archives attached to the manager by the last load, which saves append to
+    std::shared_ptr<HistoryArchive<Loan>> m_loanArchive;
+    std::shared_ptr<HistoryArchive<Reservation>> m_reservationArchive;
+    
+    // Compressed, deduplicated backups below <data>/backups
+    BackupStore m_backupStore;
+    BackupStore::RetentionPolicy m_backupRetention;
+    
+    // Workers that turn parsed JSON elements into model objects, shared by the loaders
+    QThreadPool m_decodePool;
     
     // File I/O helpers
     bool writeJsonToFile(const QString& filePath, const QJsonDocument& document);
+    bool writeBytesToFile(const QString& filePath, const QByteArray& bytes);
     bool readJsonFromFile(const QString& filePath, QJsonDocument& document);
+    template <typename FieldWriter>
+    bool writeJsonStreamToFile(const QString& filePath, FieldWriter&& writeFields);
+    static void writeJsonEnvelope(JsonStreamWriter& writer, const QString& type);
+    template <typename ElementHandler>
+    bool readJsonStreamFromFile(const QString& filePath, const QString& expectedType,
+                                const QStringList& arrayKeys, const QString& elementName,
+                                ElementHandler&& handleElement,
+                                const std::function<void(const QString&, qsizetype)>& reserve = {});
+    template <typename Writer>
+    bool writeCborToFile(const QString& filePath, Writer&& write);
+    template <typename Reader>
+    bool readCborFromFile(const QString& filePath, Reader&& read);
     
-    // JSON processing helpers
-    QJsonArray resourcesToJsonArray(const std::vector<std::unique_ptr<Resource>>& resources);
-    bool jsonArrayToResources(const QJsonArray& jsonArray, std::vector<std::unique_ptr<Resource>>& resources);
+    // Snapshot helpers
+    bool saveCollections(const LibraryManager& libraryManager);
+    static CollectionSnapshot makeCollectionSnapshot(ChangeTracker::Collection collection, const QString& filePath,
+                                                     const QString& type, const ChangeTracker& tracker);
+    CollectionSnapshot captureResources(const ResourceStore& store, const ChangeTracker& tracker);
+    CollectionSnapshot captureUsers(std::span<const std::unique_ptr<User>> users, const ChangeTracker& tracker);
+    CollectionSnapshot captureLoans(std::span<const std::unique_ptr<Loan>> activeLoans,
+                                    std::span<const std::unique_ptr<Loan>> loanHistory,
+                                    const ChangeTracker& tracker);
+    CollectionSnapshot captureReservations(std::span<const std::unique_ptr<Reservation>> activeReservations,
+                                           std::span<const std::unique_ptr<Reservation>> reservationHistory,
+                                           const ChangeTracker& tracker);
+    template <typename T, typename Annotate>
+    void captureArchiveAppends(CollectionSnapshot& snapshot, std::shared_ptr<HistoryArchive<T>> archive,
+                               std::span<const std::unique_ptr<T>> history, const ChangeTracker& tracker,
+                               const QHash<QString, quint64>& archivedRevisions, Annotate&& annotate);
+    bool writeCollection(CollectionSnapshot& snapshot);
+    static void writeCapturedElement(JsonStreamWriter& writer, CapturedElement& element,
+                                     EntityJsonCache& nextCache);
+    void keepEntityCache(const CollectionSnapshot& snapshot);
+    bool markSnapshotSaved(const SaveSnapshot& snapshot);
+    static QJsonDocument configurationDocument(const QJsonObject& config);
+    void updateSnapshotPaths();
+    SnapshotFormat readSnapshotFormat() const;
+    bool writeSnapshotFormat();
+    StorageEngine readStorageEngine() const;
+    bool writeStorageEngine();
     
-    QJsonArray usersToJsonArray(const std::vector<std::unique_ptr<User>>& users);
-    bool jsonArrayToUsers(const QJsonArray& jsonArray, std::vector<std::unique_ptr<User>>& users);
+    // Generation helpers
+    QString collectionFilePath(ChangeTracker::Collection collection) const;
+    static QString generationFileName(ChangeTracker::Collection collection, quint64 generation,
+                                      SnapshotFormat format);
+    bool readManifest(GenerationManifest& manifest) const;
+    static QJsonDocument manifestDocument(const GenerationManifest& manifest);
+    void applyManifest(const GenerationManifest& manifest);
+    void removeStaleGenerations();
+    static QString historyIndexFileName(ChangeTracker::Collection collection, quint64 generation);
+    static QString searchIndexFileName(quint64 generation);
+    bool writeSearchIndex(const CollectionSnapshot& snapshot);
+    void loadSearchIndex(LibraryManager& libraryManager);
+    bool attachHistoryArchives(LibraryManager& libraryManager);
+    
+    // Backup helpers
+    bool restoreBackup(const BackupStore::Backup& backup);
+    bool importLegacyBackups();
+    
+    // JSON processing helpers
+    static void writeResourcesJson(JsonStreamWriter& writer, const std::vector<std::unique_ptr<Resource>>& resources);
+    static void writeUsersJson(JsonStreamWriter& writer, const std::vector<std::unique_ptr<User>>& users);
+    static void writeLoansJson(JsonStreamWriter& writer, const std::vector<std::unique_ptr<Loan>>& loans);
+    static void writeReservationsJson(JsonStreamWriter& writer,
+                                      const std::vector<std::unique_ptr<Reservation>>& reservations);
     
-    QJsonArray loansToJsonArray(const std::vector<std::unique_ptr<Loan>>& loans);
-    bool jsonArrayToLoans(const QJsonArray& jsonArray, std::vector<std::unique_ptr<Loan>>& loans);
+    // Dirty tracking helpers
+    template <typename T>
+    CapturedElement captureElement(ChangeTracker::Collection collection, const T& entity,
+                                   const ChangeTracker& tracker, EntityJsonCache& nextCache) const;
+    template <typename T>
+    CapturedArray captureArray(const QString& key, ChangeTracker::Collection collection,
+                               std::span<const std::unique_ptr<T>> entities, const ChangeTracker& tracker,
+                               EntityJsonCache& nextCache) const;
+    static void cacheEntityJson(EntityJsonCache& cache, const CapturedElement& element);
+    bool needsSave(const ChangeTracker& tracker, ChangeTracker::Collection collection,
+                   const QString& filePath) const;
+    void markSaved(ChangeTracker::Collection collection, quint64 revision);
+    void resetChangeTracking();
     
-    QJsonArray reservationsToJsonArray(const std::vector<std::unique_ptr<Reservation>>& reservations);
-    bool jsonArrayToReservations(const QJsonArray& jsonArray, std::vector<std::unique_ptr<Reservation>>& reservations);
+    // Journal helpers
+    QFuture<bool> recordMutation(const LibraryManager& libraryManager, CirculationJournal::Mutation mutation,
+                                 std::vector<CirculationJournal::EntityChange> changes);
+    bool collectJournalAppends(bool wait);
+    static void addResourceChange(const LibraryManager& libraryManager, const QString& resourceId,
+                                  std::vector<CirculationJournal::EntityChange>& changes);
+    static void addUserChange(const LibraryManager& libraryManager, const QString& userId,
+                              std::vector<CirculationJournal::EntityChange>& changes);
+    void addLoanChange(const LibraryManager& libraryManager, const QString& loanId,
+                       std::vector<CirculationJournal::EntityChange>& changes);
+    void addReservationChange(const LibraryManager& libraryManager, const QString& reservationId,
+                              std::vector<CirculationJournal::EntityChange>& changes);
+    bool replayJournal(LibraryManager& libraryManager);
+    void applyJournalChange(LibraryManager& libraryManager, const CirculationJournal::EntityChange& change);
     
-    // Validation helpers
-    bool validateResourceJson(const QJsonObject& json);
-    bool validateUserJson(const QJsonObject& json);
-    bool validateLoanJson(const QJsonObject& json);
-    bool validateReservationJson(const QJsonObject& json);
+    // Validation helpers: false and a filled-in conflict for an object its entity's schema rejects
+    static bool validateResourceJson(const QJsonObject& json, LoadConflict& conflict);
+    static bool validateUserJson(const QJsonObject& json, LoadConflict& conflict);
+    static bool validateLoanJson(const QJsonObject& json, LoadConflict& conflict);
+    static bool validateReservationJson(const QJsonObject& json, LoadConflict& conflict);
+    void recordLoadConflicts(std::vector<LoadConflict> conflicts);
     
     // Error handling
     void setError(const QString& error);
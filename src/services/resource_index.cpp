@@ -0,0 +1,404 @@
+#include "resource_index.h"
+#include <QDataStream>
+#include <QByteArray>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+constexpr quint32 Magic = 0x454E5349; // "ENSI"
+
+/**
+ * @brief Write a bitmap as its word count and words
+ */
+void writeBitmap(QDataStream& stream, const ResourceIndex::Bitmap& bitmap) {
+    stream << static_cast<quint32>(bitmap.size());
+    for (quint64 word : bitmap) {
+        stream << word;
+    }
+}
+
+/**
+ * @brief Read a bitmap written by writeBitmap; bitmaps grow lazily, so it may be shorter than words
+ */
+bool readBitmap(QDataStream& stream, ResourceIndex::Bitmap& bitmap, quint32 words) {
+    quint32 size = 0;
+    stream >> size;
+    if (size > words) {
+        return false;
+    }
+    bitmap.assign(size, 0);
+    for (quint64& word : bitmap) {
+        stream >> word;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+/**
+ * @brief Remove everything from the index
+ */
+void ResourceIndex::clear() {
+    m_ids.clear();
+    m_ordinals.clear();
+    m_textHashes.clear();
+    m_trigrams.clear();
+    m_live.clear();
+    for (Bitmap& bitmap : m_categories) {
+        bitmap.clear();
+    }
+    for (Bitmap& bitmap : m_statuses) {
+        bitmap.clear();
+    }
+    m_liveCount = 0;
+}
+
+/**
+ * @brief Reserve room for a number of resources
+ */
+void ResourceIndex::reserve(qsizetype count) {
+    m_ids.reserve(count);
+    m_ordinals.reserve(count);
+    m_textHashes.reserve(static_cast<std::size_t>(count));
+}
+
+/**
+ * @brief Index a resource, or bring a known one up to date
+ *
+ * Trigrams are only added when the searchable text changed since the
+ * resource was last indexed, so status changes touch nothing but bitmaps.
+ */
+void ResourceIndex::add(const Resource& resource) {
+    const QString id = resource.getId();
+    quint32 ordinal = ordinalOf(id);
+    if (ordinal == NotFound) {
+        ordinal = static_cast<quint32>(m_ids.size());
+        m_ids.append(id);
+        m_ordinals.insert(id, ordinal);
+        m_textHashes.push_back(0);
+    } else {
+        clearBits(ordinal);
+    }
+
+    const QString text = searchableText(resource);
+    const quint64 hash = textHash(text);
+    if (m_textHashes[ordinal] != hash) {
+        indexText(ordinal, text);
+        m_textHashes[ordinal] = hash;
+    }
+
+    setBit(m_live, ordinal);
+    setBit(m_categories[std::min<std::size_t>(static_cast<std::size_t>(resource.getCategory()), CategoryCount - 1)],
+           ordinal);
+    setBit(m_statuses[std::min<std::size_t>(static_cast<std::size_t>(resource.getStatus()), StatusCount - 1)],
+           ordinal);
+    ++m_liveCount;
+}
+
+/**
+ * @brief Drop a resource from every query; its ordinal is not reused
+ */
+void ResourceIndex::remove(const QString& resourceId) {
+    const quint32 ordinal = ordinalOf(resourceId);
+    if (ordinal != NotFound) {
+        clearBits(ordinal);
+    }
+}
+
+/**
+ * @brief Candidate ordinals for a case-insensitive substring query
+ *
+ * Intersects the postings of the query's trigrams, shortest first. The
+ * query must satisfy canSearch(). Every list is reserved before it is
+ * filled, so each takes one allocation from memory.
+ */
+ResourceIndex::Ordinals ResourceIndex::search(const QString& query, std::pmr::memory_resource* memory) const {
+    Ordinals candidates(memory);
+    const std::pmr::vector<quint64> keys = trigrams(query.toLower(), memory);
+    std::pmr::vector<const QList<quint32>*> postings(memory);
+    postings.reserve(keys.size());
+    for (quint64 trigram : keys) {
+        auto it = m_trigrams.constFind(trigram);
+        if (it == m_trigrams.cend()) {
+            return candidates;
+        }
+        postings.push_back(&it.value());
+    }
+    if (postings.empty()) {
+        return candidates;
+    }
+    std::sort(postings.begin(), postings.end(), [](const QList<quint32>* a, const QList<quint32>* b) {
+        return a->size() < b->size();
+    });
+
+    candidates.reserve(static_cast<std::size_t>(postings.front()->size()));
+    std::copy_if(postings.front()->cbegin(), postings.front()->cend(), std::back_inserter(candidates),
+                 [this](quint32 ordinal) { return testBit(m_live, ordinal); });
+    Ordinals narrowed(memory);
+    narrowed.reserve(candidates.size()); // Intersections only shrink
+    for (std::size_t i = 1; i < postings.size() && !candidates.empty(); ++i) {
+        narrowed.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), postings[i]->cbegin(), postings[i]->cend(),
+                              std::back_inserter(narrowed));
+        candidates.swap(narrowed);
+    }
+    return candidates;
+}
+
+/**
+ * @brief Live resources of a category
+ */
+ResourceIndex::Ordinals ResourceIndex::withCategory(Resource::Category category,
+                                                    std::pmr::memory_resource* memory) const {
+    const auto index = static_cast<std::size_t>(category);
+    return index < CategoryCount ? ordinals(m_categories[index], memory) : Ordinals(memory);
+}
+
+/**
+ * @brief Live resources with a status
+ */
+ResourceIndex::Ordinals ResourceIndex::withStatus(Resource::Status status, std::pmr::memory_resource* memory) const {
+    const auto index = static_cast<std::size_t>(status);
+    return index < StatusCount ? ordinals(m_statuses[index], memory) : Ordinals(memory);
+}
+
+/**
+ * @brief Write the index as a sidecar: magic, version, CRC-16 and length of the payload, payload
+ */
+bool ResourceIndex::write(QIODevice& device, const QString& sourceKey) const {
+    QByteArray payload;
+    {
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << sourceKey << m_ids;
+        stream << static_cast<quint32>(m_textHashes.size());
+        for (quint64 hash : m_textHashes) {
+            stream << hash;
+        }
+        writeBitmap(stream, m_live);
+        for (const Bitmap& bitmap : m_categories) {
+            writeBitmap(stream, bitmap);
+        }
+        for (const Bitmap& bitmap : m_statuses) {
+            writeBitmap(stream, bitmap);
+        }
+        stream << static_cast<quint32>(m_trigrams.size());
+        for (auto it = m_trigrams.cbegin(); it != m_trigrams.cend(); ++it) {
+            stream << it.key() << it.value();
+        }
+    }
+
+    QDataStream stream(&device);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << Magic << FormatVersion << qChecksum(payload) << static_cast<quint64>(payload.size());
+    stream.writeRawData(payload.constData(), static_cast<int>(payload.size()));
+    return stream.status() == QDataStream::Ok;
+}
+
+/**
+ * @brief Replace the index with a sidecar's, if it describes expectedKey and is intact
+ */
+bool ResourceIndex::read(QIODevice& device, const QString& expectedKey) {
+    m_lastError.clear();
+
+    QDataStream header(&device);
+    header.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint16 checksum = 0;
+    quint64 length = 0;
+    header >> magic >> version >> checksum >> length;
+    if (header.status() != QDataStream::Ok || magic != Magic || version != FormatVersion ||
+        length > static_cast<quint64>(device.bytesAvailable())) {
+        m_lastError = "Not a readable search index";
+        return false;
+    }
+    const QByteArray payload = device.read(static_cast<qint64>(length));
+    if (payload.size() != static_cast<qsizetype>(length) || qChecksum(payload) != checksum) {
+        m_lastError = "Search index is damaged";
+        return false;
+    }
+
+    ResourceIndex index;
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_6_0);
+    QString sourceKey;
+    stream >> sourceKey;
+    if (sourceKey != expectedKey) {
+        m_lastError = QString("Search index describes %1, not %2").arg(sourceKey, expectedKey);
+        return false;
+    }
+
+    stream >> index.m_ids;
+    const quint32 count = static_cast<quint32>(index.m_ids.size());
+    const quint32 words = (count + 63) / 64;
+    quint32 hashCount = 0;
+    stream >> hashCount;
+    bool valid = stream.status() == QDataStream::Ok && hashCount == count;
+    if (valid) {
+        index.m_textHashes.resize(count);
+        for (quint64& hash : index.m_textHashes) {
+            stream >> hash;
+        }
+        valid = readBitmap(stream, index.m_live, words);
+    }
+    for (Bitmap& bitmap : index.m_categories) {
+        valid = valid && readBitmap(stream, bitmap, words);
+    }
+    for (Bitmap& bitmap : index.m_statuses) {
+        valid = valid && readBitmap(stream, bitmap, words);
+    }
+
+    quint32 trigramCount = 0;
+    stream >> trigramCount;
+    valid = valid && stream.status() == QDataStream::Ok;
+    index.m_trigrams.reserve(valid ? trigramCount : 0);
+    for (quint32 i = 0; valid && i < trigramCount; ++i) {
+        quint64 trigram = 0;
+        QList<quint32> postings;
+        stream >> trigram >> postings;
+        valid = stream.status() == QDataStream::Ok &&
+                std::all_of(postings.cbegin(), postings.cend(), [count](quint32 ordinal) { return ordinal < count; });
+        index.m_trigrams.insert(trigram, std::move(postings));
+    }
+    if (!valid) {
+        m_lastError = "Search index is inconsistent";
+        return false;
+    }
+
+    index.m_ordinals.reserve(count);
+    for (quint32 ordinal = 0; ordinal < count; ++ordinal) {
+        index.m_ordinals.insert(index.m_ids.at(ordinal), ordinal);
+        if (testBit(index.m_live, ordinal)) {
+            ++index.m_liveCount;
+        }
+    }
+
+    *this = std::move(index);
+    return true;
+}
+
+// Private helper methods
+
+/**
+ * @brief Lowercased text searches match against, fields separated so no trigram spans two
+ */
+QString ResourceIndex::searchableText(const Resource& resource) {
+    return resource.getTitle().toLower() + QChar('\n') + resource.getAuthor().toLower() + QChar('\n') +
+           resource.getDescription().toLower();
+}
+
+/**
+ * @brief FNV-1a over UTF-16 code units; stable across runs, unlike qHash
+ */
+quint64 ResourceIndex::textHash(const QString& text) {
+    quint64 hash = 0xCBF29CE484222325ULL;
+    for (QChar c : text) {
+        hash = (hash ^ c.unicode()) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Distinct trigrams of a text, each packed into the low 48 bits of a key
+ */
+std::pmr::vector<quint64> ResourceIndex::trigrams(const QString& lowerText, std::pmr::memory_resource* memory) {
+    std::pmr::vector<quint64> keys(memory);
+    if (lowerText.size() < MinQueryLength) {
+        return keys;
+    }
+    keys.reserve(static_cast<std::size_t>(lowerText.size() - 2));
+    const QChar* data = lowerText.constData();
+    for (qsizetype i = 0; i + 2 < lowerText.size(); ++i) {
+        keys.push_back((quint64(data[i].unicode()) << 32) | (quint64(data[i + 1].unicode()) << 16) |
+                       data[i + 2].unicode());
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+/**
+ * @brief Add an ordinal to the postings of every trigram of its text
+ */
+void ResourceIndex::indexText(quint32 ordinal, const QString& lowerText) {
+    for (quint64 trigram : trigrams(lowerText)) {
+        QList<quint32>& postings = m_trigrams[trigram];
+        // New resources take the highest ordinal yet, so this is almost always an append
+        if (postings.isEmpty() || postings.constLast() < ordinal) {
+            postings.append(ordinal);
+            continue;
+        }
+        auto position = std::lower_bound(postings.begin(), postings.end(), ordinal);
+        if (position == postings.end() || *position != ordinal) {
+            postings.insert(position, ordinal);
+        }
+    }
+}
+
+/**
+ * @brief Clear an ordinal from the live, category and status bitmaps
+ */
+void ResourceIndex::clearBits(quint32 ordinal) {
+    if (testBit(m_live, ordinal)) {
+        --m_liveCount;
+    }
+    clearBit(m_live, ordinal);
+    for (Bitmap& bitmap : m_categories) {
+        clearBit(bitmap, ordinal);
+    }
+    for (Bitmap& bitmap : m_statuses) {
+        clearBit(bitmap, ordinal);
+    }
+}
+
+/**
+ * @brief Ordinals of the set bits of a bitmap, ascending
+ */
+ResourceIndex::Ordinals ResourceIndex::ordinals(const Bitmap& bitmap, std::pmr::memory_resource* memory) const {
+    Ordinals result(memory);
+    std::size_t count = 0;
+    for (quint64 word : bitmap) {
+        count += static_cast<std::size_t>(qPopulationCount(word));
+    }
+    result.reserve(count);
+    for (std::size_t word = 0; word < bitmap.size(); ++word) {
+        quint64 bits = bitmap[word];
+        while (bits) {
+            result.push_back(static_cast<quint32>(word * 64 + qCountTrailingZeroBits(bits)));
+            bits &= bits - 1;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Set a bit, growing the bitmap as needed
+ */
+void ResourceIndex::setBit(Bitmap& bitmap, quint32 ordinal) {
+    const std::size_t word = ordinal / 64;
+    if (word >= bitmap.size()) {
+        bitmap.resize(word + 1, 0);
+    }
+    bitmap[word] |= quint64(1) << (ordinal % 64);
+}
+
+/**
+ * @brief Clear a bit
+ */
+void ResourceIndex::clearBit(Bitmap& bitmap, quint32 ordinal) {
+    const std::size_t word = ordinal / 64;
+    if (word < bitmap.size()) {
+        bitmap[word] &= ~(quint64(1) << (ordinal % 64));
+    }
+}
+
+/**
+ * @brief Test a bit
+ */
+bool ResourceIndex::testBit(const Bitmap& bitmap, quint32 ordinal) {
+    const std::size_t word = ordinal / 64;
+    return word < bitmap.size() && (bitmap[word] & (quint64(1) << (ordinal % 64)));
+}
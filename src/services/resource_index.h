@@ -0,0 +1,102 @@
+#ifndef RESOURCE_INDEX_H
+#define RESOURCE_INDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QIODevice>
+#include <array>
+#include <vector>
+#include <memory_resource>
+#include <limits>
+
+#include "../models/resource.h"
+
+/**
+ * @brief Search and filter index over the resource catalog
+ *
+ * Resources get an ordinal when first indexed; the index maps IDs to
+ * ordinals and back, keeps a trigram inverted index over the lowercased
+ * title, author and description, and one bitmap per category and status.
+ * Ordinals are never reused: removing a resource clears its bit in the
+ * live bitmap, so nothing else has to be renumbered.
+ *
+ * Text postings may over-report. An edit adds the new text's trigrams
+ * without removing the old ones, so callers confirm every candidate
+ * against the resource itself. Text searches therefore never miss a
+ * match, and the bitmaps are exact.
+ *
+ * Queries take the memory resource their ordinal lists and scratch
+ * space come from, so a caller's monotonic buffer serves the whole query.
+ *
+ * The index can be written to a sidecar file and read back. The file
+ * names the data it was built from, so a reader can reject a stale
+ * sidecar, and a CRC catches damaged ones.
+ */
+class ResourceIndex {
+public:
+    using Bitmap = std::vector<quint64>;
+    using Ordinals = std::pmr::vector<quint32>;
+
+    static constexpr quint32 FormatVersion = 1;
+    static constexpr quint32 NotFound = std::numeric_limits<quint32>::max();
+    static constexpr qsizetype MinQueryLength = 3; // Shorter queries have no trigram to look up
+
+    ResourceIndex() = default;
+
+    // Maintenance
+    void clear();
+    void reserve(qsizetype count);
+    void add(const Resource& resource); // Re-indexes a known ID
+    void remove(const QString& resourceId);
+
+    // Queries, as ascending ordinals of live resources; search() returns candidates to confirm
+    static bool canSearch(const QString& query) { return query.size() >= MinQueryLength; }
+    Ordinals search(const QString& query,
+                    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const;
+    Ordinals withCategory(Resource::Category category,
+                          std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const;
+    Ordinals withStatus(Resource::Status status,
+                        std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const;
+
+    // Information
+    QString idAt(quint32 ordinal) const { return ordinal < quint32(m_ids.size()) ? m_ids.at(ordinal) : QString(); }
+    quint32 ordinalOf(const QString& resourceId) const { return m_ordinals.value(resourceId, NotFound); }
+    qsizetype liveCount() const { return m_liveCount; }
+    qsizetype ordinalCount() const { return m_ids.size(); }
+    const QStringList& ids() const { return m_ids; }
+
+    // Sidecar files; sourceKey names the data the index describes
+    bool write(QIODevice& device, const QString& sourceKey) const;
+    bool read(QIODevice& device, const QString& expectedKey);
+    QString getLastError() const { return m_lastError; }
+
+private:
+    static constexpr std::size_t CategoryCount = static_cast<std::size_t>(Resource::Category::Other) + 1;
+    static constexpr std::size_t StatusCount = static_cast<std::size_t>(Resource::Status::Lost) + 1;
+
+    QStringList m_ids; // By ordinal
+    QHash<QString, quint32> m_ordinals;
+    std::vector<quint64> m_textHashes; // Of the text each ordinal was last indexed with
+    QHash<quint64, QList<quint32>> m_trigrams; // Ascending ordinals per trigram
+    Bitmap m_live;
+    std::array<Bitmap, CategoryCount> m_categories;
+    std::array<Bitmap, StatusCount> m_statuses;
+    qsizetype m_liveCount = 0;
+    QString m_lastError;
+
+    static QString searchableText(const Resource& resource);
+    static quint64 textHash(const QString& text);
+    static std::pmr::vector<quint64> trigrams(const QString& lowerText,
+                                              std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    void indexText(quint32 ordinal, const QString& lowerText);
+    void clearBits(quint32 ordinal);
+    Ordinals ordinals(const Bitmap& bitmap, std::pmr::memory_resource* memory) const;
+
+    static void setBit(Bitmap& bitmap, quint32 ordinal);
+    static void clearBit(Bitmap& bitmap, quint32 ordinal);
+    static bool testBit(const Bitmap& bitmap, quint32 ordinal);
+};
+
+#endif // RESOURCE_INDEX_H
@@ -0,0 +1,129 @@
+#include "resource_store.h"
+#include <algorithm>
+
+namespace {
+    template <typename T>
+    bool eraseFromSegment(std::vector<T*>& segment, const Resource* resource) {
+        auto it = std::find(segment.begin(), segment.end(), resource);
+        if (it == segment.end()) {
+            return false;
+        }
+        segment.erase(it);
+        return true;
+    }
+
+    template <typename T>
+    std::size_t countStatusInSegment(const std::vector<T*>& segment, Resource::Status status) {
+        return static_cast<std::size_t>(std::count_if(segment.begin(), segment.end(),
+                                                      [status](const T* resource) {
+                                                          return resource->getStatus() == status;
+                                                      }));
+    }
+}
+
+/**
+ * @brief Add a resource to the segment matching its kind
+ */
+void ResourceStore::add(Resource* resource) {
+    if (!resource) {
+        return;
+    }
+    
+    switch (resource->getKind()) {
+        case Resource::Kind::Book:
+            m_books.push_back(static_cast<Book*>(resource));
+            break;
+        case Resource::Kind::Article:
+            m_articles.push_back(static_cast<Article*>(resource));
+            break;
+        case Resource::Kind::Thesis:
+            m_theses.push_back(static_cast<Thesis*>(resource));
+            break;
+        case Resource::Kind::DigitalContent:
+            m_digitalContent.push_back(static_cast<DigitalContent*>(resource));
+            break;
+    }
+}
+
+/**
+ * @brief Remove a resource from its segment
+ */
+bool ResourceStore::remove(const Resource* resource) {
+    if (!resource) {
+        return false;
+    }
+    
+    switch (resource->getKind()) {
+        case Resource::Kind::Book: return eraseFromSegment(m_books, resource);
+        case Resource::Kind::Article: return eraseFromSegment(m_articles, resource);
+        case Resource::Kind::Thesis: return eraseFromSegment(m_theses, resource);
+        case Resource::Kind::DigitalContent: return eraseFromSegment(m_digitalContent, resource);
+    }
+    return false;
+}
+
+/**
+ * @brief Remove all resources from the store
+ */
+void ResourceStore::clear() {
+    m_books.clear();
+    m_articles.clear();
+    m_theses.clear();
+    m_digitalContent.clear();
+}
+
+/**
+ * @brief Reserve capacity in one segment
+ */
+void ResourceStore::reserve(Resource::Kind kind, std::size_t count) {
+    switch (kind) {
+        case Resource::Kind::Book: m_books.reserve(count); break;
+        case Resource::Kind::Article: m_articles.reserve(count); break;
+        case Resource::Kind::Thesis: m_theses.reserve(count); break;
+        case Resource::Kind::DigitalContent: m_digitalContent.reserve(count); break;
+    }
+}
+
+/**
+ * @brief Get the total number of resources
+ */
+std::size_t ResourceStore::size() const {
+    return m_books.size() + m_articles.size() + m_theses.size() + m_digitalContent.size();
+}
+
+/**
+ * @brief Get the number of resources of one kind
+ */
+std::size_t ResourceStore::count(Resource::Kind kind) const {
+    switch (kind) {
+        case Resource::Kind::Book: return m_books.size();
+        case Resource::Kind::Article: return m_articles.size();
+        case Resource::Kind::Thesis: return m_theses.size();
+        case Resource::Kind::DigitalContent: return m_digitalContent.size();
+    }
+    return 0;
+}
+
+/**
+ * @brief Count resources of one kind with a given status
+ */
+std::size_t ResourceStore::countByStatus(Resource::Kind kind, Resource::Status status) const {
+    switch (kind) {
+        case Resource::Kind::Book: return countStatusInSegment(m_books, status);
+        case Resource::Kind::Article: return countStatusInSegment(m_articles, status);
+        case Resource::Kind::Thesis: return countStatusInSegment(m_theses, status);
+        case Resource::Kind::DigitalContent: return countStatusInSegment(m_digitalContent, status);
+    }
+    return 0;
+}
+
+/**
+ * @brief Count resources with a given status across all kinds
+ */
+std::size_t ResourceStore::countByStatus(Resource::Status status) const {
+    std::size_t total = 0;
+    forEachSegment([&total, status](const auto& segment) {
+        total += countStatusInSegment(segment, status);
+    });
+    return total;
+}
@@ -0,0 +1,80 @@
+#ifndef RESOURCE_STORE_H
+#define RESOURCE_STORE_H
+
+#include <vector>
+#include <cstddef>
+
+#include "../models/resource.h"
+#include "../models/book.h"
+#include "../models/article.h"
+#include "../models/thesis.h"
+#include "../models/digitalcontent.h"
+
+/**
+ * @brief Type-segregated view over the library's resources
+ * 
+ * Resources are grouped into one contiguous pointer segment per concrete
+ * type, keyed by the Resource::Kind tag. Bulk operations (serialization,
+ * filtering, reporting) switch on the type once per segment and then run
+ * a tight loop over statically typed objects; since the concrete classes
+ * are final, the compiler can devirtualize calls such as toJson().
+ * 
+ * The store does not own the resources; LibraryManager keeps ownership and
+ * keeps the store in sync on add and remove.
+ */
+class ResourceStore {
+private:
+    std::vector<Book*> m_books;
+    std::vector<Article*> m_articles;
+    std::vector<Thesis*> m_theses;
+    std::vector<DigitalContent*> m_digitalContent;
+
+public:
+    ResourceStore() = default;
+
+    // Maintenance
+    void add(Resource* resource);
+    bool remove(const Resource* resource);
+    void clear();
+    void reserve(Resource::Kind kind, std::size_t count);
+
+    // Typed segments
+    const std::vector<Book*>& books() const { return m_books; }
+    const std::vector<Article*>& articles() const { return m_articles; }
+    const std::vector<Thesis*>& theses() const { return m_theses; }
+    const std::vector<DigitalContent*>& digitalContent() const { return m_digitalContent; }
+
+    // Counts
+    std::size_t size() const;
+    std::size_t count(Resource::Kind kind) const;
+    std::size_t countByStatus(Resource::Kind kind, Resource::Status status) const;
+    std::size_t countByStatus(Resource::Status status) const; // Across every segment
+
+    /**
+     * @brief Invoke visitor once per typed segment
+     * 
+     * The visitor receives each segment as a const std::vector<T*>&,
+     * so a generic lambda is instantiated once per concrete type.
+     */
+    template <typename Visitor>
+    void forEachSegment(Visitor&& visitor) const {
+        visitor(m_books);
+        visitor(m_articles);
+        visitor(m_theses);
+        visitor(m_digitalContent);
+    }
+
+    /**
+     * @brief Invoke fn on every resource, statically typed per segment
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        forEachSegment([&fn](const auto& segment) {
+            for (auto* resource : segment) {
+                fn(*resource);
+            }
+        });
+    }
+};
+
+#endif // RESOURCE_STORE_H
@@ -0,0 +1,775 @@
+#include "sqlite_storage_backend.h"
+#include "library_manager.h"
+#include "persistence_service.h"
+#include "../models/resource.h"
+#include "../models/user.h"
+#include "../models/loan.h"
+#include "../models/reservation.h"
+#include <QSqlError>
+#include <QJsonDocument>
+#include <QFile>
+#include <QDebug>
+
+namespace {
+
+constexpr int SchemaVersion = 1;
+
+// Tables by ChangeTracker::indexOf
+constexpr std::array<const char*, ChangeTracker::CollectionCount> TableNames = {
+    "resources", "users", "loans", "reservations", "configuration"
+};
+
+const QStringList SchemaStatements = {
+    "CREATE TABLE IF NOT EXISTS resources (id TEXT PRIMARY KEY, category TEXT NOT NULL, json TEXT NOT NULL)",
+    "CREATE TABLE IF NOT EXISTS users (id TEXT PRIMARY KEY, json TEXT NOT NULL)",
+    "CREATE TABLE IF NOT EXISTS loans (id TEXT PRIMARY KEY, user_id TEXT NOT NULL, resource_id TEXT NOT NULL, "
+    "active INTEGER NOT NULL, period TEXT NOT NULL, category TEXT NOT NULL, json TEXT NOT NULL)",
+    "CREATE INDEX IF NOT EXISTS loans_user ON loans (user_id)",
+    "CREATE INDEX IF NOT EXISTS loans_resource ON loans (resource_id)",
+    "CREATE INDEX IF NOT EXISTS loans_period ON loans (active, period)",
+    "CREATE TABLE IF NOT EXISTS reservations (id TEXT PRIMARY KEY, user_id TEXT NOT NULL, "
+    "resource_id TEXT NOT NULL, active INTEGER NOT NULL, period TEXT NOT NULL, category TEXT NOT NULL, "
+    "json TEXT NOT NULL)",
+    "CREATE INDEX IF NOT EXISTS reservations_user ON reservations (user_id)",
+    "CREATE INDEX IF NOT EXISTS reservations_resource ON reservations (resource_id)",
+    "CREATE INDEX IF NOT EXISTS reservations_period ON reservations (active, period)",
+    "CREATE TABLE IF NOT EXISTS configuration (id INTEGER PRIMARY KEY CHECK (id = 1), json TEXT NOT NULL)"
+};
+
+/**
+ * @brief Table holding a collection
+ */
+QString tableName(ChangeTracker::Collection collection) {
+    return QLatin1String(TableNames[ChangeTracker::indexOf(collection)]);
+}
+
+/**
+ * @brief Compact JSON text of an entity, as stored in the json columns
+ */
+QString jsonText(const QJsonObject& object) {
+    return QString::fromUtf8(QJsonDocument(object).toJson(QJsonDocument::Compact));
+}
+
+} // namespace
+
+/**
+ * @brief Constructor for SqliteStorageBackend; the database is opened on first use
+ */
+SqliteStorageBackend::SqliteStorageBackend(const QString& databasePath)
+    : m_databasePath(databasePath),
+      m_connectionName(QString("ensiary-sqlite-%1").arg(reinterpret_cast<quintptr>(this), 0, 16)),
+      m_trackedSource(nullptr) {
+    m_savedRevisions.fill(0);
+}
+
+/**
+ * @brief Destructor for SqliteStorageBackend
+ */
+SqliteStorageBackend::~SqliteStorageBackend() {
+    close();
+}
+
+/**
+ * @brief Open the database, switch it to WAL mode and create the schema if needed
+ */
+bool SqliteStorageBackend::open() {
+    if (isOpen()) {
+        return true;
+    }
+    m_lastError.clear();
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+        db.setDatabaseName(m_databasePath);
+        if (!db.open()) {
+            setError(QString("Cannot open database %1: %2").arg(m_databasePath, db.lastError().text()));
+        } else {
+            // WAL lets readers run during writes; FULL makes each commit durable
+            QSqlQuery pragma(db);
+            if (!pragma.exec("PRAGMA journal_mode = WAL") || !pragma.exec("PRAGMA synchronous = FULL")) {
+                setError("Cannot configure database: " + pragma.lastError().text());
+            } else if (createSchema()) {
+                return true;
+            }
+        }
+    }
+
+    close();
+    return false;
+}
+
+/**
+ * @brief Close the database; prepared statements are dropped
+ */
+void SqliteStorageBackend::close() {
+    m_statements.clear();
+    if (!QSqlDatabase::contains(m_connectionName)) {
+        return;
+    }
+    {
+        QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+/**
+ * @brief Check whether the database is open
+ */
+bool SqliteStorageBackend::isOpen() const {
+    return QSqlDatabase::contains(m_connectionName) && database().isOpen();
+}
+
+/**
+ * @brief Load configuration, resources, users and the active loans and reservations
+ *
+ * History stays in the database; the manager gets SqliteHistory sources
+ * over it instead.
+ */
+bool SqliteStorageBackend::loadLibrary(LibraryManager& libraryManager, std::vector<LoadConflict>& conflicts) {
+    if (!open()) {
+        return false;
+    }
+
+    auto record = [&conflicts](std::vector<LoadConflict> loaded) {
+        for (LoadConflict& conflict : loaded) {
+            qDebug() << "Skipped while loading:" << conflict.message;
+            conflicts.push_back(std::move(conflict));
+        }
+    };
+
+    // Rows that no longer decode are reported like the loaders' invalid entries
+    auto decode = [&conflicts](ChangeTracker::Collection collection, const std::vector<QJsonObject>& rows,
+                               auto factory, auto& entities) {
+        for (const QJsonObject& row : rows) {
+            try {
+                if (auto entity = factory(row)) {
+                    entities.push_back(std::move(entity));
+                    continue;
+                }
+            } catch (const std::exception&) {
+            }
+            conflicts.push_back({collection, QString(), LoadConflict::Reason::InvalidData,
+                                 "Unreadable row in table " + tableName(collection)});
+        }
+    };
+
+    std::vector<QJsonObject> configuration = selectJson("SELECT json FROM configuration WHERE id = 1");
+    if (!configuration.empty()) {
+        PersistenceService::applyConfiguration(libraryManager, configuration.front());
+    }
+
+    std::vector<std::unique_ptr<Resource>> resources;
+    decode(ChangeTracker::Collection::Resources, selectJson("SELECT json FROM resources ORDER BY rowid"),
+           &PersistenceService::createResourceFromJson, resources);
+    record(libraryManager.bulkLoadResources(std::move(resources)));
+
+    std::vector<std::unique_ptr<User>> users;
+    decode(ChangeTracker::Collection::Users, selectJson("SELECT json FROM users ORDER BY rowid"),
+           &PersistenceService::createUserFromJson, users);
+    record(libraryManager.bulkLoadUsers(std::move(users)));
+
+    std::vector<std::unique_ptr<Loan>> activeLoans;
+    decode(ChangeTracker::Collection::Loans, selectJson("SELECT json FROM loans WHERE active = 1 ORDER BY rowid"),
+           &PersistenceService::createLoanFromJson, activeLoans);
+    record(libraryManager.bulkLoadLoans(std::move(activeLoans), {}));
+
+    std::vector<std::unique_ptr<Reservation>> activeReservations;
+    decode(ChangeTracker::Collection::Reservations,
+           selectJson("SELECT json FROM reservations WHERE active = 1 ORDER BY rowid"),
+           &PersistenceService::createReservationFromJson, activeReservations);
+    record(libraryManager.bulkLoadReservations(std::move(activeReservations), {}));
+
+    libraryManager.attachHistoryArchives(
+        std::make_shared<SqliteHistory<Loan>>(shared_from_this(), ChangeTracker::Collection::Loans,
+                                              &PersistenceService::createLoanFromJson),
+        std::make_shared<SqliteHistory<Reservation>>(shared_from_this(), ChangeTracker::Collection::Reservations,
+                                                     &PersistenceService::createReservationFromJson));
+
+    markSaved(libraryManager.getChangeTracker());
+    return m_lastError.isEmpty();
+}
+
+/**
+ * @brief Write the entities that changed since the last load or save, in one transaction
+ */
+bool SqliteStorageBackend::saveLibrary(const LibraryManager& libraryManager) {
+    if (m_trackedSource != &libraryManager.getChangeTracker()) {
+        return replaceLibrary(libraryManager);
+    }
+    if (!open() || !begin()) {
+        return false;
+    }
+
+    if (!writeChangedEntities(libraryManager, false) || !commit()) {
+        rollback();
+        return false;
+    }
+    markSaved(libraryManager.getChangeTracker());
+    return true;
+}
+
+/**
+ * @brief Replace the stored library with the manager's, including all of its history
+ */
+bool SqliteStorageBackend::replaceLibrary(const LibraryManager& libraryManager) {
+    if (!open() || !begin()) {
+        return false;
+    }
+
+    if (!writeChangedEntities(libraryManager, true) || !commit()) {
+        rollback();
+        return false;
+    }
+    markSaved(libraryManager.getChangeTracker());
+    return true;
+}
+
+/**
+ * @brief Apply one operation's entity changes as a single durable transaction
+ */
+bool SqliteStorageBackend::applyChanges(const std::vector<CirculationJournal::EntityChange>& changes) {
+    if (changes.empty()) {
+        return true;
+    }
+    if (!open() || !begin()) {
+        return false;
+    }
+
+    bool success = true;
+    try {
+        for (const CirculationJournal::EntityChange& change : changes) {
+            if (change.type == CirculationJournal::ChangeType::Remove) {
+                success = removeEntity(change.collection, change.entityId);
+            } else {
+                switch (change.collection) {
+                    case ChangeTracker::Collection::Resources:
+                        if (auto resource = PersistenceService::createResourceFromJson(change.state)) {
+                            success = writeResource(*resource);
+                        }
+                        break;
+                    case ChangeTracker::Collection::Users:
+                        if (auto user = PersistenceService::createUserFromJson(change.state)) {
+                            success = writeUser(*user);
+                        }
+                        break;
+                    case ChangeTracker::Collection::Loans:
+                        if (auto loan = PersistenceService::createLoanFromJson(change.state)) {
+                            success = writeLoan(*loan);
+                        }
+                        break;
+                    case ChangeTracker::Collection::Reservations:
+                        if (auto reservation = PersistenceService::createReservationFromJson(change.state)) {
+                            success = writeReservation(*reservation);
+                        }
+                        break;
+                    case ChangeTracker::Collection::Configuration:
+                        break;
+                }
+            }
+            if (!success) {
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        setError(QString("Cannot store operation: %1").arg(e.what()));
+        success = false;
+    }
+
+    if (!success || !commit()) {
+        rollback();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Fold the write-ahead log into the database file, which is then all there is to copy
+ */
+bool SqliteStorageBackend::checkpoint(QStringList& filePaths) {
+    filePaths.clear();
+    if (isOpen()) {
+        QSqlQuery query(database());
+        if (!query.exec("PRAGMA wal_checkpoint(TRUNCATE)")) {
+            setError("Cannot checkpoint database: " + query.lastError().text());
+            return false;
+        }
+    }
+    if (QFile::exists(m_databasePath)) {
+        filePaths << m_databasePath;
+    }
+    return true;
+}
+
+/**
+ * @brief Read history rows (active = 0) of a table through its indexes
+ * @param key User, resource or entity ID, the first period of a range, or a row count
+ * @param lastKey Last period of a range
+ */
+std::vector<QJsonObject> SqliteStorageBackend::queryHistory(ChangeTracker::Collection collection,
+                                                            HistoryQuery query, const QString& key,
+                                                            const QString& lastKey) {
+    QString sql = "SELECT json FROM " + tableName(collection) + " WHERE active = 0";
+    switch (query) {
+        case HistoryQuery::All:
+            break;
+        case HistoryQuery::ByUser:
+            sql += " AND user_id = ?";
+            break;
+        case HistoryQuery::ByResource:
+            sql += " AND resource_id = ?";
+            break;
+        case HistoryQuery::ByPeriods:
+            sql += " AND (period = '' OR period BETWEEN ? AND ?)";
+            break;
+        case HistoryQuery::ById:
+            sql += " AND id = ?";
+            break;
+        case HistoryQuery::Newest:
+            break;
+    }
+    sql += query == HistoryQuery::Newest ? " ORDER BY period DESC, rowid DESC LIMIT ?" : " ORDER BY period, rowid";
+
+    std::vector<QJsonObject> rows;
+    QSqlQuery* statement = prepared(sql);
+    if (!statement) {
+        return rows;
+    }
+    if (query == HistoryQuery::Newest) {
+        statement->bindValue(0, key.toLongLong());
+    } else if (query != HistoryQuery::All) {
+        statement->bindValue(0, key);
+    }
+    if (query == HistoryQuery::ByPeriods) {
+        statement->bindValue(1, lastKey);
+    }
+    if (!exec(statement)) {
+        return rows;
+    }
+    while (statement->next()) {
+        rows.push_back(QJsonDocument::fromJson(statement->value(0).toString().toUtf8()).object());
+    }
+    statement->finish();
+    if (query == HistoryQuery::Newest) {
+        std::reverse(rows.begin(), rows.end());
+    }
+    return rows;
+}
+
+/**
+ * @brief Count history rows of a range of periods per user, resource and category
+ */
+HistorySummary SqliteStorageBackend::summarizeHistory(ChangeTracker::Collection collection,
+                                                      const QString& firstPeriod, const QString& lastPeriod) {
+    HistorySummary summary;
+    const std::array<std::pair<const char*, QHash<QString, qint64>*>, 3> groups = {{
+        {"user_id", &summary.byUser}, {"resource_id", &summary.byResource}, {"category", &summary.byCategory}
+    }};
+
+    for (const auto& [column, counts] : groups) {
+        QSqlQuery* statement = prepared(QString("SELECT %1, COUNT(*) FROM %2 WHERE active = 0 AND period <> '' "
+                                                "AND period BETWEEN ? AND ? GROUP BY %1")
+                                            .arg(QLatin1String(column), tableName(collection)));
+        if (!statement) {
+            return HistorySummary();
+        }
+        statement->bindValue(0, firstPeriod);
+        statement->bindValue(1, lastPeriod);
+        if (!exec(statement)) {
+            return HistorySummary();
+        }
+        while (statement->next()) {
+            const QString key = statement->value(0).toString();
+            if (!key.isEmpty()) {
+                counts->insert(key, statement->value(1).toLongLong());
+            }
+        }
+        statement->finish();
+    }
+
+    for (qint64 count : std::as_const(summary.byUser)) {
+        summary.records += count;
+    }
+    return summary;
+}
+
+/**
+ * @brief Check whether a history row exists
+ */
+bool SqliteStorageBackend::containsHistory(ChangeTracker::Collection collection, const QString& id) {
+    QSqlQuery* statement = prepared("SELECT 1 FROM " + tableName(collection) + " WHERE id = ? AND active = 0");
+    if (!statement) {
+        return false;
+    }
+    statement->bindValue(0, id);
+    bool found = exec(statement) && statement->next();
+    statement->finish();
+    return found;
+}
+
+// Private helper methods
+
+/**
+ * @brief Handle of this backend's connection
+ */
+QSqlDatabase SqliteStorageBackend::database() const {
+    return QSqlDatabase::database(m_connectionName, false);
+}
+
+/**
+ * @brief Create tables and indexes, refusing databases written by a newer schema
+ */
+bool SqliteStorageBackend::createSchema() {
+    QSqlDatabase db = database();
+    QSqlQuery query(db);
+    if (!query.exec("PRAGMA user_version") || !query.next()) {
+        setError("Cannot read database schema version: " + query.lastError().text());
+        return false;
+    }
+    const int version = query.value(0).toInt();
+    query.finish();
+    if (version > SchemaVersion) {
+        setError(QString("Database %1 has a newer schema (version %2)").arg(m_databasePath).arg(version));
+        return false;
+    }
+
+    if (!db.transaction()) {
+        setError("Cannot create database schema: " + db.lastError().text());
+        return false;
+    }
+    for (const QString& statement : SchemaStatements) {
+        if (!query.exec(statement)) {
+            setError("Cannot create database schema: " + query.lastError().text());
+            db.rollback();
+            return false;
+        }
+    }
+    if (!query.exec(QString("PRAGMA user_version = %1").arg(SchemaVersion)) || !db.commit()) {
+        setError("Cannot create database schema: " + db.lastError().text());
+        db.rollback();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Get the statement for some SQL, preparing it on first use
+ */
+QSqlQuery* SqliteStorageBackend::prepared(const QString& sql) {
+    auto it = m_statements.find(sql);
+    if (it == m_statements.end()) {
+        QSqlQuery query(database());
+        if (!query.prepare(sql)) {
+            setError(QString("Cannot prepare statement: %1 (%2)").arg(sql, query.lastError().text()));
+            return nullptr;
+        }
+        it = m_statements.emplace(sql, std::move(query)).first;
+    }
+    return &it->second;
+}
+
+/**
+ * @brief Execute a prepared statement with its bound values
+ */
+bool SqliteStorageBackend::exec(QSqlQuery* query) {
+    if (!query->exec()) {
+        setError("Database statement failed: " + query->lastError().text());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Begin a transaction
+ */
+bool SqliteStorageBackend::begin() {
+    QSqlDatabase db = database();
+    if (!db.transaction()) {
+        setError("Cannot begin transaction: " + db.lastError().text());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Commit the current transaction
+ */
+bool SqliteStorageBackend::commit() {
+    QSqlDatabase db = database();
+    if (!db.commit()) {
+        setError("Cannot commit transaction: " + db.lastError().text());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Roll back the current transaction
+ */
+void SqliteStorageBackend::rollback() {
+    database().rollback();
+}
+
+/**
+ * @brief Record the tracker's current revisions as stored
+ */
+void SqliteStorageBackend::markSaved(const ChangeTracker& tracker) {
+    m_trackedSource = &tracker;
+    for (std::size_t i = 0; i < ChangeTracker::CollectionCount; ++i) {
+        m_savedRevisions[i] = tracker.revision(static_cast<ChangeTracker::Collection>(i));
+    }
+}
+
+/**
+ * @brief Store the configuration row
+ */
+bool SqliteStorageBackend::writeConfiguration(const LibraryManager& libraryManager) {
+    QSqlQuery* query = prepared("INSERT INTO configuration (id, json) VALUES (1, ?) "
+                                "ON CONFLICT(id) DO UPDATE SET json = excluded.json");
+    if (!query) {
+        return false;
+    }
+    query->bindValue(0, jsonText(PersistenceService::configurationJson(libraryManager)));
+    return exec(query);
+}
+
+/**
+ * @brief Insert or update a resource row
+ */
+bool SqliteStorageBackend::writeResource(const Resource& resource) {
+    QSqlQuery* query = prepared("INSERT INTO resources (id, category, json) VALUES (?, ?, ?) "
+                                "ON CONFLICT(id) DO UPDATE SET category = excluded.category, json = excluded.json");
+    if (!query) {
+        return false;
+    }
+    query->bindValue(0, resource.getId());
+    query->bindValue(1, Resource::categoryToString(resource.getCategory()));
+    query->bindValue(2, jsonText(resource.toJson()));
+    return exec(query);
+}
+
+/**
+ * @brief Insert or update a user row
+ */
+bool SqliteStorageBackend::writeUser(const User& user) {
+    QSqlQuery* query = prepared("INSERT INTO users (id, json) VALUES (?, ?) "
+                                "ON CONFLICT(id) DO UPDATE SET json = excluded.json");
+    if (!query) {
+        return false;
+    }
+    query->bindValue(0, user.getId());
+    query->bindValue(1, jsonText(user.toJson()));
+    return exec(query);
+}
+
+/**
+ * @brief Insert or update a loan row; returned loans become history of their completion month
+ */
+bool SqliteStorageBackend::writeLoan(const Loan& loan) {
+    QSqlQuery* query = prepared(
+        "INSERT INTO loans (id, user_id, resource_id, active, period, category, json) "
+        "VALUES (?, ?, ?, ?, ?, COALESCE((SELECT category FROM resources WHERE id = ?), ''), ?) "
+        "ON CONFLICT(id) DO UPDATE SET user_id = excluded.user_id, resource_id = excluded.resource_id, "
+        "active = excluded.active, period = excluded.period, category = excluded.category, json = excluded.json");
+    if (!query) {
+        return false;
+    }
+    // Same split as LibraryManager::restoreLoan
+    const bool active = loan.getStatus() != Loan::Status::Returned;
+    query->bindValue(0, loan.getLoanId());
+    query->bindValue(1, loan.getUserId());
+    query->bindValue(2, loan.getResourceId());
+    query->bindValue(3, active ? 1 : 0);
+    query->bindValue(4, active ? QString("") : HistoryPageFile::monthPartition(loan.getCompletionDateMSecs()));
+    query->bindValue(5, loan.getResourceId());
+    query->bindValue(6, jsonText(loan.toJson()));
+    return exec(query);
+}
+
+/**
+ * @brief Insert or update a reservation row
+ */
+bool SqliteStorageBackend::writeReservation(const Reservation& reservation) {
+    QSqlQuery* query = prepared(
+        "INSERT INTO reservations (id, user_id, resource_id, active, period, category, json) "
+        "VALUES (?, ?, ?, ?, '', '', ?) "
+        "ON CONFLICT(id) DO UPDATE SET user_id = excluded.user_id, resource_id = excluded.resource_id, "
+        "active = excluded.active, json = excluded.json");
+    if (!query) {
+        return false;
+    }
+    query->bindValue(0, reservation.getReservationId());
+    query->bindValue(1, reservation.getUserId());
+    query->bindValue(2, reservation.getResourceId());
+    query->bindValue(3, reservation.isActive() ? 1 : 0);
+    query->bindValue(4, jsonText(reservation.toJson()));
+    return exec(query);
+}
+
+/**
+ * @brief Delete one entity's row
+ */
+bool SqliteStorageBackend::removeEntity(ChangeTracker::Collection collection, const QString& id) {
+    QSqlQuery* query = prepared("DELETE FROM " + tableName(collection) + " WHERE id = ?");
+    if (!query) {
+        return false;
+    }
+    query->bindValue(0, id);
+    return exec(query);
+}
+
+/**
+ * @brief Delete the rows of a table whose IDs are not in keep
+ */
+bool SqliteStorageBackend::removeStale(ChangeTracker::Collection collection, const QSet<QString>& keep) {
+    QSqlQuery* query = prepared("SELECT id FROM " + tableName(collection));
+    if (!query || !exec(query)) {
+        return false;
+    }
+    QStringList stale;
+    while (query->next()) {
+        QString id = query->value(0).toString();
+        if (!keep.contains(id)) {
+            stale.append(id);
+        }
+    }
+    query->finish();
+
+    for (const QString& id : stale) {
+        if (!removeEntity(collection, id)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Write every changed entity (or every entity) inside the open transaction
+ *
+ * Resources and users the manager no longer has are deleted. Loans and
+ * reservations are never removed, only moved into history; a full write
+ * replaces the tables, history included.
+ */
+bool SqliteStorageBackend::writeChangedEntities(const LibraryManager& libraryManager, bool everything) {
+    using Collection = ChangeTracker::Collection;
+    const ChangeTracker& tracker = libraryManager.getChangeTracker();
+    auto collectionChanged = [&](Collection collection) {
+        return everything || tracker.revision(collection) != m_savedRevisions[ChangeTracker::indexOf(collection)];
+    };
+    auto entityChanged = [&](Collection collection, const QString& id) {
+        return everything ||
+               tracker.entityRevision(collection, id) > m_savedRevisions[ChangeTracker::indexOf(collection)];
+    };
+
+    // Full history first: with this backend's own sources attached it is read from the tables being replaced
+    std::vector<HistoryRecord<Loan>> loanHistory;
+    std::vector<HistoryRecord<Reservation>> reservationHistory;
+    if (everything) {
+        try {
+            loanHistory = libraryManager.getLoanHistory();
+            reservationHistory = libraryManager.getReservationHistory();
+        } catch (const HistoryArchiveException& e) {
+            setError("Cannot read history to store: " + e.getMessage());
+            return false;
+        }
+        for (const QString& table : {QString("loans"), QString("reservations")}) {
+            QSqlQuery* query = prepared("DELETE FROM " + table);
+            if (!query || !exec(query)) {
+                return false;
+            }
+        }
+    }
+
+    if (collectionChanged(Collection::Configuration) && !writeConfiguration(libraryManager)) {
+        return false;
+    }
+
+    if (collectionChanged(Collection::Resources)) {
+        QSet<QString> ids;
+        for (const Resource* resource : libraryManager.getAllResources()) {
+            ids.insert(resource->getId());
+            if (entityChanged(Collection::Resources, resource->getId()) && !writeResource(*resource)) {
+                return false;
+            }
+        }
+        if (!removeStale(Collection::Resources, ids)) {
+            return false;
+        }
+    }
+
+    if (collectionChanged(Collection::Users)) {
+        QSet<QString> ids;
+        for (const auto& user : libraryManager.getUserStorage()) {
+            ids.insert(user->getId());
+            if (entityChanged(Collection::Users, user->getId()) && !writeUser(*user)) {
+                return false;
+            }
+        }
+        if (!removeStale(Collection::Users, ids)) {
+            return false;
+        }
+    }
+
+    if (collectionChanged(Collection::Loans)) {
+        for (const auto& loan : libraryManager.getActiveLoanStorage()) {
+            if (entityChanged(Collection::Loans, loan->getLoanId()) && !writeLoan(*loan)) {
+                return false;
+            }
+        }
+        for (const auto& loan : libraryManager.getLoanHistoryStorage()) {
+            if (entityChanged(Collection::Loans, loan->getLoanId()) && !writeLoan(*loan)) {
+                return false;
+            }
+        }
+        for (const HistoryRecord<Loan>& loan : loanHistory) {
+            if (!writeLoan(*loan)) {
+                return false;
+            }
+        }
+    }
+
+    if (collectionChanged(Collection::Reservations)) {
+        for (const auto& reservation : libraryManager.getActiveReservationStorage()) {
+            if (entityChanged(Collection::Reservations, reservation->getReservationId()) &&
+                !writeReservation(*reservation)) {
+                return false;
+            }
+        }
+        for (const auto& reservation : libraryManager.getReservationHistoryStorage()) {
+            if (entityChanged(Collection::Reservations, reservation->getReservationId()) &&
+                !writeReservation(*reservation)) {
+                return false;
+            }
+        }
+        for (const HistoryRecord<Reservation>& reservation : reservationHistory) {
+            if (!writeReservation(*reservation)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Run a query without parameters and parse its single json column
+ */
+std::vector<QJsonObject> SqliteStorageBackend::selectJson(const QString& sql) {
+    std::vector<QJsonObject> rows;
+    QSqlQuery* query = prepared(sql);
+    if (!query || !exec(query)) {
+        return rows;
+    }
+    while (query->next()) {
+        rows.push_back(QJsonDocument::fromJson(query->value(0).toString().toUtf8()).object());
+    }
+    query->finish();
+    return rows;
+}
+
+/**
+ * @brief Set error message
+ */
+void SqliteStorageBackend::setError(const QString& error) {
+    m_lastError = error;
+    qDebug() << "SqliteStorageBackend Error:" << error;
+}
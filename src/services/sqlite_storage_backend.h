@@ -0,0 +1,200 @@
+#ifndef SQLITE_STORAGE_BACKEND_H
+#define SQLITE_STORAGE_BACKEND_H
+
+#include <QString>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSet>
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include "storage_backend.h"
+#include "history_archive.h"
+#include "change_tracker.h"
+
+class Resource;
+class User;
+class Loan;
+class Reservation;
+
+/**
+ * @brief StorageBackend on an embedded SQLite database (QtSql "QSQLITE")
+ *
+ * One row per entity, holding the entity's JSON next to the key columns
+ * queries filter on. Loans and reservations keep their history in the same
+ * tables (active = 0), indexed by user, resource and period (the loan's
+ * completion month, as in the history archives), so history is never loaded
+ * at startup: the manager gets SqliteHistory sources that query it.
+ *
+ * The database runs in WAL mode with synchronous=FULL. Every journaled
+ * operation is one transaction, durable once applyChanges() returns, and
+ * saves only write entities whose revision moved since the last load or
+ * save. Statements are prepared once per connection and reused.
+ */
+class SqliteStorageBackend : public StorageBackend, public std::enable_shared_from_this<SqliteStorageBackend> {
+public:
+    enum class HistoryQuery {
+        All,
+        ByUser,
+        ByResource,
+        ByPeriods, // Inclusive range of periods, plus rows without one
+        ById,
+        Newest // The last rows; key: how many
+    };
+
+    explicit SqliteStorageBackend(const QString& databasePath);
+    ~SqliteStorageBackend() override;
+
+    SqliteStorageBackend(const SqliteStorageBackend&) = delete;
+    SqliteStorageBackend& operator=(const SqliteStorageBackend&) = delete;
+
+    // StorageBackend
+    QString getName() const override { return "sqlite"; }
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+    bool loadLibrary(LibraryManager& libraryManager, std::vector<LoadConflict>& conflicts) override;
+    bool saveLibrary(const LibraryManager& libraryManager) override;
+    bool replaceLibrary(const LibraryManager& libraryManager) override;
+    bool applyChanges(const std::vector<CirculationJournal::EntityChange>& changes) override;
+    bool checkpoint(QStringList& filePaths) override;
+    QString getLastError() const override { return m_lastError; }
+
+    // History queries, oldest first (used by SqliteHistory)
+    std::vector<QJsonObject> queryHistory(ChangeTracker::Collection collection, HistoryQuery query,
+                                          const QString& key = QString(), const QString& lastKey = QString());
+    HistorySummary summarizeHistory(ChangeTracker::Collection collection, const QString& firstPeriod,
+                                    const QString& lastPeriod);
+    bool containsHistory(ChangeTracker::Collection collection, const QString& id);
+
+    QString getDatabasePath() const { return m_databasePath; }
+
+private:
+    QString m_databasePath;
+    QString m_connectionName;
+    std::map<QString, QSqlQuery> m_statements; // Prepared statements by SQL text
+    QString m_lastError;
+
+    // Revisions written by the last load or save, for the tracker they came from
+    const ChangeTracker* m_trackedSource;
+    std::array<quint64, ChangeTracker::CollectionCount> m_savedRevisions;
+
+    QSqlDatabase database() const;
+    bool createSchema();
+    QSqlQuery* prepared(const QString& sql);
+    bool exec(QSqlQuery* query);
+    bool begin();
+    bool commit();
+    void rollback();
+    void markSaved(const ChangeTracker& tracker);
+
+    bool writeConfiguration(const LibraryManager& libraryManager);
+    bool writeResource(const Resource& resource);
+    bool writeUser(const User& user);
+    bool writeLoan(const Loan& loan);
+    bool writeReservation(const Reservation& reservation);
+    bool removeEntity(ChangeTracker::Collection collection, const QString& id);
+    bool removeStale(ChangeTracker::Collection collection, const QSet<QString>& keep);
+    bool writeChangedEntities(const LibraryManager& libraryManager, bool everything);
+    std::vector<QJsonObject> selectJson(const QString& sql);
+
+    void setError(const QString& error);
+};
+
+/**
+ * @brief History of one table of an SqliteStorageBackend
+ *
+ * Every query is an indexed SELECT whose rows are decoded into records the
+ * caller owns. The source keeps its backend (and with it the connection)
+ * alive, even after PersistenceService has moved to another engine.
+ */
+template <typename T>
+class SqliteHistory : public HistorySource<T> {
+public:
+    using Factory = std::unique_ptr<T> (*)(const QJsonObject&);
+
+    SqliteHistory(std::shared_ptr<SqliteStorageBackend> backend, ChangeTracker::Collection collection,
+                  Factory factory)
+        : m_backend(std::move(backend)), m_collection(collection), m_factory(factory) {}
+
+    std::vector<HistoryRecord<T>> all(QSet<QString>& seen) override {
+        return decode(m_backend->queryHistory(m_collection, SqliteStorageBackend::HistoryQuery::All), seen);
+    }
+
+    // Rows already in `seen` are dropped after the query, so the query fetches that many more
+    std::vector<HistoryRecord<T>> newest(qsizetype count, QSet<QString>& seen) override {
+        std::vector<HistoryRecord<T>> records = decode(
+            m_backend->queryHistory(m_collection, SqliteStorageBackend::HistoryQuery::Newest,
+                                    QString::number(count + seen.size())), seen);
+        if (static_cast<qsizetype>(records.size()) > count) {
+            for (auto it = records.begin(); it != records.end() - count; ++it) {
+                seen.remove((*it)->getId());
+            }
+            records.erase(records.begin(), records.end() - count);
+        }
+        return records;
+    }
+
+    std::vector<HistoryRecord<T>> forUser(const QString& userId, QSet<QString>& seen) override {
+        return decode(m_backend->queryHistory(m_collection, SqliteStorageBackend::HistoryQuery::ByUser, userId),
+                      seen);
+    }
+
+    std::vector<HistoryRecord<T>> forResource(const QString& resourceId, QSet<QString>& seen) override {
+        return decode(m_backend->queryHistory(m_collection, SqliteStorageBackend::HistoryQuery::ByResource,
+                                              resourceId), seen);
+    }
+
+    std::vector<HistoryRecord<T>> forPartitions(const QString& firstPartition, const QString& lastPartition,
+                                                QSet<QString>& seen,
+                                                const std::function<bool(const T&)>& matches) override {
+        return decode(m_backend->queryHistory(m_collection, SqliteStorageBackend::HistoryQuery::ByPeriods,
+                                              firstPartition, lastPartition), seen, matches);
+    }
+
+    HistoryRecord<T> find(const QString& id) override {
+        QSet<QString> seen;
+        std::vector<HistoryRecord<T>> found = decode(
+            m_backend->queryHistory(m_collection, SqliteStorageBackend::HistoryQuery::ById, id), seen);
+        return found.empty() ? nullptr : found.front();
+    }
+
+    HistorySummary summarize(const QString& firstPartition, const QString& lastPartition) const override {
+        return m_backend->summarizeHistory(m_collection, firstPartition, lastPartition);
+    }
+
+    // Operations are written as they happen, so in-memory history is already stored
+    bool wasAppended(const QString& id) const override {
+        return m_backend->containsHistory(m_collection, id);
+    }
+
+private:
+    std::shared_ptr<SqliteStorageBackend> m_backend;
+    ChangeTracker::Collection m_collection;
+    Factory m_factory;
+
+    std::vector<HistoryRecord<T>> decode(const std::vector<QJsonObject>& rows, QSet<QString>& seen,
+                                         const std::function<bool(const T&)>& matches = {}) {
+        std::vector<HistoryRecord<T>> records;
+        for (const QJsonObject& row : rows) {
+            std::unique_ptr<T> record;
+            try {
+                record = m_factory(row);
+            } catch (const std::exception&) {
+                continue; // An unreadable row is left out rather than failing the query
+            }
+            if (!record || seen.contains(record->getId()) || (matches && !matches(*record))) {
+                continue;
+            }
+            seen.insert(record->getId());
+            records.push_back(std::move(record));
+        }
+        return records;
+    }
+};
+
+#endif // SQLITE_STORAGE_BACKEND_H
@@ -0,0 +1,48 @@
+#ifndef STORAGE_BACKEND_H
+#define STORAGE_BACKEND_H
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+#include "circulation_journal.h"
+#include "load_conflict.h"
+
+class LibraryManager;
+
+/**
+ * @brief Storage engine that PersistenceService can delegate to instead of its data files
+ *
+ * PersistenceService's own engine writes generations of collection files
+ * and journals operations in between. A backend replaces both: it loads and
+ * saves the library itself and receives every journaled operation's entity
+ * changes, which it applies as one durable transaction. Backends may keep
+ * history out of memory by attaching HistorySource objects to the manager
+ * when they load.
+ *
+ * Backends are used from the thread that owns the LibraryManager.
+ */
+class StorageBackend {
+public:
+    virtual ~StorageBackend() = default;
+
+    virtual QString getName() const = 0;
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    // Whole library
+    virtual bool loadLibrary(LibraryManager& libraryManager, std::vector<LoadConflict>& conflicts) = 0;
+    virtual bool saveLibrary(const LibraryManager& libraryManager) = 0; // What changed since the last load or save
+    virtual bool replaceLibrary(const LibraryManager& libraryManager) = 0; // Everything, dropping what was stored
+
+    // The entity changes of one operation, applied atomically and durably
+    virtual bool applyChanges(const std::vector<CirculationJournal::EntityChange>& changes) = 0;
+
+    // Make the backend's files self-contained for copying, and name them
+    virtual bool checkpoint(QStringList& filePaths) = 0;
+
+    virtual QString getLastError() const = 0;
+};
+
+#endif // STORAGE_BACKEND_H
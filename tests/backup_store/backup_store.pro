@@ -0,0 +1,15 @@
+QT += core testlib
+QT -= gui
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_backup_store
+TEMPLATE = app
+
+SOURCES += \
+    tst_backup_store.cpp \
+    ../../src/services/backup_store.cpp
+
+HEADERS += \
+    ../../src/services/backup_store.h
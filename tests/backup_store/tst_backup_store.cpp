@@ -0,0 +1,213 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QRandomGenerator>
+
+#include "../../src/services/backup_store.h"
+
+/**
+ * @brief Tests for the chunked backup store: round trips, deduplication and path safety
+ */
+class TestBackupStore : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void roundTrip();
+    void appendStoresOnlyTheTail();
+    void insertKeepsLaterChunks();
+    void importUnderOtherNames();
+    void rejectsPathIds();
+    void ignoresCatalogsWithPaths();
+    void detectsDamagedChunks();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_directory;
+
+    QString sourceDirectory() const { return m_directory->filePath("data"); }
+    QString storeDirectory() const { return m_directory->filePath("backups"); }
+    void writeSource(const QString& name, const QByteArray& contents);
+    int objectCount() const;
+    static QByteArray randomBytes(qsizetype size, quint32 seed);
+};
+
+void TestBackupStore::init() {
+    m_directory = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_directory->isValid());
+    QVERIFY(QDir().mkpath(sourceDirectory()));
+}
+
+void TestBackupStore::roundTrip() {
+    const QByteArray large = randomBytes(300 * 1024, 1);
+    const QByteArray small = "{\"type\": \"configuration\"}";
+    writeSource("loans.json", large);
+    writeSource("config.json", small);
+    writeSource("empty.json", QByteArray());
+
+    BackupStore store(storeDirectory());
+    QVERIFY2(store.create("first", sourceDirectory(), {"loans.json", "config.json", "empty.json"}),
+             qPrintable(store.getLastError()));
+
+    BackupStore::Backup backup;
+    QVERIFY(store.find("first", backup));
+    QCOMPARE(backup.files.size(), std::size_t(3));
+    QVERIFY(store.verify(backup));
+
+    // Chunks stay within the bounds, so a large file is several of them
+    QVERIFY(backup.files[0].chunks.size() >= std::size_t(large.size() / BackupStore::MaxChunkSize));
+    QVERIFY(backup.files[0].chunks.size() <= std::size_t(large.size() / BackupStore::MinChunkSize));
+
+    QByteArray contents;
+    QVERIFY(store.readFile(backup.files[0], contents));
+    QCOMPARE(contents, large);
+    QVERIFY(store.readFile(backup.files[1], contents));
+    QCOMPARE(contents, small);
+    QVERIFY(store.readFile(backup.files[2], contents));
+    QVERIFY(contents.isEmpty());
+
+    QCOMPARE(store.list().size(), std::size_t(1));
+}
+
+void TestBackupStore::appendStoresOnlyTheTail() {
+    QByteArray contents = randomBytes(512 * 1024, 2);
+    writeSource("loan_history.pages", contents);
+
+    BackupStore store(storeDirectory());
+    QVERIFY(store.create("before", sourceDirectory(), {"loan_history.pages"}));
+    const int objectsBefore = objectCount();
+
+    contents.append(randomBytes(4 * 1024, 3));
+    writeSource("loan_history.pages", contents);
+    QVERIFY(store.create("after", sourceDirectory(), {"loan_history.pages"}));
+
+    // Boundaries before the old end do not move: only the old tail chunk is redone, and
+    // 4 KiB past it holds at most two more chunks of MinChunkSize
+    QVERIFY(objectCount() - objectsBefore <= 3);
+
+    BackupStore::Backup backup;
+    QVERIFY(store.find("after", backup));
+    QByteArray restored;
+    QVERIFY(store.readFile(backup.files[0], restored));
+    QCOMPARE(restored, contents);
+}
+
+void TestBackupStore::insertKeepsLaterChunks() {
+    QByteArray contents = randomBytes(512 * 1024, 4);
+    writeSource("resources.json", contents);
+
+    BackupStore store(storeDirectory());
+    QVERIFY(store.create("before", sourceDirectory(), {"resources.json"}));
+    BackupStore::Backup before;
+    QVERIFY(store.find("before", before));
+
+    contents.insert(100 * 1024, randomBytes(100, 5));
+    writeSource("resources.json", contents);
+    QVERIFY(store.create("after", sourceDirectory(), {"resources.json"}));
+    BackupStore::Backup after;
+    QVERIFY(store.find("after", after));
+
+    // The content-defined boundaries resynchronize after the edit
+    const std::vector<QByteArray>& oldChunks = before.files[0].chunks;
+    const std::vector<QByteArray>& newChunks = after.files[0].chunks;
+    QVERIFY(newChunks.size() > 4);
+    QCOMPARE(newChunks.back(), oldChunks.back());
+    QCOMPARE(newChunks[newChunks.size() - 2], oldChunks[oldChunks.size() - 2]);
+}
+
+void TestBackupStore::importUnderOtherNames() {
+    const QByteArray contents = randomBytes(20 * 1024, 6);
+    writeSource("users.json.backup_20240101_120000", contents);
+
+    BackupStore store(storeDirectory());
+    const QDateTime timestamp(QDate(2024, 1, 1), QTime(12, 0), QTimeZone::UTC);
+    QVERIFY2(store.importFiles("20240101_120000", timestamp,
+                               {{QDir(sourceDirectory()).filePath("users.json.backup_20240101_120000"), "users.json"}}),
+             qPrintable(store.getLastError()));
+
+    BackupStore::Backup backup;
+    QVERIFY(store.find("20240101_120000", backup));
+    QCOMPARE(backup.timestamp, timestamp);
+    QCOMPARE(backup.files.size(), std::size_t(1));
+    QCOMPARE(backup.files[0].name, QString("users.json"));
+
+    QByteArray restored;
+    QVERIFY(store.readFile(backup.files[0], restored));
+    QCOMPARE(restored, contents);
+}
+
+void TestBackupStore::rejectsPathIds() {
+    writeSource("config.json", "{}");
+    BackupStore store(storeDirectory());
+
+    for (const QString& id : {QString("../outside"), QString("a/b"), QString("a\\b"), QString(".."), QString()}) {
+        QVERIFY2(!store.create(id, sourceDirectory(), {"config.json"}), qPrintable(id));
+        BackupStore::Backup backup;
+        QVERIFY(!store.find(id, backup));
+    }
+    QVERIFY(!store.create("ok", sourceDirectory(), {"../config.json"}));
+
+    QVERIFY(!QFile::exists(m_directory->filePath("outside.backup.json")));
+    QVERIFY(store.list().empty());
+}
+
+void TestBackupStore::ignoresCatalogsWithPaths() {
+    writeSource("config.json", "{}");
+    BackupStore store(storeDirectory());
+    QVERIFY(store.create("good", sourceDirectory(), {"config.json"}));
+
+    // A hand-made catalog that would restore outside the data directory
+    QFile catalog(QDir(storeDirectory()).filePath("evil.backup.json"));
+    QVERIFY(catalog.open(QIODevice::WriteOnly));
+    catalog.write(R"({"version": "1.0", "type": "backup", "id": "evil", "timestamp": "2024-01-01T00:00:00Z",
+                      "files": [{"name": "../escape.json", "size": 2, "modified": 0,
+                                 "sha256": "44136fa355b3678a1146ad16f7e8649e94fb4fc21fe77e8310c060f61caaff8a",
+                                 "chunks": ["44136fa355b3678a1146ad16f7e8649e94fb4fc21fe77e8310c060f61caaff8a"]}]})");
+    catalog.close();
+
+    BackupStore::Backup backup;
+    QVERIFY(!store.find("evil", backup));
+    QCOMPARE(store.list().size(), std::size_t(1));
+    QCOMPARE(store.list().front().id, QString("good"));
+}
+
+void TestBackupStore::detectsDamagedChunks() {
+    writeSource("users.json", randomBytes(16 * 1024, 7));
+    BackupStore store(storeDirectory());
+    QVERIFY(store.create("only", sourceDirectory(), {"users.json"}));
+
+    BackupStore::Backup backup;
+    QVERIFY(store.find("only", backup));
+    const QString object = QDir(storeDirectory()).filePath("objects/" + QString::fromLatin1(backup.files[0].chunks[0]) + ".z");
+    QFile file(object);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(qCompress(QByteArray("not the original bytes")));
+    file.close();
+
+    QVERIFY(!store.verify(backup));
+    QVERIFY(!store.getLastError().isEmpty());
+}
+
+// Helpers
+
+void TestBackupStore::writeSource(const QString& name, const QByteArray& contents) {
+    QFile file(QDir(sourceDirectory()).filePath(name));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(contents), contents.size());
+}
+
+int TestBackupStore::objectCount() const {
+    return static_cast<int>(QDir(storeDirectory() + "/objects").entryList({"*.z"}, QDir::Files).size());
+}
+
+QByteArray TestBackupStore::randomBytes(qsizetype size, quint32 seed) {
+    QRandomGenerator generator(seed);
+    QByteArray bytes(size, Qt::Uninitialized);
+    for (char& byte : bytes) {
+        byte = static_cast<char>(generator.bounded(256));
+    }
+    return bytes;
+}
+
+QTEST_APPLESS_MAIN(TestBackupStore)
+#include "tst_backup_store.moc"
@@ -0,0 +1,16 @@
+QT += core testlib
+QT -= gui
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_circulation_journal
+TEMPLATE = app
+
+SOURCES += \
+    tst_circulation_journal.cpp \
+    ../../src/services/circulation_journal.cpp
+
+HEADERS += \
+    ../../src/services/circulation_journal.h \
+    ../../src/services/change_tracker.h
@@ -0,0 +1,232 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <atomic>
+#include <algorithm>
+
+#include "../../src/services/circulation_journal.h"
+
+namespace {
+
+/**
+ * @brief Journal that counts the batches it commits and can fail their sync
+ */
+class ObservedJournal : public CirculationJournal {
+public:
+    using CirculationJournal::CirculationJournal;
+    ~ObservedJournal() override { close(); }
+
+    std::atomic<int> batches = 0;
+    std::atomic<qint64> largestBatch = 0;
+    std::atomic<bool> failSync = false;
+
+protected:
+    bool writeBatch(const QByteArray& buffer, SyncMode mode) override {
+        ++batches;
+        largestBatch = std::max<qint64>(largestBatch, buffer.size());
+        if (failSync && mode == SyncMode::Fsync) {
+            // The bytes reach the file, but the fsync that would make them durable fails
+            CirculationJournal::writeBatch(buffer, SyncMode::Flush);
+            return false;
+        }
+        return CirculationJournal::writeBatch(buffer, mode);
+    }
+};
+
+/**
+ * @brief A borrow-like record whose loan state carries payloadSize bytes of notes
+ */
+CirculationJournal::Record loanRecord(const QString& loanId, qsizetype payloadSize = 16) {
+    CirculationJournal::Record record;
+    record.mutation = CirculationJournal::Mutation::Borrow;
+    record.timestamp = 1700000000000;
+    record.changes.push_back({ChangeTracker::Collection::Loans, CirculationJournal::ChangeType::Upsert, loanId,
+                              QJsonObject{{"loanId", loanId}, {"notes", QString(payloadSize, QChar('x'))}}});
+    return record;
+}
+
+bool allSucceeded(std::vector<QFuture<bool>>& futures) {
+    bool success = true;
+    for (QFuture<bool>& future : futures) {
+        success &= future.result();
+    }
+    return success;
+}
+
+} // namespace
+
+/**
+ * @brief Tests for the journal's group commit, failure reporting and torn-tail recovery
+ */
+class TestCirculationJournal : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void windowCoalescesRecords();
+    void fullBatchCommitsEarly();
+    void syncFailureReachesCallers();
+    void replayStopsAtTornTail();
+    void replayStopsAtDamagedRecord();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_directory;
+
+    QString journalPath() const { return m_directory->filePath("journal.log"); }
+    std::vector<CirculationJournal::Record> readBack();
+};
+
+void TestCirculationJournal::init() {
+    m_directory = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_directory->isValid());
+}
+
+void TestCirculationJournal::windowCoalescesRecords() {
+    ObservedJournal journal(journalPath());
+    journal.setCommitWindowMicros(500 * 1000);
+    QVERIFY(journal.open());
+
+    // Queued well within the window, so they share one write and one fsync
+    std::vector<QFuture<bool>> futures;
+    for (int i = 0; i < 20; ++i) {
+        CirculationJournal::Record record = loanRecord(QString("L%1").arg(i));
+        futures.push_back(journal.appendAsync(record));
+    }
+    QVERIFY(allSucceeded(futures));
+    QCOMPARE(journal.batches.load(), 1);
+
+    // Without a window every record is committed as soon as it arrives
+    journal.setCommitWindowMicros(0);
+    for (int i = 20; i < 23; ++i) {
+        CirculationJournal::Record record = loanRecord(QString("L%1").arg(i));
+        QVERIFY(journal.append(record));
+    }
+    QCOMPARE(journal.batches.load(), 4);
+
+    journal.close();
+    QCOMPARE(readBack().size(), std::size_t(23));
+}
+
+void TestCirculationJournal::fullBatchCommitsEarly() {
+    ObservedJournal journal(journalPath());
+    journal.setCommitWindowMicros(60 * 1000 * 1000);
+    QVERIFY(journal.open());
+
+    // Two records past MaxBatchBytes end the minute-long window at once
+    const qsizetype payload = CirculationJournal::MaxBatchBytes / 2 + 1024;
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<QFuture<bool>> futures;
+    for (const QString& loanId : {QString("L1"), QString("L2")}) {
+        CirculationJournal::Record record = loanRecord(loanId, payload);
+        futures.push_back(journal.appendAsync(record));
+    }
+    QVERIFY(allSucceeded(futures));
+    QVERIFY2(timer.elapsed() < 30 * 1000, "the batch waited out the commit window");
+    QVERIFY(journal.largestBatch.load() >= CirculationJournal::MaxBatchBytes);
+
+    journal.close();
+    QCOMPARE(readBack().size(), std::size_t(2));
+}
+
+void TestCirculationJournal::syncFailureReachesCallers() {
+    ObservedJournal journal(journalPath());
+    journal.setCommitWindowMicros(0);
+    QVERIFY(journal.open());
+
+    CirculationJournal::Record first = loanRecord("L1");
+    QVERIFY(journal.append(first));
+    const qint64 sizeBefore = journal.size();
+
+    journal.failSync = true;
+    CirculationJournal::Record failed = loanRecord("L2");
+    QFuture<bool> durable = journal.appendAsync(failed);
+    QVERIFY(!durable.result());
+    QCOMPARE(journal.size(), sizeBefore);
+
+    // The failed batch was cut off, so the next one lands right after the first record
+    journal.failSync = false;
+    CirculationJournal::Record next = loanRecord("L3");
+    QVERIFY(journal.append(next));
+    journal.close();
+
+    const std::vector<CirculationJournal::Record> records = readBack();
+    QCOMPARE(records.size(), std::size_t(2));
+    QCOMPARE(records[0].changes.front().entityId, QString("L1"));
+    QCOMPARE(records[1].changes.front().entityId, QString("L3"));
+}
+
+void TestCirculationJournal::replayStopsAtTornTail() {
+    {
+        CirculationJournal journal(journalPath());
+        journal.setCommitWindowMicros(0);
+        QVERIFY(journal.open());
+        for (const QString& loanId : {QString("L1"), QString("L2"), QString("L3")}) {
+            CirculationJournal::Record record = loanRecord(loanId);
+            QVERIFY(journal.append(record));
+        }
+    }
+
+    // A crash in the middle of the last record
+    const qint64 fullSize = QFileInfo(journalPath()).size();
+    QVERIFY(QFile::resize(journalPath(), fullSize - 5));
+
+    std::vector<CirculationJournal::Record> records = readBack();
+    QCOMPARE(records.size(), std::size_t(2));
+    QCOMPARE(records.back().changes.front().entityId, QString("L2"));
+
+    // Reopening cuts the torn bytes off; new records follow the intact ones
+    CirculationJournal journal(journalPath());
+    journal.setCommitWindowMicros(0);
+    QVERIFY(journal.open());
+    CirculationJournal::Record record = loanRecord("L4");
+    QVERIFY(journal.append(record));
+    QCOMPARE(record.sequence, quint64(3));
+    journal.close();
+
+    records = readBack();
+    QCOMPARE(records.size(), std::size_t(3));
+    QCOMPARE(records.back().changes.front().entityId, QString("L4"));
+    QCOMPARE(records.back().changes.front().state.value("loanId").toString(), QString("L4"));
+}
+
+void TestCirculationJournal::replayStopsAtDamagedRecord() {
+    {
+        CirculationJournal journal(journalPath());
+        journal.setCommitWindowMicros(0);
+        QVERIFY(journal.open());
+        for (const QString& loanId : {QString("L1"), QString("L2")}) {
+            CirculationJournal::Record record = loanRecord(loanId);
+            QVERIFY(journal.append(record));
+        }
+    }
+
+    // Flip a byte of the last payload: its CRC no longer matches
+    QFile file(journalPath());
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QByteArray data = file.readAll();
+    data[data.size() - 3] = static_cast<char>(data[data.size() - 3] ^ 0x40);
+    QVERIFY(file.seek(0));
+    QCOMPARE(file.write(data), data.size());
+    file.close();
+
+    const std::vector<CirculationJournal::Record> records = readBack();
+    QCOMPARE(records.size(), std::size_t(1));
+    QCOMPARE(records.front().changes.front().entityId, QString("L1"));
+}
+
+// Helpers
+
+std::vector<CirculationJournal::Record> TestCirculationJournal::readBack() {
+    CirculationJournal reader(journalPath());
+    std::vector<CirculationJournal::Record> records;
+    if (!reader.readRecords(records)) {
+        qWarning() << reader.getLastError();
+    }
+    return records;
+}
+
+QTEST_APPLESS_MAIN(TestCirculationJournal)
+#include "tst_circulation_journal.moc"
@@ -0,0 +1,15 @@
+QT += core testlib
+QT -= gui
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_json_pull_reader
+TEMPLATE = app
+
+SOURCES += \
+    tst_json_pull_reader.cpp \
+    ../../src/services/json_pull_reader.cpp
+
+HEADERS += \
+    ../../src/services/json_pull_reader.h
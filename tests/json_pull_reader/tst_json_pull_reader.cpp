@@ -0,0 +1,227 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include "../../src/services/json_pull_reader.h"
+
+namespace {
+
+/**
+ * @brief Read one whole document
+ * @return The value, or an undefined value if the reader reported an error
+ */
+QJsonValue parse(const QByteArray& json, qsizetype chunkSize = JsonPullReader::DefaultChunkSize,
+                 QString* error = nullptr) {
+    QBuffer buffer;
+    buffer.setData(json);
+    buffer.open(QIODevice::ReadOnly);
+
+    JsonPullReader reader(buffer, chunkSize);
+    reader.next();
+    QJsonValue value = reader.readValue();
+    if (!reader.hasError()) {
+        reader.next();
+    }
+    if (reader.hasError() || reader.token() != JsonPullReader::Token::EndDocument) {
+        if (error) {
+            *error = reader.errorString();
+        }
+        return QJsonValue(QJsonValue::Undefined);
+    }
+    return value;
+}
+
+const QString Replacement(QChar(0xFFFD));
+const QString Grinning = QString::fromUtf8("\xF0\x9F\x98\x80"); // U+1F600
+
+} // namespace
+
+/**
+ * @brief Tests for JsonPullReader's tokenizer and value reader
+ */
+class TestJsonPullReader : public QObject {
+    Q_OBJECT
+
+private slots:
+    void documents_data();
+    void documents();
+    void stringEscapes_data();
+    void stringEscapes();
+    void surrogatePairAcrossChunks();
+    void validNumbers_data();
+    void validNumbers();
+    void invalidNumbers_data();
+    void invalidNumbers();
+    void malformedDocuments_data();
+    void malformedDocuments();
+    void skipValue();
+};
+
+void TestJsonPullReader::documents_data() {
+    QTest::addColumn<QByteArray>("json");
+
+    QTest::newRow("empty object") << QByteArray("{}");
+    QTest::newRow("empty array") << QByteArray("[]");
+    QTest::newRow("nested") << QByteArray(R"({"a": [1, 2.5, -3e2, {"b": null}], "c": {"d": true, "e": false}})");
+    QTest::newRow("strings") << QByteArray(R"(["", "plain", "tab\there", "quote\"", "slash\/", "caf\u00e9"])");
+    QTest::newRow("whitespace") << QByteArray(" \n\t{ \"a\" :\r\n 1 } \n");
+}
+
+void TestJsonPullReader::documents() {
+    QFETCH(QByteArray, json);
+
+    // Qt's own parser is the reference for documents both accept
+    const QJsonDocument expected = QJsonDocument::fromJson(json);
+    QVERIFY(!expected.isNull());
+    const QJsonValue expectedValue = expected.isObject() ? QJsonValue(expected.object())
+                                                         : QJsonValue(expected.array());
+
+    for (qsizetype chunkSize : {qsizetype(1), qsizetype(3), JsonPullReader::DefaultChunkSize}) {
+        QCOMPARE(parse(json, chunkSize), expectedValue);
+    }
+}
+
+void TestJsonPullReader::stringEscapes_data() {
+    QTest::addColumn<QByteArray>("json");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("bmp escape") << QByteArray(R"("\u00e9")") << QString::fromUtf8("\xC3\xA9");
+    QTest::newRow("surrogate pair") << QByteArray(R"("\uD83D\uDE00")") << Grinning;
+    QTest::newRow("lowercase pair") << QByteArray(R"("\ud83d\ude00")") << Grinning;
+    QTest::newRow("lone high at end") << QByteArray(R"("\uD83D")") << Replacement;
+    QTest::newRow("lone low") << QByteArray(R"("\uDE00")") << Replacement;
+    QTest::newRow("high then plain text") << QByteArray(R"("\uD83Dab")") << Replacement + "ab";
+    QTest::newRow("high then newline escape") << QByteArray(R"("\uD83D\n")") << Replacement + "\n";
+    QTest::newRow("high then quote escape") << QByteArray(R"("\uD83D\"x")") << Replacement + "\"x";
+    QTest::newRow("high then backslash escape") << QByteArray(R"("\uD83D\\")") << Replacement + "\\";
+    QTest::newRow("high then bmp escape") << QByteArray(R"("\uD83D\u0041")") << Replacement + "A";
+    QTest::newRow("two highs then low") << QByteArray(R"("\uD83D\uD83D\uDE00")") << Replacement + Grinning;
+    QTest::newRow("low then high") << QByteArray(R"("\uDE00\uD83D")") << Replacement + Replacement;
+}
+
+void TestJsonPullReader::stringEscapes() {
+    QFETCH(QByteArray, json);
+    QFETCH(QString, expected);
+
+    QString error;
+    const QJsonValue value = parse(json, JsonPullReader::DefaultChunkSize, &error);
+    QVERIFY2(value.isString(), qPrintable(error));
+    QCOMPARE(value.toString(), expected);
+}
+
+void TestJsonPullReader::surrogatePairAcrossChunks() {
+    const QByteArray json = R"(["x\uD83D\uDE00y", "\uD83D\tz"])";
+    for (qsizetype chunkSize = 1; chunkSize <= json.size(); ++chunkSize) {
+        const QJsonValue value = parse(json, chunkSize);
+        QVERIFY(value.isArray());
+        QCOMPARE(value.toArray().at(0).toString(), "x" + Grinning + "y");
+        QCOMPARE(value.toArray().at(1).toString(), Replacement + "\tz");
+    }
+}
+
+void TestJsonPullReader::validNumbers_data() {
+    QTest::addColumn<QByteArray>("json");
+    QTest::addColumn<double>("expected");
+
+    QTest::newRow("zero") << QByteArray("0") << 0.0;
+    QTest::newRow("negative zero") << QByteArray("-0") << 0.0;
+    QTest::newRow("integer") << QByteArray("1024") << 1024.0;
+    QTest::newRow("negative") << QByteArray("-17") << -17.0;
+    QTest::newRow("zero fraction") << QByteArray("0.5") << 0.5;
+    QTest::newRow("fraction") << QByteArray("-12.25") << -12.25;
+    QTest::newRow("exponent") << QByteArray("1e3") << 1000.0;
+    QTest::newRow("signed exponent") << QByteArray("2.5E+2") << 250.0;
+    QTest::newRow("negative exponent") << QByteArray("25e-1") << 2.5;
+    QTest::newRow("zero with exponent") << QByteArray("0e5") << 0.0;
+}
+
+void TestJsonPullReader::validNumbers() {
+    QFETCH(QByteArray, json);
+    QFETCH(double, expected);
+
+    QString error;
+    const QJsonValue value = parse(json, JsonPullReader::DefaultChunkSize, &error);
+    QVERIFY2(value.isDouble(), qPrintable(error));
+    QCOMPARE(value.toDouble(), expected);
+
+    // Numbers end where the next token starts, also inside containers
+    QCOMPARE(parse("[" + json + "]", 1), QJsonValue(QJsonArray{expected}));
+}
+
+void TestJsonPullReader::invalidNumbers_data() {
+    QTest::addColumn<QByteArray>("json");
+
+    QTest::newRow("leading zero") << QByteArray("0123");
+    QTest::newRow("negative leading zero") << QByteArray("-0123");
+    QTest::newRow("double zero") << QByteArray("00");
+    QTest::newRow("leading zero with fraction") << QByteArray("01.5");
+    QTest::newRow("lone minus") << QByteArray("-");
+    QTest::newRow("double minus") << QByteArray("--1");
+    QTest::newRow("leading plus") << QByteArray("+1");
+    QTest::newRow("missing fraction digits") << QByteArray("1.");
+    QTest::newRow("missing integer digits") << QByteArray(".5");
+    QTest::newRow("missing exponent digits") << QByteArray("1e");
+    QTest::newRow("signed empty exponent") << QByteArray("1e+");
+    QTest::newRow("second point") << QByteArray("1.2.3");
+    QTest::newRow("leading zero in array") << QByteArray("[1, 007]");
+}
+
+void TestJsonPullReader::invalidNumbers() {
+    QFETCH(QByteArray, json);
+
+    QString error;
+    QVERIFY(parse(json, JsonPullReader::DefaultChunkSize, &error).isUndefined());
+    QVERIFY(!error.isEmpty());
+}
+
+void TestJsonPullReader::malformedDocuments_data() {
+    QTest::addColumn<QByteArray>("json");
+
+    QTest::newRow("empty input") << QByteArray("");
+    QTest::newRow("trailing comma in array") << QByteArray("[1,]");
+    QTest::newRow("trailing comma in object") << QByteArray(R"({"a": 1,})");
+    QTest::newRow("missing colon") << QByteArray(R"({"a" 1})");
+    QTest::newRow("missing value") << QByteArray(R"({"a":})");
+    QTest::newRow("unquoted key") << QByteArray("{a: 1}");
+    QTest::newRow("mismatched bracket") << QByteArray("[1}");
+    QTest::newRow("unclosed array") << QByteArray("[1, 2");
+    QTest::newRow("unterminated string") << QByteArray(R"("abc)");
+    QTest::newRow("control character") << QByteArray("\"a\nb\"");
+    QTest::newRow("invalid escape") << QByteArray(R"("\x41")");
+    QTest::newRow("short unicode escape") << QByteArray(R"("\u12")");
+    QTest::newRow("bad literal") << QByteArray("[tru]");
+    QTest::newRow("data after document") << QByteArray("1 2");
+}
+
+void TestJsonPullReader::malformedDocuments() {
+    QFETCH(QByteArray, json);
+
+    QString error;
+    QVERIFY(parse(json, JsonPullReader::DefaultChunkSize, &error).isUndefined());
+    QVERIFY(!error.isEmpty());
+}
+
+void TestJsonPullReader::skipValue() {
+    QBuffer buffer;
+    buffer.setData(R"({"skip": {"a": [1, {"b": "]"}]}, "keep": 42})");
+    buffer.open(QIODevice::ReadOnly);
+    JsonPullReader reader(buffer, 4);
+
+    QCOMPARE(reader.next(), JsonPullReader::Token::BeginObject);
+    QCOMPARE(reader.next(), JsonPullReader::Token::Key);
+    QCOMPARE(reader.string(), QString("skip"));
+    reader.next();
+    QVERIFY(reader.skipValue());
+    QCOMPARE(reader.depth(), 1);
+    QCOMPARE(reader.next(), JsonPullReader::Token::Key);
+    QCOMPARE(reader.string(), QString("keep"));
+    QCOMPARE(reader.next(), JsonPullReader::Token::Number);
+    QCOMPARE(reader.number(), 42.0);
+    QCOMPARE(reader.next(), JsonPullReader::Token::EndObject);
+    QCOMPARE(reader.next(), JsonPullReader::Token::EndDocument);
+}
+
+QTEST_APPLESS_MAIN(TestJsonPullReader)
+#include "tst_json_pull_reader.moc"
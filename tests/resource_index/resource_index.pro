@@ -0,0 +1,25 @@
+QT += core testlib
+QT -= gui
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_resource_index
+TEMPLATE = app
+
+SOURCES += \
+    tst_resource_index.cpp \
+    ../../src/services/resource_index.cpp \
+    ../../src/models/resource.cpp \
+    ../../src/models/book.cpp \
+    ../../src/models/cbor_record.cpp \
+    ../../src/models/epoch_time.cpp \
+    ../../src/models/string_pool.cpp
+
+HEADERS += \
+    ../../src/services/resource_index.h \
+    ../../src/models/resource.h \
+    ../../src/models/book.h \
+    ../../src/models/cbor_record.h \
+    ../../src/models/epoch_time.h \
+    ../../src/models/string_pool.h
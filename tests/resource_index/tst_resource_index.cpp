@@ -0,0 +1,123 @@
+#include <QtTest>
+#include <QBuffer>
+
+#include "../../src/services/resource_index.h"
+#include "../../src/models/book.h"
+
+namespace {
+
+std::unique_ptr<Book> makeBook(const QString& id, const QString& title, const QString& author,
+                               Resource::Status status = Resource::Status::Available) {
+    auto book = std::make_unique<Book>(id, title, author, 2001, "9780134685991", "Test Press");
+    book->setStatus(status);
+    return book;
+}
+
+QStringList idsOf(const ResourceIndex& index, const ResourceIndex::Ordinals& ordinals) {
+    QStringList ids;
+    for (quint32 ordinal : ordinals) {
+        ids << index.idAt(ordinal);
+    }
+    return ids;
+}
+
+} // namespace
+
+/**
+ * @brief Tests for the search index sidecar: round trips and rejection of stale or damaged files
+ */
+class TestResourceIndex : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void sidecarRoundTrip();
+    void rejectsStaleKey();
+    void rejectsDamagedPayload();
+    void rejectsTruncatedFile();
+
+private:
+    ResourceIndex m_index;
+
+    QByteArray sidecar(const QString& sourceKey) const;
+};
+
+void TestResourceIndex::init() {
+    m_index.clear();
+    m_index.add(*makeBook("R001", "Distributed Systems", "Tanenbaum"));
+    m_index.add(*makeBook("R002", "Operating Systems", "Silberschatz", Resource::Status::Borrowed));
+    m_index.add(*makeBook("R003", "Compilers", "Aho"));
+    m_index.remove("R003");
+}
+
+void TestResourceIndex::sidecarRoundTrip() {
+    QBuffer buffer;
+    buffer.setData(sidecar("resources.7.json"));
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    ResourceIndex index;
+    QVERIFY2(index.read(buffer, "resources.7.json"), qPrintable(index.getLastError()));
+    QCOMPARE(index.ids(), m_index.ids());
+    QCOMPARE(index.liveCount(), qsizetype(2));
+    QCOMPARE(index.ordinalOf("R002"), m_index.ordinalOf("R002"));
+
+    // Postings and bitmaps survive; the removed resource stays out of every answer
+    QCOMPARE(idsOf(index, index.search("systems")), QStringList({"R001", "R002"}));
+    QCOMPARE(idsOf(index, index.search("compil")), QStringList());
+    QCOMPARE(idsOf(index, index.withStatus(Resource::Status::Borrowed)), QStringList({"R002"}));
+    QCOMPARE(idsOf(index, index.withCategory(Resource::Category::Book)), QStringList({"R001", "R002"}));
+}
+
+void TestResourceIndex::rejectsStaleKey() {
+    QBuffer buffer;
+    buffer.setData(sidecar("resources.7.json"));
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    // A sidecar left over from another generation describes other data
+    ResourceIndex index;
+    index.add(*makeBook("X001", "Kept", "Unchanged"));
+    QVERIFY(!index.read(buffer, "resources.8.json"));
+    QVERIFY(index.getLastError().contains("resources.7.json"));
+    QCOMPARE(index.ids(), QStringList({"X001"}));
+}
+
+void TestResourceIndex::rejectsDamagedPayload() {
+    QByteArray bytes = sidecar("resources.7.json");
+    bytes[bytes.size() - 10] = static_cast<char>(bytes[bytes.size() - 10] ^ 0x01);
+
+    QBuffer buffer;
+    buffer.setData(bytes);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    ResourceIndex index;
+    QVERIFY(!index.read(buffer, "resources.7.json"));
+    QCOMPARE(index.getLastError(), QString("Search index is damaged"));
+    QCOMPARE(index.ordinalCount(), qsizetype(0));
+}
+
+void TestResourceIndex::rejectsTruncatedFile() {
+    const QByteArray bytes = sidecar("resources.7.json");
+    for (qsizetype length : {qsizetype(0), qsizetype(6), bytes.size() / 2, bytes.size() - 1}) {
+        QBuffer buffer;
+        buffer.setData(bytes.left(length));
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+        ResourceIndex index;
+        QVERIFY2(!index.read(buffer, "resources.7.json"), qPrintable(QString::number(length)));
+        QVERIFY(!index.getLastError().isEmpty());
+    }
+}
+
+// Helpers
+
+QByteArray TestResourceIndex::sidecar(const QString& sourceKey) const {
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    if (!m_index.write(buffer, sourceKey)) {
+        qWarning() << "Writing the sidecar failed";
+    }
+    return buffer.data();
+}
+
+QTEST_APPLESS_MAIN(TestResourceIndex)
+#include "tst_resource_index.moc"
@@ -0,0 +1,141 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "../../src/services/sqlite_storage_backend.h"
+#include "../../src/services/library_manager.h"
+#include "../../src/services/persistence_service.h"
+#include "../../src/models/book.h"
+
+namespace {
+
+std::unique_ptr<Book> makeBook(const QString& id, const QString& title) {
+    return std::make_unique<Book>(id, title, "Tanenbaum", 2001, "9780134685991", "Test Press");
+}
+
+QStringList loanIds(const std::vector<HistoryRecord<Loan>>& records) {
+    QStringList ids;
+    for (const HistoryRecord<Loan>& record : records) {
+        ids << record->getLoanId();
+    }
+    return ids;
+}
+
+} // namespace
+
+/**
+ * @brief Tests for the SQLite backend: full saves, per-operation changes and history queries
+ */
+class TestSqliteStorageBackend : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void replacedLibraryLoadsBack();
+    void appliedChangesSurviveReload();
+    void returnedLoansMoveToHistory();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_dir;
+    std::unique_ptr<LibraryManager> m_manager;
+    std::shared_ptr<SqliteStorageBackend> m_backend;
+
+    std::unique_ptr<LibraryManager> reload();
+};
+
+void TestSqliteStorageBackend::init() {
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+    m_backend = std::make_shared<SqliteStorageBackend>(m_dir->filePath("library.db"));
+
+    m_manager = std::make_unique<LibraryManager>();
+    m_manager->setClock(std::make_shared<FixedClock>(QDateTime(QDate(2024, 3, 4), QTime(10, 0))));
+    m_manager->addResource(makeBook("R001", "Distributed Systems"));
+    m_manager->addResource(makeBook("R002", "Operating Systems"));
+    m_manager->addUser(std::make_unique<User>("U001", "Ada", "Lovelace", "ada@example.org", User::UserType::Student));
+}
+
+void TestSqliteStorageBackend::cleanup() {
+    m_manager.reset();
+    m_backend.reset();
+    m_dir.reset();
+}
+
+/**
+ * @brief Load the database into a fresh manager, as at startup, through a new connection
+ */
+std::unique_ptr<LibraryManager> TestSqliteStorageBackend::reload() {
+    auto backend = std::make_shared<SqliteStorageBackend>(m_backend->getDatabasePath());
+    auto manager = std::make_unique<LibraryManager>();
+    std::vector<LoadConflict> conflicts;
+    if (!backend->loadLibrary(*manager, conflicts)) {
+        qWarning() << backend->getLastError();
+        return nullptr;
+    }
+    if (!conflicts.empty()) {
+        qWarning() << conflicts.front().message;
+        return nullptr;
+    }
+    return manager;
+}
+
+void TestSqliteStorageBackend::replacedLibraryLoadsBack() {
+    QString loanId = m_manager->borrowResource("U001", "R001");
+    QVERIFY2(m_backend->replaceLibrary(*m_manager), qPrintable(m_backend->getLastError()));
+
+    std::unique_ptr<LibraryManager> loaded = reload();
+    QVERIFY(loaded);
+    QCOMPARE(loaded->getAllResources().size(), std::size_t(2));
+    QCOMPARE(loaded->findResourceById("R001")->getStatus(), Resource::Status::Borrowed);
+    QCOMPARE(loaded->findResourceById("R002")->getTitle(), QString("Operating Systems"));
+
+    const User* user = loaded->findUserById("U001");
+    QVERIFY(user);
+    QCOMPARE(user->getEmail(), QString("ada@example.org"));
+
+    QCOMPARE(loaded->getActiveLoanStorage().size(), std::size_t(1));
+    QCOMPARE(loaded->getActiveLoanStorage().front()->getLoanId(), loanId);
+    QCOMPARE(loaded->getActiveLoanStorage().front()->getResourceId(), QString("R001"));
+}
+
+void TestSqliteStorageBackend::appliedChangesSurviveReload() {
+    QVERIFY2(m_backend->replaceLibrary(*m_manager), qPrintable(m_backend->getLastError()));
+
+    std::unique_ptr<Book> added = makeBook("R003", "Compilers");
+    std::vector<CirculationJournal::EntityChange> changes{
+        {ChangeTracker::Collection::Resources, CirculationJournal::ChangeType::Upsert, "R003",
+         PersistenceService::createResourceJson(*added)},
+        {ChangeTracker::Collection::Resources, CirculationJournal::ChangeType::Remove, "R002", QJsonObject()}};
+    QVERIFY2(m_backend->applyChanges(changes), qPrintable(m_backend->getLastError()));
+
+    std::unique_ptr<LibraryManager> loaded = reload();
+    QVERIFY(loaded);
+    QVERIFY(loaded->findResourceById("R001"));
+    QVERIFY(!loaded->findResourceById("R002"));
+    QVERIFY(loaded->findResourceById("R003"));
+    QCOMPARE(loaded->findResourceById("R003")->getTitle(), QString("Compilers"));
+}
+
+void TestSqliteStorageBackend::returnedLoansMoveToHistory() {
+    QString loanId = m_manager->borrowResource("U001", "R001");
+    QVERIFY2(m_backend->replaceLibrary(*m_manager), qPrintable(m_backend->getLastError()));
+    QVERIFY(m_manager->returnResource(loanId));
+    QVERIFY2(m_backend->saveLibrary(*m_manager), qPrintable(m_backend->getLastError()));
+
+    std::vector<QJsonObject> rows = m_backend->queryHistory(ChangeTracker::Collection::Loans,
+                                                            SqliteStorageBackend::HistoryQuery::ByUser, "U001");
+    QCOMPARE(rows.size(), std::size_t(1));
+    QCOMPARE(rows.front()["loanId"].toString(), loanId);
+    QVERIFY(m_backend->containsHistory(ChangeTracker::Collection::Loans, loanId));
+
+    std::unique_ptr<LibraryManager> loaded = reload();
+    QVERIFY(loaded);
+    QVERIFY(loaded->getActiveLoanStorage().empty());
+    QCOMPARE(loaded->findResourceById("R001")->getStatus(), Resource::Status::Available);
+    QCOMPARE(loanIds(loaded->getLoanHistory()), QStringList{loanId});
+    QCOMPARE(loanIds(loaded->getUserLoanHistory("U001")), QStringList{loanId});
+}
+
+// The SQLite driver is a plugin, which needs an application instance to be found
+QTEST_GUILESS_MAIN(TestSqliteStorageBackend)
+#include "tst_sqlite_storage_backend.moc"
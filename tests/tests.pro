@@ -0,0 +1,9 @@
+# Unit tests; build with qmake and run with "make check"
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    json_pull_reader \
+    backup_store \
+    circulation_journal \
+    resource_index \
+    sqlite_storage_backend